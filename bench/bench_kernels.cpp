@@ -0,0 +1,805 @@
+// Benchmark suite for every exported kernel, with regression baselines.
+//
+//   bench_kernels [--filter SUBSTR] [--reps N] [--min-sample-ms MS]
+//                 [--cpu N] [--json OUT] [--baseline FILE]
+//                 [--update-baseline] [--tolerance FRAC]
+//
+// Each case is warmed up, then timed in samples of enough calls to last
+// --min-sample-ms; the report is the median and MAD (median absolute
+// deviation) of the per-call time over --reps samples. The measuring thread
+// is pinned to --cpu (Linux; -1 leaves it floating). The thread pool is
+// started before pinning, so its workers keep the full CPU set.
+//
+// With --baseline, a case regresses when
+//   median > base_median * (1 + tolerance) + 3 * max(base_mad, mad)
+// and any regression makes the run exit with status 1. --update-baseline
+// writes the results to the --baseline file instead of comparing.
+#include "../lib/kernel.h"
+#include "../lib/csr_builder.h"
+#include "../lib/heston_mc.h"
+#include "../lib/local_vol.h"
+#include "../lib/lsmc.h"
+#include "../lib/markov_engine.h"
+#include "../lib/markov_kernel.h"
+#include "../lib/neural_calib.h"
+#include "../lib/sabr_calibration.h"
+#include "../lib/sabr_kernel.h"
+#include "../lib/sabr_mc.h"
+#include "../lib/signature_kernel.h"
+#include "../lib/slv.h"
+#include "../lib/sparse_matrix.h"
+#include "../lib/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+volatile double g_sink = 0.0;
+
+struct Case {
+  std::string name;
+  std::string size;
+  std::function<void()> run;
+};
+
+struct Result {
+  std::string name, size;
+  double median_ns = 0, mad_ns = 0;
+  size_t calls_per_sample = 0;
+};
+
+struct Baseline {
+  double median_ns = 0, mad_ns = 0;
+};
+
+std::string key_of(const std::string &name, const std::string &size) {
+  return name + "/" + size;
+}
+
+double median_of(std::vector<double> v) {
+  std::sort(v.begin(), v.end());
+  const size_t n = v.size();
+  return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+bool pin_to_cpu(int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+Result measure(const Case &c, int reps, double min_sample_ns) {
+  using clock = std::chrono::steady_clock;
+  auto time_calls = [&](size_t calls) {
+    auto start = clock::now();
+    for (size_t i = 0; i < calls; ++i)
+      c.run();
+    return std::chrono::duration<double, std::nano>(clock::now() - start)
+        .count();
+  };
+
+  // Warmup doubles the call count until one sample is long enough
+  // (touches buffers, grows per-thread scratch, settles the clock).
+  size_t calls = 1;
+  for (double t = time_calls(calls); t < min_sample_ns && calls < (1u << 30);
+       t = time_calls(calls))
+    calls *= 2;
+  time_calls(calls);
+
+  std::vector<double> per_call(reps);
+  for (int r = 0; r < reps; ++r)
+    per_call[r] = time_calls(calls) / (double)calls;
+
+  Result res;
+  res.name = c.name;
+  res.size = c.size;
+  res.calls_per_sample = calls;
+  res.median_ns = median_of(per_call);
+  std::vector<double> dev(reps);
+  for (int r = 0; r < reps; ++r)
+    dev[r] = std::abs(per_call[r] - res.median_ns);
+  res.mad_ns = median_of(dev);
+  return res;
+}
+
+// Reads the files written by write_json: one object per result, holding
+// "name", "size", "median_ns" and "mad_ns".
+std::map<std::string, Baseline> read_baseline(const std::string &path) {
+  std::map<std::string, Baseline> out;
+  std::ifstream in(path);
+  if (!in)
+    return out;
+  std::stringstream ss;
+  ss << in.rdbuf();
+  const std::string text = ss.str();
+
+  auto string_field = [&](size_t begin, size_t end, const char *field) {
+    const std::string tag = std::string("\"") + field + "\": \"";
+    size_t p = text.find(tag, begin);
+    if (p == std::string::npos || p >= end)
+      return std::string();
+    p += tag.size();
+    return text.substr(p, text.find('"', p) - p);
+  };
+  auto number_field = [&](size_t begin, size_t end, const char *field) {
+    const std::string tag = std::string("\"") + field + "\": ";
+    size_t p = text.find(tag, begin);
+    if (p == std::string::npos || p >= end)
+      return 0.0;
+    return std::strtod(text.c_str() + p + tag.size(), nullptr);
+  };
+
+  for (size_t p = text.find("{\"name\""); p != std::string::npos;
+       p = text.find("{\"name\"", p + 1)) {
+    const size_t end = text.find('}', p);
+    Baseline b;
+    b.median_ns = number_field(p, end, "median_ns");
+    b.mad_ns = number_field(p, end, "mad_ns");
+    out[key_of(string_field(p, end, "name"), string_field(p, end, "size"))] =
+        b;
+  }
+  return out;
+}
+
+bool write_json(const std::string &path, const std::vector<Result> &results) {
+  std::ofstream out(path);
+  if (!out)
+    return false;
+  out.precision(6);
+  out << "{\n  \"threads\": " << QuantKernel::ThreadPool::global().size()
+      << ",\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    out << "    {\"name\": \"" << r.name << "\", \"size\": \"" << r.size
+        << "\", \"median_ns\": " << r.median_ns
+        << ", \"mad_ns\": " << r.mad_ns
+        << ", \"calls_per_sample\": " << r.calls_per_sample << "}"
+        << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+  return (bool)out;
+}
+
+// ---------------------------------------------------------------------------
+// Inputs
+// ---------------------------------------------------------------------------
+
+// Random walk as (time, value) pairs.
+std::vector<double> make_path(size_t num_points, std::mt19937_64 &rng) {
+  std::normal_distribution<double> dw(0.0, 0.01);
+  std::vector<double> path(2 * num_points);
+  double w = 0.0;
+  for (size_t i = 0; i < num_points; ++i) {
+    path[2 * i] = (double)i / (double)num_points;
+    path[2 * i + 1] = w;
+    w += dw(rng);
+  }
+  return path;
+}
+
+// Row-stochastic matrix with nnz_per_row random columns per row.
+struct Csr {
+  int dim = 0;
+  std::vector<double> values;
+  std::vector<int> cols, row_ptr;
+};
+
+Csr make_csr(int dim, int nnz_per_row, std::mt19937_64 &rng) {
+  std::uniform_int_distribution<int> col(0, dim - 1);
+  Csr m;
+  m.dim = dim;
+  m.row_ptr.resize(dim + 1);
+  m.values.assign((size_t)dim * nnz_per_row, 1.0 / nnz_per_row);
+  m.cols.resize((size_t)dim * nnz_per_row);
+  for (int i = 0; i < dim; ++i) {
+    m.row_ptr[i] = i * nnz_per_row;
+    auto first = m.cols.begin() + (size_t)i * nnz_per_row;
+    for (int j = 0; j < nnz_per_row; ++j)
+      first[j] = col(rng);
+    std::sort(first, first + nnz_per_row);
+  }
+  m.row_ptr[dim] = dim * nnz_per_row;
+  return m;
+}
+
+// Valid calibration inputs: [ATM, skew25, skew10, fly25, fly10, F, T]
+std::vector<double> make_calib_inputs(size_t batch, std::mt19937_64 &rng) {
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  std::vector<double> in(batch * 7);
+  for (size_t i = 0; i < batch; ++i) {
+    double *s = in.data() + 7 * i;
+    s[0] = 0.1 + 0.4 * u(rng);
+    s[1] = -0.1 * u(rng);
+    s[2] = 1.5 * s[1];
+    s[3] = 0.03 * u(rng);
+    s[4] = 1.5 * s[3];
+    s[5] = 50.0 + 100.0 * u(rng);
+    s[6] = 0.1 + 2.0 * u(rng);
+  }
+  return in;
+}
+
+std::vector<Case> build_cases() {
+  std::vector<Case> cases;
+  std::mt19937_64 rng(42);
+  auto size_str = [](auto... parts) {
+    std::ostringstream os;
+    const char *sep = "";
+    ((os << sep << parts, sep = "x"), ...);
+    return os.str();
+  };
+
+  // --- signature_kernel.h -------------------------------------------------
+  for (size_t n : {64, 1024, 16384}) {
+    auto path = std::make_shared<std::vector<double>>(make_path(n, rng));
+    cases.push_back({"compute_signature_level3", size_str(n), [path, n] {
+                       double out[15];
+                       compute_signature_level3(path->data(), n, out);
+                       g_sink = out[14];
+                     }});
+  }
+  for (size_t paths : {64, 1024}) {
+    const size_t n = 256;
+    auto block = std::make_shared<std::vector<double>>();
+    for (size_t p = 0; p < paths; ++p) {
+      auto path = make_path(n, rng);
+      block->insert(block->end(), path.begin(), path.end());
+    }
+    auto out = std::make_shared<std::vector<double>>(paths * 15);
+    cases.push_back(
+        {"compute_signature_level3_batch", size_str(paths, n),
+         [block, out, paths, n] {
+           compute_signature_level3_batch(block->data(), paths, n, out->data());
+           g_sink = (*out)[0];
+         }});
+  }
+  {
+    auto path = make_path(256, rng);
+    auto sig = std::make_shared<std::vector<double>>(15);
+    compute_signature_level3(path.data(), 256, sig->data());
+    cases.push_back({"compute_log_signature", "1", [sig] {
+                       double out[14];
+                       compute_log_signature(sig->data(), out);
+                       g_sink = out[13];
+                     }});
+  }
+  for (size_t n : {4096, 65536}) {
+    const size_t window = 64;
+    auto path = std::make_shared<std::vector<double>>(make_path(n, rng));
+    cases.push_back({"compute_expected_signature", size_str(n, window),
+                     [path, n, window] {
+                       double out[15];
+                       compute_expected_signature(path->data(), n, window,
+                                                  out);
+                       g_sink = out[14];
+                     }});
+  }
+  for (size_t num_sigs : {16, 1024}) {
+    auto sigs = std::make_shared<std::vector<double>>(num_sigs * 15);
+    for (size_t s = 0; s < num_sigs; ++s) {
+      auto path = make_path(64, rng);
+      compute_signature_level3(path.data(), 64, sigs->data() + 15 * s);
+    }
+    cases.push_back({"compute_signature_curvature", size_str(num_sigs),
+                     [sigs, num_sigs] {
+                       g_sink =
+                           compute_signature_curvature(sigs->data(), num_sigs);
+                     }});
+  }
+  for (size_t n : {64, 4096}) {
+    std::uniform_real_distribution<double> mu(-0.1, 0.1), s2(0.01, 0.2);
+    auto points = std::make_shared<std::vector<double>>(2 * n);
+    for (size_t i = 0; i < n; ++i) {
+      (*points)[2 * i] = mu(rng);
+      (*points)[2 * i + 1] = s2(rng);
+    }
+    cases.push_back({"compute_frechet_mean", size_str(n), [points, n] {
+                       double m, s;
+                       compute_frechet_mean(points->data(), n, &m, &s);
+                       g_sink = m + s;
+                     }});
+  }
+
+  // --- markov_kernel.h ----------------------------------------------------
+  for (int dim : {1000, 100000}) {
+    auto m = std::make_shared<Csr>(make_csr(dim, 10, rng));
+    auto x = std::make_shared<std::vector<double>>(dim, 1.0 / dim);
+    auto y = std::make_shared<std::vector<double>>(dim);
+    cases.push_back({"spmv_csr", size_str(dim, 10), [m, x, y] {
+                       spmv_csr(m->values.data(), m->cols.data(),
+                                m->row_ptr.data(), m->dim, m->dim, x->data(),
+                                y->data(), (int)m->values.size());
+                       g_sink = (*y)[0];
+                     }});
+  }
+  {
+    const int dim = 100000;
+    auto m = std::make_shared<Csr>(make_csr(dim, 10, rng));
+    for (int k : {4, 16}) {
+      auto X = std::make_shared<std::vector<double>>((size_t)dim * k, 1.0);
+      auto Y = std::make_shared<std::vector<double>>((size_t)dim * k);
+      for (int parallel : {0, 1})
+        cases.push_back(
+            {parallel ? "spmm_csr_threads" : "spmm_csr", size_str(dim, k),
+             [m, X, Y, k, parallel] {
+               spmm_csr(m->values.data(), m->cols.data(), m->row_ptr.data(),
+                        m->dim, m->dim, X->data(), k, Y->data(), parallel);
+               g_sink = (*Y)[0];
+             }});
+    }
+  }
+
+  // --- sparse_matrix.h ----------------------------------------------------
+  {
+    const int dim = 100000;
+    auto m = std::make_shared<Csr>(make_csr(dim, 10, rng));
+    auto x = std::make_shared<std::vector<double>>(dim, 1.0 / dim);
+    auto y = std::make_shared<std::vector<double>>(dim);
+    const struct {
+      const char *name;
+      int format, param;
+    } formats[] = {{"sparse_matrix_spmv", 0, 0},
+                   {"sparse_matrix_spmv_sell", 1, 0},
+                   {"sparse_matrix_spmv_bcsr", 2, 4}};
+    for (const auto &f : formats) {
+      std::shared_ptr<QuantKernel::SparseMatrix> a(
+          sparse_matrix_create(m->values.data(), m->cols.data(),
+                               m->row_ptr.data(), dim, dim, f.format, f.param),
+          sparse_matrix_destroy);
+      cases.push_back({f.name, size_str(dim, 10), [a, x, y] {
+                         sparse_matrix_spmv(a.get(), x->data(), y->data());
+                         g_sink = (*y)[0];
+                       }});
+    }
+  }
+
+  // --- markov_engine.h ----------------------------------------------------
+  {
+    const int dim = 100000, steps = 16, iters = 50;
+    auto m = std::make_shared<Csr>(make_csr(dim, 10, rng));
+    std::shared_ptr<QuantKernel::MarkovEngine> engine(
+        markov_engine_create(m->values.data(), m->cols.data(),
+                             m->row_ptr.data(), dim),
+        markov_engine_destroy);
+    auto pi0 = std::make_shared<std::vector<double>>(dim, 1.0 / dim);
+    auto out = std::make_shared<std::vector<double>>(dim);
+    cases.push_back({"markov_engine_propagate", size_str(dim, 10, steps),
+                     [engine, pi0, out] {
+                       markov_engine_propagate(engine.get(), pi0->data(),
+                                               steps, out->data());
+                       g_sink = (*out)[0];
+                     }});
+    // tol = 0: every call spends the full SpMV budget
+    for (int method : {0, 1})
+      cases.push_back({method ? "markov_engine_stationary_arnoldi"
+                              : "markov_engine_stationary",
+                       size_str(dim, 10, iters), [engine, out, method] {
+                         markov_engine_stationary(engine.get(), method,
+                                                  nullptr, 0.0, iters,
+                                                  out->data(), nullptr);
+                         g_sink = (*out)[0];
+                       }});
+  }
+
+  // --- csr_builder.h ------------------------------------------------------
+  {
+    const int nodes = 100000, per_node = 10;
+    const size_t edges = (size_t)nodes * per_node;
+    std::uniform_int_distribution<int> node(0, nodes - 1);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    auto src = std::make_shared<std::vector<int>>(edges);
+    auto dst = std::make_shared<std::vector<int>>(edges);
+    auto prob = std::make_shared<std::vector<double>>(edges);
+    for (size_t e = 0; e < edges; ++e) {
+      (*src)[e] = node(rng);
+      (*dst)[e] = node(rng);
+      (*prob)[e] = u(rng);
+    }
+    auto row_ptr = std::make_shared<std::vector<int>>(nodes + 1);
+    auto cols = std::make_shared<std::vector<int>>(edges);
+    auto values = std::make_shared<std::vector<double>>(edges);
+    cases.push_back({"coo_to_csr", size_str(nodes, per_node),
+                     [src, dst, prob, row_ptr, cols, values, edges] {
+                       g_sink = (double)coo_to_csr(
+                           src->data(), dst->data(), prob->data(), edges,
+                           nodes, 0.1, 1, row_ptr->data(), cols->data(),
+                           values->data());
+                     }});
+  }
+
+  // --- sabr_kernel.h ------------------------------------------------------
+  auto params = std::make_shared<ModelParams>();
+  params->alpha = 0.3;
+  params->beta = 0.5;
+  params->rho = -0.3;
+  params->nu = 0.4;
+  for (size_t strikes : {32, 256}) {
+    const size_t tenors = 8;
+    auto K = std::make_shared<std::vector<double>>(strikes);
+    for (size_t i = 0; i < strikes; ++i)
+      (*K)[i] = 50.0 + 100.0 * (double)i / (double)strikes;
+    auto F = std::make_shared<std::vector<double>>(tenors, 100.0);
+    auto T = std::make_shared<std::vector<double>>(tenors);
+    for (size_t t = 0; t < tenors; ++t)
+      (*T)[t] = 0.25 * (double)(t + 1);
+    auto out = std::make_shared<std::vector<double>>(tenors * strikes);
+    cases.push_back({"sabr_implied_vol_surface", size_str(1, tenors, strikes),
+                     [params, K, F, T, out, strikes] {
+                       sabr_implied_vol_surface(params.get(), 1, F->data(),
+                                                T->data(), F->size(),
+                                                K->data(), strikes,
+                                                out->data());
+                       g_sink = (*out)[0];
+                     }});
+  }
+  cases.push_back({"sabr_hagan_implied_vol", "1", [params] {
+                     g_sink = sabr_hagan_implied_vol(
+                         100.0, 110.0, 1.0, params->alpha, params->beta,
+                         params->rho, params->nu);
+                   }});
+  {
+    const size_t n = 100;
+    auto out = std::make_shared<std::vector<double>>(n);
+    cases.push_back({"neural_sabr_inference", size_str(n), [params, out, n] {
+                       neural_sabr_inference(params.get(), out->data(), n);
+                       g_sink = (*out)[0];
+                     }});
+    cases.push_back(
+        {"neural_sabr_inference_analytic", size_str(n), [params, out, n] {
+           neural_sabr_inference_analytic(params.get(), out->data(), n);
+           g_sink = (*out)[0];
+         }});
+  }
+
+  // --- sabr_calibration.h ------------------------------------------------
+  {
+    // Smiles priced from known parameters, refitted from a cold start
+    const size_t smiles = 64, strikes = 21;
+    auto K = std::make_shared<std::vector<double>>(smiles * strikes);
+    auto vols = std::make_shared<std::vector<double>>(smiles * strikes);
+    auto offsets = std::make_shared<std::vector<int>>(smiles + 1);
+    auto F = std::make_shared<std::vector<double>>(smiles, 100.0);
+    auto T = std::make_shared<std::vector<double>>(smiles);
+    for (size_t s = 0; s < smiles; ++s) {
+      (*T)[s] = 0.1 + 0.05 * (double)s;
+      (*offsets)[s] = (int)(s * strikes);
+      for (size_t i = 0; i < strikes; ++i) {
+        const size_t k = s * strikes + i;
+        (*K)[k] = 60.0 + 4.0 * (double)i;
+        (*vols)[k] = sabr_hagan_implied_vol(100.0, (*K)[k], (*T)[s],
+                                            params->alpha * 10.0, params->beta,
+                                            params->rho, params->nu);
+      }
+    }
+    (*offsets)[smiles] = (int)(smiles * strikes);
+    auto fit = std::make_shared<std::vector<ModelParams>>(smiles);
+    auto rmse = std::make_shared<std::vector<double>>(smiles);
+    cases.push_back(
+        {"sabr_calibrate_chain", size_str(smiles, strikes),
+         [K, vols, offsets, F, T, fit, rmse, params] {
+           for (ModelParams &p : *fit) {
+             p = ModelParams{};
+             p.beta = params->beta;
+           }
+           sabr_calibrate_chain(K->data(), vols->data(), nullptr,
+                                offsets->data(), smiles, F->data(), T->data(),
+                                fit->data(), rmse->data(), 0);
+           g_sink = (*rmse)[0];
+         }});
+  }
+
+  // --- sabr_mc.h ----------------------------------------------------------
+  for (bool store : {false, true}) {
+    const size_t paths = 1024, steps = 252;
+    auto path_block = std::make_shared<std::vector<double>>(
+        store ? paths * 2 * (steps + 1) : 0);
+    auto sigs = std::make_shared<std::vector<double>>(paths * 15);
+    cases.push_back(
+        {store ? "sabr_mc_simulate_paths" : "sabr_mc_simulate",
+         size_str(paths, steps), [params, path_block, sigs, store] {
+           sabr_mc_simulate(params.get(), 100.0, 1.0 / 252.0, steps, paths, 7,
+                            0, store ? path_block->data() : nullptr,
+                            sigs->data());
+           g_sink = (*sigs)[1];
+         }});
+  }
+  {
+    const size_t paths = 1024, steps = 252;
+    auto sigs = std::make_shared<std::vector<double>>(paths * 15);
+    cases.push_back({"sabr_qmc_simulate", size_str(paths, steps),
+                     [params, sigs] {
+                       sabr_qmc_simulate(params.get(), 100.0, 1.0 / 252.0,
+                                         steps, paths, 7, 0, nullptr,
+                                         sigs->data());
+                       g_sink = (*sigs)[1];
+                     }});
+  }
+  {
+    const size_t paths = 1024, steps = 252;
+    cases.push_back({"sabr_mc_greeks", size_str(paths, steps), [params] {
+                       double greeks[SABR_NUM_GREEKS];
+                       sabr_mc_greeks(params.get(), 100.0, 1.0 / 252.0, steps,
+                                      paths, 7, 0, 100.0, 0.03, 0, 0, nullptr,
+                                      greeks, nullptr);
+                       g_sink = greeks[SABR_GREEK_DELTA];
+                     }});
+  }
+
+  // --- heston_mc.h --------------------------------------------------------
+  for (int qmc : {0, 1}) {
+    const size_t paths = 1024, steps = 252;
+    auto term = std::make_shared<std::vector<double>>(2 * paths);
+    cases.push_back(
+        {qmc ? "heston_mc_simulate_qmc" : "heston_mc_simulate",
+         size_str(paths, steps), [term, qmc] {
+           HestonParams p{};
+           p.t_end = 1.0;
+           p.kappa = 1.5;
+           p.theta = 0.04;
+           p.xi = 0.6;
+           p.rho = -0.7;
+           heston_mc_simulate(&p, 1, 100.0, 0.04, 1.0 / 252.0, steps, paths, 7,
+                              0, qmc, nullptr, nullptr, term->data());
+           g_sink = (*term)[0];
+         }});
+  }
+
+  // --- lsmc.h -------------------------------------------------------------
+  {
+    const size_t paths = 16384, steps = 50;
+    auto block = std::make_shared<std::vector<double>>(paths * 2 * (steps + 1));
+    auto sigs = std::make_shared<std::vector<double>>(paths * 15);
+    ModelParams p{};
+    p.alpha = 2.0;
+    p.beta = 0.5;
+    p.rho = -0.5;
+    p.nu = 0.4;
+    sabr_mc_simulate(&p, 100.0, 1.0 / 52.0, steps, paths, 7, 0, block->data(),
+                     sigs->data());
+    cases.push_back({"lsmc_american_price", size_str(paths, steps),
+                     [block, sigs] {
+                       double price;
+                       lsmc_american_price(block->data(), sigs->data(), paths,
+                                           steps + 1, 15, 100.0, 0.03,
+                                           1.0 / 52.0, 1, &price);
+                       g_sink = price;
+                     }});
+    auto strikes = std::make_shared<std::vector<double>>();
+    auto puts = std::make_shared<std::vector<int>>();
+    for (int k = 0; k < 10; ++k) {
+      strikes->insert(strikes->end(), 2, 80.0 + 4.0 * k);
+      puts->push_back(1);
+      puts->push_back(0);
+    }
+    cases.push_back({"lsmc_american_chain", size_str(paths, steps, 20),
+                     [block, sigs, strikes, puts] {
+                       double prices[20];
+                       lsmc_american_chain(block->data(), sigs->data(), paths,
+                                           steps + 1, 15, strikes->data(),
+                                           puts->data(), 20, 0.03, 1.0 / 52.0,
+                                           prices, nullptr);
+                       g_sink = prices[0];
+                     }});
+  }
+
+  // --- local_vol.h --------------------------------------------------------
+  // 41 x 8 implied grid (skewed smile), surface on 200 x 50 nodes
+  const size_t lv_k = 41, lv_t = 8;
+  auto lv_strikes = std::make_shared<std::vector<double>>(lv_k);
+  auto lv_tenors = std::make_shared<std::vector<double>>(lv_t);
+  auto lv_implied = std::make_shared<std::vector<double>>(lv_k * lv_t);
+  for (size_t i = 0; i < lv_k; ++i)
+    (*lv_strikes)[i] = 40.0 + 4.0 * (double)i;
+  for (size_t j = 0; j < lv_t; ++j) {
+    (*lv_tenors)[j] = 0.25 * (double)(j + 1);
+    for (size_t i = 0; i < lv_k; ++i) {
+      const double m = std::log((*lv_strikes)[i] / 100.0);
+      (*lv_implied)[j * lv_k + i] =
+          0.2 - 0.1 * m + 0.15 * m * m + 0.01 * (*lv_tenors)[j];
+    }
+  }
+  std::shared_ptr<QuantKernel::LocalVolSurface> lv_surface(
+      local_vol_surface_create(lv_implied->data(), lv_strikes->data(), lv_k,
+                               lv_tenors->data(), lv_t, 100.0, 0.03, 200, 50),
+      local_vol_surface_destroy);
+  cases.push_back({"local_vol_surface_create", size_str(200, 50),
+                   [lv_strikes, lv_tenors, lv_implied] {
+                     QuantKernel::LocalVolSurface *lv =
+                         local_vol_surface_create(
+                             lv_implied->data(), lv_strikes->data(), lv_k,
+                             lv_tenors->data(), lv_t, 100.0, 0.03, 200, 50);
+                     g_sink = lv->values()[0];
+                     local_vol_surface_destroy(lv);
+                   }});
+  {
+    const size_t n = 4096;
+    auto xs = std::make_shared<std::vector<double>>(n);
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> nd(std::log(100.0), 0.3);
+    for (double &x : *xs)
+      x = nd(rng);
+    cases.push_back({"local_vol_surface_at", size_str(n), [lv_surface, xs] {
+                       double acc = 0.0, t = 0.0;
+                       for (double x : *xs) {
+                         acc += lv_surface->at(x, t);
+                         t += 0.0005;
+                       }
+                       g_sink = acc;
+                     }});
+  }
+
+  // --- slv.h --------------------------------------------------------------
+  {
+    const size_t particles = 16384, steps = 100;
+    auto lev = std::make_shared<std::vector<double>>((steps + 1) * lv_k);
+    cases.push_back({"slv_calibrate_leverage", size_str(particles, steps),
+                     [lv_surface, lv_strikes, lev] {
+                       HestonParams p{};
+                       p.t_end = 1.0;
+                       p.mu = 0.03;
+                       p.kappa = 1.5;
+                       p.theta = 0.04;
+                       p.xi = 0.6;
+                       p.rho = -0.7;
+                       slv_calibrate_leverage(
+                           &p, 1, 100.0, 0.04, lv_surface.get(),
+                           lv_strikes->data(), lv_k, 0.01, steps, particles,
+                           7, lev->data(), nullptr);
+                       g_sink = (*lev)[steps * lv_k];
+                     }});
+  }
+
+  // --- neural_calib.h -----------------------------------------------------
+  {
+    auto in = std::make_shared<std::vector<double>>(make_calib_inputs(1, rng));
+    cases.push_back({"c_calibrate_sabr", "1", [in] {
+                       double out[4];
+                       c_calibrate_sabr(in->data(), out);
+                       g_sink = out[0];
+                     }});
+  }
+  for (size_t batch : {64, 1024}) {
+    auto in =
+        std::make_shared<std::vector<double>>(make_calib_inputs(batch, rng));
+    auto in32 = std::make_shared<std::vector<float>>(in->begin(), in->end());
+    auto out = std::make_shared<std::vector<double>>(batch * 4);
+    auto out32 = std::make_shared<std::vector<float>>(batch * 4);
+    cases.push_back({"c_calibrate_sabr_batch", size_str(batch),
+                     [in, out, batch] {
+                       c_calibrate_sabr_batch(in->data(), batch, out->data());
+                       g_sink = (*out)[0];
+                     }});
+    cases.push_back({"c_calibrate_sabr_batch_f32", size_str(batch),
+                     [in32, out32, batch] {
+                       c_calibrate_sabr_batch_f32(in32->data(), batch,
+                                                  out32->data());
+                       g_sink = (*out32)[0];
+                     }});
+  }
+  return cases;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string filter, json_path, baseline_path;
+  int reps = 15, cpu = 0;
+  double min_sample_ms = 2.0, tolerance = 0.25;
+  bool update_baseline = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto next = [&]() -> const char * {
+      if (i + 1 >= argc) {
+        std::cerr << arg << " needs a value" << std::endl;
+        std::exit(2);
+      }
+      return argv[++i];
+    };
+    if (arg == "--filter")
+      filter = next();
+    else if (arg == "--reps")
+      reps = std::max(1, std::atoi(next()));
+    else if (arg == "--min-sample-ms")
+      min_sample_ms = std::atof(next());
+    else if (arg == "--cpu")
+      cpu = std::atoi(next());
+    else if (arg == "--json")
+      json_path = next();
+    else if (arg == "--baseline")
+      baseline_path = next();
+    else if (arg == "--update-baseline")
+      update_baseline = true;
+    else if (arg == "--tolerance")
+      tolerance = std::atof(next());
+    else {
+      std::cerr << "unknown option " << arg << std::endl;
+      return 2;
+    }
+  }
+
+  // Start the pool first: workers inherit the affinity of their creator.
+  QuantKernel::ThreadPool::global();
+  if (cpu >= 0 && !pin_to_cpu(cpu))
+    std::cerr << "warning: could not pin to cpu " << cpu << std::endl;
+
+  std::map<std::string, Baseline> baseline;
+  if (!baseline_path.empty() && !update_baseline) {
+    baseline = read_baseline(baseline_path);
+    if (baseline.empty())
+      std::cerr << "warning: no baseline entries in " << baseline_path
+                << std::endl;
+  }
+
+  std::vector<Result> results;
+  int regressions = 0;
+  std::printf("%-32s %-14s %14s %12s %10s\n", "kernel", "size", "median ns",
+              "mad ns", "vs base");
+  for (const Case &c : build_cases()) {
+    if (!filter.empty() &&
+        key_of(c.name, c.size).find(filter) == std::string::npos)
+      continue;
+    Result r = measure(c, reps, min_sample_ms * 1e6);
+    results.push_back(r);
+
+    std::string verdict = "-";
+    auto it = baseline.find(key_of(r.name, r.size));
+    if (it != baseline.end() && it->second.median_ns > 0) {
+      const Baseline &b = it->second;
+      char ratio[32];
+      std::snprintf(ratio, sizeof(ratio), "%.2fx",
+                    r.median_ns / b.median_ns);
+      verdict = ratio;
+      if (r.median_ns > b.median_ns * (1.0 + tolerance) +
+                            3.0 * std::max(b.mad_ns, r.mad_ns)) {
+        verdict += " REGRESSION";
+        ++regressions;
+      }
+    } else if (!baseline.empty()) {
+      verdict = "new";
+    }
+    std::printf("%-32s %-14s %14.1f %12.1f %10s\n", r.name.c_str(),
+                r.size.c_str(), r.median_ns, r.mad_ns, verdict.c_str());
+  }
+
+  if (!json_path.empty() && !write_json(json_path, results)) {
+    std::cerr << "cannot write " << json_path << std::endl;
+    return 2;
+  }
+  if (update_baseline) {
+    if (baseline_path.empty() || !write_json(baseline_path, results)) {
+      std::cerr << "--update-baseline needs a writable --baseline"
+                << std::endl;
+      return 2;
+    }
+    std::cout << "Baseline written to " << baseline_path << std::endl;
+  }
+  if (regressions > 0) {
+    std::cerr << regressions << " kernel(s) regressed beyond "
+              << tolerance * 100.0 << "% of baseline" << std::endl;
+    return 1;
+  }
+  return 0;
+}
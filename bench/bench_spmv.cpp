@@ -1,14 +1,22 @@
-#include "../src_cpp/markov_kernel.h"
-#include "../src_cpp/tracer.h"
+#include "../lib/csr_builder.h"
+#include "../lib/markov_engine.h"
+#include "../lib/markov_kernel.h"
+#include "../lib/neural_calib.h"
+#include "../lib/sabr_calibration.h"
+#include "../lib/sabr_kernel.h"
+#include "../lib/signature_engine.h"
+#include "../lib/signature_kernel.h"
+#include "../lib/sparse_matrix.h"
+#include "../lib/metrics.h"
+#include "../lib/tracer.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <random>
 #include <vector>
 
-extern "C" {
-void compute_signature_level3(const double *path, size_t num_points,
-                              double *output);
-}
-
 int main(int argc, char **argv) {
   bool trace = false;
   for (int i = 1; i < argc; ++i) {
@@ -17,8 +25,10 @@ int main(int argc, char **argv) {
   }
 
   if (trace) {
-    ::enable_tracing("benchmark_trace.json");
-    std::cout << "Tracing enabled: benchmark_trace.json" << std::endl;
+    if (::enable_tracing("benchmark_trace.qkt") == 0)
+      std::cout << "Tracing enabled: benchmark_trace.qkt (convert with "
+                   "trace2json benchmark_trace.qkt benchmark_trace.json)"
+                << std::endl;
   }
 
   // Benchmark SpMV
@@ -75,5 +85,678 @@ int main(int argc, char **argv) {
               << std::endl;
   }
 
+  // Signature Kernel: per-ISA cross-check against scalar + timing
+  {
+    QuantKernel::TraceScope scope("Signature_ISA_Benchmark");
+    const size_t n = 1000;
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> gauss(0.0, 0.1);
+    std::vector<double> path(2 * n);
+    double w = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      path[2 * i] = (double)i * 0.01;
+      path[2 * i + 1] = w;
+      w += gauss(rng);
+    }
+
+    std::vector<double> ref(15, 0.0);
+    signature_kernel_force_isa(0);
+    compute_signature_level3(path.data(), n, ref.data());
+
+    const char *isa_names[] = {"scalar", "avx2", "avx512"};
+    int best = signature_kernel_force_isa(-1);
+    for (int isa = 0; isa <= best; ++isa) {
+      signature_kernel_force_isa(isa);
+      std::vector<double> out(15, 0.0);
+      compute_signature_level3(path.data(), n, out.data());
+
+      double max_rel = 0.0;
+      for (int k = 0; k < 15; ++k) {
+        double scale = std::max(1.0, std::abs(ref[k]));
+        max_rel = std::max(max_rel, std::abs(out[k] - ref[k]) / scale);
+      }
+
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < 10000; ++i) {
+        compute_signature_level3(path.data(), n, out.data());
+      }
+      auto end = std::chrono::high_resolution_clock::now();
+      auto diff =
+          std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+              .count();
+      std::cout << "Signature [" << isa_names[isa]
+                << "] Time per iteration: " << diff / 10000.0
+                << " us, max rel err vs scalar: " << max_rel << std::endl;
+      if (max_rel > 1e-12) {
+        std::cerr << "Signature [" << isa_names[isa]
+                  << "] diverges from scalar path" << std::endl;
+        return 1;
+      }
+    }
+    signature_kernel_force_isa(-1);
+  }
+
+  // Expected Signature: streaming (Chen slide) vs. per-window recompute
+  {
+    QuantKernel::TraceScope scope("Expected_Signature_Benchmark");
+    const size_t n = 5000;
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> gauss(0.0, 0.1);
+    std::vector<double> path(2 * n);
+    double w = 100.0;
+    for (size_t i = 0; i < n; ++i) {
+      path[2 * i] = (double)i * 0.01;
+      path[2 * i + 1] = w;
+      w += gauss(rng);
+    }
+
+    for (size_t window : {20, 100, 500}) {
+      double ref[15], out[15];
+      const int iters = 50;
+
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iters; ++i)
+        compute_expected_signature_reference(path.data(), n, window, ref);
+      auto mid = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iters; ++i)
+        compute_expected_signature(path.data(), n, window, out);
+      auto end = std::chrono::high_resolution_clock::now();
+
+      double t_ref =
+          std::chrono::duration<double, std::micro>(mid - start).count() /
+          iters;
+      double t_new =
+          std::chrono::duration<double, std::micro>(end - mid).count() / iters;
+      double max_rel = 0.0;
+      for (int k = 0; k < 15; ++k) {
+        double scale = std::max(1.0, std::abs(ref[k]));
+        max_rel = std::max(max_rel, std::abs(out[k] - ref[k]) / scale);
+      }
+      std::cout << "Expected Signature [N=" << n << ", W=" << window
+                << "] recompute: " << t_ref << " us, streaming: " << t_new
+                << " us (" << t_ref / t_new << "x), max rel err: " << max_rel
+                << std::endl;
+      if (max_rel > 1e-12) {
+        std::cerr << "Streaming expected signature diverges from reference"
+                  << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // General (dim, depth) signature engine
+  {
+    QuantKernel::TraceScope scope("Signature_Depth_Benchmark");
+    const size_t n = 1000;
+    std::mt19937_64 rng(11);
+    std::normal_distribution<double> gauss(0.0, 0.1);
+
+    struct Shape {
+      size_t dim, depth;
+    };
+    for (Shape shape : {Shape{2, 3}, Shape{2, 5}, Shape{4, 3}, Shape{4, 4},
+                        Shape{4, 6}, Shape{5, 3}}) {
+      std::vector<double> path(shape.dim * n);
+      for (size_t i = 0; i < n; ++i)
+        for (size_t k = 0; k < shape.dim; ++k)
+          path[i * shape.dim + k] =
+              (i > 0 ? path[(i - 1) * shape.dim + k] : 0.0) + gauss(rng);
+      std::vector<double> out(signature_size(shape.dim, shape.depth));
+
+      const int iters = shape.dim * shape.depth > 12 ? 20 : 1000;
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iters; ++i)
+        compute_signature_depth(path.data(), n, shape.dim, shape.depth,
+                                out.data());
+      auto end = std::chrono::high_resolution_clock::now();
+      std::cout << "Signature [dim=" << shape.dim << ", depth=" << shape.depth
+                << ", terms=" << out.size() << "] Time per iteration: "
+                << std::chrono::duration<double, std::micro>(end - start)
+                           .count() /
+                       iters
+                << " us" << std::endl;
+    }
+  }
+
+  // SABR Surface: batch (param set x tenor x strike) vs scalar Hagan loop
+  {
+    QuantKernel::TraceScope scope("SABR_Surface_Benchmark");
+    const size_t num_params = 256, num_tenors = 8, num_strikes = 41;
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::vector<ModelParams> params(num_params);
+    for (auto &p : params) {
+      p.alpha = 0.05 + 0.5 * unif(rng);
+      p.beta = unif(rng);
+      p.rho = -0.9 + 1.8 * unif(rng);
+      p.nu = 0.01 + 1.5 * unif(rng);
+    }
+    std::vector<double> forwards(num_tenors), tenors(num_tenors);
+    for (size_t t = 0; t < num_tenors; ++t) {
+      forwards[t] = 100.0 + (double)t;
+      tenors[t] = 0.1 + 0.5 * (double)t;
+    }
+    std::vector<double> strikes(num_strikes);
+    for (size_t k = 0; k < num_strikes; ++k)
+      strikes[k] = 60.0 + 2.0 * (double)k;
+
+    const size_t total = num_params * num_tenors * num_strikes;
+    std::vector<double> ref(total), out(total);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t p = 0; p < num_params; ++p)
+      for (size_t t = 0; t < num_tenors; ++t)
+        for (size_t k = 0; k < num_strikes; ++k)
+          ref[(p * num_tenors + t) * num_strikes + k] = sabr_hagan_implied_vol(
+              forwards[t], strikes[k], tenors[t], params[p].alpha,
+              params[p].beta, params[p].rho, params[p].nu);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "SABR Surface [scalar loop] Time per vol: "
+              << std::chrono::duration<double, std::nano>(end - start)
+                         .count() /
+                     total
+              << " ns" << std::endl;
+
+    const char *isa_names[] = {"scalar", "avx2", "avx512"};
+    int best = signature_kernel_force_isa(-1);
+    for (int isa = 0; isa <= best; ++isa) {
+      signature_kernel_force_isa(isa);
+      sabr_implied_vol_surface(params.data(), num_params, forwards.data(),
+                               tenors.data(), num_tenors, strikes.data(),
+                               num_strikes, out.data());
+      double max_rel = 0.0;
+      for (size_t i = 0; i < total; ++i)
+        max_rel = std::max(max_rel, std::abs(out[i] - ref[i]) /
+                                        std::max(1e-12, std::abs(ref[i])));
+
+      const int iters = 20;
+      start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iters; ++i)
+        sabr_implied_vol_surface(params.data(), num_params, forwards.data(),
+                                 tenors.data(), num_tenors, strikes.data(),
+                                 num_strikes, out.data());
+      end = std::chrono::high_resolution_clock::now();
+      std::cout << "SABR Surface [" << isa_names[isa] << "] Time per vol: "
+                << std::chrono::duration<double, std::nano>(end - start)
+                           .count() /
+                       (iters * total)
+                << " ns, max rel err vs scalar: " << max_rel << std::endl;
+      // The scalar formula itself loses ~1e-11 to cancellation deep OTM
+      if (max_rel > 1e-9) {
+        std::cerr << "SABR Surface [" << isa_names[isa]
+                  << "] diverges from scalar Hagan" << std::endl;
+        return 1;
+      }
+    }
+    signature_kernel_force_isa(-1);
+  }
+
+  // SABR Calibration: full chain (cold start, then warm start from the fit)
+  {
+    QuantKernel::TraceScope scope("SABR_Calibration_Benchmark");
+    const size_t num_smiles = 3000, num_strikes = 30;
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::vector<double> strikes, vols, forwards(num_smiles), tenors(num_smiles);
+    std::vector<int> offsets{0};
+    std::vector<ModelParams> truth(num_smiles), params(num_smiles);
+    for (size_t s = 0; s < num_smiles; ++s) {
+      forwards[s] = 50.0 + 100.0 * unif(rng);
+      tenors[s] = 0.05 + 2.0 * unif(rng);
+      ModelParams &q = truth[s];
+      q.beta = 0.5;
+      q.alpha = (0.1 + 0.4 * unif(rng)) * std::sqrt(forwards[s]);
+      q.rho = -0.8 + 1.4 * unif(rng);
+      q.nu = 0.1 + 1.2 * unif(rng);
+      for (size_t k = 0; k < num_strikes; ++k) {
+        double K = forwards[s] * std::exp(-0.5 + (double)k / num_strikes);
+        strikes.push_back(K);
+        vols.push_back(sabr_hagan_implied_vol(forwards[s], K, tenors[s],
+                                              q.alpha, q.beta, q.rho, q.nu));
+      }
+      offsets.push_back((int)strikes.size());
+      params[s] = ModelParams{};
+      params[s].beta = 0.5;
+    }
+
+    std::vector<double> rmse(num_smiles);
+    for (const char *mode : {"cold", "warm"}) {
+      auto start = std::chrono::high_resolution_clock::now();
+      sabr_calibrate_chain(strikes.data(), vols.data(), nullptr,
+                           offsets.data(), num_smiles, forwards.data(),
+                           tenors.data(), params.data(), rmse.data(), 0);
+      auto end = std::chrono::high_resolution_clock::now();
+      double worst = *std::max_element(rmse.begin(), rmse.end());
+      std::cout << "SABR Calibration [" << mode << ", " << num_smiles
+                << " smiles x " << num_strikes << " strikes] Time: "
+                << std::chrono::duration<double, std::milli>(end - start)
+                       .count()
+                << " ms, worst RMSE: " << worst << std::endl;
+      if (worst > 1e-8) {
+        std::cerr << "SABR Calibration [" << mode
+                  << "] failed to recover the generating smile" << std::endl;
+        return 1;
+      }
+      // Perturb the fits so the warm pass has work to do
+      for (ModelParams &p : params) {
+        p.alpha *= 1.05;
+        p.rho = std::clamp(p.rho + 0.05, -0.99, 0.99);
+        p.nu *= 0.9;
+      }
+    }
+  }
+
+  // Neural Calibration: batched GEMM engine vs the per-sample loop
+  {
+    QuantKernel::TraceScope scope("Neural_Calib_Benchmark");
+    const size_t batch = 1024;
+    std::mt19937_64 rng(5);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    std::vector<double> in(7 * batch), ref(4 * batch), out(4 * batch);
+    std::vector<float> in32(7 * batch), out32(4 * batch);
+    for (size_t i = 0; i < in.size(); ++i) {
+      in[i] = 20.0 * gauss(rng);
+      in32[i] = (float)in[i];
+    }
+
+    const int iters = 200;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iters; ++it)
+      for (size_t b = 0; b < batch; ++b)
+        c_calibrate_sabr_reference(&in[7 * b], &ref[4 * b]);
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iters; ++it)
+      c_calibrate_sabr_batch(in.data(), batch, out.data());
+    auto mid32 = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iters; ++it)
+      c_calibrate_sabr_batch_f32(in32.data(), batch, out32.data());
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double err64 = 0.0, err32 = 0.0;
+    for (size_t i = 0; i < ref.size(); ++i) {
+      double scale = std::max(1.0, std::abs(ref[i]));
+      err64 = std::max(err64, std::abs(out[i] - ref[i]) / scale);
+      err32 = std::max(err32, std::abs(out32[i] - ref[i]) / scale);
+    }
+    auto per_batch = [&](auto a, auto b) {
+      return std::chrono::duration<double, std::micro>(b - a).count() / iters;
+    };
+    std::cout << "Neural Calib [batch=" << batch
+              << "] per-sample loop: " << per_batch(start, mid)
+              << " us, batched f64: " << per_batch(mid, mid32)
+              << " us (err " << err64 << "), batched f32: "
+              << per_batch(mid32, end) << " us (err " << err32 << ")"
+              << std::endl;
+    if (err64 > 1e-12 || err32 > 1e-5) {
+      std::cerr << "Neural Calib: batched engine diverges from per-sample loop"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // Neural SABR: native surface network vs the analytic Hagan fallback
+  {
+    QuantKernel::TraceScope scope("Neural_SABR_Benchmark");
+    const size_t in = 6, hidden = 32, surf_size = 100;
+    std::mt19937_64 rng(9);
+    std::normal_distribution<double> gauss(0.0, 0.3);
+    std::vector<double> w1(hidden * in), b1(hidden), w2(hidden), b2(1, 0.2);
+    for (double &v : w1)
+      v = gauss(rng);
+    for (double &v : b1)
+      v = gauss(rng);
+    for (double &v : w2)
+      v = 0.1 * gauss(rng);
+
+    const char *path = "/tmp/bench_neural_sabr.qkmlp";
+    {
+      FILE *f = std::fopen(path, "w");
+      std::fprintf(f, "qkmlp 1\nlayers 2\ndense %zu %zu gelu\n", in, hidden);
+      for (double v : w1) std::fprintf(f, "%.17g ", v);
+      for (double v : b1) std::fprintf(f, "%.17g ", v);
+      std::fprintf(f, "\ndense %zu 1 linear\n", hidden);
+      for (double v : w2) std::fprintf(f, "%.17g ", v);
+      std::fprintf(f, "%.17g\n", b2[0]);
+      std::fclose(f);
+    }
+
+    ModelParams p = {0.2, 0.5, -0.3, 0.4, {}};
+    std::vector<double> analytic(surf_size), learned(surf_size);
+    const int iters = 2000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int it = 0; it < iters; ++it)
+      neural_sabr_inference(&p, analytic.data(), surf_size);
+    auto mid = std::chrono::high_resolution_clock::now();
+    if (neural_sabr_load_weights(path) != 0) {
+      std::cerr << "Neural SABR: failed to load bench weights" << std::endl;
+      return 1;
+    }
+    for (int it = 0; it < iters; ++it)
+      neural_sabr_inference(&p, learned.data(), surf_size);
+    auto end = std::chrono::high_resolution_clock::now();
+    neural_sabr_clear_weights();
+
+    // Naive forward pass of the same network
+    double err = 0.0;
+    for (size_t i = 0; i < surf_size; ++i) {
+      double x[6] = {p.alpha, p.beta, p.rho, p.nu,
+                     std::log((80.0 + 0.4 * i) / 100.0), 1.0};
+      double y = b2[0];
+      for (size_t h = 0; h < hidden; ++h) {
+        double a = b1[h];
+        for (size_t j = 0; j < in; ++j)
+          a += w1[h * in + j] * x[j];
+        a = 0.5 * a *
+            (1.0 + std::tanh(0.79788456 * (a + 0.044715 * a * a * a)));
+        y += w2[h] * a;
+      }
+      err = std::max(err, std::abs(learned[i] - y));
+    }
+    auto per_call = [&](auto a, auto b) {
+      return std::chrono::duration<double, std::micro>(b - a).count() / iters;
+    };
+    std::cout << "Neural SABR [" << surf_size
+              << " strikes] Hagan fallback: " << per_call(start, mid)
+              << " us, native net: " << per_call(mid, end) << " us (err "
+              << err << ")" << std::endl;
+    if (err > 1e-12) {
+      std::cerr << "Neural SABR: native net diverges from naive forward pass"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // Sparse formats: SELL-C-σ / blocked CSR handles vs the CSR kernel on a
+  // regime graph (mostly near-diagonal jumps, a few long-range ones)
+  {
+    QuantKernel::TraceScope scope("SpMV_Formats_Benchmark");
+    const int dim = 500000;
+    std::mt19937 rng(11);
+    std::vector<int> row_ptr(dim + 1, 0), col_indices;
+    std::vector<double> values;
+    for (int i = 0; i < dim; ++i) {
+      int len = 2 + (int)(rng() % 14);
+      for (int k = 0; k < len; ++k) {
+        int c = (rng() % 8 == 0) ? (int)(rng() % dim)
+                                 : std::clamp(i + (int)(rng() % 9) - 4, 0,
+                                              dim - 1);
+        col_indices.push_back(c);
+        values.push_back(1.0 / len);
+      }
+      row_ptr[i + 1] = (int)col_indices.size();
+    }
+    std::vector<double> x(dim), ref(dim), y(dim);
+    for (int i = 0; i < dim; ++i)
+      x[i] = std::sin(0.001 * i);
+
+    const int iters = 50;
+    auto time_us = [&](auto &&fn) {
+      fn();
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int it = 0; it < iters; ++it)
+        fn();
+      auto end = std::chrono::high_resolution_clock::now();
+      return std::chrono::duration<double, std::micro>(end - start).count() /
+             iters;
+    };
+    double t_csr = time_us([&]() {
+      spmv_csr(values.data(), col_indices.data(), row_ptr.data(), dim, dim,
+               x.data(), ref.data(), (int)values.size());
+    });
+    std::cout << "SpMV Formats [dim=" << dim << ", nnz=" << values.size()
+              << "] spmv_csr: " << t_csr << " us";
+
+    const char *names[] = {"CSR", "SELL-8-256", "BCSR-4"};
+    for (int f = 0; f < 3; ++f) {
+      QuantKernel::SparseMatrix *m =
+          sparse_matrix_create(values.data(), col_indices.data(),
+                               row_ptr.data(), dim, dim, f, 0);
+      double t = time_us([&]() { sparse_matrix_spmv(m, x.data(), y.data()); });
+      double err = 0.0;
+      for (int i = 0; i < dim; ++i)
+        err = std::max(err, std::abs(y[i] - ref[i]));
+      std::cout << ", " << names[f] << ": " << t << " us (fill "
+                << sparse_matrix_fill_ratio(m) << ")";
+      sparse_matrix_destroy(m);
+      if (err > 1e-12) {
+        std::cerr << std::endl
+                  << "SpMV Formats: " << names[f]
+                  << " diverges from spmv_csr (err " << err << ")"
+                  << std::endl;
+        return 1;
+      }
+    }
+    std::cout << std::endl;
+  }
+
+  // Markov Engine: stationary distribution of a regime graph, power
+  // iteration vs restarted Arnoldi, plus a k-step forecast
+  {
+    QuantKernel::TraceScope scope("Markov_Engine_Benchmark");
+    const int dim = 1000000;
+    std::mt19937 rng(13);
+    std::vector<int> row_ptr(dim + 1, 0), col_indices;
+    std::vector<double> values;
+    for (int i = 0; i < dim; ++i) {
+      int len = 1 + (int)(rng() % 8);
+      double total = 0.0;
+      size_t first = values.size();
+      for (int k = 0; k < len; ++k) {
+        col_indices.push_back((int)(rng() % dim));
+        values.push_back(1.0 + rng() % 10);
+        total += values.back();
+      }
+      // Ring edge keeps the chain irreducible (at 1M states a purely random
+      // graph leaves slowly draining pockets that never converge to 1e-10)
+      col_indices.push_back((i + 1) % dim);
+      values.push_back(1.0);
+      total += 1.0;
+      // Self-loop keeps the chain aperiodic for power iteration
+      col_indices.push_back(i);
+      values.push_back(total);
+      total *= 2.0;
+      for (size_t k = first; k < values.size(); ++k)
+        values[k] /= total;
+      row_ptr[i + 1] = (int)col_indices.size();
+    }
+
+    QuantKernel::MarkovEngine *engine = markov_engine_create(
+        values.data(), col_indices.data(), row_ptr.data(), dim);
+    std::vector<double> pi_power(dim), pi_arnoldi(dim), forecast(dim);
+    int it_power = 0, it_arnoldi = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    double r_power = markov_engine_stationary(
+        engine, 0, nullptr, 1e-10, 0, pi_power.data(), &it_power);
+    auto mid = std::chrono::high_resolution_clock::now();
+    double r_arnoldi = markov_engine_stationary(
+        engine, 1, nullptr, 1e-10, 0, pi_arnoldi.data(), &it_arnoldi);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::vector<double> pi0(dim, 0.0);
+    pi0[0] = 1.0;
+    markov_engine_propagate(engine, pi0.data(), 20, forecast.data());
+    markov_engine_destroy(engine);
+
+    double diff = 0.0, mass = 0.0;
+    for (int i = 0; i < dim; ++i) {
+      diff += std::abs(pi_power[i] - pi_arnoldi[i]);
+      mass += forecast[i];
+    }
+    auto ms = [](auto a, auto b) {
+      return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    std::cout << "Markov Engine [states=" << dim << "] power: " << ms(start, mid)
+              << " ms (" << it_power << " SpMVs, residual " << r_power
+              << "), arnoldi: " << ms(mid, end) << " ms (" << it_arnoldi
+              << " SpMVs, residual " << r_arnoldi << "), |diff|_1: " << diff
+              << std::endl;
+    if (r_power > 1e-10 || r_arnoldi > 1e-10 || diff > 1e-8 ||
+        std::abs(mass - 1.0) > 1e-12) {
+      std::cerr << "Markov Engine: solvers disagree or mass not conserved"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // SpMM: K distributions through one CSR matrix, vs K separate SpMVs
+  {
+    QuantKernel::TraceScope scope("SpMM_Benchmark");
+    const int dim = 200000;
+    std::mt19937 rng(17);
+    std::vector<int> row_ptr(dim + 1, 0), col_indices;
+    std::vector<double> values;
+    for (int i = 0; i < dim; ++i) {
+      int len = 2 + (int)(rng() % 14);
+      for (int k = 0; k < len; ++k) {
+        col_indices.push_back((int)(rng() % dim));
+        values.push_back(1.0 / len);
+      }
+      row_ptr[i + 1] = (int)col_indices.size();
+    }
+
+    for (int K : {1, 4, 8, 16, 64}) {
+      std::vector<double> X((size_t)dim * K), Y((size_t)dim * K);
+      std::vector<double> xs(dim), ys(dim), ref((size_t)dim * K);
+      for (size_t i = 0; i < X.size(); ++i)
+        X[i] = std::sin(0.37 * (double)i);
+
+      const int iters = std::max(2, 64 / K);
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int it = 0; it < iters; ++it) {
+        for (int k = 0; k < K; ++k) {
+          for (int i = 0; i < dim; ++i)
+            xs[i] = X[(size_t)i * K + k];
+          spmv_csr(values.data(), col_indices.data(), row_ptr.data(), dim, dim,
+                   xs.data(), ys.data(), (int)values.size());
+          for (int i = 0; i < dim; ++i)
+            ref[(size_t)i * K + k] = ys[i];
+        }
+      }
+      auto mid = std::chrono::high_resolution_clock::now();
+      for (int it = 0; it < iters; ++it)
+        spmm_csr(values.data(), col_indices.data(), row_ptr.data(), dim, dim,
+                 X.data(), K, Y.data(), 0);
+      auto mid_mt = std::chrono::high_resolution_clock::now();
+      for (int it = 0; it < iters; ++it)
+        spmm_csr(values.data(), col_indices.data(), row_ptr.data(), dim, dim,
+                 X.data(), K, Y.data(), 1);
+      auto end = std::chrono::high_resolution_clock::now();
+
+      double err = 0.0;
+      for (size_t i = 0; i < Y.size(); ++i)
+        err = std::max(err, std::abs(Y[i] - ref[i]));
+      // Time per vector, so the columns compare directly across K
+      auto per_vec = [&](auto a, auto b) {
+        return std::chrono::duration<double, std::micro>(b - a).count() /
+               (iters * K);
+      };
+      std::cout << "SpMM [dim=" << dim << ", K=" << K
+                << "] per vector: K x spmv_csr " << per_vec(start, mid)
+                << " us, spmm_csr " << per_vec(mid, mid_mt)
+                << " us, spmm_csr (threads) " << per_vec(mid_mt, end)
+                << " us" << std::endl;
+      if (err > 1e-12) {
+        std::cerr << "SpMM: spmm_csr diverges from spmv_csr (err " << err
+                  << ")" << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // CSR Builder: COO edge list -> pruned, renormalized CSR
+  {
+    QuantKernel::TraceScope scope("CSR_Builder_Benchmark");
+    const int num_nodes = 1000000;
+    const size_t num_edges = 10000000;
+    const double epsilon = 0.01;
+    std::mt19937 rng(19);
+    std::vector<int> src(num_edges), dst(num_edges);
+    std::vector<double> prob(num_edges);
+    size_t expected = 0;
+    for (size_t e = 0; e < num_edges; ++e) {
+      src[e] = (int)(rng() % num_nodes);
+      dst[e] = (int)(rng() % num_nodes);
+      prob[e] = (rng() % 1000) / 1000.0;
+      expected += prob[e] >= epsilon;
+    }
+
+    std::vector<int> row_ptr(num_nodes + 1), col_indices(num_edges);
+    std::vector<double> values(num_edges);
+    auto start = std::chrono::high_resolution_clock::now();
+    int64_t nnz = coo_to_csr(src.data(), dst.data(), prob.data(), num_edges,
+                             num_nodes, epsilon, 1, row_ptr.data(),
+                             col_indices.data(), values.data());
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double worst = 0.0;
+    for (int r = 0; r < num_nodes; ++r) {
+      if (row_ptr[r] == row_ptr[r + 1])
+        continue;
+      double sum = 0.0;
+      for (int k = row_ptr[r]; k < row_ptr[r + 1]; ++k)
+        sum += values[k];
+      worst = std::max(worst, std::abs(sum - 1.0));
+    }
+    std::cout << "CSR Builder [" << num_edges << " edges, " << num_nodes
+              << " states] Time: "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms, kept " << nnz << std::endl;
+    if (nnz != (int64_t)expected || worst > 1e-12) {
+      std::cerr << "CSR Builder: wrong nnz or rows not renormalized"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // Tracer overhead: cost of one QK_TRACE_SCOPE with tracing on and off
+  {
+    const int scopes = 100000; // fits one ring, nothing is dropped
+    const bool was_enabled = QuantKernel::Tracer::instance().enabled();
+    auto time_ns = [&]() {
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < scopes; ++i) {
+        QK_TRACE_SCOPE("Tracer_Overhead");
+      }
+      auto end = std::chrono::high_resolution_clock::now();
+      return std::chrono::duration<double, std::nano>(end - start).count() /
+             scopes;
+    };
+    if (!was_enabled)
+      ::enable_tracing("tracer_overhead.qkt");
+    time_ns(); // register the thread's ring, intern the name
+    QuantKernel::Tracer::instance().flush();
+    double on = time_ns();
+    if (!was_enabled) {
+      ::disable_tracing();
+      std::remove("tracer_overhead.qkt");
+    }
+    double off = was_enabled ? 0.0 : time_ns();
+    std::cout << "Tracer overhead per scope: enabled " << on << " ns";
+    if (!was_enabled)
+      std::cout << ", disabled " << off << " ns";
+    std::cout << std::endl;
+  }
+
+  // Metrics overhead and the per-kernel table the stream server reports
+  {
+    const int scopes = 1000000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < scopes; ++i) {
+      QK_METRIC_SCOPE("Metrics_Overhead", 0);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Metrics overhead per scope: "
+              << std::chrono::duration<double, std::nano>(end - start).count() /
+                     scopes
+              << " ns" << std::endl;
+    for (int id = 0; id < metrics_num_kernels(); ++id) {
+      double s[7];
+      metrics_kernel_summary(id, s);
+      std::cout << "  " << metrics_kernel_name(id) << ": calls " << s[0]
+                << ", p50 " << s[3] << " ns, p99 " << s[4] << " ns, p999 "
+                << s[5] << " ns" << std::endl;
+    }
+  }
+
   return 0;
 }
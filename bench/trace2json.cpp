@@ -0,0 +1,18 @@
+#include "../lib/tracer.h"
+#include <iostream>
+
+// Offline converter: binary spill from enable_tracing -> Chrome trace JSON
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <trace.qkt> <trace.json>"
+              << std::endl;
+    return 2;
+  }
+  long n = trace_convert_to_json(argv[1], argv[2]);
+  if (n < 0) {
+    std::cerr << "trace2json: cannot convert " << argv[1] << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << n << " events to " << argv[2] << std::endl;
+  return 0;
+}
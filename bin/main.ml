@@ -15,9 +15,10 @@ let () =
   } in
   
   Printf.printf "Running LSMC validation for American Put (S=100, K=100, r=0.03)...\n%!";
-  let results = Monte_carlo.Engine.run_parallel config (100.0, 0.2) 0.5 (-0.5) 0.4 in
-  let flattened = Array.concat results in
-  let price = American_pricing.LSMC.price_american flattened 100.0 0.03 config.dt American_pricing.LSMC.Put in
+  let paths, sigs = Monte_carlo.Engine.simulate_native config (100.0, 0.2) 0.5 (-0.5) 0.4 in
+  let price =
+    American_pricing.LSMC.price_block ~paths ~sigs ~num_paths:config.num_paths
+      ~num_steps:config.num_steps 100.0 0.03 config.dt American_pricing.LSMC.Put in
   Printf.printf "American Put Price: %.6f\n\n%!" price;
   
   (* 2. Validate Phase 14: Stochastic Local Volatility (SLV) *)
@@ -36,10 +37,20 @@ let () =
   let sigma_dup = Slv_engine.compute_local_vol ~s0 ~strike ~tenor ~get_vol ~r in
   Printf.printf "Dupire Local Vol at K=%.1f, T=%.1f: %.6f\n%!" strike tenor sigma_dup;
   
-  let results = Monte_carlo.Engine.run_parallel config (s0, 0.2) 0.5 (-0.5) 0.4 in
-  let flattened = Array.concat results in
-  let leverage = Slv_engine.calibrate_leverage flattened ~strike ~tenor ~sigma_dup in
-  Printf.printf "Calibrated Leverage L(S,t): %.6f\n\n%!" leverage;
+  let strikes = Array.init 41 (fun i -> 40.0 +. 4.0 *. float_of_int i) in
+  let tenors = Array.init 8 (fun j -> 0.25 *. float_of_int (j + 1)) in
+  let implied = { Slv_engine.strikes; tenors;
+                  vols = Array.map (fun t -> Array.map (fun k -> get_vol k t) strikes) tenors } in
+  let local_vol = Slv_engine.local_vol_surface ~s0 ~r implied in
+  Printf.printf "Local Vol Surface at K=%.1f, T=%.1f: %.6f (%d arbitrage nodes)\n%!" strike tenor
+    (Slv_engine.local_vol_at local_vol ~spot:strike ~t:tenor)
+    (Slv_engine.arbitrage_points local_vol);
+  let spots = Array.init 25 (fun i -> 50.0 +. 5.0 *. float_of_int i) in
+  let leverage =
+    Slv_engine.calibrate_leverage (Heston.flat Heston.default_params) ~s0 ~v0:0.04 ~r
+      local_vol ~spots ~dt:0.01 ~num_steps:100 ~num_paths:50_000 in
+  Printf.printf "Calibrated Leverage L(S,t): %.6f\n\n%!"
+    (Slv_engine.leverage_at leverage ~spot:strike ~t:tenor);
 
   (* 3. Validate Phase 13: Neural Calibration (Deep SABR) *)
   Printf.printf "=== Neural Calibration Demo ===\n%!";
@@ -54,9 +65,10 @@ let () =
 
   (* 4. Validate Phase 15: Live Market Data *)
   Printf.printf "=== Live Market Data Integration ===\n%!"; (* Callback to push updates to the stream server *)
+  let live_sig = Signature_bergomi.Streaming.create ~window_size:20 ~history:10 in
   let on_market_update (t : Market_data.ticker) =
-    let empty_big = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout 0 in
-    let manifold_state = Manifold_geometry.compute_state empty_big [] 0 in
+    Signature_bergomi.Streaming.push live_sig t.timestamp t.price;
+    let manifold_state = Manifold_geometry.compute_state_streaming live_sig in
     Lwt.async (fun () -> Research_bridge.run_async manifold_state []);
     (* In a real app, this would broadcast to websockets. For now, just log. *)
     Lwt_log.info_f ~section "Market Update: %s Price=%.2f Vol=%.2f" t.symbol t.price t.atm_vol
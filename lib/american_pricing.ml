@@ -1,6 +1,6 @@
 module LSMC = struct
   
-  (* Basic 15x15 Linear System Solver (Gaussian Elimination) *)
+  (* Basic NxN Linear System Solver (Gaussian Elimination) *)
   let solve_linear_system (a : float array array) (b : float array) =
     let n = Stdlib.Array.length b in
     for i = 0 to n - 1 do
@@ -48,13 +48,71 @@ module LSMC = struct
 
   type option_type = Call | Put
 
+  type buf = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  external lsmc_stub : buf -> buf -> int -> int -> float -> float -> float -> bool -> float
+    = "caml_lsmc_american_price_bytecode" "caml_lsmc_american_price"
+
+  (* Native [price_american] on whole blocks, as Monte_carlo.Engine's
+     simulate_native returns them: [paths] holds num_paths paths of
+     num_steps + 1 (t, S) pairs back to back, [sigs] num_paths rows of
+     regressors (row length = length / num_paths). Same backward
+     induction, run as one fused parallel pass per date with a Cholesky
+     solve; raises Invalid_argument on inconsistent sizes. *)
+  let price_block ~paths ~sigs ~num_paths ~num_steps strike r dt opt_type =
+    lsmc_stub paths sigs num_paths num_steps strike r dt (opt_type = Put)
+
+  type dates = (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  external lsmc_exercise_stub :
+    buf -> buf -> int -> int -> float -> float -> float -> bool -> dates -> float
+    = "caml_lsmc_american_exercise_bytecode" "caml_lsmc_american_exercise"
+
+  (* [price_block] plus the stopping rule it priced with: each path's first
+     exercise date in 1..num_steps (num_steps when held to maturity). Hold
+     it fixed to price on the same paths, e.g. Monte_carlo.Engine.greeks
+     ~exercise with the seed that simulated them. *)
+  let exercise_block ~paths ~sigs ~num_paths ~num_steps strike r dt opt_type =
+    let dates = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout num_paths in
+    let price =
+      lsmc_exercise_stub paths sigs num_paths num_steps strike r dt (opt_type = Put) dates
+    in
+    (price, dates)
+
+  external lsmc_chain_stub :
+    buf -> buf -> int -> int -> buf -> bool array -> float -> float -> buf -> buf -> unit
+    = "caml_lsmc_american_chain_bytecode" "caml_lsmc_american_chain"
+
+  type chain = {
+    prices : float array;  (* one per option, in input order *)
+    boundaries : buf;      (* options x (num_steps + 1) exercise boundaries *)
+  }
+
+  (* [price_block] for a whole chain of (strike, type) options on the same
+     block, one pass per date for every strike. Row k of [boundaries] holds
+     option k's largest exercised spot (put) / smallest (call) per date, nan
+     where nothing was exercised, the strike at maturity. *)
+  let price_chain ~paths ~sigs ~num_paths ~num_steps options r dt =
+    let n = Stdlib.Array.length options in
+    let strikes = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout n in
+    Stdlib.Array.iteri (fun k (strike, _) -> strikes.{k} <- strike) options;
+    let puts = Stdlib.Array.map (fun (_, opt_type) -> opt_type = Put) options in
+    let prices = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout n in
+    let boundaries =
+      Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (n * (num_steps + 1)) in
+    lsmc_chain_stub paths sigs num_paths num_steps strikes puts r dt prices boundaries;
+    { prices = Stdlib.Array.init n (fun k -> prices.{k}); boundaries }
+
   (* Aligning with Bigarray for zero-copy performance *)
   let price_american (paths : ((float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t * 
                                (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t) array) 
                      (strike : float) (r : float) (dt : float) (opt_type : option_type) =
     let num_paths = Stdlib.Array.length paths in
-    let first_path, _ = paths.(0) in
+    let first_path, first_sig = paths.(0) in
     let num_steps = Bigarray.Array1.dim first_path / 2 in
+    (* Regressor count follows the signature shape: 15 for (2, 3), more for
+       Signature.compute_signature_depth outputs *)
+    let basis = Bigarray.Array1.dim first_sig in
     
     let cash_flow = Stdlib.Array.init num_paths (fun i ->
       let path, _ = paths.(i) in
@@ -76,23 +134,29 @@ module LSMC = struct
       done;
       
       let itm_count = Stdlib.List.length !itm_indices in
-      if itm_count > 15 then begin
-        let x_itm = Stdlib.Array.make_matrix itm_count 15 0.0 in
+      if itm_count > basis then begin
+        let x_itm = Stdlib.Array.make_matrix itm_count basis 0.0 in
         let y_itm = Stdlib.Array.make itm_count 0.0 in
         Stdlib.List.iteri (fun idx i ->
           let _path, sig_out = paths.(i) in
-          for j = 0 to 14 do x_itm.(idx).(j) <- Bigarray.Array1.get sig_out j done;
+          for j = 0 to basis - 1 do x_itm.(idx).(j) <- Bigarray.Array1.get sig_out j done;
           y_itm.(idx) <- cash_flow.(i) *. discount
         ) !itm_indices;
         
         let beta = solve_regression x_itm y_itm in
         
+        let in_money = Stdlib.Array.make num_paths false in
+        Stdlib.List.iter (fun i -> in_money.(i) <- true) !itm_indices;
+        for i = 0 to num_paths - 1 do
+          if not in_money.(i) then cash_flow.(i) <- cash_flow.(i) *. discount
+        done;
+
         Stdlib.List.iter (fun i ->
           let path, sig_out = paths.(i) in
           let spot = Bigarray.Array1.get path (2 * t + 1) in
           let intrinsic = match opt_type with | Call -> spot -. strike | Put -> strike -. spot in
           let cont_value = Stdlib.ref 0.0 in
-          for j = 0 to 14 do 
+          for j = 0 to basis - 1 do 
             cont_value := !cont_value +. beta.(j) *. Bigarray.Array1.get sig_out j
           done;
           
@@ -0,0 +1,118 @@
+#include "csr_builder.h"
+#include "metrics.h"
+#include "sparse_matrix.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <vector>
+
+// =============================================================================
+// COO -> CSR Builder (counting sort, pruning, renormalization)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Turn a flat list of (from, to, prob) edges into the CSR
+   arrays the SpMV kernels want, dropping negligible transitions and
+   re-scaling each row back to a probability distribution on the way.
+
+   [HS MATH]:
+   Edges are cut into P contiguous parts. Pass 1 counts kept edges per
+   (part, row); an exclusive scan in (row, part) order turns the counts
+   into write cursors, so pass 2 scatters every part independently and
+   still lands each edge where a serial stable sort would put it.
+   Renormalization: v_ij <- v_ij / Σ_j v_ij over the kept edges of row i.
+
+   [SAFETY]:
+   - Index validation happens in pass 1, before anything is written to the
+     caller's col_indices / values.
+   - A kept count past INT_MAX is caught after the scan, also before pass
+     2, and reported as -2 so callers can tell it from a bad index (-1).
+   - The (part, row) table is P x num_nodes ints; P is capped at the pool
+     size and at num_edges / num_nodes, and is 1 for small inputs.
+*/
+
+extern "C" {
+
+int64_t coo_to_csr(const int *src, const int *dst, const double *prob,
+                   size_t num_edges, int num_nodes, double epsilon,
+                   int renormalize, int *row_ptr, int *col_indices,
+                   double *values) {
+  if (num_nodes < 0)
+    return -1;
+  QK_METRIC_SCOPE("coo_to_csr",
+                  num_edges * (2 * sizeof(int) + sizeof(double)));
+  QuantKernel::ThreadPool &pool = QuantKernel::ThreadPool::global();
+  const size_t rows = (size_t)num_nodes;
+  // Each part costs a rows-sized counter table: split only when the edges
+  // outnumber the rows enough to amortize it
+  const size_t parts = std::min(
+      {pool.size(), num_edges / QuantKernel::SPARSE_MIN_PART_ENTRIES + 1,
+       std::max<size_t>(1, num_edges / std::max<size_t>(rows, 1))});
+  auto edge_begin = [&](size_t p) { return num_edges * p / parts; };
+
+  // Pass 1: kept edges per (part, row), with index validation
+  std::vector<int> cursor(parts * rows, 0);
+  std::atomic<bool> bad{false};
+  pool.parallel_for(parts, [&](size_t p) {
+    int *count = cursor.data() + p * rows;
+    for (size_t e = edge_begin(p); e < edge_begin(p + 1); ++e) {
+      if ((unsigned)src[e] >= (unsigned)num_nodes ||
+          (unsigned)dst[e] >= (unsigned)num_nodes) {
+        bad.store(true, std::memory_order_relaxed);
+        return;
+      }
+      if (prob[e] >= epsilon)
+        ++count[src[e]];
+    }
+  });
+  if (bad.load())
+    return -1;
+
+  // Exclusive scan in (row, part) order: counts become write cursors
+  int64_t nnz = 0;
+  row_ptr[0] = 0;
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t p = 0; p < parts; ++p) {
+      int c = cursor[p * rows + r];
+      cursor[p * rows + r] = (int)nnz;
+      nnz += c;
+    }
+    row_ptr[r + 1] = (int)std::min<int64_t>(nnz, INT_MAX);
+  }
+  if (nnz > INT_MAX)
+    return -2;
+
+  // Pass 2: stable scatter, every part into its own slots
+  pool.parallel_for(parts, [&](size_t p) {
+    int *next = cursor.data() + p * rows;
+    for (size_t e = edge_begin(p); e < edge_begin(p + 1); ++e) {
+      if (prob[e] >= epsilon) {
+        int pos = next[src[e]]++;
+        col_indices[pos] = dst[e];
+        values[pos] = prob[e];
+      }
+    }
+  });
+
+  if (renormalize) {
+    const size_t row_parts =
+        QuantKernel::sparse_num_parts((size_t)nnz, pool.size());
+    pool.parallel_for(row_parts, [&](size_t p) {
+      int r0 = QuantKernel::csr_part_begin(row_ptr, num_nodes, p, row_parts);
+      int r1 =
+          QuantKernel::csr_part_begin(row_ptr, num_nodes, p + 1, row_parts);
+      for (int r = r0; r < r1; ++r) {
+        double sum = 0.0;
+        for (int k = row_ptr[r]; k < row_ptr[r + 1]; ++k)
+          sum += values[k];
+        if (sum > 0.0) {
+          const double inv = 1.0 / sum;
+          for (int k = row_ptr[r]; k < row_ptr[r + 1]; ++k)
+            values[k] *= inv;
+        }
+      }
+    });
+  }
+  return nnz;
+}
+}
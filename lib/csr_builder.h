@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+/**
+ * @brief Build a CSR transition matrix from an edge list (COO) in one go:
+ *        counting sort by source, epsilon pruning and row renormalization.
+ *
+ * Edges with prob < epsilon are dropped (same rule as Markov.prune_graph).
+ * Surviving edges keep their input order within a row, so the result is
+ * identical to a serial build whatever the thread count.
+ *
+ * @param src Source state per edge (row index).
+ * @param dst Target state per edge (column index).
+ * @param prob Transition probability per edge.
+ * @param num_edges Number of input edges.
+ * @param num_nodes Number of states (rows and columns).
+ * @param epsilon Pruning threshold (-inf or 0 keeps every edge).
+ * @param renormalize Non-zero: scale each row to sum to 1 after pruning.
+ * @param row_ptr Output: num_nodes + 1 row offsets.
+ * @param col_indices Output: capacity num_edges; first nnz entries written.
+ * @param values Output: capacity num_edges; first nnz entries written.
+ * @return nnz kept; -1 if num_nodes < 0 or an edge references a state
+ *         outside [0, num_nodes) (outputs untouched); -2 if more than
+ *         INT_MAX edges survive, which int CSR offsets cannot index
+ *         (row_ptr then unspecified, col_indices / values untouched).
+ */
+int64_t coo_to_csr(const int *src, const int *dst, const double *prob,
+                   size_t num_edges, int num_nodes, double epsilon,
+                   int renormalize, int *row_ptr, int *col_indices,
+                   double *values);
+}
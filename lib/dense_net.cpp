@@ -0,0 +1,286 @@
+#include "dense_net.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// =============================================================================
+// Dense Network Engine (loadable weights, GEMM-style forward pass)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Instead of pushing one input at a time through the
+   network, push a whole block of them: each layer then becomes one matrix
+   multiply that the CPU can stream through its vector units.
+
+   [HS MATH]:
+   Y = act(X Wᵀ + b) per layer, X is (rows x in). Weights are stored
+   transposed, [in][out_pad], so a 4-row x 64-byte output tile accumulates
+   in registers: Y[r, j:j+w] += X[r, k] * Wᵀ[k, j:j+w] over k.
+   GELU(x) = x σ(2u), u = √(2/π)(x + 0.044715 x³) (same tanh form).
+
+   [SAFETY]:
+   - Weight rows are padded to a multiple of 16 lanes (zero weights and
+     biases), so padded activations are exactly 0 and never leak.
+   - A network is immutable once built and shared via shared_ptr, so
+     in-flight batches finish on the model they started with.
+   - Scratch is thread_local and only grows: no allocation per call.
+*/
+
+namespace QuantKernel {
+
+namespace {
+
+constexpr size_t NET_LANES = 16;     // pad widths to 64 bytes of float32
+constexpr size_t NET_ROW_BLOCK = 64; // batch rows kept hot across layers
+
+size_t pad_lanes(size_t n) { return (n + NET_LANES - 1) / NET_LANES * NET_LANES; }
+
+template <class T> const T *layer_weights(const DenseNet::Layer &L) {
+  if constexpr (sizeof(T) == sizeof(double))
+    return L.wt.data();
+  else
+    return L.wt32.data();
+}
+
+template <class T> const T *layer_biases(const DenseNet::Layer &L) {
+  if constexpr (sizeof(T) == sizeof(double))
+    return L.bias.data();
+  else
+    return L.bias32.data();
+}
+
+// One 64-byte register of T (8 doubles / 16 floats) and its integer view
+template <class T> struct MlpVec;
+template <> struct MlpVec<double> {
+  typedef double vec __attribute__((vector_size(64)));
+  typedef int64_t ivec __attribute__((vector_size(64)));
+};
+template <> struct MlpVec<float> {
+  typedef float vec __attribute__((vector_size(64)));
+  typedef int32_t ivec __attribute__((vector_size(64)));
+};
+
+typedef MlpVec<double>::vec vec_f64;
+typedef MlpVec<float>::vec vec_f32;
+
+// Branch-free exp, same range reduction as the SABR surface kernel:
+// x = n ln2 + r, 2^n built in the exponent bits, Taylor on |r| <= ln2/2.
+inline vec_f64 fast_exp(vec_f64 x) {
+  typedef MlpVec<double>::ivec ivec;
+  constexpr double magic = 6755399441055744.0; // 2^52 + 2^51
+  x = x < -700.0 ? vec_f64{} - 700.0 : x;
+  x = x > 700.0 ? vec_f64{} + 700.0 : x;
+  vec_f64 t = x * 1.4426950408889634 + magic;
+  vec_f64 nf = t - magic;
+  vec_f64 r = (x - nf * 6.93147180369123816490e-01) -
+              nf * 1.90821492927058770002e-10;
+  vec_f64 p = vec_f64{} + 1.0 / 6227020800.0;
+  p = p * r + 1.0 / 479001600.0;
+  p = p * r + 1.0 / 39916800.0;
+  p = p * r + 1.0 / 3628800.0;
+  p = p * r + 1.0 / 362880.0;
+  p = p * r + 1.0 / 40320.0;
+  p = p * r + 1.0 / 5040.0;
+  p = p * r + 1.0 / 720.0;
+  p = p * r + 1.0 / 120.0;
+  p = p * r + 1.0 / 24.0;
+  p = p * r + 1.0 / 6.0;
+  p = p * r + 0.5;
+  p = p * r + 1.0;
+  p = p * r + 1.0;
+  ivec n = (ivec)t - 0x4338000000000000LL; // minus bits of magic
+  return p * (vec_f64)((n + 1023) << 52);
+}
+
+inline vec_f32 fast_exp(vec_f32 x) {
+  typedef MlpVec<float>::ivec ivec;
+  constexpr float magic = 12582912.0f; // 2^23 + 2^22
+  x = x < -87.0f ? vec_f32{} - 87.0f : x;
+  x = x > 87.0f ? vec_f32{} + 87.0f : x;
+  vec_f32 t = x * 1.44269504f + magic;
+  vec_f32 nf = t - magic;
+  vec_f32 r = (x - nf * 0.693145752f) - nf * 1.42860677e-6f;
+  vec_f32 p = vec_f32{} + 1.0f / 5040.0f;
+  p = p * r + 1.0f / 720.0f;
+  p = p * r + 1.0f / 120.0f;
+  p = p * r + 1.0f / 24.0f;
+  p = p * r + 1.0f / 6.0f;
+  p = p * r + 0.5f;
+  p = p * r + 1.0f;
+  p = p * r + 1.0f;
+  ivec n = (ivec)t - 0x4b400000; // minus bits of magic
+  return p * (vec_f32)((n + 127) << 23);
+}
+
+// GELU over a block of whole registers: x σ(2u) == 0.5 x (1 + tanh(u))
+template <class T> void gelu_inplace(T *v, size_t n) {
+  typedef typename MlpVec<T>::vec vec;
+  for (size_t i = 0; i < n; i += sizeof(vec) / sizeof(T)) {
+    vec x;
+    std::memcpy(&x, v + i, sizeof(vec));
+    vec u2 = T(1.59576912) * (x + T(0.044715) * x * x * x);
+    x = x / (T(1) + fast_exp(-u2));
+    std::memcpy(v + i, &x, sizeof(vec));
+  }
+}
+
+// Micro-kernel: R rows x one 64-byte column strip, accumulators stay in
+// registers across the whole k loop and each weight strip is loaded once
+// per R rows.
+template <class T, int R>
+inline void dense_tile(const DenseNet::Layer &L, const T *X, size_t ldx, T *Y,
+                       size_t j0) {
+  typedef typename MlpVec<T>::vec vec;
+  const size_t out_pad = L.out_pad;
+  const T *wt = layer_weights<T>(L) + j0;
+  vec acc[R];
+  vec b;
+  std::memcpy(&b, layer_biases<T>(L) + j0, sizeof(vec));
+  for (int i = 0; i < R; ++i)
+    acc[i] = b;
+  for (size_t k = 0; k < L.in; ++k) {
+    vec w;
+    std::memcpy(&w, wt + k * out_pad, sizeof(vec));
+    for (int i = 0; i < R; ++i)
+      acc[i] += X[i * ldx + k] * w;
+  }
+  for (int i = 0; i < R; ++i)
+    std::memcpy(Y + i * out_pad + j0, &acc[i], sizeof(vec));
+}
+
+// Y[rows x out_pad] = act(X[rows x ldx] Wᵀ + b)
+template <class T>
+void dense_forward(const DenseNet::Layer &L, const T *X, size_t ldx,
+                   size_t rows, T *Y) {
+  constexpr size_t strip = 64 / sizeof(T);
+  constexpr int ROW_TILE = 4;
+  const size_t out_pad = L.out_pad;
+  size_t r = 0;
+  for (; r + ROW_TILE <= rows; r += ROW_TILE)
+    for (size_t j0 = 0; j0 < out_pad; j0 += strip)
+      dense_tile<T, ROW_TILE>(L, X + r * ldx, ldx, Y + r * out_pad, j0);
+  for (; r < rows; ++r)
+    for (size_t j0 = 0; j0 < out_pad; j0 += strip)
+      dense_tile<T, 1>(L, X + r * ldx, ldx, Y + r * out_pad, j0);
+  if (L.gelu)
+    gelu_inplace(Y, rows * out_pad);
+}
+
+} // namespace
+
+void DenseNet::add_layer(size_t in, size_t out, bool gelu, const double *w,
+                         const double *b) {
+  Layer L;
+  L.in = in;
+  L.out = out;
+  L.out_pad = pad_lanes(out);
+  L.gelu = gelu;
+  L.wt.assign(in * L.out_pad, 0.0);
+  L.bias.assign(L.out_pad, 0.0);
+  for (size_t o = 0; o < out; ++o) {
+    for (size_t i = 0; i < in; ++i)
+      L.wt[i * L.out_pad + o] = w[o * in + i];
+    L.bias[o] = b[o];
+  }
+  L.wt32.assign(L.wt.begin(), L.wt.end());
+  L.bias32.assign(L.bias.begin(), L.bias.end());
+  max_width_ = std::max({max_width_, L.out_pad, pad_lanes(in)});
+  layers_.push_back(std::move(L));
+}
+
+template <class T>
+void DenseNet::forward_impl(const T *inputs, size_t batch, T *outputs) const {
+  if (layers_.empty())
+    return;
+  // Two ping-pong activation blocks per thread, grown on demand only
+  static thread_local AlignedVec<T> scratch;
+  const size_t block = NET_ROW_BLOCK * max_width_;
+  if (scratch.size() < 2 * block)
+    scratch.resize(2 * block);
+
+  const size_t in_dim = input_dim(), out_dim = output_dim();
+  for (size_t base = 0; base < batch; base += NET_ROW_BLOCK) {
+    const size_t rows = std::min(NET_ROW_BLOCK, batch - base);
+    const T *x = inputs + base * in_dim;
+    size_t ldx = in_dim;
+    T *cur = scratch.data(), *next = scratch.data() + block;
+    for (const Layer &L : layers_) {
+      dense_forward(L, x, ldx, rows, cur);
+      x = cur;
+      ldx = L.out_pad;
+      std::swap(cur, next);
+    }
+    for (size_t r = 0; r < rows; ++r)
+      std::copy(x + r * ldx, x + r * ldx + out_dim,
+                outputs + (base + r) * out_dim);
+  }
+}
+
+void DenseNet::forward(const double *inputs, size_t batch,
+                       double *outputs) const {
+  forward_impl(inputs, batch, outputs);
+}
+
+void DenseNet::forward(const float *inputs, size_t batch,
+                       float *outputs) const {
+  forward_impl(inputs, batch, outputs);
+}
+
+std::shared_ptr<const DenseNet> DenseNet::load(const char *path,
+                                               int *status) {
+  auto fail = [&](int code) -> std::shared_ptr<const DenseNet> {
+    if (status != nullptr)
+      *status = code;
+    return nullptr;
+  };
+
+  std::ifstream in(path);
+  if (!in)
+    return fail(-1);
+
+  // Strip '#' comments, then parse as one token stream
+  std::string text, line;
+  while (std::getline(in, line)) {
+    size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.resize(hash);
+    text += line;
+    text += '\n';
+  }
+  std::istringstream ts(text);
+
+  std::string tag, act;
+  int version = 0;
+  size_t num_layers = 0;
+  if (!(ts >> tag >> version) || tag != "qkmlp" || version != 1)
+    return fail(-2);
+  if (!(ts >> tag >> num_layers) || tag != "layers" || num_layers == 0)
+    return fail(-2);
+
+  auto net = std::make_shared<DenseNet>();
+  std::vector<double> w, b;
+  for (size_t l = 0; l < num_layers; ++l) {
+    size_t n_in = 0, n_out = 0;
+    if (!(ts >> tag >> n_in >> n_out >> act) || tag != "dense")
+      return fail(-2);
+    if (n_in == 0 || n_out == 0 || (l > 0 && n_in != net->output_dim()) ||
+        (act != "gelu" && act != "linear"))
+      return fail(-2);
+    w.resize(n_in * n_out);
+    b.resize(n_out);
+    for (double &v : w)
+      if (!(ts >> v))
+        return fail(-2);
+    for (double &v : b)
+      if (!(ts >> v))
+        return fail(-2);
+    net->add_layer(n_in, n_out, act == "gelu", w.data(), b.data());
+  }
+  if (status != nullptr)
+    *status = 0;
+  return net;
+}
+
+} // namespace QuantKernel
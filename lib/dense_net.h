@@ -0,0 +1,60 @@
+#pragma once
+
+#include "kernel_util.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+/**
+ * Dense feed-forward network with a dependency-free weight format.
+ *
+ * Weight file ("qkmlp" v1), whitespace separated, '#' starts a comment:
+ *
+ *     qkmlp 1
+ *     layers <L>
+ *     dense <in> <out> <gelu|linear>     (repeated L times, each followed by)
+ *     <out * in weights, row-major [out][in]> <out biases>
+ *
+ * i.e. exactly what numpy's W.ravel() / b print for a PyTorch nn.Linear.
+ * Consecutive layers must chain (in == previous out).
+ *
+ * Weights are kept transposed ([in][out_pad]), 64-byte aligned and padded
+ * to 16 lanes, in f64 and f32 copies. forward() runs each layer as a
+ * register-tiled GEMM over blocks of 64 rows and uses a per-thread scratch
+ * buffer that only grows, so steady-state calls allocate nothing.
+ */
+class DenseNet {
+public:
+  struct Layer {
+    size_t in = 0, out = 0, out_pad = 0;
+    bool gelu = false;
+    AlignedVec<double> wt, bias; // wt is [in][out_pad]
+    AlignedVec<float> wt32, bias32;
+  };
+
+  /// status: 0 ok, -1 unreadable file, -2 malformed file. nullptr on error.
+  static std::shared_ptr<const DenseNet> load(const char *path, int *status);
+
+  /// Append a layer; w is row-major [out][in].
+  void add_layer(size_t in, size_t out, bool gelu, const double *w,
+                 const double *b);
+
+  size_t input_dim() const { return layers_.empty() ? 0 : layers_[0].in; }
+  size_t output_dim() const { return layers_.empty() ? 0 : layers_.back().out; }
+
+  /// inputs: batch x input_dim, outputs: batch x output_dim (row-major).
+  void forward(const double *inputs, size_t batch, double *outputs) const;
+  void forward(const float *inputs, size_t batch, float *outputs) const;
+
+private:
+  template <class T>
+  void forward_impl(const T *inputs, size_t batch, T *outputs) const;
+
+  std::vector<Layer> layers_;
+  size_t max_width_ = 0; // widest padded activation
+};
+
+} // namespace QuantKernel
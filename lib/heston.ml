@@ -41,3 +41,54 @@ let simulate_step current_price current_vol dt params =
   let next_price = current_price +. ds in
   
   (next_price, next_vol)
+
+(* Native batched engine (heston_mc.cpp): Andersen QE variance step,
+   martingale-corrected log-spot step, W paths per SIMD register. *)
+
+type term_structure = (float * params) list
+
+let flat params = [ (infinity, params) ]
+
+type buf = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+type simulation = {
+  paths : buf;
+  variance : buf;
+  terminal : buf;
+}
+
+external heston_mc_stub :
+  buf -> float -> float -> float -> int -> int -> int -> int -> bool -> buf -> buf ->
+  buf -> int = "caml_heston_mc_simulate_bytecode" "caml_heston_mc_simulate"
+
+let empty : buf = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout 0
+
+(* One 64-byte HestonParams per piece: t_end, mu, kappa, theta, xi, rho, pad *)
+let pieces_buffer (term : term_structure) =
+  let b = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (8 * List.length term) in
+  Bigarray.Array1.fill b 0.0;
+  List.iteri (fun i (t_end, p) ->
+      let o = 8 * i in
+      b.{o} <- t_end;
+      b.{o + 1} <- p.mu;
+      b.{o + 2} <- p.kappa;
+      b.{o + 3} <- p.theta;
+      b.{o + 4} <- p.xi;
+      b.{o + 5} <- p.rho) term;
+  b
+
+let simulate ?(seed = Random.bits ()) ?(first_path = 0) ?(qmc = false)
+    ?(store_paths = false) ?(store_variance = false) (term : term_structure) ~s0 ~v0 ~dt
+    ~num_steps ~num_paths =
+  let block enabled n =
+    if enabled then Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout n else empty
+  in
+  let paths = block store_paths (num_paths * 2 * (num_steps + 1)) in
+  let variance = block store_variance (num_paths * (num_steps + 1)) in
+  let terminal = block true (num_paths * 2) in
+  match heston_mc_stub (pieces_buffer term) s0 v0 dt num_steps num_paths seed first_path
+          qmc paths variance terminal with
+  | 0 -> { paths; variance; terminal }
+  | -1 -> invalid_arg "Heston.simulate: num_steps > 2048 in QMC mode"
+  | -2 -> invalid_arg "Heston.simulate: path index >= 2^32 in QMC mode"
+  | _ -> invalid_arg "Heston.simulate: invalid term structure"
@@ -14,3 +14,40 @@ val default_params : params
 (** Simulates a single time step of the Heston process. 
     Returns (next_price, next_vol). *)
 val simulate_step : float -> float -> float -> params -> float * float
+
+(** Piecewise-constant parameters as [(t_end, p)] pieces with increasing
+    [t_end]: a piece applies to steps starting before its [t_end], the last
+    one also to everything after. *)
+type term_structure = (float * params) list
+
+(** The same parameters at every tenor *)
+val flat : params -> term_structure
+
+type buf = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+(** The native layout of a term structure: one 64-byte HestonParams (8
+    doubles: t_end, mu, kappa, theta, xi, rho, padding) per piece. *)
+val pieces_buffer : term_structure -> buf
+
+(** Native simulation output. [paths]: num_paths x (num_steps + 1) (t, S)
+    pairs (the signature kernels' layout); [variance]: num_paths x
+    (num_steps + 1) variances; both empty unless requested. [terminal]:
+    num_paths (S_T, V_T) pairs. *)
+type simulation = {
+  paths : buf;
+  variance : buf;
+  terminal : buf;
+}
+
+(** Simulates [num_paths] Heston paths natively: Andersen's QE scheme for
+    the variance (never negative) with a martingale-corrected spot step,
+    several paths per SIMD register across the native thread pool. Paths
+    depend only on ([seed], global path index), so runs can be split with
+    [first_path]. [qmc] switches to scrambled Sobol normals through a
+    Brownian bridge ([seed] is then the scramble seed). Raises
+    Invalid_argument on an invalid term structure or QMC limits (2048
+    steps, 2^32 paths). *)
+val simulate :
+  ?seed:int -> ?first_path:int -> ?qmc:bool -> ?store_paths:bool ->
+  ?store_variance:bool -> term_structure -> s0:float -> v0:float -> dt:float ->
+  num_steps:int -> num_paths:int -> simulation
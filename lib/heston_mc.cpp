@@ -0,0 +1,217 @@
+#include "heston_mc.h"
+#include "heston_qe.h"
+#include "mc_random.h"
+#include "metrics.h"
+#include "signature_kernel.h"
+#include "simd_math.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// =============================================================================
+// Heston Monte Carlo Path Engine (Andersen QE, SIMD across paths)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Generates Heston price / variance paths W at a time,
+   one path per SIMD lane, on the same random sources as the SABR engine.
+   The variance step samples a distribution matched to the true one's
+   first two moments, so V never goes negative and large steps stay
+   accurate; the spot step is tuned so the discounted price is an exact
+   martingale on the time grid.
+
+   [HS MATH]:
+   Step n -> n + 1, Δ = dt, normals (z_V, z_S) independent, piece params
+   (μ, κ, θ, ξ, ρ) of the step's start time. With e = exp(-κΔ):
+     m  = θ + (V - θ) e
+     s² = V ξ² e (1 - e) / κ + θ ξ² (1 - e)² / (2κ),   ψ = s² / m²
+   ψ <= 1.5 (quadratic):   b² = 2/ψ - 1 + √(2/ψ (2/ψ - 1)),  a = m / (1 + b²)
+                           V' = a (b + z_V)²
+   ψ >  1.5 (exponential): p = (ψ - 1)/(ψ + 1),  β = (1 - p) / m
+                           1 - U = Φ(-z_V) = ½ erfc(z_V / √2)
+                           V' = 0 if 1 - U >= 1 - p, else log((1-p)/(1-U)) / β
+   Log spot, central weights γ1 = γ2 = ½:
+     K1 = ½Δ (κρ/ξ - ½) - ρ/ξ,  K2 = ½Δ (κρ/ξ - ½) + ρ/ξ,  K3 = K4 = ½Δ (1 - ρ²)
+     A  = K2 + ½ K4
+     K0* = -A b² a / (1 - 2Aa) + ½ log(1 - 2Aa) - (K1 + ½K3) V     (quadratic)
+         = -log(p + β (1-p) / (β - A))         - (K1 + ½K3) V     (exponential)
+     log S' = log S + μΔ + K0* + K1 V + K2 V' + √(K3 V + K4 V') z_S
+   K0* needs 2Aa < 1 (resp. A < β); where that fails (very large ρξΔ) the
+   plain K0 = -ρκθΔ/ξ is used for that lane.
+
+   [SAFETY]:
+   - κ and ξ are floored at 1e-8 so (1 - e)/κ and ρ/ξ stay finite; a
+     flat (ξ → 0) variance then follows its mean exactly.
+   - m and ψ are floored (1e-300, 1e-12): V = θ = 0 stays at 0 without
+     0/0.
+   - Φ(-z_V) is floored at 1e-300 before the log.
+*/
+namespace {
+
+using QuantKernel::Lanes;
+using QuantKernel::MC_TILE;
+using QuantKernel::QePiece;
+
+constexpr size_t HESTON_CHUNK = 64; // paths per thread-pool task
+
+struct HestonSetup {
+  double s0, v0, dt;
+  size_t num_steps;
+  std::vector<QePiece> pieces;
+  QuantKernel::NormalSource normals;
+};
+
+// W paths driven by `normals`; only the first `valid` lanes are written.
+// Output pointers are at lane 0's block (any may be null).
+template <int W, class Normals>
+__attribute__((always_inline)) inline void
+heston_lanes(const HestonSetup &h, Normals &normals, size_t valid,
+             double *paths, double *variance, double *terminal) {
+  typedef typename Lanes<W>::vec vec;
+
+  const size_t stride = h.num_steps + 1;
+  vec x = vec{} + std::log(h.s0);
+  vec V = vec{} + h.v0;
+
+  for (size_t w = 0; w < valid; ++w) {
+    if (paths) {
+      paths[w * 2 * stride] = 0.0;
+      paths[w * 2 * stride + 1] = h.s0;
+    }
+    if (variance)
+      variance[w * stride] = h.v0;
+  }
+
+  const vec *z = nullptr;
+  for (const QePiece &q : h.pieces) {
+    for (size_t n = q.step_begin; n < q.step_end; ++n) {
+      if (n % MC_TILE == 0)
+        z = normals.tile(n, std::min(MC_TILE, h.num_steps - n));
+      const vec zv = z[2 * (n % MC_TILE)], zs = z[2 * (n % MC_TILE) + 1];
+
+      vec v_new, k0;
+      QuantKernel::qe_step<W>(q, V, zv, v_new, k0);
+      x += q.drift + k0 + q.k1 * V + q.k2 * v_new +
+           QuantKernel::vsqrt<W>(q.k3 * (V + v_new)) * zs;
+      V = v_new;
+
+      if (paths || variance) {
+        const double t = (double)(n + 1) * h.dt;
+        vec S = QuantKernel::vexp<W>(x);
+        for (size_t w = 0; w < valid; ++w) {
+          if (paths) {
+            paths[w * 2 * stride + 2 * (n + 1)] = t;
+            paths[w * 2 * stride + 2 * (n + 1) + 1] = S[w];
+          }
+          if (variance)
+            variance[w * stride + n + 1] = V[w];
+        }
+      }
+    }
+  }
+
+  if (terminal) {
+    vec S = QuantKernel::vexp<W>(x);
+    for (size_t w = 0; w < valid; ++w) {
+      terminal[2 * w] = S[w];
+      terminal[2 * w + 1] = V[w];
+    }
+  }
+}
+
+// Paths [begin, end) of this call (global index first_path + i)
+template <int W>
+__attribute__((always_inline)) inline void
+heston_range(const HestonSetup &h, uint64_t first_path, size_t begin,
+             size_t end, double *out_paths, double *out_variance,
+             double *out_terminal) {
+  const size_t stride = h.num_steps + 1;
+  QuantKernel::for_each_path_block<W>(
+      h.normals, first_path, begin, end,
+      [&](auto &normals, size_t p) __attribute__((always_inline)) {
+        heston_lanes<W>(h, normals, std::min<size_t>(W, end - p),
+                        out_paths ? out_paths + 2 * stride * p : nullptr,
+                        out_variance ? out_variance + stride * p : nullptr,
+                        out_terminal ? out_terminal + 2 * p : nullptr);
+      });
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HESTON_MC_X86_DISPATCH 1
+
+__attribute__((target("avx2,fma"))) void
+heston_range_avx2(const HestonSetup &h, uint64_t first_path, size_t begin,
+                  size_t end, double *out_paths, double *out_variance,
+                  double *out_terminal) {
+  heston_range<4>(h, first_path, begin, end, out_paths, out_variance,
+                  out_terminal);
+}
+
+__attribute__((target("avx512f"))) void
+heston_range_avx512(const HestonSetup &h, uint64_t first_path, size_t begin,
+                    size_t end, double *out_paths, double *out_variance,
+                    double *out_terminal) {
+  heston_range<8>(h, first_path, begin, end, out_paths, out_variance,
+                  out_terminal);
+}
+#endif
+
+} // namespace
+
+extern "C" {
+
+int heston_mc_simulate(const HestonParams *pieces, size_t num_pieces,
+                       double s0, double v0, double dt, size_t num_steps,
+                       size_t num_paths, uint64_t seed, uint64_t first_path,
+                       int qmc, double *out_paths, double *out_variance,
+                       double *out_terminal) {
+  if (!QuantKernel::qe_pieces_valid(pieces, num_pieces))
+    return -3;
+  if (qmc && 2 * num_steps > QuantKernel::SOBOL_MAX_DIMS)
+    return -1;
+  if (qmc && first_path + num_paths > (1ULL << QuantKernel::SOBOL_BITS))
+    return -2;
+  if (num_paths == 0 || (!out_paths && !out_variance && !out_terminal))
+    return 0;
+  QK_METRIC_SCOPE("heston_mc_simulate",
+                  num_paths *
+                      ((out_paths ? 2 * (num_steps + 1) : 0) +
+                       (out_variance ? num_steps + 1 : 0) +
+                       (out_terminal ? 2 : 0)) *
+                      sizeof(double));
+
+  HestonSetup h{.s0 = s0,
+                .v0 = std::max(v0, 0.0),
+                .dt = dt,
+                .num_steps = num_steps,
+                .pieces = QuantKernel::qe_pieces(pieces, num_pieces, dt,
+                                                 num_steps),
+                .normals = QuantKernel::NormalSource(seed, num_steps, qmc)};
+
+  const int isa = signature_kernel_isa();
+  const size_t chunks = (num_paths + HESTON_CHUNK - 1) / HESTON_CHUNK;
+  QuantKernel::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+    const size_t begin = c * HESTON_CHUNK;
+    const size_t end = std::min(num_paths, begin + HESTON_CHUNK);
+#ifdef HESTON_MC_X86_DISPATCH
+    switch (isa) {
+    case 2:
+      heston_range_avx512(h, first_path, begin, end, out_paths, out_variance,
+                          out_terminal);
+      return;
+    case 1:
+      heston_range_avx2(h, first_path, begin, end, out_paths, out_variance,
+                        out_terminal);
+      return;
+    default:
+      break;
+    }
+#else
+    (void)isa;
+#endif
+    heston_range<4>(h, first_path, begin, end, out_paths, out_variance,
+                    out_terminal);
+  });
+  return 0;
+}
+}
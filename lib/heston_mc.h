@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+
+/// One piece of a piecewise-constant Heston term structure (64 bytes, the
+/// ModelParams layout: OCaml fills 8 doubles per piece).
+struct alignas(64) HestonParams {
+  double t_end; // applies to steps starting before t_end (years)
+  double mu;    // drift of S
+  double kappa; // mean reversion speed of V
+  double theta; // long-run variance
+  double xi;    // vol of variance
+  double rho;   // corr(dW_S, dW_V)
+  double padding[2];
+};
+
+/**
+ * @brief Simulate Heston paths natively, several paths per SIMD register.
+ *
+ *   dS = μ S dt + √V S dW_S,   dV = κ (θ - V) dt + ξ √V dW_V,
+ *   dW_S dW_V = ρ dt
+ *
+ * Andersen's Quadratic-Exponential scheme for V (non-negative, moment
+ * matched) with the martingale-corrected log-spot step, so E[S_{n+1} | S_n]
+ * = S_n e^{μΔ} exactly. Gaussians come from the same sources as the SABR
+ * engine (sabr_mc_simulate / sabr_qmc_simulate): deterministic per
+ * (seed, path index), so chunked runs match a single run.
+ *
+ * @param pieces Term structure: piece k applies to steps whose start time
+ *               is below pieces[k].t_end (increasing); the last piece
+ *               also covers everything after it.
+ * @param num_pieces At least 1.
+ * @param s0 Initial spot.
+ * @param v0 Initial variance.
+ * @param dt Time step in years.
+ * @param num_steps Steps per path.
+ * @param num_paths Paths to simulate in this call.
+ * @param seed Philox key, or Sobol scramble seed when qmc != 0.
+ * @param first_path Global index of the first path.
+ * @param qmc Non-zero: scrambled Sobol + Brownian bridge normals.
+ * @param out_paths num_paths x (num_steps + 1) (t, S) pairs, or nullptr.
+ * @param out_variance num_paths x (num_steps + 1) variances, or nullptr.
+ * @param out_terminal num_paths (S_T, V_T) pairs, or nullptr.
+ * @return 0 on success, -1 if qmc and 2 * num_steps exceeds 4096, -2 if
+ *         qmc and first_path + num_paths exceeds 2^32, -3 on an invalid
+ *         term structure (no pieces, t_end not increasing, κ, θ or ξ
+ *         negative, |ρ| > 1).
+ */
+int heston_mc_simulate(const HestonParams *pieces, size_t num_pieces,
+                       double s0, double v0, double dt, size_t num_steps,
+                       size_t num_paths, uint64_t seed, uint64_t first_path,
+                       int qmc, double *out_paths, double *out_variance,
+                       double *out_terminal);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "heston_mc.h"
+#include "simd_math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+// Andersen QE step of the Heston variance, shared by the native Heston
+// engine (heston_mc.cpp, where the scheme is written out) and the SLV
+// calibrator (slv.cpp).
+
+constexpr double QE_PSI_C = 1.5;
+
+// Step constants of one term-structure piece, over steps [step_begin,
+// step_end)
+struct QePiece {
+  size_t step_begin, step_end;
+  double e, c1, c2, theta_1me; // m = V e + θ (1 - e), s² = V c1 + c2
+  double drift, k0, k1, k2, k3, a_mart, k13;
+};
+
+inline QePiece qe_piece(const HestonParams &p, double dt) {
+  QePiece q{};
+  const double kappa = std::max(p.kappa, 1e-8);
+  const double xi = std::max(p.xi, 1e-8);
+  const double one_me = -std::expm1(-kappa * dt);
+  q.e = 1.0 - one_me;
+  q.c1 = xi * xi * q.e * one_me / kappa;
+  q.c2 = p.theta * xi * xi * one_me * one_me / (2.0 * kappa);
+  q.theta_1me = p.theta * one_me;
+  q.drift = p.mu * dt;
+  q.k0 = -p.rho * kappa * p.theta * dt / xi;
+  const double g = 0.5 * dt * (kappa * p.rho / xi - 0.5);
+  q.k1 = g - p.rho / xi;
+  q.k2 = g + p.rho / xi;
+  q.k3 = 0.5 * dt * (1.0 - p.rho * p.rho);
+  q.a_mart = q.k2 + 0.5 * q.k3;
+  q.k13 = q.k1 + 0.5 * q.k3;
+  return q;
+}
+
+// Valid term structure: κ, θ, ξ >= 0, |ρ| <= 1, increasing t_end
+inline bool qe_pieces_valid(const HestonParams *pieces, size_t num_pieces) {
+  if (num_pieces == 0)
+    return false;
+  for (size_t k = 0; k < num_pieces; ++k) {
+    const HestonParams &p = pieces[k];
+    if (!(p.kappa >= 0.0 && p.theta >= 0.0 && p.xi >= 0.0 &&
+          std::fabs(p.rho) <= 1.0) ||
+        (k > 0 && !(p.t_end > pieces[k - 1].t_end)))
+      return false;
+  }
+  return true;
+}
+
+// Step ranges of a term structure on the grid n dt, n < num_steps; pieces
+// that cover no step are dropped.
+inline std::vector<QePiece> qe_pieces(const HestonParams *pieces,
+                                      size_t num_pieces, double dt,
+                                      size_t num_steps) {
+  std::vector<QePiece> out;
+  size_t step = 0;
+  for (size_t k = 0; k < num_pieces && step < num_steps; ++k) {
+    size_t end = num_steps;
+    if (k + 1 < num_pieces) {
+      // Steps starting strictly before t_end (1e-9 guards t_end = n dt)
+      const double n_end = std::ceil(pieces[k].t_end / dt - 1e-9);
+      end = n_end <= (double)step ? step
+            : n_end >= (double)num_steps ? num_steps
+                                         : (size_t)n_end;
+    }
+    if (end == step)
+      continue;
+    QePiece q = qe_piece(pieces[k], dt);
+    q.step_begin = step;
+    q.step_end = end;
+    out.push_back(q);
+    step = end;
+  }
+  return out;
+}
+
+// V -> V' for W lanes driven by z_V; k0 gets the martingale constant of
+// the log-spot step (K0* where defined, plain K0 elsewhere). Callers that
+// only need V' let the K0* arithmetic fold away.
+template <int W>
+__attribute__((always_inline)) inline void
+qe_step(const QePiece &q, typename Lanes<W>::vec V, typename Lanes<W>::vec zv,
+        typename Lanes<W>::vec &v_new, typename Lanes<W>::vec &k0) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+
+  vec m = V * q.e + q.theta_1me;
+  m = m > 1e-300 ? m : vec{} + 1e-300;
+  vec psi = (V * q.c1 + q.c2) / (m * m);
+  psi = psi > 1e-12 ? psi : vec{} + 1e-12;
+  const ivec quad = psi <= QE_PSI_C;
+
+  // Quadratic branch (other lanes evaluate a harmless ψ = 1)
+  vec inv = 2.0 / (quad ? psi : vec{} + 1.0);
+  vec b2 = inv - 1.0 + vsqrt<W>(inv * (inv - 1.0));
+  vec a = m / (1.0 + b2);
+  vec bz = vsqrt<W>(b2) + zv;
+  vec v_quad = a * bz * bz;
+  vec one_m2aa = 1.0 - 2.0 * q.a_mart * a;
+  const ivec quad_ok = one_m2aa > 0.0;
+  vec k_quad = -q.a_mart * b2 * a / (quad_ok ? one_m2aa : vec{} + 1.0) +
+               0.5 * vlog<W>(quad_ok ? one_m2aa : vec{} + 1.0);
+
+  v_new = v_quad;
+  vec k_star = k_quad;
+  ivec corrected = quad_ok;
+  bool any_exp = false;
+  for (int w = 0; w < W; ++w)
+    any_exp |= !quad[w];
+  if (any_exp) {
+    // Exponential branch (other lanes evaluate a harmless ψ = 3)
+    vec pe = quad ? vec{} + 3.0 : psi;
+    vec p = (pe - 1.0) / (pe + 1.0);
+    vec beta = (1.0 - p) / m;
+    vec surv = 0.5 * verfc<W>(zv * 0.7071067811865476);
+    surv = surv > 1e-300 ? surv : vec{} + 1e-300;
+    const ivec hit = surv < 1.0 - p;
+    vec ratio = hit ? (1.0 - p) / surv : vec{} + 1.0;
+    vec v_exp = vlog<W>(ratio) / beta;
+    v_exp = hit ? v_exp : vec{};
+    const ivec exp_ok = beta > q.a_mart;
+    vec k_exp = -vlog<W>(
+        p + beta * (1.0 - p) / (exp_ok ? beta - q.a_mart : vec{} + 1.0));
+    v_new = quad ? v_new : v_exp;
+    k_star = quad ? k_star : k_exp;
+    corrected = quad ? corrected : exp_ok;
+  }
+
+  k0 = corrected ? k_star - q.k13 * V : vec{} + q.k0;
+}
+
+} // namespace QuantKernel
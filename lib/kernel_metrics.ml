@@ -0,0 +1,43 @@
+(* Always-on latency histograms of the native kernels. Each instrumented
+   entry point records per thread; a snapshot merges every thread. *)
+
+type summary = {
+  name : string;
+  calls : int;
+  bytes : float;
+  mean_ns : float;
+  p50_ns : float;
+  p99_ns : float;
+  p999_ns : float;
+  max_ns : float;
+}
+
+(* [(name, [|calls; bytes; mean; p50; p99; p999; max|])] per kernel *)
+external snapshot_stub : unit -> (string * float array) array = "caml_metrics_snapshot"
+
+let snapshot () =
+  snapshot_stub ()
+  |> Array.to_list
+  |> List.map (fun (name, s) ->
+         { name; calls = int_of_float s.(0); bytes = s.(1); mean_ns = s.(2);
+           p50_ns = s.(3); p99_ns = s.(4); p999_ns = s.(5); max_ns = s.(6) })
+
+(* Kernels that have been called at least once, as the [metrics] reply of
+   the stream server. *)
+let to_json () =
+  let kernels =
+    snapshot ()
+    |> List.filter (fun s -> s.calls > 0)
+    |> List.map (fun s ->
+           `Assoc [
+             ("name", `String s.name);
+             ("calls", `Int s.calls);
+             ("bytes", `Float s.bytes);
+             ("mean_ns", `Float s.mean_ns);
+             ("p50_ns", `Float s.p50_ns);
+             ("p99_ns", `Float s.p99_ns);
+             ("p999_ns", `Float s.p999_ns);
+             ("max_ns", `Float s.max_ns);
+           ])
+  in
+  `Assoc [ ("type", `String "metrics"); ("kernels", `List kernels) ]
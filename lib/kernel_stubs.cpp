@@ -1,25 +1,602 @@
 #include <caml/alloc.h>
 #include <caml/bigarray.h>
 #include <caml/custom.h>
+#include <caml/fail.h>
 #include <caml/memory.h>
 #include <caml/mlvalues.h>
+#include <caml/signals.h>
 
+#include "csr_builder.h"
+#include "heston_mc.h"
+#include "local_vol.h"
+#include "lsmc.h"
+#include "markov_engine.h"
+#include "metrics.h"
+#include "neural_calib.h"
+#include "sabr_calibration.h"
 #include "sabr_kernel.h"
+#include "sabr_mc.h"
+#include "signature_engine.h"
 #include "signature_kernel.h"
+#include "slv.h"
+#include "sparse_matrix.h"
+#include "streaming_signature.h"
+#include "tracer.h"
+
+#include <string>
 
 extern "C" {
-// Neural Calibration Stub
+// Neural Calibration Stub (batch = input length / 7)
 // external calibrate_sabr : Bigarray.float64 -> Bigarray.float64 -> unit
 CAMLprim value caml_calibrate_sabr(value v_input, value v_output) {
+  size_t input_len = Caml_ba_array_val(v_input)->dim[0];
+  size_t batch = input_len / 7;
+  if (input_len % 7 != 0 ||
+      Caml_ba_array_val(v_output)->dim[0] < (intnat)(4 * batch))
+    caml_invalid_argument("Neural_calibrate.calibrate_sabr: bad sizes");
   double *input = (double *)Caml_ba_data_val(v_input);
   double *output = (double *)Caml_ba_data_val(v_output);
 
-  extern void c_calibrate_sabr(const double *input, double *output);
-  c_calibrate_sabr(input, output);
+  c_calibrate_sabr_batch(input, batch, output);
+
+  return Val_unit;
+}
+
+// external calibrate_sabr_f32 : Bigarray.float32 -> Bigarray.float32 -> unit
+CAMLprim value caml_calibrate_sabr_f32(value v_input, value v_output) {
+  size_t input_len = Caml_ba_array_val(v_input)->dim[0];
+  size_t batch = input_len / 7;
+  if (input_len % 7 != 0 ||
+      Caml_ba_array_val(v_output)->dim[0] < (intnat)(4 * batch))
+    caml_invalid_argument("Neural_calibrate.calibrate_sabr_f32: bad sizes");
+  float *input = (float *)Caml_ba_data_val(v_input);
+  float *output = (float *)Caml_ba_data_val(v_output);
+
+  c_calibrate_sabr_batch_f32(input, batch, output);
+
+  return Val_unit;
+}
+
+// external load_weights : string -> unit (raises Failure)
+CAMLprim value caml_neural_calib_load_weights(value v_path) {
+  CAMLparam1(v_path);
+  if (neural_calib_load_weights(String_val(v_path)) != 0)
+    caml_failwith("Neural_calibrate.load_weights: cannot load weight file");
+  CAMLreturn(Val_unit);
+}
+
+// Batch SABR Surface
+// external sabr_implied_vol_surface : Bigarray.float64 -> Bigarray.float64 ->
+// Bigarray.float64 -> Bigarray.float64 -> Bigarray.float64 -> unit
+// params is a Memory_bridge buffer (8 doubles per ModelParams); tenors
+// matches forwards and out holds num_params x num_tenors x num_strikes.
+CAMLprim value caml_sabr_implied_vol_surface(value v_params, value v_forwards,
+                                             value v_tenors, value v_strikes,
+                                             value v_out) {
+  const ModelParams *params = (const ModelParams *)Caml_ba_data_val(v_params);
+  size_t num_params = Caml_ba_array_val(v_params)->dim[0] /
+                      (sizeof(ModelParams) / sizeof(double));
+  size_t num_tenors = Caml_ba_array_val(v_forwards)->dim[0];
+  size_t num_strikes = Caml_ba_array_val(v_strikes)->dim[0];
+  if ((size_t)Caml_ba_array_val(v_tenors)->dim[0] != num_tenors ||
+      (size_t)Caml_ba_array_val(v_out)->dim[0] <
+          num_params * num_tenors * num_strikes)
+    caml_invalid_argument("Sabr.Surface.implied_vol_surface: bad sizes");
+
+  sabr_implied_vol_surface(params, num_params,
+                           (double *)Caml_ba_data_val(v_forwards),
+                           (double *)Caml_ba_data_val(v_tenors), num_tenors,
+                           (double *)Caml_ba_data_val(v_strikes), num_strikes,
+                           (double *)Caml_ba_data_val(v_out));
 
   return Val_unit;
 }
 
+// SABR Chain Calibration (CSR smiles, LM per smile, thread pool)
+// external sabr_calibrate_chain : Bigarray.float64 -> Bigarray.float64 ->
+// Bigarray.float64 -> Bigarray.int32 -> Bigarray.float64 -> Bigarray.float64 ->
+// Bigarray.float64 -> Bigarray.float64 -> int -> unit
+// An empty weights Bigarray means equal weights. Offsets must start at 0 or
+// above and never decrease.
+CAMLprim value caml_sabr_calibrate_chain(value v_strikes, value v_vols,
+                                         value v_weights, value v_offsets,
+                                         value v_forwards, value v_tenors,
+                                         value v_params, value v_rmse,
+                                         value v_max_iters) {
+  CAMLparam5(v_strikes, v_vols, v_weights, v_offsets, v_forwards);
+  CAMLxparam3(v_tenors, v_params, v_rmse);
+  size_t num_smiles = Caml_ba_array_val(v_forwards)->dim[0];
+  size_t num_quotes = Caml_ba_array_val(v_strikes)->dim[0];
+  size_t weights_len = Caml_ba_array_val(v_weights)->dim[0];
+  if ((size_t)Caml_ba_array_val(v_tenors)->dim[0] < num_smiles ||
+      (size_t)Caml_ba_array_val(v_offsets)->dim[0] != num_smiles + 1 ||
+      (size_t)Caml_ba_array_val(v_params)->dim[0] < 8 * num_smiles ||
+      (size_t)Caml_ba_array_val(v_rmse)->dim[0] < num_smiles ||
+      (size_t)Caml_ba_array_val(v_vols)->dim[0] < num_quotes ||
+      (weights_len > 0 && weights_len < num_quotes))
+    caml_invalid_argument("Sabr.Calibrator.calibrate_chain: bad sizes");
+  const int *offsets = (int *)Caml_ba_data_val(v_offsets);
+  for (size_t s = 0; s < num_smiles; ++s)
+    if (offsets[s] < 0 || offsets[s + 1] < offsets[s])
+      caml_invalid_argument("Sabr.Calibrator.calibrate_chain: bad offsets");
+  if ((size_t)offsets[num_smiles] > num_quotes)
+    caml_invalid_argument("Sabr.Calibrator.calibrate_chain: bad offsets");
+
+  const double *strikes = (const double *)Caml_ba_data_val(v_strikes);
+  const double *vols = (const double *)Caml_ba_data_val(v_vols);
+  const double *weights =
+      weights_len > 0 ? (const double *)Caml_ba_data_val(v_weights) : nullptr;
+  const double *forwards = (const double *)Caml_ba_data_val(v_forwards);
+  const double *tenors = (const double *)Caml_ba_data_val(v_tenors);
+  ModelParams *params = (ModelParams *)Caml_ba_data_val(v_params);
+  double *rmse = (double *)Caml_ba_data_val(v_rmse);
+  int max_iters = Long_val(v_max_iters);
+
+  // Bigarray data never moves: calibrate without the runtime lock
+  caml_enter_blocking_section();
+  sabr_calibrate_chain(strikes, vols, weights, offsets, num_smiles, forwards,
+                       tenors, params, rmse, max_iters);
+  caml_leave_blocking_section();
+
+  CAMLreturn(Val_unit);
+}
+
+CAMLprim value caml_sabr_calibrate_chain_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_sabr_calibrate_chain(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                   argv[5], argv[6], argv[7], argv[8]);
+}
+
+// Native SABR Monte Carlo (Philox RNG, SIMD across paths, thread pool)
+// external sabr_mc_simulate : Bigarray.float64 -> float -> float -> int ->
+// int -> int -> int -> Bigarray.float64 -> Bigarray.float64 -> unit
+// params is a Memory_bridge buffer (one ModelParams); an empty paths or
+// signatures Bigarray means "do not produce it".
+CAMLprim value caml_sabr_mc_simulate(value v_params, value v_s0, value v_dt,
+                                     value v_num_steps, value v_num_paths,
+                                     value v_seed, value v_first_path,
+                                     value v_paths, value v_sigs) {
+  CAMLparam3(v_params, v_paths, v_sigs);
+  size_t num_steps = Long_val(v_num_steps);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t paths_len = Caml_ba_array_val(v_paths)->dim[0];
+  size_t sigs_len = Caml_ba_array_val(v_sigs)->dim[0];
+  if (Caml_ba_array_val(v_params)->dim[0] < 8)
+    caml_invalid_argument(
+        "Monte_carlo.Engine.simulate_native: params too short");
+  if ((paths_len > 0 && paths_len < num_paths * 2 * (num_steps + 1)) ||
+      (sigs_len > 0 && sigs_len < num_paths * 15))
+    caml_failwith("Monte_carlo.Engine.simulate_native: output too short");
+
+  const ModelParams *params = (const ModelParams *)Caml_ba_data_val(v_params);
+  double s0 = Double_val(v_s0), dt = Double_val(v_dt);
+  uint64_t seed = (uint64_t)Long_val(v_seed);
+  uint64_t first_path = (uint64_t)Long_val(v_first_path);
+  double *paths = paths_len > 0 ? (double *)Caml_ba_data_val(v_paths) : nullptr;
+  double *sigs = sigs_len > 0 ? (double *)Caml_ba_data_val(v_sigs) : nullptr;
+
+  // Bigarray data never moves: simulate without the runtime lock
+  caml_enter_blocking_section();
+  sabr_mc_simulate(params, s0, dt, num_steps, num_paths, seed, first_path,
+                   paths, sigs);
+  caml_leave_blocking_section();
+  CAMLreturn(Val_unit);
+}
+
+CAMLprim value caml_sabr_mc_simulate_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_sabr_mc_simulate(argv[0], argv[1], argv[2], argv[3], argv[4],
+                               argv[5], argv[6], argv[7], argv[8]);
+}
+
+// QMC variant: same arguments (seed = scramble seed), returns the
+// sabr_qmc_simulate status as an int.
+CAMLprim value caml_sabr_qmc_simulate(value v_params, value v_s0, value v_dt,
+                                      value v_num_steps, value v_num_paths,
+                                      value v_seed, value v_first_path,
+                                      value v_paths, value v_sigs) {
+  CAMLparam3(v_params, v_paths, v_sigs);
+  size_t num_steps = Long_val(v_num_steps);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t paths_len = Caml_ba_array_val(v_paths)->dim[0];
+  size_t sigs_len = Caml_ba_array_val(v_sigs)->dim[0];
+  if (Caml_ba_array_val(v_params)->dim[0] < 8)
+    caml_invalid_argument(
+        "Monte_carlo.Engine.simulate_qmc: params too short");
+  if ((paths_len > 0 && paths_len < num_paths * 2 * (num_steps + 1)) ||
+      (sigs_len > 0 && sigs_len < num_paths * 15))
+    caml_failwith("Monte_carlo.Engine.simulate_qmc: output too short");
+
+  const ModelParams *params = (const ModelParams *)Caml_ba_data_val(v_params);
+  double s0 = Double_val(v_s0), dt = Double_val(v_dt);
+  uint64_t seed = (uint64_t)Long_val(v_seed);
+  uint64_t first_path = (uint64_t)Long_val(v_first_path);
+  double *paths = paths_len > 0 ? (double *)Caml_ba_data_val(v_paths) : nullptr;
+  double *sigs = sigs_len > 0 ? (double *)Caml_ba_data_val(v_sigs) : nullptr;
+
+  caml_enter_blocking_section();
+  int status = sabr_qmc_simulate(params, s0, dt, num_steps, num_paths, seed,
+                                 first_path, paths, sigs);
+  caml_leave_blocking_section();
+  CAMLreturn(Val_int(status));
+}
+
+CAMLprim value caml_sabr_qmc_simulate_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_sabr_qmc_simulate(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                argv[5], argv[6], argv[7], argv[8]);
+}
+
+// Native SABR price and Greeks (pathwise tangents, one simulation)
+// external sabr_mc_greeks : Bigarray.float64 -> float -> float -> int -> int
+// -> int -> bool -> float -> float -> bool -> bool -> Bigarray.int32
+// -> Bigarray.float64 -> Bigarray.float64 -> int
+// An empty exercise array prices the European option; out and stderr get
+// SABR_NUM_GREEKS doubles each. Returns the sabr_mc_greeks status.
+CAMLprim value caml_sabr_mc_greeks(value v_params, value v_s0, value v_dt,
+                                   value v_num_steps, value v_num_paths,
+                                   value v_seed, value v_qmc, value v_strike,
+                                   value v_rate, value v_put, value v_digital,
+                                   value v_exercise, value v_out,
+                                   value v_stderr) {
+  CAMLparam4(v_params, v_exercise, v_out, v_stderr);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t exercise_len = Caml_ba_array_val(v_exercise)->dim[0];
+  if (Caml_ba_array_val(v_params)->dim[0] < 8)
+    caml_invalid_argument("Monte_carlo.Engine.greeks: params too short");
+  if ((exercise_len > 0 && exercise_len < num_paths) ||
+      Caml_ba_array_val(v_out)->dim[0] < SABR_NUM_GREEKS ||
+      Caml_ba_array_val(v_stderr)->dim[0] < SABR_NUM_GREEKS)
+    caml_failwith("Monte_carlo.Engine.greeks: buffer too short");
+
+  const ModelParams *params = (const ModelParams *)Caml_ba_data_val(v_params);
+  double s0 = Double_val(v_s0), dt = Double_val(v_dt);
+  size_t num_steps = Long_val(v_num_steps);
+  uint64_t seed = (uint64_t)Long_val(v_seed);
+  int qmc = Bool_val(v_qmc), put = Bool_val(v_put);
+  int digital = Bool_val(v_digital);
+  double strike = Double_val(v_strike), rate = Double_val(v_rate);
+  const uint32_t *exercise =
+      exercise_len > 0 ? (const uint32_t *)Caml_ba_data_val(v_exercise)
+                       : nullptr;
+  double *out = (double *)Caml_ba_data_val(v_out);
+  double *stderr_out = (double *)Caml_ba_data_val(v_stderr);
+
+  // Bigarray data never moves: simulate without the runtime lock
+  caml_enter_blocking_section();
+  int status = sabr_mc_greeks(params, s0, dt, num_steps, num_paths, seed, qmc,
+                              strike, rate, put, digital, exercise, out,
+                              stderr_out);
+  caml_leave_blocking_section();
+  CAMLreturn(Val_int(status));
+}
+
+CAMLprim value caml_sabr_mc_greeks_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_sabr_mc_greeks(argv[0], argv[1], argv[2], argv[3], argv[4],
+                             argv[5], argv[6], argv[7], argv[8], argv[9],
+                             argv[10], argv[11], argv[12], argv[13]);
+}
+
+// Native Heston Monte Carlo (QE scheme, SIMD across paths, thread pool)
+// external heston_mc_simulate : Bigarray.float64 -> float -> float -> float
+// -> int -> int -> int -> int -> bool -> Bigarray.float64 -> Bigarray.float64
+// -> Bigarray.float64 -> int
+// pieces is 8 doubles per HestonParams; empty outputs are not produced.
+// Returns the heston_mc_simulate status.
+CAMLprim value caml_heston_mc_simulate(value v_pieces, value v_s0, value v_v0,
+                                       value v_dt, value v_num_steps,
+                                       value v_num_paths, value v_seed,
+                                       value v_first_path, value v_qmc,
+                                       value v_paths, value v_variance,
+                                       value v_terminal) {
+  CAMLparam4(v_pieces, v_paths, v_variance, v_terminal);
+  size_t num_steps = Long_val(v_num_steps);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t num_pieces = Caml_ba_array_val(v_pieces)->dim[0] / 8;
+  size_t paths_len = Caml_ba_array_val(v_paths)->dim[0];
+  size_t variance_len = Caml_ba_array_val(v_variance)->dim[0];
+  size_t terminal_len = Caml_ba_array_val(v_terminal)->dim[0];
+  if ((paths_len > 0 && paths_len < num_paths * 2 * (num_steps + 1)) ||
+      (variance_len > 0 && variance_len < num_paths * (num_steps + 1)) ||
+      (terminal_len > 0 && terminal_len < num_paths * 2))
+    caml_failwith("Heston.simulate: output too short");
+
+  const HestonParams *pieces =
+      (const HestonParams *)Caml_ba_data_val(v_pieces);
+  double s0 = Double_val(v_s0), v0 = Double_val(v_v0), dt = Double_val(v_dt);
+  uint64_t seed = (uint64_t)Long_val(v_seed);
+  uint64_t first_path = (uint64_t)Long_val(v_first_path);
+  int qmc = Bool_val(v_qmc);
+  double *paths = paths_len > 0 ? (double *)Caml_ba_data_val(v_paths) : nullptr;
+  double *variance =
+      variance_len > 0 ? (double *)Caml_ba_data_val(v_variance) : nullptr;
+  double *terminal =
+      terminal_len > 0 ? (double *)Caml_ba_data_val(v_terminal) : nullptr;
+
+  // Bigarray data never moves: simulate without the runtime lock
+  caml_enter_blocking_section();
+  int status = heston_mc_simulate(pieces, num_pieces, s0, v0, dt, num_steps,
+                                  num_paths, seed, first_path, qmc, paths,
+                                  variance, terminal);
+  caml_leave_blocking_section();
+  CAMLreturn(Val_int(status));
+}
+
+CAMLprim value caml_heston_mc_simulate_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_heston_mc_simulate(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                 argv[5], argv[6], argv[7], argv[8], argv[9],
+                                 argv[10], argv[11]);
+}
+
+// Native Longstaff-Schwartz on a contiguous path block
+// external lsmc_american_price : Bigarray.float64 -> Bigarray.float64 -> int
+// -> int -> float -> float -> float -> bool -> float
+// basis = length of sigs / num_paths. Raises Invalid_argument on a
+// non-zero lsmc_american_price status.
+CAMLprim value caml_lsmc_american_price(value v_paths, value v_sigs,
+                                        value v_num_paths, value v_num_steps,
+                                        value v_strike, value v_rate,
+                                        value v_dt, value v_put) {
+  CAMLparam2(v_paths, v_sigs);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t num_points = Long_val(v_num_steps) + 1;
+  size_t paths_len = Caml_ba_array_val(v_paths)->dim[0];
+  size_t sigs_len = Caml_ba_array_val(v_sigs)->dim[0];
+  if (num_paths == 0 || paths_len < num_paths * 2 * num_points ||
+      sigs_len % num_paths != 0)
+    caml_invalid_argument("American_pricing.LSMC.price_block: bad sizes");
+
+  const double *paths = (const double *)Caml_ba_data_val(v_paths);
+  const double *sigs = (const double *)Caml_ba_data_val(v_sigs);
+  double strike = Double_val(v_strike), rate = Double_val(v_rate);
+  double dt = Double_val(v_dt);
+  int put = Bool_val(v_put);
+
+  // Bigarray data never moves: regress without the runtime lock and raise
+  // only once it is held again
+  double price = 0.0;
+  caml_enter_blocking_section();
+  int status = lsmc_american_price(paths, sigs, num_paths, num_points,
+                                   sigs_len / num_paths, strike, rate, dt, put,
+                                   &price);
+  caml_leave_blocking_section();
+  if (status != 0)
+    caml_invalid_argument("American_pricing.LSMC.price_block: bad sizes");
+  CAMLreturn(caml_copy_double(price));
+}
+
+CAMLprim value caml_lsmc_american_price_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_lsmc_american_price(argv[0], argv[1], argv[2], argv[3],
+                                  argv[4], argv[5], argv[6], argv[7]);
+}
+
+// Native Longstaff-Schwartz for a chain of options on one path block
+// external lsmc_american_chain : Bigarray.float64 -> Bigarray.float64 -> int
+// -> int -> Bigarray.float64 -> bool array -> float -> float
+// -> Bigarray.float64 -> Bigarray.float64 -> unit
+// One option per strike / put flag; prices gets one double per option, an
+// empty boundary is not produced. Raises Invalid_argument on a non-zero
+// lsmc_american_chain status.
+CAMLprim value caml_lsmc_american_chain(value v_paths, value v_sigs,
+                                        value v_num_paths, value v_num_steps,
+                                        value v_strikes, value v_puts,
+                                        value v_rate, value v_dt,
+                                        value v_prices, value v_boundary) {
+  CAMLparam5(v_paths, v_sigs, v_strikes, v_puts, v_prices);
+  CAMLxparam1(v_boundary);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t num_points = Long_val(v_num_steps) + 1;
+  size_t num_options = Wosize_val(v_puts);
+  size_t paths_len = Caml_ba_array_val(v_paths)->dim[0];
+  size_t sigs_len = Caml_ba_array_val(v_sigs)->dim[0];
+  size_t boundary_len = Caml_ba_array_val(v_boundary)->dim[0];
+  if (num_paths == 0 || paths_len < num_paths * 2 * num_points ||
+      sigs_len % num_paths != 0 ||
+      Caml_ba_array_val(v_strikes)->dim[0] != (intnat)num_options ||
+      Caml_ba_array_val(v_prices)->dim[0] < (intnat)num_options ||
+      (boundary_len > 0 && boundary_len < num_options * num_points))
+    caml_invalid_argument("American_pricing.LSMC.price_chain: bad sizes");
+
+  const double *paths = (const double *)Caml_ba_data_val(v_paths);
+  const double *sigs = (const double *)Caml_ba_data_val(v_sigs);
+  const double *strikes = (const double *)Caml_ba_data_val(v_strikes);
+  double rate = Double_val(v_rate), dt = Double_val(v_dt);
+  double *prices = (double *)Caml_ba_data_val(v_prices);
+  double *boundary =
+      boundary_len > 0 ? (double *)Caml_ba_data_val(v_boundary) : nullptr;
+
+  // caml_invalid_argument longjmps past destructors: release puts first.
+  // The OCaml bool array is copied while the runtime lock is still held.
+  int status;
+  {
+    std::vector<int> puts(num_options);
+    for (size_t k = 0; k < num_options; ++k)
+      puts[k] = Bool_val(Field(v_puts, k));
+    caml_enter_blocking_section();
+    status = lsmc_american_chain(paths, sigs, num_paths, num_points,
+                                 sigs_len / num_paths, strikes, puts.data(),
+                                 num_options, rate, dt, prices, boundary);
+    caml_leave_blocking_section();
+  }
+  if (status != 0)
+    caml_invalid_argument("American_pricing.LSMC.price_chain: bad sizes");
+  CAMLreturn(Val_unit);
+}
+CAMLprim value caml_lsmc_american_chain_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_lsmc_american_chain(argv[0], argv[1], argv[2], argv[3],
+                                  argv[4], argv[5], argv[6], argv[7],
+                                  argv[8], argv[9]);
+}
+
+// lsmc_american_price plus each path's exercise date
+// external lsmc_american_exercise : Bigarray.float64 -> Bigarray.float64
+// -> int -> int -> float -> float -> float -> bool -> Bigarray.int32 -> float
+// exercise gets num_paths dates. Raises Invalid_argument on a non-zero
+// lsmc_american_exercise status.
+CAMLprim value caml_lsmc_american_exercise(value v_paths, value v_sigs,
+                                           value v_num_paths,
+                                           value v_num_steps, value v_strike,
+                                           value v_rate, value v_dt,
+                                           value v_put, value v_exercise) {
+  CAMLparam3(v_paths, v_sigs, v_exercise);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t num_points = Long_val(v_num_steps) + 1;
+  size_t paths_len = Caml_ba_array_val(v_paths)->dim[0];
+  size_t sigs_len = Caml_ba_array_val(v_sigs)->dim[0];
+  if (num_paths == 0 || paths_len < num_paths * 2 * num_points ||
+      sigs_len % num_paths != 0 ||
+      Caml_ba_array_val(v_exercise)->dim[0] < (intnat)num_paths)
+    caml_invalid_argument("American_pricing.LSMC.exercise_block: bad sizes");
+
+  const double *paths = (const double *)Caml_ba_data_val(v_paths);
+  const double *sigs = (const double *)Caml_ba_data_val(v_sigs);
+  double strike = Double_val(v_strike), rate = Double_val(v_rate);
+  double dt = Double_val(v_dt);
+  int put = Bool_val(v_put);
+  uint32_t *exercise = (uint32_t *)Caml_ba_data_val(v_exercise);
+
+  double price = 0.0;
+  caml_enter_blocking_section();
+  int status = lsmc_american_exercise(paths, sigs, num_paths, num_points,
+                                      sigs_len / num_paths, strike, rate, dt,
+                                      put, &price, exercise);
+  caml_leave_blocking_section();
+  if (status != 0)
+    caml_invalid_argument("American_pricing.LSMC.exercise_block: bad sizes");
+  CAMLreturn(caml_copy_double(price));
+}
+CAMLprim value caml_lsmc_american_exercise_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_lsmc_american_exercise(argv[0], argv[1], argv[2], argv[3],
+                                     argv[4], argv[5], argv[6], argv[7],
+                                     argv[8]);
+}
+
+// Local-vol surface handle (custom block, freed by the GC finalizer)
+#define LocalVolSurface_val(v)                                                 \
+  (*((QuantKernel::LocalVolSurface **)Data_custom_val(v)))
+
+static void finalize_local_vol_surface(value v) {
+  local_vol_surface_destroy(LocalVolSurface_val(v));
+  LocalVolSurface_val(v) = nullptr;
+}
+
+static struct custom_operations local_vol_surface_ops = {
+    "quant_kernel.local_vol_surface",
+    finalize_local_vol_surface,
+    custom_compare_default,
+    custom_hash_default,
+    custom_serialize_default,
+    custom_deserialize_default,
+    custom_compare_ext_default,
+    custom_fixed_length_default};
+
+// external local_vol_surface : Bigarray.float64 -> Bigarray.float64
+// -> Bigarray.float64 -> float -> float -> int -> int -> local_vol
+// vols is num_tenors x num_strikes, row per tenor; the surface has
+// num_x x num_t nodes.
+CAMLprim value caml_local_vol_surface_create(value v_vols, value v_strikes,
+                                             value v_tenors, value v_s0,
+                                             value v_rate, value v_num_x,
+                                             value v_num_t) {
+  CAMLparam5(v_vols, v_strikes, v_tenors, v_s0, v_rate);
+  CAMLxparam2(v_num_x, v_num_t);
+  CAMLlocal1(v_surface);
+
+  size_t num_strikes = Caml_ba_array_val(v_strikes)->dim[0];
+  size_t num_tenors = Caml_ba_array_val(v_tenors)->dim[0];
+  if ((size_t)Caml_ba_array_val(v_vols)->dim[0] < num_strikes * num_tenors)
+    caml_invalid_argument("Slv_engine.local_vol_surface: bad sizes");
+
+  QuantKernel::LocalVolSurface *lv = local_vol_surface_create(
+      (const double *)Caml_ba_data_val(v_vols),
+      (const double *)Caml_ba_data_val(v_strikes), num_strikes,
+      (const double *)Caml_ba_data_val(v_tenors), num_tenors,
+      Double_val(v_s0), Double_val(v_rate), Long_val(v_num_x),
+      Long_val(v_num_t));
+  if (lv == nullptr)
+    caml_invalid_argument("Slv_engine.local_vol_surface: invalid grid");
+
+  v_surface = caml_alloc_custom(&local_vol_surface_ops,
+                                sizeof(QuantKernel::LocalVolSurface *), 0, 1);
+  LocalVolSurface_val(v_surface) = lv;
+  CAMLreturn(v_surface);
+}
+
+CAMLprim value caml_local_vol_surface_create_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_local_vol_surface_create(argv[0], argv[1], argv[2], argv[3],
+                                       argv[4], argv[5], argv[6]);
+}
+
+// external local_vol_at : local_vol -> float -> float -> float
+CAMLprim value caml_local_vol_surface_at(value v_surface, value v_spot,
+                                         value v_t) {
+  return caml_copy_double(local_vol_surface_at(
+      LocalVolSurface_val(v_surface), Double_val(v_spot), Double_val(v_t)));
+}
+
+// external arbitrage_points : local_vol -> int
+CAMLprim value caml_local_vol_surface_arbitrage_points(value v_surface) {
+  return Val_long(LocalVolSurface_val(v_surface)->arbitrage_points());
+}
+
+// Particle-method SLV leverage calibration
+// external slv_calibrate_leverage : Bigarray.float64 -> float -> float
+// -> local_vol -> Bigarray.float64 -> float -> int -> int -> int
+// -> Bigarray.float64 -> Bigarray.float64 -> int
+// pieces is 8 doubles per HestonParams; leverage gets (num_steps + 1) x
+// num_spots; an empty terminal is not produced. Returns the
+// slv_calibrate_leverage status.
+CAMLprim value caml_slv_calibrate_leverage(value v_pieces, value v_s0,
+                                           value v_v0, value v_local_vol,
+                                           value v_spots, value v_dt,
+                                           value v_num_steps,
+                                           value v_num_paths, value v_seed,
+                                           value v_leverage,
+                                           value v_terminal) {
+  CAMLparam5(v_pieces, v_local_vol, v_spots, v_leverage, v_terminal);
+  size_t num_steps = Long_val(v_num_steps);
+  size_t num_paths = Long_val(v_num_paths);
+  size_t num_pieces = Caml_ba_array_val(v_pieces)->dim[0] / 8;
+  size_t num_spots = Caml_ba_array_val(v_spots)->dim[0];
+  size_t terminal_len = Caml_ba_array_val(v_terminal)->dim[0];
+  if ((size_t)Caml_ba_array_val(v_leverage)->dim[0] <
+          (num_steps + 1) * num_spots ||
+      (terminal_len > 0 && terminal_len < 2 * num_paths))
+    caml_invalid_argument("Slv_engine.calibrate_leverage: bad sizes");
+
+  const HestonParams *pieces =
+      (const HestonParams *)Caml_ba_data_val(v_pieces);
+  double s0 = Double_val(v_s0), v0 = Double_val(v_v0), dt = Double_val(v_dt);
+  // The surface stays alive while v_local_vol is a registered root
+  const QuantKernel::LocalVolSurface *lv = LocalVolSurface_val(v_local_vol);
+  const double *spots = (const double *)Caml_ba_data_val(v_spots);
+  uint64_t seed = (uint64_t)Long_val(v_seed);
+  double *leverage = (double *)Caml_ba_data_val(v_leverage);
+  double *terminal =
+      terminal_len > 0 ? (double *)Caml_ba_data_val(v_terminal) : nullptr;
+
+  // Bigarray data never moves: calibrate without the runtime lock
+  caml_enter_blocking_section();
+  int status = slv_calibrate_leverage(pieces, num_pieces, s0, v0, lv, spots,
+                                      num_spots, dt, num_steps, num_paths,
+                                      seed, leverage, terminal);
+  caml_leave_blocking_section();
+  CAMLreturn(Val_int(status));
+}
+
+CAMLprim value caml_slv_calibrate_leverage_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_slv_calibrate_leverage(argv[0], argv[1], argv[2], argv[3],
+                                     argv[4], argv[5], argv[6], argv[7],
+                                     argv[8], argv[9], argv[10]);
+}
+
 // Path Signature Stub
 // external compute_signature_level3 : Bigarray.float64 -> int ->
 // Bigarray.float64 -> unit
@@ -34,6 +611,30 @@ CAMLprim value caml_compute_signature_level3(value v_path, value v_n,
   return Val_unit;
 }
 
+// Batched Path Signatures (contiguous path block -> N x 15 matrix)
+// external compute_signature_level3_batch : Bigarray.float64 -> int -> int ->
+// Bigarray.float64 -> unit
+// paths holds num_paths x num_points (t, x) pairs, out num_paths x 15.
+CAMLprim value caml_compute_signature_level3_batch(value v_paths,
+                                                   value v_num_paths,
+                                                   value v_num_points,
+                                                   value v_out) {
+  if (Long_val(v_num_paths) < 0 || Long_val(v_num_points) < 0)
+    caml_invalid_argument("Signature.compute_signature_batch: bad sizes");
+  size_t num_paths = Long_val(v_num_paths);
+  size_t num_points = Long_val(v_num_points);
+  if ((size_t)Caml_ba_array_val(v_paths)->dim[0] <
+          num_paths * num_points * 2 ||
+      (size_t)Caml_ba_array_val(v_out)->dim[0] < num_paths * 15)
+    caml_invalid_argument("Signature.compute_signature_batch: bad sizes");
+  double *paths = (double *)Caml_ba_data_val(v_paths);
+  double *out = (double *)Caml_ba_data_val(v_out);
+
+  compute_signature_level3_batch(paths, num_paths, num_points, out);
+
+  return Val_unit;
+}
+
 // Log-Signature via BCH Inversion
 // external compute_log_signature : Bigarray.float64 -> Bigarray.float64 -> unit
 CAMLprim value caml_compute_log_signature(value v_sig, value v_out) {
@@ -60,6 +661,71 @@ CAMLprim value caml_compute_expected_signature(value v_path, value v_n,
   return Val_unit;
 }
 
+// Arbitrary (dim, depth) Signature
+// external compute_signature_depth : Bigarray.float64 -> int -> int -> int ->
+// Bigarray.float64 -> unit
+// path holds n x dim doubles, out signature_size dim depth.
+CAMLprim value caml_compute_signature_depth(value v_path, value v_n,
+                                            value v_dim, value v_depth,
+                                            value v_out) {
+  intnat n = Long_val(v_n), dim = Long_val(v_dim), depth = Long_val(v_depth);
+  if (n < 0 || dim < 1 || depth < 1 ||
+      (size_t)Caml_ba_array_val(v_path)->dim[0] < (size_t)(n * dim) ||
+      (size_t)Caml_ba_array_val(v_out)->dim[0] < signature_size(dim, depth))
+    caml_invalid_argument("Signature.compute_signature_depth: bad sizes");
+
+  compute_signature_depth((double *)Caml_ba_data_val(v_path), n, dim, depth,
+                          (double *)Caml_ba_data_val(v_out));
+
+  return Val_unit;
+}
+
+// external compute_log_signature_depth : Bigarray.float64 -> int -> int ->
+// Bigarray.float64 -> unit
+// sig holds signature_size dim depth doubles, out one fewer.
+CAMLprim value caml_compute_log_signature_depth(value v_sig, value v_dim,
+                                                value v_depth, value v_out) {
+  intnat dim = Long_val(v_dim), depth = Long_val(v_depth);
+  if (dim < 1 || depth < 1 ||
+      (size_t)Caml_ba_array_val(v_sig)->dim[0] < signature_size(dim, depth) ||
+      (size_t)Caml_ba_array_val(v_out)->dim[0] < signature_size(dim, depth) - 1)
+    caml_invalid_argument("Signature.compute_log_signature_depth: bad sizes");
+
+  compute_log_signature_depth((double *)Caml_ba_data_val(v_sig), dim, depth,
+                              (double *)Caml_ba_data_val(v_out));
+
+  return Val_unit;
+}
+
+// external compute_expected_signature_depth : Bigarray.float64 -> int -> int ->
+// int -> int -> Bigarray.float64 -> unit
+// path holds n x dim doubles, out signature_size dim depth.
+CAMLprim value caml_compute_expected_signature_depth(value v_path, value v_n,
+                                                     value v_dim,
+                                                     value v_depth,
+                                                     value v_window,
+                                                     value v_out) {
+  intnat n = Long_val(v_n), dim = Long_val(v_dim), depth = Long_val(v_depth);
+  if (n < 0 || dim < 1 || depth < 1 || Long_val(v_window) < 0 ||
+      (size_t)Caml_ba_array_val(v_path)->dim[0] < (size_t)(n * dim) ||
+      (size_t)Caml_ba_array_val(v_out)->dim[0] < signature_size(dim, depth))
+    caml_invalid_argument(
+        "Signature.compute_expected_sig_depth: bad sizes");
+
+  compute_expected_signature_depth((double *)Caml_ba_data_val(v_path), n, dim,
+                                   depth, Long_val(v_window),
+                                   (double *)Caml_ba_data_val(v_out));
+
+  return Val_unit;
+}
+
+CAMLprim value caml_compute_expected_signature_depth_bytecode(value *argv,
+                                                              int argn) {
+  (void)argn;
+  return caml_compute_expected_signature_depth(argv[0], argv[1], argv[2],
+                                               argv[3], argv[4], argv[5]);
+}
+
 // Signature Curvature
 // external compute_signature_curvature : Bigarray.float64 -> int -> float
 CAMLprim value caml_compute_signature_curvature(value v_sigs, value v_n) {
@@ -95,3 +761,373 @@ extern "C" CAMLprim value caml_compute_frechet_mean(value v_points) {
 
   CAMLreturn(v_res);
 }
+
+// Streaming Signature state (custom block, freed by the GC finalizer)
+#define Streaming_val(v)                                                       \
+  (*((QuantKernel::StreamingSignature **)Data_custom_val(v)))
+
+static void finalize_streaming_signature(value v) {
+  streaming_signature_destroy(Streaming_val(v));
+  Streaming_val(v) = nullptr;
+}
+
+static struct custom_operations streaming_signature_ops = {
+    "quant_kernel.streaming_signature",
+    finalize_streaming_signature,
+    custom_compare_default,
+    custom_hash_default,
+    custom_serialize_default,
+    custom_deserialize_default,
+    custom_compare_ext_default,
+    custom_fixed_length_default};
+
+// external create : int -> int -> t
+extern "C" CAMLprim value caml_streaming_signature_create(value v_window,
+                                                          value v_history) {
+  CAMLparam2(v_window, v_history);
+  CAMLlocal1(v_state);
+
+  v_state = caml_alloc_custom(&streaming_signature_ops,
+                              sizeof(QuantKernel::StreamingSignature *), 0, 1);
+  Streaming_val(v_state) =
+      streaming_signature_create(Long_val(v_window), Long_val(v_history));
+
+  CAMLreturn(v_state);
+}
+
+// external push : t -> float -> float -> unit
+extern "C" CAMLprim value caml_streaming_signature_push(value v_state,
+                                                        value v_t, value v_x) {
+  streaming_signature_push(Streaming_val(v_state), Double_val(v_t),
+                           Double_val(v_x));
+  return Val_unit;
+}
+
+// external full / window / expected / log : t -> Bigarray.float64 -> unit
+extern "C" CAMLprim value caml_streaming_signature_full(value v_state,
+                                                        value v_out) {
+  streaming_signature_full(Streaming_val(v_state),
+                           (double *)Caml_ba_data_val(v_out));
+  return Val_unit;
+}
+
+extern "C" CAMLprim value caml_streaming_signature_window(value v_state,
+                                                          value v_out) {
+  streaming_signature_window(Streaming_val(v_state),
+                             (double *)Caml_ba_data_val(v_out));
+  return Val_unit;
+}
+
+extern "C" CAMLprim value caml_streaming_signature_expected(value v_state,
+                                                            value v_out) {
+  streaming_signature_expected(Streaming_val(v_state),
+                               (double *)Caml_ba_data_val(v_out));
+  return Val_unit;
+}
+
+extern "C" CAMLprim value caml_streaming_signature_log(value v_state,
+                                                       value v_out) {
+  streaming_signature_log(Streaming_val(v_state),
+                          (double *)Caml_ba_data_val(v_out));
+  return Val_unit;
+}
+
+// external curvature : t -> float
+extern "C" CAMLprim value caml_streaming_signature_curvature(value v_state) {
+  return caml_copy_double(
+      streaming_signature_curvature(Streaming_val(v_state)));
+}
+
+// external num_points : t -> int
+extern "C" CAMLprim value caml_streaming_signature_num_points(value v_state) {
+  return Val_long(Streaming_val(v_state)->num_points());
+}
+
+// external num_snapshots : t -> int
+extern "C" CAMLprim value caml_streaming_signature_num_snapshots(value v_state) {
+  return Val_long(Streaming_val(v_state)->num_snapshots());
+}
+
+// external snapshots : t -> Bigarray.float64 -> int
+extern "C" CAMLprim value caml_streaming_signature_snapshots(value v_state,
+                                                             value v_out) {
+  const QuantKernel::StreamingSignature *state = Streaming_val(v_state);
+  if (Caml_ba_array_val(v_out)->dim[0] <
+      (intnat)(state->num_snapshots() * QuantKernel::StreamingSignature::SIG_SIZE))
+    caml_invalid_argument("streaming_signature_snapshots: output too short");
+  return Val_long(streaming_signature_snapshots(
+      state, (double *)Caml_ba_data_val(v_out)));
+}
+
+// Sparse matrix handle (custom block, freed by the GC finalizer)
+#define SparseMatrix_val(v) (*((QuantKernel::SparseMatrix **)Data_custom_val(v)))
+
+static void finalize_sparse_matrix(value v) {
+  sparse_matrix_destroy(SparseMatrix_val(v));
+  SparseMatrix_val(v) = nullptr;
+}
+
+static struct custom_operations sparse_matrix_ops = {
+    "quant_kernel.sparse_matrix",
+    finalize_sparse_matrix,
+    custom_compare_default,
+    custom_hash_default,
+    custom_serialize_default,
+    custom_deserialize_default,
+    custom_compare_ext_default,
+    custom_fixed_length_default};
+
+// external create : Bigarray.float64 -> Bigarray.int32 -> Bigarray.int32 ->
+// int -> int -> int -> t   (num_rows = length row_ptr - 1)
+extern "C" CAMLprim value caml_sparse_matrix_create(value v_values,
+                                                    value v_cols,
+                                                    value v_row_ptr,
+                                                    value v_num_cols,
+                                                    value v_format,
+                                                    value v_param) {
+  CAMLparam5(v_values, v_cols, v_row_ptr, v_num_cols, v_format);
+  CAMLxparam1(v_param);
+  CAMLlocal1(v_mat);
+
+  const int *row_ptr = (int *)Caml_ba_data_val(v_row_ptr);
+  int num_rows = (int)Caml_ba_array_val(v_row_ptr)->dim[0] - 1;
+  if (num_rows < 0 ||
+      Caml_ba_array_val(v_cols)->dim[0] < row_ptr[num_rows] ||
+      Caml_ba_array_val(v_values)->dim[0] < row_ptr[num_rows])
+    caml_failwith("Markov.Sparse.create: CSR arrays too short");
+
+  QuantKernel::SparseMatrix *m = sparse_matrix_create(
+      (double *)Caml_ba_data_val(v_values), (int *)Caml_ba_data_val(v_cols),
+      row_ptr, num_rows, Int_val(v_num_cols), Int_val(v_format),
+      Int_val(v_param));
+  if (m == nullptr)
+    caml_failwith("Markov.Sparse.create: invalid CSR matrix or format");
+
+  v_mat = caml_alloc_custom(&sparse_matrix_ops,
+                            sizeof(QuantKernel::SparseMatrix *), 0, 1);
+  SparseMatrix_val(v_mat) = m;
+  CAMLreturn(v_mat);
+}
+
+extern "C" CAMLprim value caml_sparse_matrix_create_bytecode(value *argv,
+                                                             int argn) {
+  (void)argn;
+  return caml_sparse_matrix_create(argv[0], argv[1], argv[2], argv[3],
+                                   argv[4], argv[5]);
+}
+
+// external spmv : t -> Bigarray.float64 -> Bigarray.float64 -> unit
+extern "C" CAMLprim value caml_sparse_matrix_spmv(value v_mat, value v_x,
+                                                  value v_y) {
+  const QuantKernel::SparseMatrix *m = SparseMatrix_val(v_mat);
+  if (Caml_ba_array_val(v_x)->dim[0] < m->num_cols() ||
+      Caml_ba_array_val(v_y)->dim[0] < m->num_rows())
+    caml_failwith("Markov.Sparse.spmv: vector too short");
+  sparse_matrix_spmv(m, (double *)Caml_ba_data_val(v_x),
+                     (double *)Caml_ba_data_val(v_y));
+  return Val_unit;
+}
+
+// external fill_ratio : t -> float
+extern "C" CAMLprim value caml_sparse_matrix_fill_ratio(value v_mat) {
+  return caml_copy_double(sparse_matrix_fill_ratio(SparseMatrix_val(v_mat)));
+}
+
+// Markov propagation engine (custom block, freed by the GC finalizer)
+#define MarkovEngine_val(v) (*((QuantKernel::MarkovEngine **)Data_custom_val(v)))
+
+static void finalize_markov_engine(value v) {
+  markov_engine_destroy(MarkovEngine_val(v));
+  MarkovEngine_val(v) = nullptr;
+}
+
+static struct custom_operations markov_engine_ops = {
+    "quant_kernel.markov_engine",
+    finalize_markov_engine,
+    custom_compare_default,
+    custom_hash_default,
+    custom_serialize_default,
+    custom_deserialize_default,
+    custom_compare_ext_default,
+    custom_fixed_length_default};
+
+// external create : Bigarray.float64 -> Bigarray.int32 -> Bigarray.int32 -> t
+// (num_states = length row_ptr - 1)
+extern "C" CAMLprim value caml_markov_engine_create(value v_values,
+                                                    value v_cols,
+                                                    value v_row_ptr) {
+  CAMLparam3(v_values, v_cols, v_row_ptr);
+  CAMLlocal1(v_engine);
+
+  const int *row_ptr = (int *)Caml_ba_data_val(v_row_ptr);
+  int num_states = (int)Caml_ba_array_val(v_row_ptr)->dim[0] - 1;
+  if (num_states <= 0 ||
+      Caml_ba_array_val(v_cols)->dim[0] < row_ptr[num_states] ||
+      Caml_ba_array_val(v_values)->dim[0] < row_ptr[num_states])
+    caml_failwith("Markov.Engine.create: CSR arrays too short");
+
+  QuantKernel::MarkovEngine *e =
+      markov_engine_create((double *)Caml_ba_data_val(v_values),
+                           (int *)Caml_ba_data_val(v_cols), row_ptr,
+                           num_states);
+  if (e == nullptr)
+    caml_failwith("Markov.Engine.create: invalid transition matrix");
+
+  v_engine = caml_alloc_custom(&markov_engine_ops,
+                               sizeof(QuantKernel::MarkovEngine *), 0, 1);
+  MarkovEngine_val(v_engine) = e;
+  CAMLreturn(v_engine);
+}
+
+// external num_states : t -> int
+extern "C" CAMLprim value caml_markov_engine_num_states(value v_engine) {
+  return Val_int(MarkovEngine_val(v_engine)->num_states());
+}
+
+// external propagate : t -> Bigarray.float64 -> int -> Bigarray.float64 ->
+// unit
+extern "C" CAMLprim value caml_markov_engine_propagate(value v_engine,
+                                                       value v_pi0,
+                                                       value v_steps,
+                                                       value v_out) {
+  QuantKernel::MarkovEngine *e = MarkovEngine_val(v_engine);
+  if (Caml_ba_array_val(v_pi0)->dim[0] < e->num_states() ||
+      Caml_ba_array_val(v_out)->dim[0] < e->num_states())
+    caml_failwith("Markov.Engine.propagate: vector too short");
+  markov_engine_propagate(e, (double *)Caml_ba_data_val(v_pi0),
+                          Int_val(v_steps), (double *)Caml_ba_data_val(v_out));
+  return Val_unit;
+}
+
+// external stationary : t -> int -> float -> int -> Bigarray.float64 ->
+// int * float   (out holds the starting guess; all zeros -> uniform)
+extern "C" CAMLprim value caml_markov_engine_stationary(value v_engine,
+                                                        value v_method,
+                                                        value v_tol,
+                                                        value v_max_iters,
+                                                        value v_out) {
+  CAMLparam5(v_engine, v_method, v_tol, v_max_iters, v_out);
+  CAMLlocal1(v_res);
+
+  QuantKernel::MarkovEngine *e = MarkovEngine_val(v_engine);
+  if (Caml_ba_array_val(v_out)->dim[0] < e->num_states())
+    caml_failwith("Markov.Engine.stationary: vector too short");
+  double *out = (double *)Caml_ba_data_val(v_out);
+  bool has_guess = false;
+  for (int i = 0; i < e->num_states() && !has_guess; ++i)
+    has_guess = out[i] != 0.0;
+
+  int method = Int_val(v_method), max_iters = Int_val(v_max_iters);
+  double tol = Double_val(v_tol);
+
+  // A 1M-state solve takes seconds: run it without the runtime lock
+  int iters = 0;
+  caml_enter_blocking_section();
+  double residual = markov_engine_stationary(
+      e, method, has_guess ? out : nullptr, tol, max_iters, out, &iters);
+  caml_leave_blocking_section();
+
+  v_res = caml_alloc(2, 0);
+  Store_field(v_res, 0, Val_int(iters));
+  Store_field(v_res, 1, caml_copy_double(residual));
+  CAMLreturn(v_res);
+}
+
+// COO -> CSR builder (pruning + renormalization fused)
+// external coo_to_csr : Bigarray.int32 -> Bigarray.int32 -> Bigarray.float64 ->
+// int -> float -> bool -> Bigarray.int32 -> Bigarray.int32 ->
+// Bigarray.float64 -> int
+extern "C" CAMLprim value caml_coo_to_csr(value v_src, value v_dst,
+                                          value v_prob, value v_num_nodes,
+                                          value v_epsilon, value v_renorm,
+                                          value v_row_ptr, value v_cols,
+                                          value v_values) {
+  size_t num_edges = Caml_ba_array_val(v_src)->dim[0];
+  int num_nodes = Int_val(v_num_nodes);
+  if ((size_t)Caml_ba_array_val(v_dst)->dim[0] < num_edges ||
+      (size_t)Caml_ba_array_val(v_prob)->dim[0] < num_edges ||
+      (size_t)Caml_ba_array_val(v_cols)->dim[0] < num_edges ||
+      (size_t)Caml_ba_array_val(v_values)->dim[0] < num_edges ||
+      num_nodes < 0 || Caml_ba_array_val(v_row_ptr)->dim[0] < num_nodes + 1)
+    caml_failwith("Markov.of_coo: array too short");
+
+  int64_t nnz = coo_to_csr(
+      (int *)Caml_ba_data_val(v_src), (int *)Caml_ba_data_val(v_dst),
+      (double *)Caml_ba_data_val(v_prob), num_edges, num_nodes,
+      Double_val(v_epsilon), Bool_val(v_renorm),
+      (int *)Caml_ba_data_val(v_row_ptr), (int *)Caml_ba_data_val(v_cols),
+      (double *)Caml_ba_data_val(v_values));
+  if (nnz == -2)
+    caml_failwith("Markov.of_coo: more than INT_MAX edges kept");
+  if (nnz < 0)
+    caml_failwith("Markov.of_coo: state index out of range");
+  return Val_long(nnz);
+}
+
+extern "C" CAMLprim value caml_coo_to_csr_bytecode(value *argv, int argn) {
+  (void)argn;
+  return caml_coo_to_csr(argv[0], argv[1], argv[2], argv[3], argv[4], argv[5],
+                         argv[6], argv[7], argv[8]);
+}
+
+// Kernel metrics snapshot (merged across threads at call time)
+// external snapshot : unit -> (string * float array) array
+// Each float array is [calls; bytes; mean; p50; p99; p999; max], times in ns.
+extern "C" CAMLprim value caml_metrics_snapshot(value v_unit) {
+  CAMLparam1(v_unit);
+  CAMLlocal4(v_res, v_entry, v_name, v_stats);
+
+  const int n = metrics_num_kernels();
+  v_res = caml_alloc(n, 0);
+  for (int i = 0; i < n; ++i) {
+    double stats[7];
+    metrics_kernel_summary(i, stats);
+    v_name = caml_copy_string(metrics_kernel_name(i));
+    v_stats = caml_alloc(7 * Double_wosize, Double_array_tag);
+    for (int k = 0; k < 7; ++k)
+      Store_double_field(v_stats, k, stats[k]);
+    v_entry = caml_alloc(2, 0);
+    Store_field(v_entry, 0, v_name);
+    Store_field(v_entry, 1, v_stats);
+    Store_field(v_res, i, v_entry);
+  }
+  CAMLreturn(v_res);
+}
+
+// Kernel tracer (binary spill, Chrome trace JSON offline)
+// external enable : string -> bool
+extern "C" CAMLprim value caml_tracing_enable(value v_path) {
+  return Val_bool(enable_tracing(String_val(v_path)) == 0);
+}
+
+// external disable : unit -> unit
+// Drains every ring and joins the flusher: run without the runtime lock
+extern "C" CAMLprim value caml_tracing_disable(value v_unit) {
+  caml_enter_blocking_section();
+  disable_tracing();
+  caml_leave_blocking_section();
+  return Val_unit;
+}
+
+// external span_begin : string -> unit
+extern "C" CAMLprim value caml_tracing_begin(value v_name) {
+  trace_begin(String_val(v_name));
+  return Val_unit;
+}
+
+// external span_end : string -> unit
+extern "C" CAMLprim value caml_tracing_end(value v_name) {
+  trace_end(String_val(v_name));
+  return Val_unit;
+}
+
+// external to_json : string -> string -> int
+// Events written, or -1 on an unreadable spill / unwritable output
+extern "C" CAMLprim value caml_tracing_to_json(value v_bin, value v_json) {
+  CAMLparam2(v_bin, v_json);
+  std::string bin(String_val(v_bin)), json(String_val(v_json));
+  caml_enter_blocking_section();
+  long n = trace_convert_to_json(bin.c_str(), json.c_str());
+  caml_leave_blocking_section();
+  CAMLreturn(Val_long(n));
+}
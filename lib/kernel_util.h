@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+template <class T> struct AlignedAllocator {
+  typedef T value_type;
+  AlignedAllocator() = default;
+  template <class U> AlignedAllocator(const AlignedAllocator<U> &) {}
+  T *allocate(size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t(64)));
+  }
+  void deallocate(T *p, size_t) { ::operator delete(p, std::align_val_t(64)); }
+  bool operator==(const AlignedAllocator &) const { return true; }
+  bool operator!=(const AlignedAllocator &) const { return false; }
+};
+
+// 64-byte (cache line / zmm) aligned storage
+template <class T> using AlignedVec = std::vector<T, AlignedAllocator<T>>;
+
+// Grid nodes (strikes, tenors, spots): finite, strictly increasing, first
+// one positive
+inline bool increasing_positive(const double *x, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    if (!std::isfinite(x[i]) || !(i > 0 ? x[i] > x[i - 1] : x[i] > 0.0))
+      return false;
+  return true;
+}
+
+} // namespace QuantKernel
@@ -0,0 +1,350 @@
+#include "local_vol.h"
+#include "kernel_util.h"
+#include "metrics.h"
+#include "signature_kernel.h"
+#include "simd_math.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// =============================================================================
+// Dupire Local Volatility Surface (spline fit, SIMD evaluation)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Turns a grid of implied vols into the local vols a
+   one-factor model needs at each (spot, time) to reprice every option on
+   the grid, tabulated on a regular grid so Monte Carlo engines read them
+   back in a few nanoseconds. Each tenor's smile is fitted once by a
+   smooth curve whose slope and curvature are known exactly, so no point
+   needs finite differences or repeated surface calls.
+
+   [HS MATH]:
+   Total variance w = σ_imp² T at log-moneyness y = log(K / F_T), F_T =
+   S0 e^{rT}. Per tenor: not-a-knot cubic spline of w in u = log(K / K_0)
+   (knots shared by all tenors; exact for w quadratic in y), coefficients
+   per segment
+     w = a + b s + c s² + d s³,   s = u - u_i.
+   Between tenors T_lo < t <= T_hi, at fixed y:
+     w = α w_lo + β w_hi,  β = (t - T_lo) / (T_hi - T_lo),  α = 1 - β,
+     ∂_T w = (w_hi - w_lo) / (T_hi - T_lo);
+   before the first tenor w = (t / T_0) w_0 (flat implied vol). Node
+   (x, t) reads tenor j's spline at u = x - log K_0 + r (T_j - t).
+   Dupire in total variance (Gatheral), ρ = ∂_y w / w:
+     σ_LV² = ∂_T w / g,
+     g = (1 - y ρ / 2)² - ¼ ρ ∂_y w - (∂_y w)² / 16 + ½ ∂_yy w
+   ρ does not depend on the t / T_0 scaling, so the first row (t = 0)
+   is the short-maturity limit rather than 0 / 0.
+
+   [SAFETY]:
+   - ∂_T w <= 0 (calendar arbitrage) or g <= 0 (butterfly arbitrage,
+     negative density) falls back to the implied vol w / t and the node
+     is counted in arbitrage_points().
+   - A spline that overshoots to w <= 0 also falls back (floored at 0).
+   - Outside its strikes a tenor's w continues as the parabola with the
+     end's value, slope and curvature, so its derivatives stay continuous.
+     Nodes read a tenor at most |r| x (tenor spacing) past its strikes.
+*/
+namespace {
+
+using QuantKernel::Lanes;
+
+// Knots, spline coefficients (a, b, c, d per segment and tenor) and tenors
+struct LvFit {
+  const double *knots;
+  const double *coef;
+  const double *tenors;
+  size_t num_knots;
+  double x_min, dx, log_s0, rate;
+};
+
+// Weights of one time row on its two tenors: value, ρ, ∂_T w and implied
+// variance (w / t)
+struct LvRow {
+  size_t lo, hi;
+  double t;
+  double val[2], ratio[2], slope[2], imp[2];
+};
+
+LvRow lv_row(const double *tenors, size_t num_tenors, double t) {
+  LvRow r{};
+  r.t = t;
+  size_t j = std::lower_bound(tenors, tenors + num_tenors, t) - tenors;
+  if (j == num_tenors)
+    j = num_tenors - 1; // last row, within rounding of the last tenor
+  if (j == 0) {
+    r.lo = r.hi = 0;
+    r.val[1] = t / tenors[0];
+    r.ratio[1] = 1.0;
+    r.slope[1] = r.imp[1] = 1.0 / tenors[0];
+    return r;
+  }
+  r.lo = j - 1;
+  r.hi = j;
+  const double span = tenors[j] - tenors[j - 1];
+  r.val[1] = r.ratio[1] = std::min((t - tenors[j - 1]) / span, 1.0);
+  r.val[0] = r.ratio[0] = 1.0 - r.val[1];
+  r.slope[0] = -1.0 / span;
+  r.slope[1] = 1.0 / span;
+  r.imp[0] = r.val[0] / t;
+  r.imp[1] = r.val[1] / t;
+  return r;
+}
+
+// w, ∂_u w, ∂_uu w of tenor j's spline at u0 + k dx, k < n; outside the
+// knots, the parabola with the end's value, slope and curvature
+void spline_row(const LvFit &f, size_t j, double u0, size_t n, double *w,
+                double *w1, double *w2) {
+  const size_t segs = f.num_knots - 1;
+  const double *coef = f.coef + j * segs * 4, *last = coef + (segs - 1) * 4;
+  const double u_max = f.knots[segs], h = u_max - f.knots[segs - 1];
+  const double left[4] = {coef[0], coef[1], coef[2], 0.0};
+  const double right[4] = {
+      last[0] + h * (last[1] + h * (last[2] + h * last[3])),
+      last[1] + h * (2.0 * last[2] + 3.0 * h * last[3]),
+      last[2] + 3.0 * h * last[3], 0.0};
+  size_t seg = 0;
+  for (size_t k = 0; k < n; ++k) {
+    const double u = u0 + (double)k * f.dx;
+    const double *c;
+    double s;
+    if (u < 0.0) {
+      c = left;
+      s = u;
+    } else if (u > u_max) {
+      c = right;
+      s = u - u_max;
+    } else {
+      while (seg + 1 < segs && f.knots[seg + 1] <= u)
+        ++seg;
+      c = coef + seg * 4;
+      s = u - f.knots[seg];
+    }
+    w[k] = c[0] + s * (c[1] + s * (c[2] + s * c[3]));
+    w1[k] = c[1] + s * (2.0 * c[2] + 3.0 * s * c[3]);
+    w2[k] = 2.0 * c[2] + 6.0 * s * c[3];
+  }
+}
+
+// Scratch row length: num_x rounded up to whole 8-lane blocks
+inline size_t lv_stride(size_t num_x) { return (num_x + 7) / 8 * 8; }
+
+// σ_LV on one time row from its two tenors' splines (scratch: 6 x
+// lv_stride(num_x)); returns the row's arbitrage fallbacks
+template <int W>
+__attribute__((always_inline)) inline size_t
+lv_row_range(const LvFit &f, const LvRow &r, size_t num_x, double *scratch,
+             double *out) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+  const size_t stride = lv_stride(num_x);
+  double *sp[6];
+  for (size_t m = 0; m < 6; ++m)
+    sp[m] = scratch + m * stride;
+  spline_row(f, r.lo, f.rate * (f.tenors[r.lo] - r.t), num_x, sp[0], sp[1],
+             sp[2]);
+  spline_row(f, r.hi, f.rate * (f.tenors[r.hi] - r.t), num_x, sp[3], sp[4],
+             sp[5]);
+  const double y0 = f.x_min - f.log_s0 - f.rate * r.t;
+
+  vec lane{};
+  for (int l = 0; l < W; ++l)
+    lane[l] = (double)l;
+  size_t bad = 0;
+  for (size_t k = 0; k < num_x; k += W) {
+    vec a, a1, a2, b, b1, b2;
+    std::memcpy(&a, sp[0] + k, sizeof a);
+    std::memcpy(&a1, sp[1] + k, sizeof a1);
+    std::memcpy(&a2, sp[2] + k, sizeof a2);
+    std::memcpy(&b, sp[3] + k, sizeof b);
+    std::memcpy(&b1, sp[4] + k, sizeof b1);
+    std::memcpy(&b2, sp[5] + k, sizeof b2);
+
+    const vec y = (lane + (double)k) * f.dx + y0;
+    const vec w1 = r.val[0] * a1 + r.val[1] * b1;
+    const vec w2 = r.val[0] * a2 + r.val[1] * b2;
+    const vec wr = r.ratio[0] * a + r.ratio[1] * b;
+    const vec rho = (r.ratio[0] * a1 + r.ratio[1] * b1) /
+                    (wr > 0.0 ? wr : vec{} + 1.0);
+    const vec wt = r.slope[0] * a + r.slope[1] * b;
+    const vec lin = 1.0 - 0.5 * y * rho;
+    const vec g = lin * lin - 0.25 * rho * w1 - 0.0625 * w1 * w1 + 0.5 * w2;
+    const ivec ok = (wt > 0.0) & (g > 0.0) & (wr > 0.0);
+    const vec var = ok ? wt / (ok ? g : vec{} + 1.0)
+                       : r.imp[0] * a + r.imp[1] * b;
+    const ivec pos = var > 0.0;
+    const vec v = QuantKernel::vsqrt<W>(pos ? var : vec{} + 1.0);
+
+    const size_t valid = std::min<size_t>(W, num_x - k);
+    for (size_t l = 0; l < valid; ++l) {
+      out[k + l] = pos[l] ? v[l] : 0.0;
+      bad += !ok[l];
+    }
+  }
+  return bad;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LV_X86_DISPATCH 1
+
+__attribute__((target("avx2,fma"))) size_t
+lv_row_avx2(const LvFit &f, const LvRow &r, size_t num_x, double *scratch,
+            double *out) {
+  return lv_row_range<4>(f, r, num_x, scratch, out);
+}
+
+__attribute__((target("avx512f"))) size_t
+lv_row_avx512(const LvFit &f, const LvRow &r, size_t num_x, double *scratch,
+              double *out) {
+  return lv_row_range<8>(f, r, num_x, scratch, out);
+}
+#endif
+
+// Not-a-knot cubic spline coefficients of every row of w (num_rows x n,
+// n >= 3) on the knots u; the tridiagonal system in M = w'' is shared and
+// factored once. Three knots: the parabola through them.
+void fit_splines(const double *u, size_t n, const double *w, size_t num_rows,
+                 double *coef) {
+  std::vector<double> h(n - 1), lower(n), diag(n), upper(n), m(n), rhs(n);
+  for (size_t i = 0; i + 1 < n; ++i)
+    h[i] = u[i + 1] - u[i];
+  // Rows 1 .. n - 2 of h_{i-1} M_{i-1} + 2 (h_{i-1} + h_i) M_i + h_i M_{i+1}
+  // = rhs_i, with M_0 and M_{n-1} eliminated by the not-a-knot conditions
+  // (third derivative continuous at u_1 and u_{n-2})
+  for (size_t i = 1; i + 1 < n; ++i) {
+    lower[i] = h[i - 1];
+    diag[i] = 2.0 * (h[i - 1] + h[i]);
+    upper[i] = h[i];
+  }
+  if (n > 3) {
+    const double h0 = h[0], h1 = h[1], ha = h[n - 3], hb = h[n - 2];
+    diag[1] = (h0 + h1) * (h0 + 2.0 * h1) / h1;
+    upper[1] = (h1 - h0) * (h1 + h0) / h1;
+    lower[n - 2] = (ha - hb) * (ha + hb) / ha;
+    diag[n - 2] = (hb + ha) * (hb + 2.0 * ha) / ha;
+  }
+  // Thomas elimination: diag becomes the pivots, upper the scaled uppers
+  for (size_t i = 1; i + 1 < n; ++i) {
+    if (i > 1)
+      diag[i] -= lower[i] * upper[i - 1];
+    upper[i] /= diag[i];
+  }
+  for (size_t row = 0; row < num_rows; ++row) {
+    const double *y = w + row * n;
+    for (size_t i = 1; i + 1 < n; ++i) {
+      rhs[i] =
+          6.0 * ((y[i + 1] - y[i]) / h[i] - (y[i] - y[i - 1]) / h[i - 1]);
+      if (i > 1)
+        rhs[i] -= lower[i] * rhs[i - 1];
+      rhs[i] /= diag[i];
+    }
+    if (n == 3) {
+      m[0] = m[1] = m[2] = 2.0 *
+                           ((y[2] - y[1]) / h[1] - (y[1] - y[0]) / h[0]) /
+                           (h[0] + h[1]);
+    } else {
+      m[n - 2] = rhs[n - 2];
+      for (size_t i = n - 3; i >= 1; --i)
+        m[i] = rhs[i] - upper[i] * m[i + 1];
+      m[0] = m[1] + h[0] * (m[1] - m[2]) / h[1];
+      m[n - 1] = m[n - 2] + h[n - 2] * (m[n - 2] - m[n - 3]) / h[n - 3];
+    }
+    double *out = coef + row * (n - 1) * 4;
+    for (size_t i = 0; i + 1 < n; ++i) {
+      out[4 * i] = y[i];
+      out[4 * i + 1] =
+          (y[i + 1] - y[i]) / h[i] - h[i] * (2.0 * m[i] + m[i + 1]) / 6.0;
+      out[4 * i + 2] = 0.5 * m[i];
+      out[4 * i + 3] = (m[i + 1] - m[i]) / (6.0 * h[i]);
+    }
+  }
+}
+
+} // namespace
+
+namespace QuantKernel {
+
+LocalVolSurface::LocalVolSurface(const double *implied_vol,
+                                 const double *strikes, size_t num_strikes,
+                                 const double *tenors, size_t num_tenors,
+                                 double s0, double rate, size_t num_x,
+                                 size_t num_t)
+    : num_x_(num_x), num_t_(num_t), vol_(num_x * num_t) {
+  std::vector<double> knots(num_strikes), w(num_tenors * num_strikes);
+  for (size_t i = 0; i < num_strikes; ++i)
+    knots[i] = std::log(strikes[i] / strikes[0]);
+  for (size_t j = 0; j < num_tenors; ++j)
+    for (size_t i = 0; i < num_strikes; ++i) {
+      const double v = implied_vol[j * num_strikes + i];
+      w[j * num_strikes + i] = v * v * tenors[j];
+    }
+  std::vector<double> coef(num_tenors * (num_strikes - 1) * 4);
+  fit_splines(knots.data(), num_strikes, w.data(), num_tenors, coef.data());
+
+  x_min_ = std::log(strikes[0]);
+  dx_ = knots[num_strikes - 1] / (double)(num_x - 1);
+  inv_dx_ = 1.0 / dx_;
+  dt_ = tenors[num_tenors - 1] / (double)(num_t - 1);
+  inv_dt_ = 1.0 / dt_;
+
+  const LvFit fit{knots.data(), coef.data(), tenors, num_strikes,
+                  x_min_,       dx_,         std::log(s0), rate};
+  std::vector<size_t> bad(num_t);
+  std::vector<double> scratch(num_t * 6 * lv_stride(num_x));
+  const int isa = signature_kernel_isa();
+  ThreadPool::global().parallel_for(num_t, [&](size_t j) {
+    const LvRow r = lv_row(tenors, num_tenors, (double)j * dt_);
+    double *sc = scratch.data() + j * 6 * lv_stride(num_x);
+    double *out = vol_.data() + j * num_x;
+#ifdef LV_X86_DISPATCH
+    switch (isa) {
+    case 2:
+      bad[j] = lv_row_avx512(fit, r, num_x, sc, out);
+      return;
+    case 1:
+      bad[j] = lv_row_avx2(fit, r, num_x, sc, out);
+      return;
+    default:
+      break;
+    }
+#else
+    (void)isa;
+#endif
+    bad[j] = lv_row_range<4>(fit, r, num_x, sc, out);
+  });
+  for (size_t b : bad)
+    arbitrage_ += b;
+}
+
+} // namespace QuantKernel
+
+extern "C" {
+
+QuantKernel::LocalVolSurface *
+local_vol_surface_create(const double *implied_vol, const double *strikes,
+                         size_t num_strikes, const double *tenors,
+                         size_t num_tenors, double s0, double rate,
+                         size_t num_x, size_t num_t) {
+  if (num_strikes < 3 || num_tenors == 0 || num_x < 2 || num_t < 2 ||
+      !(s0 > 0.0) || !std::isfinite(rate) ||
+      !QuantKernel::increasing_positive(strikes, num_strikes) ||
+      !QuantKernel::increasing_positive(tenors, num_tenors))
+    return nullptr;
+  for (size_t k = 0; k < num_tenors * num_strikes; ++k)
+    if (!(implied_vol[k] > 0.0) || !std::isfinite(implied_vol[k]))
+      return nullptr;
+  QK_METRIC_SCOPE("local_vol_surface_create", num_x * num_t * sizeof(double));
+  return new QuantKernel::LocalVolSurface(implied_vol, strikes, num_strikes,
+                                          tenors, num_tenors, s0, rate, num_x,
+                                          num_t);
+}
+
+void local_vol_surface_destroy(QuantKernel::LocalVolSurface *surface) {
+  delete surface;
+}
+
+double local_vol_surface_at(const QuantKernel::LocalVolSurface *surface,
+                            double spot, double t) {
+  return surface->at(std::log(spot), t);
+}
+}
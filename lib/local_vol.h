@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+/**
+ * Dupire local volatility on a uniform (log-spot, time) grid.
+ *
+ * Built once from an implied-vol grid: each tenor's total implied variance
+ * is fitted by a not-a-knot cubic spline in log-moneyness, tenors are joined
+ * linearly in total variance at fixed log-moneyness, and Dupire's formula
+ * is evaluated on every grid node from the spline's analytic derivatives.
+ * Lookups are bilinear on the grid and flat outside it, so a Monte Carlo
+ * step pays two index computations and four loads per path.
+ *
+ * The grid spans the input strikes in log-spot and [0, last tenor] in
+ * time. Nodes where the fitted surface admits no local vol (calendar or
+ * butterfly arbitrage) take the implied vol and are counted.
+ */
+class LocalVolSurface {
+public:
+  LocalVolSurface(const double *implied_vol, const double *strikes,
+                  size_t num_strikes, const double *tenors, size_t num_tenors,
+                  double s0, double rate, size_t num_x, size_t num_t);
+
+  /// σ_LV at log-spot x and time t.
+  double at(double x, double t) const {
+    double u = (x - x_min_) * inv_dx_;
+    u = u > 0.0 ? u : 0.0;
+    u = u < (double)(num_x_ - 1) ? u : (double)(num_x_ - 1);
+    double v = t * inv_dt_;
+    v = v > 0.0 ? v : 0.0;
+    v = v < (double)(num_t_ - 1) ? v : (double)(num_t_ - 1);
+    const size_t i = u < (double)(num_x_ - 2) ? (size_t)u : num_x_ - 2;
+    const size_t j = v < (double)(num_t_ - 2) ? (size_t)v : num_t_ - 2;
+    const double fu = u - (double)i, fv = v - (double)j;
+    const double *p = vol_.data() + j * num_x_ + i;
+    const double lo = p[0] + fu * (p[1] - p[0]);
+    const double hi = p[num_x_] + fu * (p[num_x_ + 1] - p[num_x_]);
+    return lo + fv * (hi - lo);
+  }
+
+  size_t num_x() const { return num_x_; }
+  size_t num_t() const { return num_t_; }
+  double x_min() const { return x_min_; }
+  double dx() const { return dx_; }
+  double dt() const { return dt_; }
+  /// num_t x num_x node values, row per time.
+  const double *values() const { return vol_.data(); }
+  /// Nodes that fell back to the implied vol.
+  size_t arbitrage_points() const { return arbitrage_; }
+
+private:
+  size_t num_x_, num_t_;
+  double x_min_, dx_, inv_dx_, dt_, inv_dt_;
+  size_t arbitrage_ = 0;
+  std::vector<double> vol_;
+};
+
+} // namespace QuantKernel
+
+extern "C" {
+/**
+ * @brief Build a local-vol surface from an implied-vol grid.
+ *
+ * @param implied_vol num_tenors x num_strikes implied vols, row per tenor.
+ * @param strikes num_strikes increasing positive strikes, at least 3.
+ * @param num_strikes Strikes per row.
+ * @param tenors num_tenors increasing positive tenors in years.
+ * @param num_tenors At least 1 (one tenor: vols constant in time at fixed
+ *                   log-moneyness).
+ * @param s0 Spot.
+ * @param rate Continuously compounded rate (forwards s0 e^{rate T}).
+ * @param num_x Log-spot nodes, at least 2.
+ * @param num_t Time nodes, at least 2.
+ * @return Owned handle; release with local_vol_surface_destroy. nullptr on
+ *         invalid input (sizes, unsorted or non-positive nodes,
+ *         non-positive vols, s0 <= 0).
+ */
+QuantKernel::LocalVolSurface *
+local_vol_surface_create(const double *implied_vol, const double *strikes,
+                         size_t num_strikes, const double *tenors,
+                         size_t num_tenors, double s0, double rate,
+                         size_t num_x, size_t num_t);
+
+void local_vol_surface_destroy(QuantKernel::LocalVolSurface *surface);
+
+/**
+ * @brief σ_LV at (spot, t): bilinear in (log-spot, t), flat outside.
+ */
+double local_vol_surface_at(const QuantKernel::LocalVolSurface *surface,
+                            double spot, double t);
+}
@@ -0,0 +1,798 @@
+#include "lsmc.h"
+#include "kernel_util.h"
+#include "metrics.h"
+#include "signature_kernel.h"
+#include "simd_math.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// =============================================================================
+// Longstaff-Schwartz American Pricing (fused backward sweeps)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Walks back from maturity one date at a time. At each
+   date, paths in the money compare exercising now against a regression
+   estimate of what holding is worth, fitted on the paths' regressors.
+   The expensive part is building the least-squares system. Every pass
+   over the path block does two jobs at once: it applies date t's
+   exercise rule, then feeds the updated cash flows straight into date
+   t - 1's normal equations while the same paths are still in cache.
+
+   [HS MATH]:
+   cf = cash flow per path, valued one date ahead; D = exp(-r dt);
+   h_t = (S_t - K)^+ (call) or (K - S_t)^+ (put); x = regressor row.
+     init:    cf = h_T
+     date t:  y = D cf,  over the ITM set I_t = {h_t > 0}:
+              G = Σ_I x xᵀ,  b = Σ_I x y,  G β = b
+              cf = h_t        if h_t > 0 and h_t > βᵀx
+                 = D cf       otherwise
+     price = D · mean(cf) after date 1
+   G and b are accumulated as the Gram matrix of the augmented columns
+   [X | y], weighted by the ITM mask, LSMC_SPAN paths at a time and 2 x 4
+   entries per register block. The regressors are laid out by column
+   once, in the first pass, and reused at every date.
+
+   [SAFETY]:
+   - G is scaled to unit diagonal before the solve, so regressors of very
+     different size (signature levels grow like ΔS^k) are well
+     conditioned. A 1e-12 ridge is added to the diagonal.
+   - Cholesky pivots under 1e-10 mark a column as dependent on earlier
+     ones (e.g. the time terms of a signature, equal on every path). Its
+     coefficient is 0 and the rest are fitted without it.
+   - With no more ITM paths than regressors, or a system with no usable
+     column, the date is not regressed and every cash flow is discounted.
+*/
+namespace {
+
+using QuantKernel::Lanes;
+
+constexpr size_t LSMC_CHUNK = 1024; // paths per thread-pool task
+constexpr size_t LSMC_SPAN = 256;   // paths per Gram update (L1-sized)
+constexpr size_t LSMC_COLS = LSMC_MAX_BASIS + 1; // regressors + y
+constexpr double LSMC_RIDGE = 1e-12;
+constexpr double LSMC_PIVOT_TOL = 1e-10;
+
+enum class Exercise { Init, Regress, Discount };
+
+// One backward pass: apply date t's rule, then (if accumulate) build date
+// t - 1's normal equations into one partial Gram per chunk.
+struct LsmcSweep {
+  const double *paths, *sigs;
+  size_t num_points, basis;
+  size_t cols; // basis + 1 rounded up to 4
+  double strike, sign, disc; // h = sign (S - K)
+  Exercise mode;
+  size_t t;
+  bool accumulate;
+  const double *beta;
+  double *xt; // regressors by span: column j of a span at j * LSMC_SPAN
+  double *cf;
+  uint32_t *exercise; // per path: date of the exercise taken, or nullptr
+  double *partial; // per chunk: cols x cols Gram, then the ITM count
+};
+
+size_t partial_stride(size_t cols) { return cols * cols + 1; }
+
+template <int W>
+__attribute__((always_inline)) inline double hsum(typename Lanes<W>::vec v) {
+  double s = 0.0;
+  for (int w = 0; w < W; ++w)
+    s += v[w];
+  return s;
+}
+
+// g += Σ_i w_i col_j[i] col_k[i] over rows [0, npad). Only rows j < m are
+// needed: entries (j, k >= j) of the regressors and (j, m) of the
+// right-hand side (col[m] = y, already zero where w_i = 0).
+template <int W>
+__attribute__((always_inline)) inline void
+gram_update(const double *const *col, const double *w, size_t m,
+            size_t cols, size_t npad, double *g) {
+  typedef typename Lanes<W>::vec vec;
+  for (size_t j = 0; j < m; j += 2) {
+    const double *u0 = col[j], *u1 = col[j + 1];
+    for (size_t k = j & ~(size_t)3; k < cols; k += 4) {
+      const double *v0 = col[k], *v1 = col[k + 1], *v2 = col[k + 2],
+                   *v3 = col[k + 3];
+      vec a00{}, a01{}, a02{}, a03{}, a10{}, a11{}, a12{}, a13{};
+      for (size_t i = 0; i < npad; i += W) {
+        vec x0, x1, y0, y1, y2, y3, wi;
+        std::memcpy(&wi, w + i, sizeof(vec));
+        std::memcpy(&x0, u0 + i, sizeof(vec));
+        std::memcpy(&x1, u1 + i, sizeof(vec));
+        std::memcpy(&y0, v0 + i, sizeof(vec));
+        std::memcpy(&y1, v1 + i, sizeof(vec));
+        std::memcpy(&y2, v2 + i, sizeof(vec));
+        std::memcpy(&y3, v3 + i, sizeof(vec));
+        x0 *= wi;
+        x1 *= wi;
+        a00 += x0 * y0;
+        a01 += x0 * y1;
+        a02 += x0 * y2;
+        a03 += x0 * y3;
+        a10 += x1 * y0;
+        a11 += x1 * y1;
+        a12 += x1 * y2;
+        a13 += x1 * y3;
+      }
+      double *r0 = g + j * cols + k, *r1 = r0 + cols;
+      r0[0] += hsum<W>(a00);
+      r0[1] += hsum<W>(a01);
+      r0[2] += hsum<W>(a02);
+      r0[3] += hsum<W>(a03);
+      r1[0] += hsum<W>(a10);
+      r1[1] += hsum<W>(a11);
+      r1[2] += hsum<W>(a12);
+      r1[3] += hsum<W>(a13);
+    }
+  }
+}
+
+// S_t and S_{t-1} of n paths (rows of `row` doubles). Lanes [n, npad)
+// get NaN: never in the money, never exercised.
+inline void gather_spots(const double *rows, size_t row, size_t t, size_t n,
+                         size_t npad, double *st, double *sa) {
+  // S_{t-1} and S_t share a cache line more often than not; one line
+  // per path, fetched a few dozen paths ahead
+  for (size_t i = 0; i < n; ++i) {
+    if (i + 32 < n)
+      __builtin_prefetch(rows + (i + 32) * row + 2 * t - 1);
+    st[i] = rows[i * row + 2 * t + 1];
+    sa[i] = rows[i * row + 2 * t - 1];
+  }
+  for (size_t i = n; i < npad; ++i)
+    st[i] = sa[i] = NAN;
+}
+
+// n regressor rows (m each) -> one span of columns, zero past n
+inline void layout_span(const double *x, size_t m, size_t n, double *xt) {
+  for (size_t j = 0; j < m; ++j)
+    for (size_t i = 0; i < LSMC_SPAN; ++i)
+      xt[j * LSMC_SPAN + i] = i < n ? x[i * m + j] : 0.0;
+}
+
+// Paths [begin, end) of one chunk; g is the chunk's partial
+template <int W>
+__attribute__((always_inline)) inline void
+lsmc_range(const LsmcSweep &s, size_t begin, size_t end, double *g) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+
+  alignas(64) static const double zeros[LSMC_SPAN] = {};
+  alignas(64) double st[LSMC_SPAN], sa[LSMC_SPAN], cft[LSMC_SPAN];
+  alignas(64) double y[LSMC_SPAN], itm[LSMC_SPAN];
+
+  const size_t m = s.basis, row = 2 * s.num_points;
+  const bool regress = s.mode == Exercise::Regress;
+  const double *col[LSMC_COLS + 1];
+  double count = 0.0;
+  if (s.accumulate)
+    std::fill(g, g + s.cols * s.cols, 0.0);
+
+  for (size_t p0 = begin; p0 < end; p0 += LSMC_SPAN) {
+    const size_t n = std::min(LSMC_SPAN, end - p0);
+    const size_t npad = (n + W - 1) / W * W;
+    const double *rows = s.paths + p0 * row;
+    double *xt = s.xt + p0 * m; // this span's regressors, by column
+
+    gather_spots(rows, row, s.t, n, npad, st, sa);
+    std::memcpy(cft, s.cf + p0, n * sizeof(double));
+    std::fill(cft + n, cft + npad, 0.0);
+    // Regressors are the same at every date: lay them out once
+    if (s.mode == Exercise::Init) {
+      layout_span(s.sigs + p0 * m, m, n, xt);
+      if (s.exercise)
+        std::fill(s.exercise + p0, s.exercise + p0 + n, (uint32_t)s.t);
+    }
+
+    // Exercise rule of date t, then y and the ITM mask of date t - 1
+    vec itm_count = vec{};
+    for (size_t i = 0; i < npad; i += W) {
+      vec S, cv;
+      std::memcpy(&S, st + i, sizeof(vec));
+      std::memcpy(&cv, cft + i, sizeof(vec));
+      const vec h = s.sign * (S - s.strike);
+      if (s.mode == Exercise::Init) {
+        cv = h > 0.0 ? h : vec{};
+      } else if (regress) {
+        vec cont = vec{};
+        for (size_t j = 0; j < m; ++j) {
+          vec xj;
+          std::memcpy(&xj, xt + j * LSMC_SPAN + i, sizeof(vec));
+          cont += s.beta[j] * xj;
+        }
+        const ivec exercise = (h > 0.0) & (h > cont);
+        cv = exercise ? h : cv * s.disc;
+        if (s.exercise)
+          for (int w = 0; w < W; ++w)
+            if (exercise[w])
+              s.exercise[p0 + i + w] = (uint32_t)s.t; // pad lanes never
+      } else {
+        cv = cv * s.disc;
+      }
+      std::memcpy(cft + i, &cv, sizeof(vec));
+
+      std::memcpy(&S, sa + i, sizeof(vec));
+      const vec w = s.sign * (S - s.strike) > 0.0 ? vec{} + 1.0 : vec{};
+      const vec yi = w * (s.disc * cv);
+      std::memcpy(itm + i, &w, sizeof(vec));
+      std::memcpy(y + i, &yi, sizeof(vec));
+      itm_count += w;
+    }
+    std::memcpy(s.cf + p0, cft, n * sizeof(double));
+
+    // Normal equations of date t - 1 over its ITM paths
+    const double span_itm = hsum<W>(itm_count);
+    if (!s.accumulate || span_itm == 0.0)
+      continue;
+    for (size_t j = 0; j < m; ++j)
+      col[j] = xt + j * LSMC_SPAN;
+    col[m] = y;
+    for (size_t j = m + 1; j <= s.cols; ++j)
+      col[j] = zeros;
+    gram_update<W>(col, itm, m, s.cols, npad, g);
+    count += span_itm;
+  }
+  if (s.accumulate)
+    g[s.cols * s.cols] = count;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LSMC_X86_DISPATCH 1
+
+__attribute__((target("avx2,fma"))) void
+lsmc_range_avx2(const LsmcSweep &s, size_t begin, size_t end, double *g) {
+  lsmc_range<4>(s, begin, end, g);
+}
+
+__attribute__((target("avx512f"))) void
+lsmc_range_avx512(const LsmcSweep &s, size_t begin, size_t end, double *g) {
+  lsmc_range<8>(s, begin, end, g);
+}
+#endif
+
+// Solve G β = b, G the upper triangle of g (m x m, row stride cols), b
+// at rhs[j * rhs_stride]. false if no column is usable.
+bool lsmc_solve(const double *g, size_t cols, const double *rhs,
+                size_t rhs_stride, size_t m, double *beta) {
+  double scale[LSMC_MAX_BASIS], l[LSMC_MAX_BASIS * LSMC_MAX_BASIS];
+  double z[LSMC_MAX_BASIS];
+  bool used[LSMC_MAX_BASIS];
+
+  double dmax = 0.0;
+  for (size_t j = 0; j < m; ++j)
+    dmax = std::max(dmax, g[j * cols + j]);
+  if (!(dmax > 0.0) || !std::isfinite(dmax))
+    return false;
+  for (size_t j = 0; j < m; ++j) {
+    const double d = g[j * cols + j];
+    scale[j] = d > 1e-300 ? 1.0 / std::sqrt(d) : 0.0;
+  }
+
+  // Cholesky of the scaled G + ridge (lower triangle, row-major)
+  size_t rank = 0;
+  for (size_t j = 0; j < m; ++j) {
+    for (size_t k = 0; k <= j; ++k) {
+      double a = g[k * cols + j] * scale[j] * scale[k];
+      if (k == j)
+        a += LSMC_RIDGE;
+      for (size_t q = 0; q < k; ++q)
+        a -= l[j * m + q] * l[k * m + q];
+      if (k < j) {
+        l[j * m + k] = used[k] ? a / l[k * m + k] : 0.0;
+      } else {
+        used[j] = scale[j] > 0.0 && a > LSMC_PIVOT_TOL;
+        l[j * m + j] = used[j] ? std::sqrt(a) : 1.0;
+        rank += used[j];
+      }
+    }
+  }
+  if (rank == 0)
+    return false;
+
+  for (size_t j = 0; j < m; ++j) {
+    double a = rhs[j * rhs_stride] * scale[j];
+    for (size_t q = 0; q < j; ++q)
+      a -= l[j * m + q] * z[q];
+    z[j] = used[j] ? a / l[j * m + j] : 0.0;
+  }
+  for (size_t j = m; j-- > 0;) {
+    double a = z[j];
+    for (size_t q = j + 1; q < m; ++q)
+      a -= l[q * m + j] * z[q];
+    z[j] = used[j] ? a / l[j * m + j] : 0.0;
+    beta[j] = z[j] * scale[j];
+  }
+  return true;
+}
+
+// =============================================================================
+// Option Chains (one pass per date for every strike)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: A chain of puts and calls on the same paths shares
+   almost everything: spots and regressors are loaded once per date, and
+   the expensive regression matrix is built once for all strikes. Paths
+   are sorted into buckets by where S sits among the distinct strikes.
+   A put's in-the-money set is every bucket below its strike, a call's
+   every bucket above, so each option's matrix is a running sum of
+   bucket matrices. Only the cash flows, X'y and the exercise rule are
+   per option.
+
+   [HS MATH]:
+   Distinct strikes L_0 < ... < L_{n-1}; bucket of S, with q = #{L < S}:
+     2q + 1 if S = L_q, else 2q   (2n + 1 buckets)
+   G_b = Σ_{S ∈ b} x xᵀ; for the option on L_q:
+     put:  ITM ⇔ S < L_q ⇔ b <= 2q,      G = Σ_{b <= 2q} G_b
+     call: ITM ⇔ S > L_q ⇔ b >= 2q + 2,  G = Σ_{b >= 2q + 2} G_b
+   Puts take prefix sums and calls suffix sums, so a deep out-of-the-money
+   option never gets its matrix as the difference of two large ones.
+   Exercise boundary at date t: the largest exercised S for a put, the
+   smallest for a call, tracked as max(-sign S) so both reduce by max.
+
+   [SAFETY]:
+   - Chunk partials hold one matrix per bucket, so the chunk count is
+     capped (LSMC_CHAIN_PARTS). Chunk sizes depend on num_paths only and
+     sums run in chunk order, so results do not depend on thread count.
+   - Buckets no option needs (above every put, below every call) are
+     skipped.
+*/
+
+constexpr size_t LSMC_CHAIN_PARTS = 64; // max chunk partials per pass
+constexpr size_t LSMC_ROW = 32;         // LSMC_MAX_BASIS rounded up to 8
+
+struct LsmcChainSweep {
+  const double *paths, *sigs;
+  size_t num_paths, num_points, basis;
+  size_t row_width; // bucket matrix row stride: basis rounded up to 8
+  size_t num_options;
+  const double *strike, *sign; // per option; h = sign (S - K)
+  const double *levels;        // distinct strikes, increasing
+  size_t num_levels;
+  size_t used_below, used_from; // buckets b < used_below or >= used_from
+  double disc;
+  bool init;
+  size_t t;
+  bool accumulate;
+  const unsigned char *regress; // per option: date t has a fit
+  const double *beta;           // per option, basis each
+  double *xt;
+  double *cf; // option k's cash flows at k * num_paths
+  double *partial;
+};
+
+// Per chunk partial: bucket matrices (first, so their rows stay 64-byte
+// aligned), option boundaries (max of -sign S), bucket counts, option X'y
+struct ChainPartial {
+  double *gram, *bound, *count, *xty;
+};
+
+ChainPartial chain_partial(const LsmcChainSweep &s, double *p) {
+  const size_t buckets = 2 * s.num_levels + 1;
+  ChainPartial c;
+  c.gram = p;
+  c.bound = c.gram + buckets * s.basis * s.row_width;
+  c.count = c.bound + s.num_options;
+  c.xty = c.count + buckets;
+  return c;
+}
+
+// Rounded up to whole cache lines
+size_t chain_stride(size_t num_options, size_t num_levels, size_t basis,
+                    size_t row_width) {
+  const size_t buckets = 2 * num_levels + 1;
+  const size_t n =
+      buckets * (basis * row_width + 1) + num_options * (basis + 1);
+  return (n + 7) & ~(size_t)7;
+}
+
+// Bucket of S among n increasing levels (see [HS MATH]); branch-free,
+// spots arrive in random order
+inline size_t bucket(const double *levels, size_t n, double S) {
+  const double *base = levels;
+  for (size_t len = n; len > 1;) {
+    const size_t half = len / 2;
+    base = base[half - 1] < S ? base + half : base;
+    len -= half;
+  }
+  const size_t q = (size_t)(base - levels) + (*base < S);
+  return 2 * q + (q < n && levels[q] == S);
+}
+
+template <int W>
+__attribute__((always_inline)) inline void
+chain_range(const LsmcChainSweep &s, size_t begin, size_t end, double *p) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+
+  alignas(64) double st[LSMC_SPAN], sa[LSMC_SPAN], cft[LSMC_SPAN];
+  alignas(64) double wy[LSMC_SPAN], xr[2][LSMC_ROW] = {};
+
+  const size_t m = s.basis, rw = s.row_width, row = 2 * s.num_points;
+  const size_t buckets = 2 * s.num_levels + 1;
+  const ChainPartial c = chain_partial(s, p);
+  std::fill(c.bound, c.bound + s.num_options, -INFINITY);
+  if (s.accumulate) {
+    std::fill(c.gram, c.gram + buckets * m * rw, 0.0);
+    std::fill(c.count, c.count + buckets, 0.0);
+    std::fill(c.xty, c.xty + s.num_options * m, 0.0);
+  }
+
+  for (size_t p0 = begin; p0 < end; p0 += LSMC_SPAN) {
+    const size_t n = std::min(LSMC_SPAN, end - p0);
+    const size_t npad = (n + W - 1) / W * W;
+    double *xt = s.xt + p0 * m;
+    gather_spots(s.paths + p0 * row, row, s.t, n, npad, st, sa);
+    if (s.init)
+      layout_span(s.sigs + p0 * m, m, n, xt);
+
+    // Bucket matrices of date t - 1, one outer product per path. The
+    // row of path i + 1 is gathered while path i's is used: a vector
+    // load of freshly stored scalars would stall on store forwarding.
+    if (s.accumulate) {
+      for (size_t j = 0; j < m; ++j)
+        xr[0][j] = xt[j * LSMC_SPAN];
+      for (size_t i = 0; i < n; ++i) {
+        const double *x = xr[i & 1];
+        if (i + 1 < n)
+          for (size_t j = 0; j < m; ++j)
+            xr[(i + 1) & 1][j] = xt[j * LSMC_SPAN + i + 1];
+        const size_t b = bucket(s.levels, s.num_levels, sa[i]);
+        if (b >= s.used_below && b < s.used_from)
+          continue;
+        c.count[b] += 1.0;
+        double *g = c.gram + b * m * rw;
+        for (size_t j = 0; j < m; ++j) {
+          const vec xj = vec{} + x[j];
+          for (size_t k = j / W * W; k < rw; k += W) {
+            vec gk, xk;
+            std::memcpy(&gk, g + j * rw + k, sizeof(vec));
+            std::memcpy(&xk, x + k, sizeof(vec));
+            gk += xj * xk;
+            std::memcpy(g + j * rw + k, &gk, sizeof(vec));
+          }
+        }
+      }
+    }
+
+    for (size_t k = 0; k < s.num_options; ++k) {
+      const double sign = s.sign[k], strike = s.strike[k];
+      const double *beta = s.beta + k * m;
+      const bool regress = !s.init && s.regress[k];
+      double *cf = s.cf + k * s.num_paths + p0;
+      std::memcpy(cft, cf, n * sizeof(double));
+      std::fill(cft + n, cft + npad, 0.0);
+
+      // Exercise rule of date t, then y of date t - 1
+      vec bound = vec{} - INFINITY;
+      for (size_t i = 0; i < npad; i += W) {
+        vec S, cv;
+        std::memcpy(&S, st + i, sizeof(vec));
+        std::memcpy(&cv, cft + i, sizeof(vec));
+        const vec h = sign * (S - strike);
+        if (s.init) {
+          cv = h > 0.0 ? h : vec{};
+        } else if (regress) {
+          vec cont = vec{};
+          for (size_t j = 0; j < m; ++j) {
+            vec xj;
+            std::memcpy(&xj, xt + j * LSMC_SPAN + i, sizeof(vec));
+            cont += beta[j] * xj;
+          }
+          const ivec exercise = (h > 0.0) & (h > cont);
+          cv = exercise ? h : cv * s.disc;
+          const vec edge = exercise ? -sign * S : vec{} - INFINITY;
+          bound = edge > bound ? edge : bound;
+        } else {
+          cv = cv * s.disc;
+        }
+        std::memcpy(cft + i, &cv, sizeof(vec));
+        if (s.accumulate) {
+          std::memcpy(&S, sa + i, sizeof(vec));
+          const vec yi = sign * (S - strike) > 0.0 ? s.disc * cv : vec{};
+          std::memcpy(wy + i, &yi, sizeof(vec));
+        }
+      }
+      std::memcpy(cf, cft, n * sizeof(double));
+      for (int w = 0; w < W; ++w)
+        c.bound[k] = std::max(c.bound[k], bound[w]);
+
+      if (!s.accumulate)
+        continue;
+      for (size_t j = 0; j < m; ++j) {
+        vec acc = vec{};
+        for (size_t i = 0; i < npad; i += W) {
+          vec xj, yi;
+          std::memcpy(&xj, xt + j * LSMC_SPAN + i, sizeof(vec));
+          std::memcpy(&yi, wy + i, sizeof(vec));
+          acc += xj * yi;
+        }
+        c.xty[k * m + j] += hsum<W>(acc);
+      }
+    }
+  }
+}
+
+#ifdef LSMC_X86_DISPATCH
+__attribute__((target("avx2,fma"))) void
+chain_range_avx2(const LsmcChainSweep &s, size_t begin, size_t end,
+                 double *p) {
+  chain_range<4>(s, begin, end, p);
+}
+
+__attribute__((target("avx512f"))) void
+chain_range_avx512(const LsmcChainSweep &s, size_t begin, size_t end,
+                   double *p) {
+  chain_range<8>(s, begin, end, p);
+}
+#endif
+
+} // namespace
+
+extern "C" {
+
+int lsmc_american_price(const double *paths, const double *sigs,
+                        size_t num_paths, size_t num_points, size_t basis,
+                        double strike, double rate, double dt, int is_put,
+                        double *out_price) {
+  return lsmc_american_exercise(paths, sigs, num_paths, num_points, basis,
+                                strike, rate, dt, is_put, out_price, nullptr);
+}
+
+int lsmc_american_exercise(const double *paths, const double *sigs,
+                           size_t num_paths, size_t num_points, size_t basis,
+                           double strike, double rate, double dt, int is_put,
+                           double *out_price, uint32_t *out_exercise) {
+  if (num_paths == 0 || num_points < 2 || basis == 0 ||
+      basis > LSMC_MAX_BASIS)
+    return -1;
+  QK_METRIC_SCOPE("lsmc_american_price",
+                  num_paths * (num_points - 1) * (basis + 3) * sizeof(double));
+
+  const size_t cols = (basis + 4) & ~(size_t)3;
+  const size_t chunks = (num_paths + LSMC_CHUNK - 1) / LSMC_CHUNK;
+  const size_t stride = partial_stride(cols);
+  const size_t spans = (num_paths + LSMC_SPAN - 1) / LSMC_SPAN;
+  std::vector<double> cf(num_paths), partial(chunks * stride),
+      gram(cols * cols), beta(basis);
+  QuantKernel::AlignedVec<double> xt(spans * LSMC_SPAN * basis);
+
+  LsmcSweep s{.paths = paths,
+              .sigs = sigs,
+              .num_points = num_points,
+              .basis = basis,
+              .cols = cols,
+              .strike = strike,
+              .sign = is_put ? -1.0 : 1.0,
+              .disc = std::exp(-rate * dt),
+              .mode = Exercise::Init,
+              .t = num_points - 1,
+              .accumulate = num_points > 2,
+              .beta = beta.data(),
+              .xt = xt.data(),
+              .cf = cf.data(),
+              .exercise = out_exercise,
+              .partial = partial.data()};
+
+  const int isa = signature_kernel_isa();
+  double itm = 0.0;
+  auto sweep = [&]() {
+    QuantKernel::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+      const size_t begin = c * LSMC_CHUNK;
+      const size_t end = std::min(num_paths, begin + LSMC_CHUNK);
+      double *g = s.partial + c * stride;
+#ifdef LSMC_X86_DISPATCH
+      switch (isa) {
+      case 2:
+        lsmc_range_avx512(s, begin, end, g);
+        return;
+      case 1:
+        lsmc_range_avx2(s, begin, end, g);
+        return;
+      default:
+        break;
+      }
+#else
+      (void)isa;
+#endif
+      lsmc_range<4>(s, begin, end, g);
+    });
+    if (!s.accumulate)
+      return;
+    // Chunk order, not completion order: same sums for any thread count
+    std::fill(gram.begin(), gram.end(), 0.0);
+    itm = 0.0;
+    for (size_t c = 0; c < chunks; ++c) {
+      const double *g = s.partial + c * stride;
+      for (size_t k = 0; k < cols * cols; ++k)
+        gram[k] += g[k];
+      itm += g[cols * cols];
+    }
+  };
+
+  sweep();
+  for (size_t t = num_points - 2; t >= 1; --t) {
+    const bool fit = itm > (double)basis &&
+                     lsmc_solve(gram.data(), cols, gram.data() + basis, cols,
+                                basis, beta.data());
+    s.mode = fit ? Exercise::Regress : Exercise::Discount;
+    s.t = t;
+    s.accumulate = t > 1;
+    sweep();
+  }
+
+  double sum = 0.0;
+  for (size_t p = 0; p < num_paths; ++p)
+    sum += cf[p];
+  *out_price = sum / (double)num_paths * s.disc;
+  return 0;
+}
+
+int lsmc_american_chain(const double *paths, const double *sigs,
+                        size_t num_paths, size_t num_points, size_t basis,
+                        const double *strikes, const int *is_put,
+                        size_t num_options, double rate, double dt,
+                        double *out_prices, double *out_boundary) {
+  if (num_paths == 0 || num_points < 2 || basis == 0 ||
+      basis > LSMC_MAX_BASIS || num_options == 0)
+    return -1;
+  for (size_t k = 0; k < num_options; ++k)
+    if (!std::isfinite(strikes[k]))
+      return -1;
+  QK_METRIC_SCOPE("lsmc_american_chain",
+                  num_paths * (num_points - 1) *
+                      (basis + 2 + 2 * num_options) * sizeof(double));
+
+  // Distinct strikes, each option's level, the buckets anyone needs
+  std::vector<double> levels(strikes, strikes + num_options), sign(num_options);
+  std::sort(levels.begin(), levels.end());
+  levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+  const size_t num_levels = levels.size(), buckets = 2 * num_levels + 1;
+  std::vector<size_t> level(num_options);
+  size_t used_below = 0, used_from = buckets;
+  for (size_t k = 0; k < num_options; ++k) {
+    level[k] = std::lower_bound(levels.begin(), levels.end(), strikes[k]) -
+               levels.begin();
+    sign[k] = is_put[k] ? -1.0 : 1.0;
+    if (is_put[k])
+      used_below = std::max(used_below, 2 * level[k] + 1);
+    else
+      used_from = std::min(used_from, 2 * level[k] + 2);
+  }
+
+  const size_t rw = (basis + 7) & ~(size_t)7;
+  const size_t per_part = (num_paths + LSMC_CHAIN_PARTS - 1) /
+                          LSMC_CHAIN_PARTS;
+  const size_t chunk = std::max(
+      LSMC_CHUNK, (per_part + LSMC_SPAN - 1) / LSMC_SPAN * LSMC_SPAN);
+  const size_t chunks = (num_paths + chunk - 1) / chunk;
+  const size_t stride = chain_stride(num_options, num_levels, basis, rw);
+  const size_t spans = (num_paths + LSMC_SPAN - 1) / LSMC_SPAN;
+  const size_t mat = basis * rw;
+  std::vector<double> cf(num_options * num_paths), total(stride),
+      prefix(buckets * mat), suffix(buckets * mat), beta(num_options * basis);
+  QuantKernel::AlignedVec<double> partial(chunks * stride),
+      xt(spans * LSMC_SPAN * basis);
+  std::vector<unsigned char> regress(num_options, 0);
+
+  LsmcChainSweep s{.paths = paths,
+                   .sigs = sigs,
+                   .num_paths = num_paths,
+                   .num_points = num_points,
+                   .basis = basis,
+                   .row_width = rw,
+                   .num_options = num_options,
+                   .strike = strikes,
+                   .sign = sign.data(),
+                   .levels = levels.data(),
+                   .num_levels = num_levels,
+                   .used_below = used_below,
+                   .used_from = used_from,
+                   .disc = std::exp(-rate * dt),
+                   .init = true,
+                   .t = num_points - 1,
+                   .accumulate = num_points > 2,
+                   .regress = regress.data(),
+                   .beta = beta.data(),
+                   .xt = xt.data(),
+                   .cf = cf.data(),
+                   .partial = partial.data()};
+
+  const int isa = signature_kernel_isa();
+  const ChainPartial sum = chain_partial(s, total.data());
+  auto sweep = [&]() {
+    QuantKernel::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+      const size_t begin = c * chunk;
+      const size_t end = std::min(num_paths, begin + chunk);
+      double *p = s.partial + c * stride;
+#ifdef LSMC_X86_DISPATCH
+      switch (isa) {
+      case 2:
+        chain_range_avx512(s, begin, end, p);
+        return;
+      case 1:
+        chain_range_avx2(s, begin, end, p);
+        return;
+      default:
+        break;
+      }
+#else
+      (void)isa;
+#endif
+      chain_range<4>(s, begin, end, p);
+    });
+    // Chunk order, not completion order: same sums for any thread count
+    if (s.accumulate) {
+      std::fill(total.begin(), total.end(), 0.0);
+      for (size_t c = 0; c < chunks; ++c)
+        for (size_t e = 0; e < stride; ++e)
+          total[e] += s.partial[c * stride + e];
+    }
+    std::fill(sum.bound, sum.bound + num_options, -INFINITY);
+    for (size_t c = 0; c < chunks; ++c) {
+      const ChainPartial part = chain_partial(s, s.partial + c * stride);
+      for (size_t k = 0; k < num_options; ++k)
+        sum.bound[k] = std::max(sum.bound[k], part.bound[k]);
+    }
+  };
+
+  auto fit = [&]() {
+    // Puts sum buckets upwards, calls downwards
+    for (size_t b = 0; b < buckets; ++b)
+      for (size_t e = 0; e < mat; ++e)
+        prefix[b * mat + e] =
+            sum.gram[b * mat + e] + (b > 0 ? prefix[(b - 1) * mat + e] : 0.0);
+    for (size_t b = buckets; b-- > 0;)
+      for (size_t e = 0; e < mat; ++e)
+        suffix[b * mat + e] = sum.gram[b * mat + e] +
+                              (b + 1 < buckets ? suffix[(b + 1) * mat + e]
+                                               : 0.0);
+    for (size_t k = 0; k < num_options; ++k) {
+      double itm = 0.0;
+      const double *g;
+      if (is_put[k]) {
+        for (size_t b = 0; b <= 2 * level[k]; ++b)
+          itm += sum.count[b];
+        g = prefix.data() + 2 * level[k] * mat;
+      } else {
+        for (size_t b = 2 * level[k] + 2; b < buckets; ++b)
+          itm += sum.count[b];
+        g = suffix.data() + (2 * level[k] + 2) * mat;
+      }
+      regress[k] = itm > (double)basis &&
+                   lsmc_solve(g, rw, sum.xty + k * basis, 1, basis,
+                              beta.data() + k * basis);
+    }
+  };
+
+  if (out_boundary)
+    for (size_t k = 0; k < num_options; ++k) {
+      std::fill(out_boundary + k * num_points,
+                out_boundary + (k + 1) * num_points, NAN);
+      out_boundary[k * num_points + num_points - 1] = strikes[k];
+    }
+  sweep();
+  for (size_t t = num_points - 2; t >= 1; --t) {
+    fit();
+    s.init = false;
+    s.t = t;
+    s.accumulate = t > 1;
+    sweep();
+    if (out_boundary)
+      for (size_t k = 0; k < num_options; ++k)
+        if (std::isfinite(sum.bound[k]))
+          out_boundary[k * num_points + t] = -sign[k] * sum.bound[k];
+  }
+
+  for (size_t k = 0; k < num_options; ++k) {
+    double total_cf = 0.0;
+    for (size_t p = 0; p < num_paths; ++p)
+      total_cf += cf[k * num_paths + p];
+    out_prices[k] = total_cf / (double)num_paths * s.disc;
+  }
+  return 0;
+}
+}
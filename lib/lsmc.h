@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+
+/// Largest regressor count lsmc_american_price accepts.
+#define LSMC_MAX_BASIS 31
+
+/**
+ * @brief Price an American option by Longstaff-Schwartz on a path block.
+ *
+ * Native counterpart of American_pricing.LSMC.price_american: the same
+ * backward induction, the same per-path regressors (one row per path,
+ * e.g. the level-3 path signature from sabr_mc_simulate), and only paths
+ * in the money at a date enter its regression. The cash flow of every
+ * path not exercised is discounted one step per date.
+ *
+ * Each backward step is one parallel pass over the block that applies the
+ * exercise rule of date t and accumulates the normal equations of date
+ * t - 1. The least-squares fit is solved by ridge-regularized Cholesky on
+ * the scaled normal equations. Per-chunk partial sums are added in chunk
+ * order, so the price does not depend on the thread count.
+ *
+ * @param paths num_paths x num_points (t, S) pairs, back to back.
+ * @param sigs num_paths x basis regressors, row per path.
+ * @param num_paths Paths in the block.
+ * @param num_points Points per path (num_steps + 1), at least 2.
+ * @param basis Regressors per path, 1..LSMC_MAX_BASIS.
+ * @param strike Strike.
+ * @param rate Continuously compounded rate.
+ * @param dt Time between points in years.
+ * @param is_put Non-zero for a put, zero for a call.
+ * @param out_price Discounted price at time 0.
+ * @return 0 on success, -1 on invalid sizes (num_paths == 0,
+ *         num_points < 2, basis out of range).
+ */
+int lsmc_american_price(const double *paths, const double *sigs,
+                        size_t num_paths, size_t num_points, size_t basis,
+                        double strike, double rate, double dt, int is_put,
+                        double *out_price);
+
+/**
+ * @brief lsmc_american_price that also reports each path's exercise date.
+ *
+ * The stopping rule the price was computed with, for pricing on the same
+ * paths under that frozen rule (e.g. pathwise Greeks, see sabr_mc_greeks).
+ *
+ * @param out_exercise num_paths dates in 1..num_points - 1: the first
+ *                     date the path is exercised, num_points - 1 if it is
+ *                     held to maturity (in the money there or not), or
+ *                     nullptr.
+ * @return As lsmc_american_price.
+ */
+int lsmc_american_exercise(const double *paths, const double *sigs,
+                           size_t num_paths, size_t num_points, size_t basis,
+                           double strike, double rate, double dt, int is_put,
+                           double *out_price, uint32_t *out_exercise);
+
+/**
+ * @brief Price a chain of American puts and calls on one path block.
+ *
+ * Same recursion and result as one lsmc_american_price call per option,
+ * in one pass per date for the whole chain: spots and regressors are read
+ * once, and X'X is built once per date by bucketing paths between the
+ * distinct strikes (each option's in-the-money matrix is a prefix or
+ * suffix sum of bucket matrices). Cash flows take num_options x num_paths
+ * doubles.
+ *
+ * @param paths num_paths x num_points (t, S) pairs, back to back.
+ * @param sigs num_paths x basis regressors, row per path.
+ * @param num_paths Paths in the block.
+ * @param num_points Points per path (num_steps + 1), at least 2.
+ * @param basis Regressors per path, 1..LSMC_MAX_BASIS.
+ * @param strikes num_options strikes (any order, repeats allowed).
+ * @param is_put num_options flags, non-zero for a put.
+ * @param num_options At least 1.
+ * @param rate Continuously compounded rate.
+ * @param dt Time between points in years.
+ * @param out_prices num_options discounted prices at time 0.
+ * @param out_boundary num_options x num_points early-exercise boundaries,
+ *                     or nullptr: at date t the largest exercised spot of
+ *                     a put / smallest of a call, NaN where no path was
+ *                     exercised (and at t = 0), the strike at maturity.
+ * @return 0 on success, -1 on invalid sizes or a non-finite strike.
+ */
+int lsmc_american_chain(const double *paths, const double *sigs,
+                        size_t num_paths, size_t num_points, size_t basis,
+                        const double *strikes, const int *is_put,
+                        size_t num_options, double rate, double dt,
+                        double *out_prices, double *out_boundary);
+}
@@ -74,23 +74,14 @@ type manifold_state = {
   log_signature: float array; (* raw coefficients for visualization *)
 }
 
-(** Compute full manifold state from a path and its signature history. *)
-let compute_state path_arr sig_history_arr num_snapshots =
-  (* Expected signature (noise-filtered) *)
-  let expected_sig = Signature_bergomi.Signature.compute_expected_sig path_arr ~window_size:20 in
-  
-  (* Log-signature projection to Lie algebra *)
-  let logsig = Signature_bergomi.Signature.compute_log_signature expected_sig in
-  
+(** Pack a manifold state from a log-signature and a curvature value. *)
+let state_of_logsig logsig curvature =
   (* Manifold parameters *)
   let (mu, sigma2) = params_of_logsig logsig in
   
   (* Geodesic distances *)
   let d_crash = geodesic_distance (mu, sigma2) crash_ref in
   
-  (* Curvature from C++ *)
-  let curvature = Signature_bergomi.Signature.compute_curvature sig_history_arr num_snapshots in
-  
   (* Exhaustion *)
   let exhaust = exhaustion_score logsig in
   
@@ -106,3 +97,24 @@ let compute_state path_arr sig_history_arr num_snapshots =
     sigma2;
     log_signature = ls_arr;
   }
+
+(** Compute full manifold state from a path and its signature history. *)
+let compute_state path_arr sig_history_arr num_snapshots =
+  (* Expected signature (noise-filtered) *)
+  let expected_sig = Signature_bergomi.Signature.compute_expected_sig path_arr ~window_size:20 in
+  
+  (* Log-signature projection to Lie algebra *)
+  let logsig = Signature_bergomi.Signature.compute_log_signature expected_sig in
+  
+  (* Curvature from C++ *)
+  let curvature = Signature_bergomi.Signature.compute_curvature sig_history_arr num_snapshots in
+  
+  state_of_logsig logsig curvature
+
+(** Tick-driven manifold state: O(1) read of a live streaming signature.
+    Same features as [compute_state] on the stream's last points and its
+    snapshot history (for a window_size of 20). *)
+let compute_state_streaming stream =
+  let expected_sig = Signature_bergomi.Streaming.expected stream in
+  let logsig = Signature_bergomi.Signature.compute_log_signature expected_sig in
+  state_of_logsig logsig (Signature_bergomi.Streaming.curvature stream)
@@ -39,5 +39,12 @@ val compute_state :
   int -> 
   manifold_state
 
+(** Manifold state of a live streaming signature (window_size 20): the
+    same features [compute_state] returns for the stream's last
+    window_size + history - 1 points and its window snapshots, read from
+    the incrementally maintained expected signature and curvature; O(1)
+    per tick, no path re-integration. *)
+val compute_state_streaming : Signature_bergomi.Streaming.t -> manifold_state
+
 (** Computes the natural Riemannian distance between two points on the Fisher manifold. *)
 val geodesic_distance : (float * float) -> (float * float) -> float
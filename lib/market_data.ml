@@ -78,14 +78,17 @@ let run_simulator ?(symbol="HESTON-SIM") on_update =
   (* Simulation State *)
   let price = ref 100.0 in
   let vol = ref 0.09 in (* Variance actually, so sqrt(0.09) = 30% vol *)
-  let params = Heston.default_params in
+  let term = Heston.flat Heston.default_params in
 
   let rec loop () =
     (* High-frequency Loop: Update 10 times per second *)
     let dt = 0.1 in 
-    let (next_p, next_v) = Heston.simulate_step !price !vol dt params in
-    price := next_p;
-    vol := next_v;
+    (* One native QE step (true Gaussians, variance stays >= 0) *)
+    let step =
+      Heston.simulate term ~s0:!price ~v0:!vol ~dt ~num_steps:1 ~num_paths:1
+    in
+    price := step.Heston.terminal.{0};
+    vol := step.Heston.terminal.{1};
 
     (* Mock Ticker Object *)
     let t = {
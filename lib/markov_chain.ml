@@ -10,6 +10,10 @@ module Markov = struct
   let spmv_csr = 
     foreign ~from:handle "spmv_csr" (ptr double @-> ptr int @-> ptr int @-> int @-> int @-> ptr double @-> ptr double @-> int @-> returning void)
 
+  (* External SpMM binding: Y = A X for K row-major vectors (X: num_cols x K) *)
+  let spmm_csr =
+    foreign ~from:handle "spmm_csr" (ptr double @-> ptr int @-> ptr int @-> int @-> int @-> ptr double @-> int @-> ptr double @-> int @-> returning void)
+
   (* Graph representation: Adjacency list *)
   type transition = { target : int; prob : float }
   type graph = (int, transition list) Hashtbl.t
@@ -34,22 +38,139 @@ module Markov = struct
     ) g;
     new_g
 
-  let to_csr (g : graph) num_nodes =
-    let nnz = Hashtbl.fold (fun _ transitions acc -> acc + List.length transitions) g 0 in
-    let values = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout nnz in
-    let col_indices = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout nnz in
+  type int32_vec = (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+  type float_vec = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  external coo_to_csr_stub :
+    int32_vec -> int32_vec -> float_vec -> int -> float -> bool ->
+    int32_vec -> int32_vec -> float_vec -> int
+    = "caml_coo_to_csr_bytecode" "caml_coo_to_csr"
+
+  (* Native COO -> CSR: parallel counting sort by source, dropping edges
+     with prob < epsilon and (optionally) rescaling each row to sum to 1, in
+     one call. Edges keep their input order within a row. *)
+  let of_coo ?(epsilon = neg_infinity) ?(renormalize = false) ~num_nodes
+      (src : int32_vec) (dst : int32_vec) (prob : float_vec) : csr_matrix =
+    let n = Bigarray.Array1.dim src in
+    if Bigarray.Array1.dim dst <> n || Bigarray.Array1.dim prob <> n then
+      invalid_arg "Markov.of_coo: edge arrays differ in length";
+    let values = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout n in
+    let col_indices = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout n in
     let row_ptr = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout (num_nodes + 1) in
-    let current_idx = ref 0 in
-    Bigarray.Array1.set row_ptr 0 Int32.zero;
+    let nnz = coo_to_csr_stub src dst prob num_nodes epsilon renormalize row_ptr col_indices values in
+    { values = Bigarray.Array1.sub values 0 nnz;
+      col_indices = Bigarray.Array1.sub col_indices 0 nnz;
+      row_ptr; num_rows = num_nodes; num_cols = num_nodes; nnz }
+
+  (* Flattens rows 0 .. num_nodes - 1 of the graph into edge arrays *)
+  let edges_of_graph (g : graph) num_nodes =
+    let n = ref 0 in
+    for i = 0 to num_nodes - 1 do
+      match Hashtbl.find_opt g i with
+      | Some ts -> n := !n + List.length ts
+      | None -> ()
+    done;
+    let src = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout !n in
+    let dst = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout !n in
+    let prob = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout !n in
+    let k = ref 0 in
     for i = 0 to num_nodes - 1 do
-      let transitions = try Hashtbl.find g i with Not_found -> [] in
-      List.iter (fun t ->
-        Bigarray.Array1.set values !current_idx t.prob;
-        Bigarray.Array1.set col_indices !current_idx (Int32.of_int t.target);
-        incr current_idx
-      ) transitions;
-      Bigarray.Array1.set row_ptr (i+1) (Int32.of_int !current_idx);
+      match Hashtbl.find_opt g i with
+      | Some ts ->
+        List.iter (fun t ->
+          Bigarray.Array1.unsafe_set src !k (Int32.of_int i);
+          Bigarray.Array1.unsafe_set dst !k (Int32.of_int t.target);
+          Bigarray.Array1.unsafe_set prob !k t.prob;
+          incr k
+        ) ts
+      | None -> ()
     done;
-    { values; col_indices; row_ptr; num_rows = num_nodes; num_cols = num_nodes; nnz }
+    (src, dst, prob)
+
+  let to_csr (g : graph) num_nodes =
+    let src, dst, prob = edges_of_graph g num_nodes in
+    of_coo ~num_nodes src dst prob
+
+  (* prune_graph + to_csr in one native pass, rows renormalized by default *)
+  let prune_to_csr ?(renormalize = true) (g : graph) num_nodes epsilon =
+    let src, dst, prob = edges_of_graph g num_nodes in
+    of_coo ~epsilon ~renormalize ~num_nodes src dst prob
+
+  (* Native SpMV handle: built once from CSR, multithreaded multiply *)
+  module Sparse = struct
+    type t
+
+    (* Csr: plain copy; Sell: SELL-C-sigma (8-row chunks, SIMD gathers);
+       Bcsr: register-blocked CSR (2x2 or 4x4 dense blocks) *)
+    type format = Csr | Sell | Bcsr
+
+    external create_stub :
+      (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      int -> int -> int -> t
+      = "caml_sparse_matrix_create_bytecode" "caml_sparse_matrix_create"
+
+    external spmv :
+      t -> (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t -> unit
+      = "caml_sparse_matrix_spmv"
+
+    (* Stored entries (padding included) per non-zero *)
+    external fill_ratio : t -> float = "caml_sparse_matrix_fill_ratio"
+
+    let int_of_format = function Csr -> 0 | Sell -> 1 | Bcsr -> 2
+
+    (* [param]: sigma for Sell (default 256), block size for Bcsr (2 or 4) *)
+    let of_csr ?(format = Sell) ?(param = 0) (m : csr_matrix) =
+      create_stub m.values m.col_indices m.row_ptr m.num_cols
+        (int_of_format format) param
+  end
+
+  (* Native propagation engine: k-step forecasts and stationary
+     distributions without crossing the FFI per step *)
+  module Engine = struct
+    type t
+
+    type vec = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+    type method_ = Power | Arnoldi
+
+    external create_stub :
+      (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t -> t
+      = "caml_markov_engine_create"
+
+    external propagate_stub : t -> vec -> int -> vec -> unit
+      = "caml_markov_engine_propagate"
+
+    external stationary_stub : t -> int -> float -> int -> vec -> int * float
+      = "caml_markov_engine_stationary"
+
+    external num_states : t -> int = "caml_markov_engine_num_states"
+
+    (* Rows of [m] are "from" states; [m] must be square *)
+    let of_csr (m : csr_matrix) =
+      if m.num_rows <> m.num_cols then invalid_arg "Markov.Engine.of_csr: matrix not square";
+      create_stub m.values m.col_indices m.row_ptr
+
+    (* pi0 P^steps *)
+    let propagate t (pi0 : vec) steps =
+      let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (Bigarray.Array1.dim pi0) in
+      propagate_stub t pi0 steps out;
+      out
+
+    (* Returns (pi, SpMVs used, ||pi P - pi||_1). Power iteration suits
+       fast-mixing aperiodic chains; Arnoldi handles slow or periodic ones. *)
+    let stationary ?(method_ = Power) ?(tol = 1e-10) ?(max_iters = 10000) ?init t =
+      let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (num_states t) in
+      (match init with
+       | Some (v : vec) -> Bigarray.Array1.blit v out
+       | None -> Bigarray.Array1.fill out 0.0);
+      let code = match method_ with Power -> 0 | Arnoldi -> 1 in
+      let iters, residual = stationary_stub t code tol max_iters out in
+      (out, iters, residual)
+  end
 
 end
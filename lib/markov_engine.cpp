@@ -0,0 +1,334 @@
+#include "markov_engine.h"
+#include "metrics.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// =============================================================================
+// Markov Propagation: k-step forecast, power iteration, Arnoldi
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Push a regime distribution forward through the
+   transition graph without leaving C++: k steps for a forecast, or until
+   it stops changing for the long-run (stationary) distribution. Power
+   iteration is one SpMV per step; Arnoldi builds a small Krylov basis and
+   picks the best combination in it, which needs far fewer SpMVs when the
+   chain mixes slowly and still works when the chain is periodic.
+
+   [HS MATH]:
+   Step: π_{t+1} = Pᵀ π_t. Residual r = ||Pᵀ π - π||_1 with Σπ = 1.
+   Arnoldi on A = Pᵀ: A V_m = V_{m+1} H̄_m. With eigenvalue 1 known, the
+   stationary vector in span(V_m) minimizes
+     ||(A - I) V_m y||_2 = ||(H̄_m - Ī) y||_2,  ||y||_2 = 1,
+   i.e. y is the right singular vector of the smallest singular value of
+   the (m+1) x m matrix H̄_m - Ī. The new π = V_m y restarts the next cycle.
+
+   [SAFETY]:
+   - Orthogonalization is classical Gram-Schmidt applied twice (CGS2),
+     which keeps the basis orthogonal to working precision.
+   - π is re-normalized to Σπ = 1 each step, so sub-stochastic rows (e.g.
+     pruned graphs) converge to the quasi-stationary distribution instead
+     of decaying to zero.
+*/
+
+namespace {
+
+constexpr int MARKOV_DEFAULT_ITERS = 10000;
+
+// Right singular vector of the smallest singular value of the rows x cols
+// matrix M (row major, overwritten), by one-sided Jacobi.
+void smallest_right_singular(double *M, int rows, int cols, double *y) {
+  const int K = QuantKernel::MarkovEngine::KRYLOV_DIM;
+  double V[K * K];
+  for (int i = 0; i < cols; ++i)
+    for (int j = 0; j < cols; ++j)
+      V[i * cols + j] = i == j ? 1.0 : 0.0;
+
+  for (int sweep = 0; sweep < 60; ++sweep) {
+    bool rotated = false;
+    for (int p = 0; p < cols - 1; ++p) {
+      for (int q = p + 1; q < cols; ++q) {
+        double a = 0.0, b = 0.0, g = 0.0;
+        for (int i = 0; i < rows; ++i) {
+          a += M[i * cols + p] * M[i * cols + p];
+          b += M[i * cols + q] * M[i * cols + q];
+          g += M[i * cols + p] * M[i * cols + q];
+        }
+        if (std::abs(g) <= 1e-15 * std::sqrt(a * b) || g == 0.0)
+          continue;
+        rotated = true;
+        double zeta = (b - a) / (2.0 * g);
+        double t = (zeta >= 0.0 ? 1.0 : -1.0) /
+                   (std::abs(zeta) + std::sqrt(1.0 + zeta * zeta));
+        double c = 1.0 / std::sqrt(1.0 + t * t), s = c * t;
+        for (int i = 0; i < rows; ++i) {
+          double up = M[i * cols + p], uq = M[i * cols + q];
+          M[i * cols + p] = c * up - s * uq;
+          M[i * cols + q] = s * up + c * uq;
+        }
+        for (int i = 0; i < cols; ++i) {
+          double vp = V[i * cols + p], vq = V[i * cols + q];
+          V[i * cols + p] = c * vp - s * vq;
+          V[i * cols + q] = s * vp + c * vq;
+        }
+      }
+    }
+    if (!rotated)
+      break;
+  }
+
+  int best = 0;
+  double best_norm = std::numeric_limits<double>::infinity();
+  for (int j = 0; j < cols; ++j) {
+    double nrm = 0.0;
+    for (int i = 0; i < rows; ++i)
+      nrm += M[i * cols + j] * M[i * cols + j];
+    if (nrm < best_norm) {
+      best_norm = nrm;
+      best = j;
+    }
+  }
+  for (int i = 0; i < cols; ++i)
+    y[i] = V[i * cols + best];
+}
+
+} // namespace
+
+namespace QuantKernel {
+
+MarkovEngine::MarkovEngine(const double *values, const int *col_indices,
+                           const int *row_ptr, int num_states)
+    : n_(num_states), cur_(num_states), next_(num_states) {
+  // Pᵀ by counting sort on the column index
+  const int nnz = row_ptr[n_];
+  std::vector<int> t_ptr(n_ + 1, 0), t_cols(nnz);
+  std::vector<double> t_vals(nnz);
+  for (int k = 0; k < nnz; ++k)
+    ++t_ptr[col_indices[k] + 1];
+  for (int i = 0; i < n_; ++i)
+    t_ptr[i + 1] += t_ptr[i];
+  std::vector<int> fill(t_ptr.begin(), t_ptr.end() - 1);
+  for (int i = 0; i < n_; ++i) {
+    for (int k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+      int dst = fill[col_indices[k]]++;
+      t_cols[dst] = i;
+      t_vals[dst] = values[k];
+    }
+  }
+  pt_ = std::make_unique<SparseMatrix>(t_vals.data(), t_cols.data(),
+                                       t_ptr.data(), n_, n_,
+                                       SparseMatrix::SELL, 0);
+}
+
+void MarkovEngine::propagate(const double *pi0, int steps, double *out) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (steps <= 0) {
+    std::copy(pi0, pi0 + n_, out);
+    return;
+  }
+  // Ping-pong between the engine buffers, last step straight into out
+  const double *src = pi0;
+  for (int s = 0; s < steps; ++s) {
+    double *dst = (s == steps - 1) ? out : (s % 2 == 0 ? next_.data()
+                                                       : cur_.data());
+    pt_->multiply(src, dst);
+    src = dst;
+  }
+}
+
+double MarkovEngine::residual(std::vector<double> &x, std::vector<double> &y) {
+  double sum = 0.0;
+  for (int i = 0; i < n_; ++i)
+    sum += x[i];
+  if (sum != 0.0) {
+    const double inv = 1.0 / sum;
+    for (int i = 0; i < n_; ++i)
+      x[i] *= inv;
+  }
+  pt_->multiply(x.data(), y.data());
+  double r = 0.0;
+  for (int i = 0; i < n_; ++i)
+    r += std::abs(y[i] - x[i]);
+  return r;
+}
+
+double MarkovEngine::stationary(Method method, const double *init, double tol,
+                                int max_iters, double *out, int *iters) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (max_iters <= 0)
+    max_iters = MARKOV_DEFAULT_ITERS;
+  if (init)
+    std::copy(init, init + n_, cur_.begin());
+  else
+    std::fill(cur_.begin(), cur_.end(), 1.0 / n_);
+
+  int used = 0;
+  double r = method == ARNOLDI ? stationary_arnoldi(tol, max_iters, &used)
+                               : stationary_power(tol, max_iters, &used);
+
+  // Σπ = 1 already; clip round-off negatives left by the Krylov combination
+  double sum = 0.0;
+  for (int i = 0; i < n_; ++i)
+    sum += (out[i] = std::max(0.0, cur_[i]));
+  if (sum > 0.0)
+    for (int i = 0; i < n_; ++i)
+      out[i] /= sum;
+  if (iters)
+    *iters = used;
+  return r;
+}
+
+double MarkovEngine::stationary_power(double tol, int max_iters, int *iters) {
+  double r = std::numeric_limits<double>::infinity();
+  int used = 0;
+  while (used < max_iters) {
+    r = residual(cur_, next_);
+    ++used;
+    cur_.swap(next_);
+    if (r <= tol)
+      break;
+  }
+  *iters = used;
+  return r;
+}
+
+double MarkovEngine::stationary_arnoldi(double tol, int max_iters,
+                                        int *iters) {
+  const int m = std::min(KRYLOV_DIM, n_);
+  const size_t n = (size_t)n_;
+  if (basis_.size() < (m + 1) * n)
+    basis_.resize((m + 1) * n);
+  double *V = basis_.data();
+  ThreadPool &pool = ThreadPool::global();
+  const size_t parts = std::min(n, sparse_num_parts(n * m, pool.size()));
+  auto part_begin = [&](size_t p) { return n * p / parts; };
+
+  // h[0..j] = V_{0..j}ᵀ w, then w -= V h (one CGS pass)
+  if (partial_.size() < parts * (m + 1))
+    partial_.resize(parts * (m + 1));
+  double *partial = partial_.data();
+  auto cgs_pass = [&](int j, double *w, double *h) {
+    pool.parallel_for(parts, [&](size_t p) {
+      double *acc = &partial[p * (m + 1)];
+      for (int i = 0; i <= j; ++i) {
+        const double *v = V + i * n;
+        double s = 0.0;
+        for (size_t k = part_begin(p); k < part_begin(p + 1); ++k)
+          s += v[k] * w[k];
+        acc[i] = s;
+      }
+    });
+    for (int i = 0; i <= j; ++i) {
+      h[i] = 0.0;
+      for (size_t p = 0; p < parts; ++p)
+        h[i] += partial[p * (m + 1) + i];
+    }
+    pool.parallel_for(parts, [&](size_t p) {
+      for (int i = 0; i <= j; ++i) {
+        const double *v = V + i * n;
+        for (size_t k = part_begin(p); k < part_begin(p + 1); ++k)
+          w[k] -= h[i] * v[k];
+      }
+    });
+  };
+  auto norm2 = [&](const double *v) {
+    double s = 0.0;
+    for (size_t k = 0; k < n; ++k)
+      s += v[k] * v[k];
+    return std::sqrt(s);
+  };
+
+  int used = 1;
+  double r = residual(cur_, next_);
+  while (r > tol && used < max_iters) {
+    double H[(KRYLOV_DIM + 1) * KRYLOV_DIM] = {};
+    double h[KRYLOV_DIM + 1];
+    const double nrm = norm2(cur_.data());
+    for (size_t k = 0; k < n; ++k)
+      V[k] = cur_[k] / nrm;
+
+    int dim = 0;
+    for (int j = 0; j < m && used < max_iters; ++j) {
+      double *w = V + (j + 1) * n;
+      pt_->multiply(V + j * n, w);
+      ++used;
+      for (int pass = 0; pass < 2; ++pass) {
+        cgs_pass(j, w, h);
+        for (int i = 0; i <= j; ++i)
+          H[i * m + j] += h[i];
+      }
+      const double hn = norm2(w);
+      H[(j + 1) * m + j] = hn;
+      dim = j + 1;
+      if (hn < 1e-14) // invariant subspace: the answer is in span(V_dim)
+        break;
+      for (size_t k = 0; k < n; ++k)
+        w[k] /= hn;
+    }
+    if (dim == 0)
+      break;
+
+    // (H̄ - Ī) restricted to the dim columns built, compacted row major
+    double M[(KRYLOV_DIM + 1) * KRYLOV_DIM];
+    for (int i = 0; i <= dim; ++i)
+      for (int j = 0; j < dim; ++j)
+        M[i * dim + j] = H[i * m + j] - (i == j ? 1.0 : 0.0);
+    double y[KRYLOV_DIM];
+    smallest_right_singular(M, dim + 1, dim, y);
+
+    std::fill(cur_.begin(), cur_.end(), 0.0);
+    for (int j = 0; j < dim; ++j) {
+      const double *v = V + j * n;
+      for (size_t k = 0; k < n; ++k)
+        cur_[k] += y[j] * v[k];
+    }
+    r = residual(cur_, next_);
+    ++used;
+  }
+  *iters = used;
+  return r;
+}
+
+} // namespace QuantKernel
+
+extern "C" {
+
+QuantKernel::MarkovEngine *markov_engine_create(const double *values,
+                                                const int *col_indices,
+                                                const int *row_ptr,
+                                                int num_states) {
+  if (num_states <= 0 || row_ptr[0] != 0)
+    return nullptr;
+  for (int i = 0; i < num_states; ++i)
+    if (row_ptr[i + 1] < row_ptr[i])
+      return nullptr;
+  for (int k = 0; k < row_ptr[num_states]; ++k)
+    if (col_indices[k] < 0 || col_indices[k] >= num_states)
+      return nullptr;
+  return new QuantKernel::MarkovEngine(values, col_indices, row_ptr,
+                                       num_states);
+}
+
+void markov_engine_destroy(QuantKernel::MarkovEngine *engine) {
+  delete engine;
+}
+
+void markov_engine_propagate(QuantKernel::MarkovEngine *engine,
+                             const double *pi0, int steps, double *out) {
+  QK_METRIC_SCOPE("markov_engine_propagate",
+                  (size_t)engine->num_states() * 2 * sizeof(double));
+  engine->propagate(pi0, steps, out);
+}
+
+double markov_engine_stationary(QuantKernel::MarkovEngine *engine, int method,
+                                const double *init, double tol, int max_iters,
+                                double *out, int *out_iters) {
+  QK_METRIC_SCOPE("markov_engine_stationary",
+                  (size_t)engine->num_states() * sizeof(double));
+  return engine->stationary(method == 1
+                                ? QuantKernel::MarkovEngine::ARNOLDI
+                                : QuantKernel::MarkovEngine::POWER,
+                            init, tol, max_iters, out, out_iters);
+}
+}
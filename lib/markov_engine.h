@@ -0,0 +1,101 @@
+#pragma once
+
+#include "sparse_matrix.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+/**
+ * Distribution propagation on a row-stochastic transition matrix P
+ * (row = from-state, CSR as produced by Markov.to_csr).
+ *
+ * A distribution is a row vector, so one step is π <- π P = Pᵀ π. Pᵀ is
+ * formed once at construction and kept as a SELL-C-σ SparseMatrix, so each
+ * step is one multithreaded SpMV. Iteration buffers (and the Krylov basis
+ * and its reduction scratch, on first use) are owned by the engine;
+ * steady-state calls allocate nothing. Calls on one engine are serialized by an internal mutex.
+ */
+class MarkovEngine {
+public:
+  enum Method { POWER = 0, ARNOLDI = 1 };
+
+  /// Krylov basis size per Arnoldi restart.
+  static constexpr int KRYLOV_DIM = 16;
+
+  MarkovEngine(const double *values, const int *col_indices,
+               const int *row_ptr, int num_states);
+
+  int num_states() const { return n_; }
+
+  /// out = π0 Pᵏ.
+  void propagate(const double *pi0, int steps, double *out);
+
+  /**
+   * Stationary distribution π = π P (normalized to sum 1).
+   *
+   * @param init Starting guess, or nullptr for uniform.
+   * @param tol Stop once ||π P - π||_1 <= tol.
+   * @param max_iters Budget in SpMVs (both methods).
+   * @param iters Output: SpMVs used, or nullptr.
+   * @return Final residual ||π P - π||_1.
+   */
+  double stationary(Method method, const double *init, double tol,
+                    int max_iters, double *out, int *iters);
+
+private:
+  double stationary_power(double tol, int max_iters, int *iters);
+  double stationary_arnoldi(double tol, int max_iters, int *iters);
+  // Sum-normalizes x, applies Pᵀ into y and returns ||y - x||_1.
+  double residual(std::vector<double> &x, std::vector<double> &y);
+
+  int n_;
+  std::unique_ptr<SparseMatrix> pt_; // Pᵀ
+  std::mutex mu_;
+  std::vector<double> cur_, next_;
+  std::vector<double> basis_; // (KRYLOV_DIM + 1) x n, Arnoldi only
+  std::vector<double> partial_; // per-part CGS dot products, Arnoldi only
+};
+
+} // namespace QuantKernel
+
+extern "C" {
+/**
+ * @brief Build a propagation engine from a square CSR transition matrix.
+ *
+ * @return Owned handle; release with markov_engine_destroy. nullptr if the
+ *         CSR arrays are inconsistent.
+ */
+QuantKernel::MarkovEngine *markov_engine_create(const double *values,
+                                                const int *col_indices,
+                                                const int *row_ptr,
+                                                int num_states);
+
+void markov_engine_destroy(QuantKernel::MarkovEngine *engine);
+
+/**
+ * @brief k-step forecast: out = pi0 P^steps (num_states doubles each).
+ */
+void markov_engine_propagate(QuantKernel::MarkovEngine *engine,
+                             const double *pi0, int steps, double *out);
+
+/**
+ * @brief Stationary distribution by power iteration (method 0) or
+ *        restarted Arnoldi with the known eigenvalue 1 (method 1).
+ *
+ * Power iteration needs an aperiodic chain; Arnoldi also converges on
+ * periodic or slowly mixing chains, at the cost of a (16 + 1) x num_states
+ * basis allocated on its first call.
+ *
+ * @param init Starting guess, or nullptr for uniform.
+ * @param max_iters Budget in SpMVs (<= 0 -> 10000).
+ * @param out_iters SpMVs used, or nullptr.
+ * @return Final residual ||pi P - pi||_1.
+ */
+double markov_engine_stationary(QuantKernel::MarkovEngine *engine, int method,
+                                const double *init, double tol, int max_iters,
+                                double *out, int *out_iters);
+}
@@ -20,4 +20,22 @@ extern "C" {
 void spmv_csr(const double *values, const int *col_indices, const int *row_ptr,
               int num_rows, int num_cols, const double *x, double *y,
               int num_nnz);
+
+/**
+ * @brief Sparse x dense multi-vector product (SpMM): Y = A * X
+ *
+ * X holds num_vecs vectors stored row-major (num_cols x num_vecs), so the
+ * num_vecs entries multiplied by one A(i, j) are contiguous. Each matrix
+ * entry is loaded once per call and applied to all vectors with SIMD, in
+ * register tiles of 16 / 8 / 4 vectors.
+ *
+ * @param X Input block (num_cols x num_vecs, row-major).
+ * @param num_vecs Number of vectors K.
+ * @param Y Output block (num_rows x num_vecs, row-major).
+ * @param parallel Non-zero: split rows into nnz-balanced runs across the
+ *                 process-wide thread pool. Zero: calling thread only.
+ */
+void spmm_csr(const double *values, const int *col_indices, const int *row_ptr,
+              int num_rows, int num_cols, const double *X, int num_vecs,
+              double *Y, int parallel);
 }
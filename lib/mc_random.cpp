@@ -0,0 +1,154 @@
+#include "mc_random.h"
+#include <cmath>
+
+namespace QuantKernel {
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// Polynomials over GF(2) as bit masks (bit i = coefficient of x^i)
+uint64_t poly_mulmod(uint64_t a, uint64_t b, uint64_t p, int deg) {
+  uint64_t r = 0;
+  while (b) {
+    if (b & 1)
+      r ^= a;
+    b >>= 1;
+    a <<= 1;
+    if ((a >> deg) & 1)
+      a ^= p;
+  }
+  return r;
+}
+
+uint64_t poly_powmod_x(uint64_t e, uint64_t p, int deg) {
+  uint64_t base = 2, r = 1; // x (deg >= 2), 1
+  while (e) {
+    if (e & 1)
+      r = poly_mulmod(r, base, p, deg);
+    base = poly_mulmod(base, base, p, deg);
+    e >>= 1;
+  }
+  return r;
+}
+
+// p (degree deg, constant term 1) is primitive iff x has order 2^deg - 1
+bool is_primitive(uint64_t p, int deg) {
+  const uint64_t order = (1ULL << deg) - 1;
+  if (deg == 1)
+    return true; // x + 1
+  if (poly_powmod_x(order, p, deg) != 1)
+    return false;
+  uint64_t rest = order;
+  for (uint64_t q = 2; q * q <= rest; ++q) {
+    if (rest % q)
+      continue;
+    if (poly_powmod_x(order / q, p, deg) == 1)
+      return false;
+    while (rest % q == 0)
+      rest /= q;
+  }
+  return rest == 1 || poly_powmod_x(order / rest, p, deg) != 1;
+}
+
+std::vector<uint32_t> build_sobol_directions() {
+  std::vector<uint32_t> v(SOBOL_BITS * SOBOL_MAX_DIMS);
+  for (size_t k = 0; k < SOBOL_BITS; ++k)
+    v[k * SOBOL_MAX_DIMS] = 1u << (SOBOL_BITS - 1 - k); // van der Corput
+
+  size_t d = 1;
+  for (int deg = 1; d < SOBOL_MAX_DIMS; ++deg) {
+    for (uint64_t a = 0; a < (1ULL << (deg - 1)) && d < SOBOL_MAX_DIMS; ++a) {
+      const uint64_t p = (1ULL << deg) | (a << 1) | 1;
+      if (!is_primitive(p, deg))
+        continue;
+      uint64_t m[SOBOL_BITS + 1];
+      for (int k = 1; k <= deg && k <= (int)SOBOL_BITS; ++k)
+        m[k] = (splitmix64(d * 64 + (uint64_t)k) & ((1ULL << k) - 1)) | 1;
+      for (int k = deg + 1; k <= (int)SOBOL_BITS; ++k) {
+        uint64_t mk = m[k - deg] ^ (m[k - deg] << deg);
+        for (int j = 1; j < deg; ++j)
+          if ((a >> (deg - 1 - j)) & 1)
+            mk ^= m[k - j] << j;
+        m[k] = mk;
+      }
+      for (size_t k = 0; k < SOBOL_BITS; ++k)
+        v[k * SOBOL_MAX_DIMS + d] =
+            (uint32_t)(m[k + 1] << (SOBOL_BITS - 1 - k));
+      ++d;
+    }
+  }
+  return v;
+}
+
+} // namespace
+
+const uint32_t *sobol_directions() {
+  static const std::vector<uint32_t> table = build_sobol_directions();
+  return table.data();
+}
+
+uint32_t sobol_scramble_seed(uint64_t seed, size_t dim) {
+  return (uint32_t)splitmix64(seed ^ splitmix64((uint64_t)dim + 1));
+}
+
+void sobol_seek(uint64_t index, size_t dims, uint32_t *cur) {
+  const uint32_t *dirs = sobol_directions();
+  const uint64_t gray = index ^ (index >> 1);
+  for (size_t d = 0; d < dims; ++d)
+    cur[d] = 0;
+  for (size_t k = 0; k < SOBOL_BITS; ++k)
+    if ((gray >> k) & 1)
+      for (size_t d = 0; d < dims; ++d)
+        cur[d] ^= dirs[k * SOBOL_MAX_DIMS + d];
+}
+
+NormalSource::NormalSource(uint64_t seed, size_t steps, bool qmc)
+    : num_steps(steps), key0((uint32_t)seed), key1((uint32_t)(seed >> 32)) {
+  if (!qmc)
+    return;
+  qmc_seeds.resize(2 * steps);
+  for (size_t d = 0; d < 2 * steps; ++d)
+    qmc_seeds[d] = sobol_scramble_seed(seed, d);
+  bridge = std::make_unique<BrownianBridge>(steps);
+}
+
+BrownianBridge::BrownianBridge(size_t n)
+    : num_steps(n), left(n), right(n), index(n), w_left(n), w_right(n),
+      stddev(n) {
+  if (n == 0)
+    return;
+  // Point l sits at time l + 1; left[i] = j means the left neighbour is
+  // point j - 1 at time j (the origin when j = 0).
+  std::vector<size_t> filled(n, 0);
+  filled[n - 1] = 1;
+  index[0] = (uint32_t)(n - 1);
+  stddev[0] = std::sqrt((double)n);
+  size_t j = 0;
+  for (size_t i = 1; i < n; ++i) {
+    while (filled[j])
+      ++j;
+    size_t k = j;
+    while (!filled[k])
+      ++k;
+    const size_t l = j + ((k - 1 - j) >> 1);
+    filled[l] = i + 1;
+    index[i] = (uint32_t)l;
+    left[i] = (uint32_t)j;
+    right[i] = (uint32_t)k;
+    const double tj = (double)j, tl = (double)(l + 1), tk = (double)(k + 1);
+    w_left[i] = (tk - tl) / (tk - tj);
+    w_right[i] = (tl - tj) / (tk - tj);
+    stddev[i] = std::sqrt((tl - tj) * (tk - tl) / (tk - tj));
+    j = k + 1;
+    if (j >= n)
+      j = 0;
+  }
+}
+
+} // namespace QuantKernel
@@ -0,0 +1,440 @@
+#pragma once
+
+#include "simd_math.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// C++ internal API
+namespace QuantKernel {
+
+// =============================================================================
+// Monte Carlo Random Sources (Philox, scrambled Sobol, Brownian bridge)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: The random numbers behind the native path engines, W
+   lanes at a time. Two sources:
+   - Pseudo-random: Philox4x32-10, a pure function of (key, counter), so
+     any path can be drawn without drawing the ones before it.
+   - Quasi-random: Sobol points with Owen scrambling. Points fill the unit
+     cube far more evenly than random draws, so averages converge at close
+     to 1/N instead of 1/√N. The Brownian bridge hands the first (best
+     spread) coordinates to the moves that matter most: the end point,
+     then the midpoint, and so on.
+
+   [HS MATH]:
+   Sobol, dimension d, index i (Gray-code order g = i ^ (i >> 1)):
+     x_d(i) = ⊕_k g_k v_{d,k},   v_{d,k} = m_{d,k} 2^{32-k}
+     m_{d,k} = 2 a_1 m_{k-1} ⊕ ... ⊕ 2^{s-1} a_{s-1} m_{k-s+1}
+               ⊕ 2^s m_{k-s} ⊕ m_{k-s}           (k > s)
+   for the d-th primitive polynomial x^s + a_1 x^{s-1} + ... + 1 over
+   GF(2) (by degree, then coefficients). Dimension 0 is the van der
+   Corput sequence. Initial m_{d,1..s} are odd and < 2^k, from a fixed
+   hash of (d, k) instead of the Joe–Kuo search tables; the scrambling
+   and bridge ordering carry most of the gain at these dimensions.
+   Owen scrambling (Burley 2020): reverse the bits, apply the
+   Laine–Karras hash (each output bit depends only on lower input bits,
+   i.e. on the higher-order digits of the point), reverse back. This is
+   a nested uniform scramble seeded per (replication, dimension).
+   Brownian bridge on unit steps t = 1..N: W_N = √N z_0, then each
+   unfilled interval (j, k) gets its midpoint l from
+     W_l = ((k-l) W_j + (l-j) W_k) / (k-j) + √((l-j)(k-l)/(k-j)) z_i
+   and the increments W_n - W_{n-1} are i.i.d. N(0, 1) again.
+   Φ⁻¹ is Acklam's rational approximation (relative error < 1.2e-9).
+
+   [SAFETY]:
+   - 32-bit words live in 64-bit lanes, so products never overflow and
+     need no widening shuffles.
+   - Philox uniforms are (k + ½) 2^-52, Sobol ones (x + ½) 2^-32: never 0
+     or 1, so Φ⁻¹ stays finite.
+   - Sobol indices are 32-bit: at most 2^32 points per scramble.
+*/
+
+constexpr uint64_t PHILOX_M0 = 0xD2511F53u;
+constexpr uint64_t PHILOX_M1 = 0xCD9E8D57u;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9u;
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85u;
+constexpr uint64_t RNG_LOW32 = 0xffffffffu;
+
+constexpr size_t SOBOL_BITS = 32;
+constexpr size_t SOBOL_MAX_DIMS = 4096;
+
+// Acklam's inverse normal coefficients
+constexpr double ICDF_A[6] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                              -2.759285104469687e+02, 1.383577518672690e+02,
+                              -3.066479806614716e+01, 2.506628277459239e+00};
+constexpr double ICDF_B[5] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                              -1.556989798598866e+02, 6.680131188771972e+01,
+                              -1.328068155288572e+01};
+constexpr double ICDF_C[6] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                              -2.400758277161838e+00, -2.549732539343734e+00,
+                              4.374664141464968e+00,  2.938163982698783e+00};
+constexpr double ICDF_D[4] = {7.784695709041462e-03, 3.224671290700398e-01,
+                              2.445134137142996e+00, 3.754408661907416e+00};
+constexpr double ICDF_CENTRAL = 0.5 - 0.02425;
+
+// Vectors per inverse_normal_inplace gather pass (bounds its stack use)
+constexpr size_t ICDF_BLOCK = 64;
+
+// Steps per block of pre-drawn Philox normals
+constexpr size_t MC_TILE = 32;
+
+/// Sobol direction numbers, [SOBOL_BITS][SOBOL_MAX_DIMS] (bit k of every
+/// dimension is contiguous). Built once, on first use.
+const uint32_t *sobol_directions();
+
+/// Per-dimension scramble seed of a replication seed
+uint32_t sobol_scramble_seed(uint64_t seed, size_t dim);
+
+/// Unscrambled Sobol words of point `index` (Gray-code order) in
+/// dimensions [0, dims): the state sobol_uniform_lanes advances.
+void sobol_seek(uint64_t index, size_t dims, uint32_t *cur);
+
+/**
+ * Brownian bridge over num_steps unit steps. Input k is the k-th normal
+ * in bridge order (end point first); output n is the increment of step n.
+ */
+struct BrownianBridge {
+  size_t num_steps = 0;
+  std::vector<uint32_t> left, right, index; // left = 0: no left neighbour
+  std::vector<double> w_left, w_right, stddev;
+
+  explicit BrownianBridge(size_t n);
+
+  // in[k * stride] -> out[n * stride], W lanes; in and out must not alias
+  template <int W>
+  __attribute__((always_inline)) inline void
+  apply(const typename Lanes<W>::vec *in, typename Lanes<W>::vec *out,
+        size_t stride) const {
+    if (num_steps == 0)
+      return;
+    // Positions W_1..W_N in out, then differenced in place
+    out[(num_steps - 1) * stride] = stddev[0] * in[0];
+    for (size_t i = 1; i < num_steps; ++i) {
+      const size_t l = index[i], k = right[i];
+      typename Lanes<W>::vec v =
+          w_right[i] * out[k * stride] + stddev[i] * in[i * stride];
+      if (left[i])
+        v += w_left[i] * out[(left[i] - 1) * stride];
+      out[l * stride] = v;
+    }
+    for (size_t n = num_steps - 1; n > 0; --n)
+      out[n * stride] -= out[(n - 1) * stride];
+  }
+};
+
+/**
+ * Where a path engine's Gaussians come from: two standard normals per
+ * step, from Philox keyed by seed or (qmc) from scrambled Sobol points in
+ * 2 * num_steps dimensions through a Brownian bridge, scrambled by seed.
+ * Dimension 2k + j drives the k-th bridge node of normal j.
+ */
+struct NormalSource {
+  size_t num_steps = 0;
+  uint32_t key0 = 0, key1 = 0;
+  std::vector<uint32_t> qmc_seeds; // per dimension; empty for Philox
+  std::unique_ptr<BrownianBridge> bridge;
+
+  NormalSource(uint64_t seed, size_t steps, bool qmc);
+  bool qmc() const { return bridge != nullptr; }
+};
+
+// Low 32 bits of each lane times m (< 2^32), full 64-bit product. Spelled
+// as pmuludq where available: the generic 64-bit multiply lowers to the
+// much slower vpmullq (or a 3-multiply sequence without AVX512DQ).
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::uvec
+mul_lo32(typename Lanes<W>::uvec a, uint64_t m) {
+#if defined(__AVX512F__)
+  if constexpr (W == 8)
+    return (typename Lanes<W>::uvec)_mm512_mul_epu32((__m512i)a,
+                                                     _mm512_set1_epi64(m));
+#endif
+#if defined(__AVX2__)
+  if constexpr (W == 4)
+    return (typename Lanes<W>::uvec)_mm256_mul_epu32((__m256i)a,
+                                                     _mm256_set1_epi64x(m));
+#endif
+  return (a & RNG_LOW32) * m;
+}
+
+// Philox4x32-10 on W counters; c[j] holds 32-bit word j of every lane.
+template <int W>
+__attribute__((always_inline)) inline void
+philox4x32(typename Lanes<W>::uvec c[4], uint32_t k0, uint32_t k1) {
+  typedef typename Lanes<W>::uvec uvec;
+  for (int round = 0; round < 10; ++round) {
+    uvec p0 = mul_lo32<W>(c[0], PHILOX_M0);
+    uvec p1 = mul_lo32<W>(c[2], PHILOX_M1);
+    uvec n0 = (p1 >> 32) ^ c[1] ^ (uint64_t)k0;
+    uvec n2 = (p0 >> 32) ^ c[3] ^ (uint64_t)k1;
+    c[0] = n0;
+    c[1] = p1 & RNG_LOW32;
+    c[2] = n2;
+    c[3] = p0 & RNG_LOW32;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+
+// Two 32-bit words -> uniform in (0, 1) with 52 random bits
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::vec
+uniform_open(typename Lanes<W>::uvec hi, typename Lanes<W>::uvec lo) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::uvec uvec;
+  uvec bits = (hi << 20) ^ (lo >> 12);
+  vec one_two = (vec)(bits | 0x3ff0000000000000ULL); // [1, 2)
+  return one_two - (1.0 - 0x1p-53);
+}
+
+// Owen scramble of 32-bit Sobol words (one per lane) with a 32-bit seed
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::uvec
+owen_scramble(typename Lanes<W>::uvec x, uint32_t seed) {
+  auto reverse = [](typename Lanes<W>::uvec v) {
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0f0f0f0fu) | ((v & 0x0f0f0f0fu) << 4);
+    v = ((v >> 8) & 0x00ff00ffu) | ((v & 0x00ff00ffu) << 8);
+    return ((v >> 16) & 0xffffu) | ((v & 0xffffu) << 16);
+  };
+  x = reverse(x);
+  x = (x + (uint64_t)seed) & RNG_LOW32;
+  x ^= mul_lo32<W>(x, 0x6c50b47cu) & RNG_LOW32;
+  x ^= mul_lo32<W>(x, 0xb82f1e52u) & RNG_LOW32;
+  x ^= mul_lo32<W>(x, 0xc7afe638u) & RNG_LOW32;
+  x ^= mul_lo32<W>(x, 0x8d22f6e6u) & RNG_LOW32;
+  return reverse(x);
+}
+
+// 32-bit word -> (x + ½) 2^-32
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::vec
+uniform_from_u32(typename Lanes<W>::uvec x) {
+  typedef typename Lanes<W>::vec vec;
+  vec xf = (vec)(x | 0x4330000000000000ULL) - 0x1p52; // exact for x < 2^52
+  return (xf + 0.5) * 0x1p-32;
+}
+
+// Scrambled Sobol uniforms of points index .. index + W - 1 (one per lane):
+// u[d] holds dimension d. cur holds the words of point `index` on entry
+// (see sobol_seek) and of point index + W on return; words is dims * W
+// scratch.
+template <int W>
+__attribute__((always_inline)) inline void
+sobol_uniform_lanes(const uint32_t *seeds, size_t dims, uint64_t index,
+                    uint32_t *cur, uint64_t *words,
+                    typename Lanes<W>::vec *u) {
+  typedef typename Lanes<W>::uvec uvec;
+  const uint32_t *dirs = sobol_directions();
+  for (int w = 0; w < W; ++w) {
+    for (size_t d = 0; d < dims; ++d)
+      words[d * W + w] = cur[d];
+    // Gray code: point i + 1 differs from point i in bit ctz(i + 1)
+    const int k = __builtin_ctzll(index + (uint64_t)w + 1);
+    if (k < (int)SOBOL_BITS) {
+      const uint32_t *v = dirs + (size_t)k * SOBOL_MAX_DIMS;
+      for (size_t d = 0; d < dims; ++d)
+        cur[d] ^= v[d];
+    }
+  }
+  for (size_t d = 0; d < dims; ++d) {
+    uvec x;
+    std::memcpy(&x, words + d * W, sizeof x);
+    u[d] = uniform_from_u32<W>(owen_scramble<W>(x, seeds[d]));
+  }
+}
+
+// Φ⁻¹ on the central region |u - ½| <= ICDF_CENTRAL (other lanes garbage)
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::vec
+inverse_normal_central(typename Lanes<W>::vec u) {
+  typedef typename Lanes<W>::vec vec;
+  vec q = u - 0.5;
+  vec r = q * q;
+  vec num = vec{} + ICDF_A[0];
+  for (int k = 1; k < 6; ++k)
+    num = num * r + ICDF_A[k];
+  vec den = vec{} + ICDF_B[0];
+  for (int k = 1; k < 5; ++k)
+    den = den * r + ICDF_B[k];
+  den = den * r + 1.0;
+  return num * q / den;
+}
+
+// Φ⁻¹ on the tails |u - ½| > ICDF_CENTRAL
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::vec
+inverse_normal_tail(typename Lanes<W>::vec u) {
+  typedef typename Lanes<W>::vec vec;
+  vec lower = u < 0.5 ? u : 1.0 - u;
+  vec t = vsqrt<W>(-2.0 * vlog<W>(lower));
+  vec tn = vec{} + ICDF_C[0];
+  for (int k = 1; k < 6; ++k)
+    tn = tn * t + ICDF_C[k];
+  vec td = vec{} + ICDF_D[0];
+  for (int k = 1; k < 4; ++k)
+    td = td * t + ICDF_D[k];
+  td = td * t + 1.0;
+  vec xt = tn / td; // lower-tail quantile (negative)
+  return u < 0.5 ? xt : -xt;
+}
+
+// Φ⁻¹ of count vectors of uniforms, in place. Central lanes are evaluated
+// where they sit; the ~5% tail lanes are gathered across ICDF_BLOCK
+// vectors and evaluated W at a time, so the tail formula costs a full
+// vector only once per W tail draws instead of whenever any lane needs it.
+template <int W>
+__attribute__((always_inline)) inline void
+inverse_normal_inplace(typename Lanes<W>::vec *u, size_t count) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+
+  // Tail draws: flat index k * W + w into the block, and its uniform
+  uint32_t tail_idx[ICDF_BLOCK * W];
+  alignas(64) double tail_u[ICDF_BLOCK * W];
+
+  for (size_t b0 = 0; b0 < count; b0 += ICDF_BLOCK) {
+    vec *blk = u + b0;
+    const size_t len = count - b0 < ICDF_BLOCK ? count - b0 : ICDF_BLOCK;
+    size_t num_tail = 0;
+    for (size_t k = 0; k < len; ++k) {
+      const vec uk = blk[k];
+      vec q = uk - 0.5;
+      ivec tail = (q > ICDF_CENTRAL) | (q < -ICDF_CENTRAL);
+      blk[k] = inverse_normal_central<W>(uk);
+      // Lane mask as bits (one movmsk), then visit only the set lanes
+      unsigned bits = 0;
+      for (int w = 0; w < W; ++w)
+        bits |= (unsigned)(tail[w] & 1) << w;
+      while (bits) {
+        const int w = __builtin_ctz(bits);
+        bits &= bits - 1;
+        tail_idx[num_tail] = (uint32_t)(k * W + w);
+        tail_u[num_tail++] = uk[w];
+      }
+    }
+
+    double *zf = (double *)blk;
+    for (size_t k = 0; k < num_tail; k += W) {
+      vec t;
+      for (int w = 0; w < W; ++w)
+        t[w] = k + w < num_tail ? tail_u[k + w] : 0.01; // padding: any tail u
+      vec x = inverse_normal_tail<W>(t);
+      for (size_t w = 0; w < W && k + w < num_tail; ++w)
+        zf[tail_idx[k + w]] = x[w];
+    }
+  }
+}
+
+// Philox uniforms behind normal 0 and 1 of `step` for paths path_lo/hi
+// (low / high 32 bits of each lane's path index) into u[0], u[1]
+template <int W>
+__attribute__((always_inline)) inline void
+philox_step_uniforms(const NormalSource &src, typename Lanes<W>::uvec path_lo,
+                     typename Lanes<W>::uvec path_hi, uint64_t step,
+                     typename Lanes<W>::vec *u) {
+  typedef typename Lanes<W>::uvec uvec;
+  uvec c[4] = {uvec{} + (step & RNG_LOW32), uvec{} + (step >> 32), path_lo,
+               path_hi};
+  philox4x32<W>(c, src.key0, src.key1);
+  u[0] = uniform_open<W>(c[0], c[1]);
+  u[1] = uniform_open<W>(c[2], c[3]);
+}
+
+// Philox normals for W paths, drawn MC_TILE steps at a time.
+// tile(n, len)[2 s + j] holds normal j of step n + s.
+template <int W> struct PhiloxNormals {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::uvec uvec;
+
+  const NormalSource &src;
+  uvec path_lo, path_hi;
+  vec z[2 * MC_TILE];
+
+  __attribute__((always_inline)) PhiloxNormals(const NormalSource &source,
+                                               uint64_t path0)
+      : src(source) {
+    for (int w = 0; w < W; ++w) {
+      path_lo[w] = (path0 + (uint64_t)w) & RNG_LOW32;
+      path_hi[w] = (path0 + (uint64_t)w) >> 32;
+    }
+  }
+
+  __attribute__((always_inline)) const vec *tile(size_t step0, size_t len) {
+    for (size_t s = 0; s < len; ++s)
+      philox_step_uniforms<W>(src, path_lo, path_hi, step0 + s, z + 2 * s);
+    inverse_normal_inplace<W>(z, 2 * len);
+    return z;
+  }
+};
+
+// Sobol normals for W paths: the whole path's 2N normals are built up
+// front (the bridge needs every node), tile() just indexes into them.
+template <int W> struct SobolNormals {
+  typedef typename Lanes<W>::vec vec;
+
+  const vec *z;
+
+  // cur: Sobol state at point path0 (advanced to path0 + W); words, u,
+  // zbuf: 2N-vector scratch
+  __attribute__((always_inline)) SobolNormals(const NormalSource &src,
+                                              uint64_t path0, uint32_t *cur,
+                                              uint64_t *words, vec *u,
+                                              vec *zbuf)
+      : z(zbuf) {
+    const size_t dims = 2 * src.num_steps;
+    sobol_uniform_lanes<W>(src.qmc_seeds.data(), dims, path0, cur, words, u);
+    inverse_normal_inplace<W>(u, dims);
+    src.bridge->template apply<W>(u, zbuf, 2);
+    src.bridge->template apply<W>(u + 1, zbuf + 1, 2);
+  }
+
+  __attribute__((always_inline)) const vec *tile(size_t step0, size_t) {
+    return z + 2 * step0;
+  }
+};
+
+// Calls body(normals, p) for p = begin, begin + W, ... < end, where
+// normals (PhiloxNormals / SobolNormals) serves paths first_path + p ..
+// first_path + p + W - 1.
+template <int W, class Body>
+__attribute__((always_inline)) inline void
+for_each_path_block(const NormalSource &src, uint64_t first_path,
+                    size_t begin, size_t end, Body &&body) {
+  typedef typename Lanes<W>::vec vec;
+  if (!src.qmc()) {
+    for (size_t p = begin; p < end; p += W) {
+      PhiloxNormals<W> normals(src, first_path + p);
+      body(normals, p);
+    }
+    return;
+  }
+
+  // Per-thread scratch for the QMC normals, grown on demand
+  const size_t dims = 2 * src.num_steps;
+  static thread_local std::vector<vec> u, z;
+  static thread_local std::vector<uint64_t> words;
+  static thread_local std::vector<uint32_t> cur;
+  if (u.size() < dims) {
+    u.resize(dims);
+    z.resize(dims);
+    words.resize(dims * W);
+    cur.resize(dims);
+  }
+  sobol_seek(first_path + begin, dims, cur.data());
+  for (size_t p = begin; p < end; p += W) {
+    SobolNormals<W> normals(src, first_path + p, cur.data(), words.data(),
+                            u.data(), z.data());
+    body(normals, p);
+  }
+}
+
+} // namespace QuantKernel
@@ -0,0 +1,129 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+
+// =============================================================================
+// Kernel Metrics Registry
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Every instrumented entry point drops its latency into a
+   histogram owned by the calling thread, so recording never contends.
+   Asking for p99 adds up all threads' histograms at that moment.
+
+   [HS MATH]:
+   Bucket of v >= 16 ns: e = floor(log2 v), sub = next 4 bits below the
+   leading one; index (e - 3) · 16 + sub covers [2^e (1 + sub/16),
+   2^e (1 + (sub+1)/16)). Values < 16 ns get exact buckets. Percentile q is
+   the first bucket whose cumulative count reaches ceil(q · N), reported at
+   the bucket midpoint.
+
+   [SAFETY]:
+   - Counters are written by one thread and read racily by the merger with
+     relaxed atomics: a snapshot may miss in-flight calls but never tears.
+   - Thread slots are never freed, so counts from finished threads stay.
+*/
+
+namespace QuantKernel {
+
+int Metrics::register_kernel(const char *name) {
+  std::lock_guard<std::mutex> lock(mu_);
+  const int n = num_kernels_.load(std::memory_order_relaxed);
+  for (int i = 0; i < n; ++i)
+    if (names_[i] == name)
+      return i;
+  if (n == MAX_KERNELS)
+    return -1;
+  names_[n] = name;
+  num_kernels_.store(n + 1, std::memory_order_release);
+  return n;
+}
+
+Metrics::Histogram *Metrics::thread_histogram(int id) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!tls_) {
+    threads_.push_back(std::make_unique<ThreadSlots>());
+    tls_ = threads_.back()->slot;
+  }
+  if (!tls_[id])
+    tls_[id] = std::make_unique<Histogram>();
+  return tls_[id].get();
+}
+
+double Metrics::bucket_value(int b) {
+  if (b < SUB_BUCKETS)
+    return (double)b;
+  const int e = b / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+  const int sub = b % SUB_BUCKETS;
+  const double width = std::ldexp(1.0, e - SUB_BUCKET_BITS);
+  return (double)(SUB_BUCKETS + sub) * width + 0.5 * width;
+}
+
+Metrics::Summary Metrics::summary(int id) const {
+  Summary s;
+  if (id < 0 || id >= num_kernels())
+    return s;
+
+  std::vector<uint64_t> merged(NUM_BUCKETS, 0);
+  uint64_t total_ns = 0, max_ns = 0;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto &t : threads_) {
+      const Histogram *h = t->slot[id].get();
+      if (!h)
+        continue;
+      for (int b = 0; b < NUM_BUCKETS; ++b)
+        merged[b] += h->buckets[b].load(std::memory_order_relaxed);
+      s.calls += h->calls.load(std::memory_order_relaxed);
+      s.bytes += h->bytes.load(std::memory_order_relaxed);
+      total_ns += h->total_ns.load(std::memory_order_relaxed);
+      max_ns = std::max(max_ns, h->max_ns.load(std::memory_order_relaxed));
+    }
+  }
+
+  uint64_t n = 0;
+  for (uint64_t c : merged)
+    n += c;
+  if (n == 0)
+    return s;
+  auto percentile = [&](double q) {
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * n));
+    uint64_t cum = 0;
+    for (int b = 0; b < NUM_BUCKETS; ++b) {
+      cum += merged[b];
+      if (cum >= rank)
+        return std::min(bucket_value(b), (double)max_ns);
+    }
+    return (double)max_ns;
+  };
+  s.mean_ns = (double)total_ns / (double)s.calls;
+  s.p50_ns = percentile(0.50);
+  s.p99_ns = percentile(0.99);
+  s.p999_ns = percentile(0.999);
+  s.max_ns = (double)max_ns;
+  return s;
+}
+
+} // namespace QuantKernel
+
+extern "C" {
+
+int metrics_num_kernels(void) {
+  return QuantKernel::Metrics::instance().num_kernels();
+}
+
+const char *metrics_kernel_name(int id) {
+  return QuantKernel::Metrics::instance().kernel_name(id);
+}
+
+void metrics_kernel_summary(int id, double *out) {
+  QuantKernel::Metrics::Summary s =
+      QuantKernel::Metrics::instance().summary(id);
+  out[0] = (double)s.calls;
+  out[1] = (double)s.bytes;
+  out[2] = s.mean_ns;
+  out[3] = s.p50_ns;
+  out[4] = s.p99_ns;
+  out[5] = s.p999_ns;
+  out[6] = s.max_ns;
+}
+}
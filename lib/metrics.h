@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Build with -DQK_DISABLE_METRICS to compile every QK_METRIC_SCOPE out.
+
+namespace QuantKernel {
+
+/**
+ * Always-on per-kernel latency histograms and call / byte counters.
+ *
+ * Each thread records into its own histograms (single writer, relaxed
+ * atomics, no lock); readers merge every thread's copy on demand. Buckets
+ * are HDR-style log-linear: 16 linear sub-buckets per power of two of
+ * nanoseconds, so any reported percentile is within 6.25% of the true
+ * value, from 1 ns up to ~18 minutes.
+ *
+ * Entry points register once per call site through QK_METRIC_SCOPE, which
+ * costs two steady_clock reads and a handful of thread-local stores per
+ * call.
+ */
+class Metrics {
+public:
+  static constexpr int MAX_KERNELS = 64;
+  static constexpr int SUB_BUCKET_BITS = 4;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static constexpr int MAX_EXPONENT = 40; // 2^40 ns
+  static constexpr int NUM_BUCKETS =
+      (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+  struct Histogram {
+    std::atomic<uint64_t> buckets[NUM_BUCKETS] = {};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+  };
+
+  /// Merged view of one kernel across all threads.
+  struct Summary {
+    uint64_t calls = 0, bytes = 0;
+    double mean_ns = 0, p50_ns = 0, p99_ns = 0, p999_ns = 0, max_ns = 0;
+  };
+
+  static Metrics &instance() {
+    static Metrics metrics;
+    return metrics;
+  }
+
+  /// Stable id for a kernel name (idempotent); -1 once MAX_KERNELS are in
+  /// use. Takes a lock, call once per call site.
+  int register_kernel(const char *name);
+
+  int num_kernels() const { return num_kernels_.load(std::memory_order_acquire); }
+  const char *kernel_name(int id) const { return names_[id].c_str(); }
+
+  void record(int id, uint64_t ns, uint64_t bytes) {
+    if (id < 0)
+      return;
+    Histogram *h = tls_ ? tls_[id].get() : nullptr;
+    if (!h)
+      h = thread_histogram(id);
+    bump(h->buckets[bucket_of(ns)], 1);
+    bump(h->calls, 1);
+    bump(h->bytes, bytes);
+    bump(h->total_ns, ns);
+    if (ns > h->max_ns.load(std::memory_order_relaxed))
+      h->max_ns.store(ns, std::memory_order_relaxed);
+  }
+
+  Summary summary(int id) const;
+
+  static int bucket_of(uint64_t ns) {
+    if (ns < (uint64_t)SUB_BUCKETS)
+      return (int)ns;
+    const int e = 63 - __builtin_clzll(ns); // >= SUB_BUCKET_BITS
+    if (e > MAX_EXPONENT)
+      return NUM_BUCKETS - 1;
+    const int sub = (int)(ns >> (e - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (e - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+  }
+  /// Midpoint of a bucket's [lo, hi) range in ns.
+  static double bucket_value(int b);
+
+private:
+  Metrics() = default;
+
+  // Single writer per histogram: a load + store is enough, no RMW.
+  static void bump(std::atomic<uint64_t> &c, uint64_t v) {
+    c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+  }
+
+  Histogram *thread_histogram(int id);
+
+  struct ThreadSlots {
+    std::unique_ptr<Histogram> slot[MAX_KERNELS];
+  };
+  inline static thread_local std::unique_ptr<Histogram> *tls_ = nullptr;
+
+  mutable std::mutex mu_;
+  std::string names_[MAX_KERNELS];
+  std::atomic<int> num_kernels_{0};
+  // One slot array per thread that ever recorded; kept after thread exit
+  // so its counts stay in the totals.
+  std::vector<std::unique_ptr<ThreadSlots>> threads_;
+};
+
+#ifndef QK_DISABLE_METRICS
+
+// RAII Helper: times the enclosing scope into kernel id
+class MetricScope {
+  int id_;
+  uint64_t bytes_;
+  std::chrono::steady_clock::time_point start_;
+
+public:
+  MetricScope(int id, uint64_t bytes)
+      : id_(id), bytes_(bytes), start_(std::chrono::steady_clock::now()) {}
+  ~MetricScope() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start_)
+                  .count();
+    Metrics::instance().record(id_, (uint64_t)ns, bytes_);
+  }
+
+  MetricScope(const MetricScope &) = delete;
+  MetricScope &operator=(const MetricScope &) = delete;
+};
+
+#define QK_METRIC_CONCAT_(a, b) a##b
+#define QK_METRIC_CONCAT(a, b) QK_METRIC_CONCAT_(a, b)
+/// Times the rest of the enclosing scope as kernel `name`, moving `bytes`.
+#define QK_METRIC_SCOPE(name, bytes)                                           \
+  static const int QK_METRIC_CONCAT(qk_metric_id_, __LINE__) =                 \
+      ::QuantKernel::Metrics::instance().register_kernel(name);                \
+  ::QuantKernel::MetricScope QK_METRIC_CONCAT(qk_metric_scope_, __LINE__)(     \
+      QK_METRIC_CONCAT(qk_metric_id_, __LINE__), (uint64_t)(bytes))
+
+#else
+
+#define QK_METRIC_SCOPE(name, bytes) ((void)0)
+
+#endif
+
+} // namespace QuantKernel
+
+extern "C" {
+/// Number of kernels registered so far (ids are 0 .. n-1).
+int metrics_num_kernels(void);
+
+/// Name of kernel id (valid for the life of the process).
+const char *metrics_kernel_name(int id);
+
+/**
+ * @brief Merged statistics of kernel id across all threads.
+ *
+ * @param out 7 doubles: calls, bytes, mean, p50, p99, p999, max (times in
+ *            nanoseconds).
+ */
+void metrics_kernel_summary(int id, double *out);
+}
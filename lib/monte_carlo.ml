@@ -1,33 +1,123 @@
-open Domain
-
 module Engine = struct
   type config = {
     num_paths: int;
     num_steps: int;
     dt: float;
-    num_domains: int;
+    num_domains: int; (* unused: threads come from the native pool *)
   }
 
-  (* SABR Path Generation: dS = sigma * S^beta * dW, dsigma = nu * sigma * dZ *)
-  let simulate_path config (s0, sigma0) beta rho nu =
-    let path = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (config.num_steps * 2) in
-    let rec loop i s sigma =
-      if i >= config.num_steps then ()
-      else
-        let z1 = Random.float 2.0 -. 1.0 in (* Simple uniform approximation for demo *)
-        let z2 = Random.float 2.0 -. 1.0 in
-        let dw = z1 *. Float.sqrt config.dt in
-        let dz = (rho *. z1 +. Float.sqrt (1.0 -. rho *. rho) *. z2) *. Float.sqrt config.dt in
-        
-        let s_new = s +. sigma *. (Float.pow s beta) *. dw in
-        let sigma_new = sigma *. Float.exp (nu *. dz -. 0.5 *. nu *. nu *. config.dt) in
-        
-        path.{2*i} <- float_of_int i *. config.dt;
-        path.{2*i + 1} <- s_new;
-        loop (i + 1) s_new sigma_new
+  type buf = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  external sabr_mc_stub :
+    buf -> float -> float -> int -> int -> int -> int -> buf -> buf -> unit
+    = "caml_sabr_mc_simulate_bytecode" "caml_sabr_mc_simulate"
+
+  external sabr_qmc_stub :
+    buf -> float -> float -> int -> int -> int -> int -> buf -> buf -> int
+    = "caml_sabr_qmc_simulate_bytecode" "caml_sabr_qmc_simulate"
+
+  let empty : buf = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout 0
+
+  (* Params buffer and output blocks for one native call *)
+  let outputs ~store_paths config (sigma0, beta, rho, nu) =
+    let params = Memory_bridge.Bridge.create_buffer 1 in
+    Memory_bridge.Bridge.set_param params 0 (sigma0, beta, rho, nu);
+    let paths =
+      if store_paths then
+        Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout
+          (config.num_paths * 2 * (config.num_steps + 1))
+      else empty
     in
-    loop 0 s0 sigma0;
-    path
+    let sigs =
+      Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (config.num_paths * 15)
+    in
+    (params, paths, sigs)
+
+  (* Native SABR paths: dS = sigma * S^beta * dW, dsigma = nu * sigma * dZ.
+     Returns [(paths, signatures)]: [paths] holds num_paths paths of
+     num_steps + 1 (t, S) pairs back to back (empty if [store_paths] is
+     false), [signatures] num_paths x 15 level-3 signatures. Gaussians come
+     from a counter-based generator, so a (seed, first_path) pair gives the
+     same paths for any thread count; threads come from the native pool,
+     [config.num_domains] is not used. *)
+  let simulate_native ?(seed = Random.bits ()) ?(first_path = 0) ?(store_paths = true)
+      config (s0, sigma0) beta rho nu =
+    let params, paths, sigs = outputs ~store_paths config (sigma0, beta, rho, nu) in
+    sabr_mc_stub params s0 config.dt config.num_steps config.num_paths seed first_path
+      paths sigs;
+    (paths, sigs)
+
+  (* Quasi-Monte Carlo version of [simulate_native]: path i is point i of a
+     scrambled Sobol sequence in 2 * num_steps dimensions, turned into the
+     two Brownian paths by a Brownian bridge. [seed] picks the scrambling;
+     runs with different seeds are the independent replications [rqmc]
+     takes error bars from. Works best with num_paths a power of two.
+     Raises Invalid_argument beyond 2048 steps or 2^32 paths. *)
+  let simulate_qmc ?(seed = Random.bits ()) ?(first_path = 0) ?(store_paths = true)
+      config (s0, sigma0) beta rho nu =
+    let params, paths, sigs = outputs ~store_paths config (sigma0, beta, rho, nu) in
+    match sabr_qmc_stub params s0 config.dt config.num_steps config.num_paths seed
+            first_path paths sigs with
+    | 0 -> (paths, sigs)
+    | -1 -> invalid_arg "Monte_carlo.Engine.simulate_qmc: num_steps > 2048"
+    | _ -> invalid_arg "Monte_carlo.Engine.simulate_qmc: path index >= 2^32"
+
+  type dates = (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  external sabr_greeks_stub :
+    buf -> float -> float -> int -> int -> int -> bool -> float -> float -> bool -> bool ->
+    dates -> buf -> buf -> int
+    = "caml_sabr_mc_greeks_bytecode" "caml_sabr_mc_greeks"
+
+  (* Price and sensitivities: delta = dV/dS0, gamma = d2V/dS0^2, vega =
+     dV/dsigma0, then dV/dbeta, dV/drho, dV/dnu. [stderr] holds the seven
+     standard errors in that order. *)
+  type greeks = {
+    price : float;
+    delta : float;
+    gamma : float;
+    vega : float;
+    dbeta : float;
+    drho : float;
+    dnu : float;
+    stderr : float array;
+  }
+
+  let no_dates : dates = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout 0
+
+  (* Price and Greeks of a put or call on strike (paying 1 in the money
+     when [digital]) from one native simulation: the paths [simulate_native]
+     (or [simulate_qmc]) gives for [seed], each carrying its derivatives in
+     S0, sigma0, beta, rho and nu; no bumps and no fresh random numbers.
+     The step to maturity is integrated in closed form, which is what makes
+     gamma and digitals work. [exercise] (num_paths dates, e.g. from
+     American_pricing.LSMC.exercise_block on the same seed) prices the
+     American option under that stopping rule instead. Raises
+     Invalid_argument on invalid inputs. *)
+  let greeks ?(seed = Random.bits ()) ?(qmc = false) ?(digital = false) ?(exercise = no_dates)
+      config (s0, sigma0) beta rho nu ~strike ~rate ~put =
+    let params = Memory_bridge.Bridge.create_buffer 1 in
+    Memory_bridge.Bridge.set_param params 0 (sigma0, beta, rho, nu);
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout 7 in
+    let err = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout 7 in
+    match sabr_greeks_stub params s0 config.dt config.num_steps config.num_paths seed qmc
+            strike rate put digital exercise out err with
+    | 0 ->
+      { price = out.{0}; delta = out.{1}; gamma = out.{2}; vega = out.{3};
+        dbeta = out.{4}; drho = out.{5}; dnu = out.{6};
+        stderr = Array.init 7 (fun j -> err.{j}) }
+    | _ -> invalid_arg "Monte_carlo.Engine.greeks: invalid input"
+
+  (* Single SABR path as 2 * (num_steps + 1) floats: (k * dt, S_k) for
+     k = 0 .. num_steps, starting at (0, s0). The old OCaml loop returned
+     only num_steps pairs and left out the starting point. With the start
+     point, the signature covers the first step and the layout matches
+     each path in [run_parallel]. *)
+  let simulate_path ?seed config (s0, sigma0) beta rho nu =
+    let paths, _ =
+      simulate_native ?seed { config with num_paths = 1 } (s0, sigma0) beta rho nu
+    in
+    paths
 
   (* Function to compute signature of a path using our C++ kernel *)
   let compute_path_signature path =
@@ -35,16 +125,39 @@ module Engine = struct
     Signature_bergomi.Signature.compute_signature_bigarray path sig_out;
     sig_out
 
-  let run_parallel config (s0, sigma0) beta rho nu =
-    let paths_per_domain = config.num_paths / config.num_domains in
-    let work () =
-      Array.init paths_per_domain (fun _ -> 
-        let path = simulate_path config (s0, sigma0) beta rho nu in
-        (path, compute_path_signature path)
-      )
+  (* (path, sig) views into the shared blocks (no copies) *)
+  let views config paths sigs =
+    let path_len = 2 * (config.num_steps + 1) in
+    Array.init config.num_paths (fun p ->
+        (Bigarray.Array1.sub paths (p * path_len) path_len,
+         Bigarray.Array1.sub sigs (p * 15) 15))
+
+  (* All num_paths paths and their signatures as (path, sig) views into one
+     contiguous block each (no copies, nothing dropped when num_paths is
+     not a multiple of the thread count). The work runs on the persistent
+     native pool, which load-balances chunks of paths by work stealing;
+     path i depends only on (seed, i). *)
+  let run_parallel ?seed config (s0, sigma0) beta rho nu =
+    let paths, sigs = simulate_native ?seed config (s0, sigma0) beta rho nu in
+    views config paths sigs
+
+  (* Randomized QMC: [estimate] (e.g. an LSMC price) on the (path, sig)
+     views of [replications] independently scrambled QMC runs. Returns the
+     mean estimate and its standard error. *)
+  let rqmc ?(seed = Random.bits ()) ?(replications = 16) config (s0, sigma0) beta rho nu
+      estimate =
+    let values = Array.init replications (fun r ->
+        let paths, sigs =
+          simulate_qmc ~seed:(Hashtbl.hash (seed, r)) config (s0, sigma0) beta rho nu
+        in
+        estimate (views config paths sigs))
+    in
+    let n = float_of_int replications in
+    let mean = Array.fold_left ( +. ) 0.0 values /. n in
+    let var =
+      Array.fold_left (fun acc v -> acc +. (v -. mean) *. (v -. mean)) 0.0 values
+      /. Float.max 1.0 (n -. 1.0)
     in
-    let domains = List.init (config.num_domains - 1) (fun _ -> spawn work) in
-    let last_batch = work () in
-    last_batch :: (List.map join domains)
+    (mean, sqrt (var /. n))
 
 end
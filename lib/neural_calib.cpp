@@ -1,6 +1,11 @@
+#include "neural_calib.h"
+#include "dense_net.h"
+#include "metrics.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 // Lightweight MLP for SABR Calibration (Double Precision)
@@ -20,10 +25,18 @@ double clamp(double v, double lo, double hi) {
 
 // GELU activation function
 double gelu(double x) {
-  return 0.5 * x * (1.0 + tanhf(0.79788456 * (x + 0.044715 * x * x * x)));
+  return 0.5 * x * (1.0 + std::tanh(0.79788456 * (x + 0.044715 * x * x * x)));
 }
 
-// Simple MLP Forward Pass
+// Constrain outputs to valid SABR ranges
+template <class T> void constrain_outputs(T *output) {
+  output[0] = std::max<T>(0.01, output[0]);             // alpha
+  output[1] = 0.5;                                      // beta
+  output[2] = (T)clamp((double)output[2], -0.99, 0.99); // rho
+  output[3] = std::max<T>(0.01, output[3]);             // nu
+}
+
+// Simple MLP Forward Pass (per-sample reference with the placeholder weights)
 void calibrate_sabr(const double *input, double *output) {
   double hidden1[HIDDEN_DIM];
   double hidden2[HIDDEN_DIM];
@@ -55,17 +68,111 @@ void calibrate_sabr(const double *input, double *output) {
     output[i] = sum;
   }
 
-  // Constrain outputs to valid SABR ranges
-  output[0] = std::max(0.01, output[0]);     // alpha
-  output[1] = 0.5;                           // beta
-  output[2] = clamp(output[2], -0.99, 0.99); // rho
-  output[3] = std::max(0.01, output[3]);     // nu
+  constrain_outputs(output);
+}
+
+// =============================================================================
+// Batched MLP Engine (loadable weights, see dense_net.h for the format)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: The calibration network is a QuantKernel::DenseNet.
+   Until a weight file is loaded it carries the placeholder weights above,
+   so callers see the same outputs as the per-sample loop.
+
+   [SAFETY]:
+   - Loading checks the 7 -> 4 shape and swaps the shared_ptr under a
+     mutex; in-flight batches finish on the model they started with.
+*/
+
+using QuantKernel::DenseNet;
+
+// The placeholder network of calibrate_sabr, expressed as a DenseNet
+std::shared_ptr<const DenseNet> default_model() {
+  auto m = std::make_shared<DenseNet>();
+  std::vector<double> w, b;
+
+  w.assign(HIDDEN_DIM * INPUT_DIM, 0.01);
+  b.resize(HIDDEN_DIM);
+  for (int i = 0; i < HIDDEN_DIM; ++i)
+    b[i] = (double)i * 0.001;
+  m->add_layer(INPUT_DIM, HIDDEN_DIM, true, w.data(), b.data());
+
+  w.assign(HIDDEN_DIM * HIDDEN_DIM, 0.05);
+  b.assign(HIDDEN_DIM, 0.01);
+  m->add_layer(HIDDEN_DIM, HIDDEN_DIM, true, w.data(), b.data());
+
+  w.assign(OUTPUT_DIM * HIDDEN_DIM, 0.1);
+  b.assign(OUTPUT_DIM, 0.0);
+  m->add_layer(HIDDEN_DIM, OUTPUT_DIM, false, w.data(), b.data());
+  return m;
+}
+
+std::mutex g_model_mu;
+std::shared_ptr<const DenseNet> g_model;
+
+std::shared_ptr<const DenseNet> current_model() {
+  std::lock_guard<std::mutex> lock(g_model_mu);
+  if (!g_model)
+    g_model = default_model();
+  return g_model;
+}
+
+template <class T>
+void forward_batch(const T *inputs, size_t batch, T *outputs) {
+  current_model()->forward(inputs, batch, outputs);
+  for (size_t r = 0; r < batch; ++r)
+    constrain_outputs(outputs + r * OUTPUT_DIM);
+}
+
+int load_weights(const char *path) {
+  int status = 0;
+  auto net = DenseNet::load(path, &status);
+  if (!net)
+    return status;
+  if (net->input_dim() != (size_t)INPUT_DIM ||
+      net->output_dim() != (size_t)OUTPUT_DIM)
+    return -2;
+
+  std::lock_guard<std::mutex> lock(g_model_mu);
+  g_model = std::move(net);
+  return 0;
 }
 
 } // namespace neural_calib
 
 extern "C" {
+int neural_calib_load_weights(const char *path) {
+  int rc = neural_calib::load_weights(path);
+  if (rc != 0)
+    std::cerr << "neural_calib: failed to load weights from " << path
+              << " (code " << rc << ")" << std::endl;
+  return rc;
+}
+
 void c_calibrate_sabr(const double *input, double *output) {
+  c_calibrate_sabr_batch(input, 1, output);
+}
+
+void c_calibrate_sabr_batch(const double *inputs, size_t batch,
+                            double *outputs) {
+  QK_METRIC_SCOPE("c_calibrate_sabr_batch",
+                  batch *
+                      (neural_calib::INPUT_DIM + neural_calib::OUTPUT_DIM) *
+                      sizeof(double));
+  neural_calib::forward_batch<double>(inputs, batch, outputs);
+}
+
+void c_calibrate_sabr_batch_f32(const float *inputs, size_t batch,
+                                float *outputs) {
+  QK_METRIC_SCOPE("c_calibrate_sabr_batch_f32",
+                  batch *
+                      (neural_calib::INPUT_DIM + neural_calib::OUTPUT_DIM) *
+                      sizeof(float));
+  neural_calib::forward_batch<float>(inputs, batch, outputs);
+}
+
+// Original per-sample loop (placeholder weights), kept for benchmarking
+void c_calibrate_sabr_reference(const double *input, double *output) {
   neural_calib::calibrate_sabr(input, output);
 }
 }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+extern "C" {
+/**
+ * @brief Load MLP weights for the SABR calibration network from a file.
+ *
+ * Text format (whitespace separated, '#' starts a comment line):
+ *
+ *     qkmlp 1
+ *     layers <L>
+ *     dense <in> <out> <gelu|linear>     (repeated L times, each followed by)
+ *     <out * in weights, row-major [out][in]> <out biases>
+ *
+ * The first layer must take 7 inputs and the last must emit 4 outputs.
+ * On success the new model replaces the process-wide one atomically;
+ * on failure the current model is kept.
+ *
+ * @return 0 on success, -1 if the file cannot be read, -2 on a malformed
+ *         or dimensionally inconsistent file.
+ */
+int neural_calib_load_weights(const char *path);
+
+/**
+ * @brief Single-sample SABR calibration (batch of one).
+ *
+ * Input: [ATM_Vol, Skew_25d, Skew_10d, Fly_25d, Fly_10d, F, T]
+ * Output: [alpha, beta, rho, nu], clamped to valid SABR ranges.
+ */
+void c_calibrate_sabr(const double *input, double *output);
+
+/**
+ * @brief Batched forward pass: batch x 7 inputs -> batch x 4 outputs.
+ *
+ * Each dense layer is a (batch x in) * (in x out) GEMM over 64-byte
+ * aligned, transposed weights; the batch is processed in row blocks so
+ * the activations of a block stay in L1 across all layers.
+ */
+void c_calibrate_sabr_batch(const double *inputs, size_t batch,
+                            double *outputs);
+
+/**
+ * @brief float32 variant of c_calibrate_sabr_batch (twice the SIMD width).
+ */
+void c_calibrate_sabr_batch_f32(const float *inputs, size_t batch,
+                                float *outputs);
+
+/**
+ * @brief Original per-sample forward pass (placeholder weights only).
+ *
+ * Kept as the baseline for benchmarking the batched engine.
+ */
+void c_calibrate_sabr_reference(const double *input, double *output);
+}
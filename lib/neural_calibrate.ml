@@ -1,4 +1,33 @@
+(* Batched MLP calibration: each sample is [ATM_Vol; Skew_25d; Skew_10d;
+   Fly_25d; Fly_10d; F; T] -> [alpha; beta; rho; nu]. The batch size is
+   inferred from the input length (7 doubles per sample); the output must
+   hold 4 doubles per sample (Invalid_argument otherwise). A single sample
+   is a batch of one. *)
 external calibrate_sabr : 
   (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t -> 
   (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t -> 
   unit = "caml_calibrate_sabr"
+
+(* float32 path: same layout, twice the SIMD width *)
+external calibrate_sabr_f32 :
+  (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+  (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+  unit = "caml_calibrate_sabr_f32"
+
+(* Replace the process-wide network with weights from a qkmlp text file.
+   Raises [Failure] if the file is missing or malformed. *)
+external load_weights : string -> unit = "caml_neural_calib_load_weights"
+
+let input_dim = 7
+let output_dim = 4
+
+(* Allocate the output for [inputs] and run the batch *)
+let calibrate_batch inputs =
+  let n = Bigarray.Array1.dim inputs in
+  if n mod input_dim <> 0 then
+    invalid_arg "Neural_calibrate.calibrate_batch: input length not a multiple of 7";
+  let out =
+    Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (n / input_dim * output_dim)
+  in
+  calibrate_sabr inputs out;
+  out
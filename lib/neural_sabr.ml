@@ -19,6 +19,69 @@ module Sabr = struct
     else
       Ok { alpha = p.alpha; beta = p.beta; rho = p.rho; nu = p.nu }
 
+  (* Batch Hagan surface over a (param set x tenor x strike) grid *)
+  module Surface = struct
+    type buf = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+    external implied_vol_surface_stub :
+      buf -> buf -> buf -> buf -> buf -> unit = "caml_sabr_implied_vol_surface"
+
+    (* [params] is a Memory_bridge.Bridge buffer (8 doubles per set).
+       Result is row-major num_params x num_tenors x num_strikes. *)
+    let implied_vol_surface ~(params : buf) ~(forwards : buf) ~(tenors : buf)
+        ~(strikes : buf) =
+      let num_params = Bigarray.Array1.dim params / 8 in
+      let num_tenors = Bigarray.Array1.dim forwards in
+      let num_strikes = Bigarray.Array1.dim strikes in
+      if Bigarray.Array1.dim tenors <> num_tenors then
+        invalid_arg "implied_vol_surface: forwards and tenors differ in length";
+      let out =
+        Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout
+          (num_params * num_tenors * num_strikes)
+      in
+      implied_vol_surface_stub params forwards tenors strikes out;
+      out
+  end
+
+  (* Native Levenberg-Marquardt calibration of (alpha, rho, nu), beta fixed *)
+  module Calibrator = struct
+    type buf = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+    type offsets = (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+    external calibrate_chain_stub :
+      buf -> buf -> buf -> offsets -> buf -> buf -> buf -> buf -> int -> unit
+      = "caml_sabr_calibrate_chain_bytecode" "caml_sabr_calibrate_chain"
+
+    (* Smile s owns entries [offsets.{s}, offsets.{s+1}) of strikes / vols.
+       [params] is a Memory_bridge.Bridge buffer holding the warm starts
+       (previous fit or MLP output; alpha <= 0 means cold start) and beta;
+       it is overwritten with the fits. Returns the RMSE per smile. Raises
+       Invalid_argument if offsets are negative or decrease, or if weights
+       are shorter than strikes. *)
+    let calibrate_chain ?weights ?(max_iters = 0) ~(strikes : buf) ~(vols : buf)
+        ~(offsets : offsets) ~(forwards : buf) ~(tenors : buf) ~(params : buf) () =
+      let num_smiles = Bigarray.Array1.dim forwards in
+      if Bigarray.Array1.dim tenors <> num_smiles
+         || Bigarray.Array1.dim offsets <> num_smiles + 1
+         || Bigarray.Array1.dim params < num_smiles * 8
+      then invalid_arg "calibrate_chain: inconsistent chain dimensions";
+      if Int32.to_int offsets.{num_smiles} > Bigarray.Array1.dim strikes
+         || Bigarray.Array1.dim vols <> Bigarray.Array1.dim strikes
+      then invalid_arg "calibrate_chain: offsets exceed quote arrays";
+      let weights = match weights with
+        | Some w -> w
+        | None -> Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout 0
+      in
+      let rmse = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout num_smiles in
+      calibrate_chain_stub strikes vols weights offsets forwards tenors params rmse max_iters;
+      rmse
+
+    (* Seed smile [index] from a Neural_calibrate output [alpha; beta; rho; nu] *)
+    let warm_start_of_mlp (params : buf) index (mlp_out : buf) =
+      Memory_bridge.Bridge.set_param params index
+        (mlp_out.{0}, mlp_out.{1}, mlp_out.{2}, mlp_out.{3})
+  end
+
   (* Type-safe solver interface *)
   module Solver = struct
     open Ctypes
@@ -30,6 +93,25 @@ module Sabr = struct
     let neural_sabr_inference =
       foreign ~from:handle "neural_sabr_inference" (ptr Types.model_params @-> ptr double @-> size_t @-> returning void)
 
+    (* Native surface network (qkmlp weights, 6 -> 1); Hagan when none loaded *)
+    let neural_sabr_load_weights =
+      foreign ~from:handle "neural_sabr_load_weights" (string @-> returning int)
+
+    let neural_sabr_clear_weights =
+      foreign ~from:handle "neural_sabr_clear_weights" (void @-> returning void)
+
+    let neural_sabr_model_loaded =
+      foreign ~from:handle "neural_sabr_model_loaded" (void @-> returning int)
+
+    let load_weights path =
+      match neural_sabr_load_weights path with
+      | 0 -> Ok ()
+      | -1 -> Error ("cannot read SABR surface weights: " ^ path)
+      | _ -> Error ("malformed SABR surface weights: " ^ path)
+
+    let clear_weights () = neural_sabr_clear_weights ()
+    let model_loaded () = neural_sabr_model_loaded () <> 0
+
     let solve (p : no_arbitrage params) =
       let c_params = make Types.model_params in
       setf c_params Types.alpha p.alpha;
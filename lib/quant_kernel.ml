@@ -5,6 +5,8 @@ module Signature_bergomi = Signature_bergomi
 module Markov_chain = Markov_chain
 module Monte_carlo = Monte_carlo
 module American_pricing = American_pricing
+module Kernel_metrics = Kernel_metrics
+module Tracing = Tracing
 module Stream_server = Stream_server
 module Slv_engine = Slv_engine
 module Neural_calibrate = Neural_calibrate
@@ -0,0 +1,305 @@
+#include "sabr_calibration.h"
+#include "metrics.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// =============================================================================
+// SABR Calibration: Levenberg-Marquardt with analytic Jacobian
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Turn a market smile into SABR parameters. Start from a
+   good guess (yesterday's fit or the MLP), then take damped Gauss-Newton
+   steps until the model smile stops getting closer to the market one.
+
+   [HS MATH]:
+   σ(K) = a R(z) P,  a = α / (f0 D),  z = (ν/α) f0 L,  R = z / x(z, ρ)
+   f0 = (F K)^{(1-β)/2},  L = ln(F/K),  D = 1 + (1-β)²/24 L² + (1-β)⁴/1920 L⁴
+   P  = 1 + T ((1-β)²/24 α²/f0² + ρβνα/(4 f0) + (2 - 3ρ²) ν²/24)
+   ∂x/∂z = 1/sqrt(1 - 2ρz + z²),  ∂x/∂ρ = (-z/s - 1)/(s + z - ρ) + 1/(1 - ρ)
+   LM step: (JᵀJ + λ diag(JᵀJ)) δ = -Jᵀr over θ = (α, ρ, ν), β fixed.
+
+   [SAFETY]:
+   - x is odd in (z, ρ), so it is evaluated at (|z|, sgn(z) ρ) where no term
+     cancels; the ATM band |z| < 1e-6 uses the series of R and its
+     derivatives.
+   - Steps are projected onto α > 0, |ρ| < 1, ν >= 0.
+   - Each smile is independent: the chain is a parallel_for over smiles.
+*/
+
+namespace {
+
+constexpr double SABR_RHO_MAX = 0.9999;
+constexpr double SABR_ALPHA_MIN = 1e-8;
+constexpr int SABR_DEFAULT_ITERS = 50;
+
+// Strike-only invariants of one smile point (fixed for the whole fit)
+struct SabrQuote {
+  double log_fk; // L
+  double f0;     // (F K)^{(1-β)/2}
+  double D;      // 1 + c2 L² + c4 L⁴
+  double vol;
+  double sqrt_w;
+};
+
+struct SabrSmileFit {
+  std::vector<SabrQuote> quotes;
+  double beta, c2, T;
+};
+
+// σ and ∂σ/∂(α, ρ, ν) for one quote
+double vol_grad(const SabrSmileFit &s, const SabrQuote &q, double alpha,
+                double rho, double nu, double *grad) {
+  const double beta = s.beta, T = s.T, f0 = q.f0, L = q.log_fk;
+  const double z = nu / alpha * f0 * L;
+  const double dz_dalpha = -z / alpha;
+  const double dz_dnu = f0 * L / alpha;
+
+  double R, Rz, Rr;
+  if (std::abs(z) < 1e-6) {
+    const double c = (2.0 - 3.0 * rho * rho) / 12.0;
+    R = 1.0 + z * (-0.5 * rho + z * c);
+    Rz = -0.5 * rho + 2.0 * c * z;
+    Rr = -0.5 * z - 0.5 * rho * z * z;
+  } else {
+    const double sgn = z < 0.0 ? -1.0 : 1.0;
+    const double za = std::abs(z), rp = sgn * rho;
+    const double q2 = z * z - 2.0 * rho * z;
+    const double sq = std::sqrt(1.0 + q2);
+    const double x = sgn * std::log1p((q2 / (sq + 1.0) + za) / (1.0 - rp));
+    const double x_rho = (-za / sq - 1.0) / (sq + za - rp) + 1.0 / (1.0 - rp);
+    const double x_z = 1.0 / sq;
+    R = z / x;
+    Rz = (x - z * x_z) / (x * x);
+    Rr = -z * x_rho / (x * x);
+  }
+
+  const double inv_f0 = 1.0 / f0;
+  const double a = alpha * inv_f0 / q.D;
+  const double P = 1.0 + T * (s.c2 * alpha * alpha * inv_f0 * inv_f0 +
+                              0.25 * rho * beta * nu * alpha * inv_f0 +
+                              (2.0 - 3.0 * rho * rho) / 24.0 * nu * nu);
+  const double aR = a * R;
+
+  grad[0] = R * P * inv_f0 / q.D + a * Rz * dz_dalpha * P +
+            aR * T * (2.0 * s.c2 * alpha * inv_f0 * inv_f0 +
+                      0.25 * rho * beta * nu * inv_f0);
+  grad[1] = a * Rr * P +
+            aR * T * (0.25 * beta * nu * alpha * inv_f0 - 0.25 * rho * nu * nu);
+  grad[2] = a * Rz * dz_dnu * P +
+            aR * T * (0.25 * rho * beta * alpha * inv_f0 +
+                      (2.0 - 3.0 * rho * rho) / 12.0 * nu);
+  return aR * P;
+}
+
+SabrSmileFit make_fit(const double *strikes, const double *vols,
+                      const double *weights, size_t n, double forward,
+                      double tenor, double beta) {
+  SabrSmileFit s;
+  const double omb = 1.0 - beta;
+  const double c2 = omb * omb / 24.0, c4 = omb * omb * omb * omb / 1920.0;
+  s.beta = beta;
+  s.c2 = c2;
+  s.T = tenor;
+  s.quotes.reserve(n);
+  const double log_f = std::log(forward);
+  for (size_t i = 0; i < n; ++i) {
+    if (!(strikes[i] > 0.0) || !(vols[i] > 0.0))
+      continue;
+    const double log_k = std::log(strikes[i]);
+    const double L = log_f - log_k;
+    SabrQuote q;
+    q.log_fk = L;
+    q.f0 = std::exp(0.5 * omb * (log_f + log_k));
+    q.D = 1.0 + L * L * (c2 + L * L * c4);
+    q.vol = vols[i];
+    q.sqrt_w = weights ? std::sqrt(std::max(0.0, weights[i])) : 1.0;
+    s.quotes.push_back(q);
+  }
+  return s;
+}
+
+// Weighted sum of squared residuals; optionally fills J (n x 3) and r
+double residuals(const SabrSmileFit &s, const double *theta, double *J,
+                 double *r) {
+  double cost = 0.0, g[3];
+  for (size_t i = 0; i < s.quotes.size(); ++i) {
+    const SabrQuote &q = s.quotes[i];
+    const double v = vol_grad(s, q, theta[0], theta[1], theta[2], g);
+    const double ri = q.sqrt_w * (v - q.vol);
+    cost += ri * ri;
+    if (J != nullptr) {
+      r[i] = ri;
+      for (int k = 0; k < 3; ++k)
+        J[3 * i + k] = q.sqrt_w * g[k];
+    }
+  }
+  return cost;
+}
+
+// Solve the SPD 3x3 system A x = b by Cholesky; false if not SPD
+bool solve3(const double A[9], const double b[3], double x[3]) {
+  double l00 = A[0];
+  if (!(l00 > 0.0))
+    return false;
+  l00 = std::sqrt(l00);
+  const double l10 = A[3] / l00, l20 = A[6] / l00;
+  double l11 = A[4] - l10 * l10;
+  if (!(l11 > 0.0))
+    return false;
+  l11 = std::sqrt(l11);
+  const double l21 = (A[7] - l20 * l10) / l11;
+  double l22 = A[8] - l20 * l20 - l21 * l21;
+  if (!(l22 > 0.0))
+    return false;
+  l22 = std::sqrt(l22);
+
+  const double y0 = b[0] / l00;
+  const double y1 = (b[1] - l10 * y0) / l11;
+  const double y2 = (b[2] - l20 * y0 - l21 * y1) / l22;
+  x[2] = y2 / l22;
+  x[1] = (y1 - l21 * x[2]) / l11;
+  x[0] = (y0 - l10 * x[1] - l20 * x[2]) / l00;
+  return true;
+}
+
+void project(double *theta) {
+  theta[0] = std::max(theta[0], SABR_ALPHA_MIN);
+  theta[1] = std::clamp(theta[1], -SABR_RHO_MAX, SABR_RHO_MAX);
+  theta[2] = std::max(theta[2], 0.0);
+}
+
+// ATM-vol heuristic when no warm start is supplied: σ_ATM ≈ α / F^{1-β}
+void cold_start(const SabrSmileFit &s, double forward, double *theta) {
+  double best = 1e300, atm_vol = 0.2;
+  for (const SabrQuote &q : s.quotes) {
+    if (std::abs(q.log_fk) < best) {
+      best = std::abs(q.log_fk);
+      atm_vol = q.vol;
+    }
+  }
+  theta[0] = atm_vol * std::pow(forward, 1.0 - s.beta);
+  theta[1] = 0.0;
+  theta[2] = 0.5;
+}
+
+double fit_smile(const SabrSmileFit &s, double forward, ModelParams *params,
+                 int max_iters) {
+  const size_t n = s.quotes.size();
+  if (n == 0)
+    return 0.0;
+  if (max_iters <= 0)
+    max_iters = SABR_DEFAULT_ITERS;
+
+  double theta[3] = {params->alpha, params->rho, params->nu};
+  if (!(theta[0] > 0.0))
+    cold_start(s, forward, theta);
+  project(theta);
+
+  std::vector<double> J(3 * n), r(n);
+  double cost = residuals(s, theta, J.data(), r.data());
+  double lambda = 1e-3;
+
+  for (int it = 0; it < max_iters; ++it) {
+    double JtJ[9] = {}, Jtr[3] = {};
+    for (size_t i = 0; i < n; ++i) {
+      const double *Ji = &J[3 * i];
+      for (int a = 0; a < 3; ++a) {
+        Jtr[a] += Ji[a] * r[i];
+        for (int b = 0; b <= a; ++b)
+          JtJ[3 * a + b] += Ji[a] * Ji[b];
+      }
+    }
+    JtJ[1] = JtJ[3];
+    JtJ[2] = JtJ[6];
+    JtJ[5] = JtJ[7];
+
+    bool accepted = false;
+    double trial[3], delta[3];
+    while (lambda < 1e12) {
+      double A[9];
+      std::copy(JtJ, JtJ + 9, A);
+      for (int a = 0; a < 3; ++a)
+        A[4 * a] += lambda * JtJ[4 * a] + 1e-14;
+      const double neg_g[3] = {-Jtr[0], -Jtr[1], -Jtr[2]};
+      if (solve3(A, neg_g, delta)) {
+        for (int a = 0; a < 3; ++a)
+          trial[a] = theta[a] + delta[a];
+        project(trial);
+        const double trial_cost = residuals(s, trial, nullptr, nullptr);
+        if (trial_cost < cost) {
+          accepted = true;
+          break;
+        }
+      }
+      lambda *= 10.0;
+    }
+    if (!accepted)
+      break;
+
+    const double prev = cost;
+    std::copy(trial, trial + 3, theta);
+    cost = residuals(s, theta, J.data(), r.data());
+    lambda = std::max(lambda * 0.1, 1e-12);
+
+    const double step = std::abs(delta[0]) / std::max(theta[0], 1e-12) +
+                        std::abs(delta[1]) + std::abs(delta[2]);
+    if (prev - cost <= 1e-12 * prev || step < 1e-10 || cost < 1e-24)
+      break;
+  }
+
+  params->alpha = theta[0];
+  params->rho = theta[1];
+  params->nu = theta[2];
+
+  double wsum = 0.0;
+  for (const SabrQuote &q : s.quotes)
+    wsum += q.sqrt_w * q.sqrt_w;
+  return wsum > 0.0 ? std::sqrt(cost / wsum) : 0.0;
+}
+
+} // namespace
+
+extern "C" {
+
+double sabr_hagan_vol_grad(double forward, double strike, double tenor,
+                           double alpha, double beta, double rho, double nu,
+                           double *grad) {
+  grad[0] = grad[1] = grad[2] = 0.0;
+  if (forward <= 0 || strike <= 0)
+    return 0.0;
+  const double vol = 1.0;
+  SabrSmileFit s = make_fit(&strike, &vol, nullptr, 1, forward, tenor, beta);
+  return vol_grad(s, s.quotes[0], alpha, rho, nu, grad);
+}
+
+double sabr_calibrate_smile(const double *strikes, const double *market_vols,
+                            const double *weights, size_t num_strikes,
+                            double forward, double tenor, ModelParams *params,
+                            int max_iters) {
+  if (forward <= 0 || num_strikes == 0)
+    return 0.0;
+  SabrSmileFit s = make_fit(strikes, market_vols, weights, num_strikes,
+                            forward, tenor, params->beta);
+  return fit_smile(s, forward, params, max_iters);
+}
+
+void sabr_calibrate_chain(const double *strikes, const double *market_vols,
+                          const double *weights, const int *offsets,
+                          size_t num_smiles, const double *forwards,
+                          const double *tenors, ModelParams *params,
+                          double *out_rmse, int max_iters) {
+  QK_METRIC_SCOPE("sabr_calibrate_chain",
+                  (size_t)offsets[num_smiles] * 3 * sizeof(double));
+  QuantKernel::ThreadPool::global().parallel_for(num_smiles, [&](size_t i) {
+    const size_t begin = offsets[i], end = offsets[i + 1];
+    double rmse = sabr_calibrate_smile(
+        strikes + begin, market_vols + begin,
+        weights ? weights + begin : nullptr, end - begin, forwards[i],
+        tenors[i], &params[i], max_iters);
+    if (out_rmse != nullptr)
+      out_rmse[i] = rmse;
+  });
+}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "kernel.h"
+
+extern "C" {
+/**
+ * @brief Hagan SABR implied vol and its analytic gradient in (alpha, rho, nu).
+ *
+ * Same formula as sabr_hagan_implied_vol (beta held fixed). The ATM limit
+ * z -> 0 switches to the series of z/x(z) and its derivatives.
+ *
+ * @param grad Output: d(vol)/d(alpha), d(vol)/d(rho), d(vol)/d(nu).
+ * @return Implied vol (0 and a zero gradient if forward or strike <= 0).
+ */
+double sabr_hagan_vol_grad(double forward, double strike, double tenor,
+                           double alpha, double beta, double rho, double nu,
+                           double *grad);
+
+/**
+ * @brief Fit (alpha, rho, nu) of one smile by Levenberg-Marquardt.
+ *
+ * Minimises sum_i w_i (vol_i(theta) - market_vols_i)^2 with the analytic
+ * Jacobian; beta is taken from params->beta and held fixed.
+ *
+ * @param strikes Strike grid (num_strikes doubles).
+ * @param market_vols Market implied vols per strike.
+ * @param weights Per-strike weights, or nullptr for equal weights.
+ * @param params In: warm start (previous fit or MLP output) and beta.
+ *               alpha <= 0 means "no warm start" (ATM-vol heuristic).
+ *               Out: fitted parameters.
+ * @param max_iters Maximum LM iterations (<= 0 -> 50).
+ * @return Weighted RMS vol error of the fit.
+ */
+double sabr_calibrate_smile(const double *strikes, const double *market_vols,
+                            const double *weights, size_t num_strikes,
+                            double forward, double tenor, ModelParams *params,
+                            int max_iters);
+
+/**
+ * @brief Calibrate a whole option chain, one LM fit per smile, in parallel.
+ *
+ * Smiles are stored back to back in CSR form: smile s owns entries
+ * [offsets[s], offsets[s + 1]) of strikes / market_vols / weights.
+ * Smiles are distributed over the process-wide thread pool.
+ *
+ * @param weights Per-strike weights, or nullptr for equal weights.
+ * @param offsets num_smiles + 1 row offsets.
+ * @param forwards Forward per smile.
+ * @param tenors Expiry in years per smile.
+ * @param params num_smiles ModelParams, in/out as in sabr_calibrate_smile.
+ * @param out_rmse Fit RMSE per smile, or nullptr.
+ */
+void sabr_calibrate_chain(const double *strikes, const double *market_vols,
+                          const double *weights, const int *offsets,
+                          size_t num_smiles, const double *forwards,
+                          const double *tenors, ModelParams *params,
+                          double *out_rmse, int max_iters);
+}
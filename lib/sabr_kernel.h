@@ -3,9 +3,71 @@
 #include "kernel.h"
 
 extern "C" {
-// Run Neural-SABR inference using ONNX Runtime
-// Input: pointer to single ModelParams struct (validated by OCaml)
-// Output: pointer to implied volatility surface buffer
+/**
+ * @brief Neural-SABR inference on the fixed grid F = 100, T = 1,
+ *        K_i = 80 + 0.4 i (i < surface_size).
+ *
+ * Runs the loaded dense network natively (no ONNX Runtime); falls back to
+ * the analytic Hagan surface when no weights are loaded. Allocates nothing
+ * once the per-thread buffers have grown to surface_size.
+ *
+ * @param params Single ModelParams struct (validated by OCaml).
+ * @param out_surface Implied volatility per grid strike.
+ */
 void neural_sabr_inference(const ModelParams *params, double *out_surface,
                            size_t surface_size);
+
+/**
+ * @brief Analytic Hagan surface on the same grid (fallback and accuracy
+ *        reference for the network).
+ */
+void neural_sabr_inference_analytic(const ModelParams *params,
+                                    double *out_surface, size_t surface_size);
+
+/**
+ * @brief Load the surface network from a qkmlp weight file (see
+ *        dense_net.h). One row per strike, 6 features in, 1 vol out:
+ *        [alpha, beta, rho, nu, ln(K/F), T] -> sigma.
+ *
+ * @return 0 on success, -1 unreadable, -2 malformed or wrong shape. On
+ *         failure the current model (or the Hagan fallback) is kept.
+ */
+int neural_sabr_load_weights(const char *path);
+
+/// Drop the loaded network; inference reverts to the Hagan surface.
+void neural_sabr_clear_weights(void);
+
+/// 1 if a surface network is loaded, 0 if inference uses Hagan.
+int neural_sabr_model_loaded(void);
+
+/**
+ * @brief Price a full Hagan (2002) SABR implied-vol grid in one call.
+ *
+ * Strikes are processed several per SIMD lane block (AVX2/AVX-512 chosen at
+ * runtime, same selection as signature_kernel_isa). Strike and tenor
+ * invariants are hoisted out of the inner loop, and the ATM limit z -> 0 is
+ * handled with a lane mask, not a branch. Relative error vs a long double
+ * evaluation of the same formula is ~1e-13.
+ *
+ * @param params Array of num_params ModelParams (alpha, beta, rho, nu).
+ * @param num_params Number of parameter sets.
+ * @param forwards Forward price per tenor (num_tenors doubles).
+ * @param tenors Expiry in years per tenor (num_tenors doubles).
+ * @param num_tenors Number of tenors.
+ * @param strikes Strike grid shared by every smile (num_strikes doubles).
+ * @param num_strikes Number of strikes.
+ * @param out_surface Output, row-major num_params x num_tenors x num_strikes.
+ *                    Entries with a non-positive strike or forward are 0.
+ */
+void sabr_implied_vol_surface(const ModelParams *params, size_t num_params,
+                              const double *forwards, const double *tenors,
+                              size_t num_tenors, const double *strikes,
+                              size_t num_strikes, double *out_surface);
+
+/**
+ * @brief Scalar Hagan SABR implied vol (reference for the batch kernel).
+ */
+double sabr_hagan_implied_vol(double forward, double strike, double tenor,
+                              double alpha, double beta, double rho,
+                              double nu);
 }
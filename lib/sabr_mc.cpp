@@ -0,0 +1,645 @@
+#include "sabr_mc.h"
+#include "mc_random.h"
+#include "metrics.h"
+#include "signature_kernel.h"
+#include "simd_math.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// =============================================================================
+// SABR Monte Carlo Path Engine (counter-based RNG, SIMD across paths)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Generates SABR price paths W at a time, one path per
+   SIMD lane. Random numbers are a pure function of (seed, path, step), so
+   a run can be split across any number of threads or calls and still give
+   the same paths. Signatures can be built as the paths are walked, so
+   millions of paths never have to sit in memory. The QMC mode swaps the
+   Gaussians for scrambled Sobol points through a Brownian bridge (see
+   mc_random.h); everything downstream of the normals is shared.
+
+   [HS MATH]:
+   Step n -> n + 1, Δ = dt, (u1, u2) from Philox4x32-10 on counter
+   (n, 0, path_lo, path_hi) with key (seed_lo, seed_hi):
+     z1 = Φ⁻¹(u1),  z2 = Φ⁻¹(u2)
+     S'  = max(S + σ S^β √Δ z1, 0)                  (0 is absorbing)
+     σ'  = σ exp(ν √Δ (ρ z1 + √(1-ρ²) z2) - ½ ν² Δ)
+   QMC: path i is Sobol point i in 2N dimensions; dimension 2k + j drives
+   the k-th bridge node of z_{j+1}, so the leading dimensions shape the
+   terminal values of both Brownian motions. S^β is specialised for
+   β ∈ {0, ½, 1}, exp(β log S) otherwise. The signature of (t, S) uses the
+   same lane-wise Chen update as compute_signature_level3_batch.
+
+   [SAFETY]:
+   - Lanes past num_paths are simulated but never written.
+   - QMC needs 2N <= SOBOL_MAX_DIMS and path indices < 2^32; both are
+     checked before any work starts.
+*/
+namespace {
+
+using QuantKernel::Lanes;
+
+using QuantKernel::MC_TILE;
+
+constexpr size_t MC_CHUNK = 64; // paths per thread-pool task
+
+enum BetaMode { BETA_ZERO, BETA_HALF, BETA_ONE, BETA_GENERAL };
+
+struct McSetup {
+  double s0, alpha, beta, rho, rho_bar, nu_sqdt, vol_drift, sqdt, dt;
+  size_t num_steps;
+  BetaMode beta_mode;
+  QuantKernel::NormalSource normals;
+};
+
+McSetup mc_setup(const ModelParams &p, double s0, double dt, size_t num_steps,
+                 uint64_t seed, bool qmc) {
+  const double sqdt = std::sqrt(dt);
+  return McSetup{
+      .s0 = s0,
+      .alpha = p.alpha,
+      .beta = p.beta,
+      .rho = p.rho,
+      .rho_bar = std::sqrt(std::max(0.0, 1.0 - p.rho * p.rho)),
+      .nu_sqdt = p.nu * sqdt,
+      .vol_drift = -0.5 * p.nu * p.nu * dt,
+      .sqdt = sqdt,
+      .dt = dt,
+      .num_steps = num_steps,
+      .beta_mode = p.beta == 0.0   ? BETA_ZERO
+                   : p.beta == 0.5 ? BETA_HALF
+                   : p.beta == 1.0 ? BETA_ONE
+                                   : BETA_GENERAL,
+      .normals = QuantKernel::NormalSource(seed, num_steps, qmc)};
+}
+
+// W paths driven by `normals` (PhiloxNormals / SobolNormals); only the
+// first `valid` lanes are written. paths / sigs point at lane 0's output
+// (either may be null).
+template <int W, class Normals>
+__attribute__((always_inline)) inline void
+sabr_mc_lanes(const McSetup &m, Normals &normals, size_t valid, double *paths,
+              double *sigs) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+
+  const size_t stride = 2 * (m.num_steps + 1);
+  vec S = vec{} + m.s0;
+  vec sigma = vec{} + m.alpha;
+  vec l1[2] = {}, l2[4] = {}, l3[8] = {};
+
+  if (paths)
+    for (size_t w = 0; w < valid; ++w) {
+      paths[w * stride] = 0.0;
+      paths[w * stride + 1] = m.s0;
+    }
+
+  const vec *z = nullptr;
+  double t_prev = 0.0;
+  for (size_t n = 0; n < m.num_steps; ++n) {
+    if (n % MC_TILE == 0)
+      z = normals.tile(n, std::min(MC_TILE, m.num_steps - n));
+    const vec z1 = z[2 * (n % MC_TILE)], z2 = z[2 * (n % MC_TILE) + 1];
+
+    ivec alive = S > 0.0;
+    vec s_beta;
+    switch (m.beta_mode) {
+    case BETA_ZERO:
+      s_beta = vec{} + 1.0;
+      break;
+    case BETA_HALF:
+      s_beta = QuantKernel::vsqrt<W>(alive ? S : vec{} + 1.0);
+      break;
+    case BETA_ONE:
+      s_beta = S;
+      break;
+    default:
+      s_beta = QuantKernel::vexp<W>(
+          m.beta * QuantKernel::vlog<W>(alive ? S : vec{} + 1.0));
+      break;
+    }
+    vec s_new = S + sigma * s_beta * (m.sqdt * z1);
+    s_new = s_new > 0.0 ? s_new : vec{};
+    s_new = alive ? s_new : vec{};
+    sigma = sigma * QuantKernel::vexp<W>(
+                        m.nu_sqdt * (m.rho * z1 + m.rho_bar * z2) +
+                        m.vol_drift);
+
+    const double t = (double)(n + 1) * m.dt;
+    if (sigs) {
+      // Chen update with increment (t - t_prev, S' - S), as in
+      // compute_signature_level3_batch
+      vec d[2] = {vec{} + (t - t_prev), s_new - S};
+      vec half_d0 = 0.5 * d[0], half_d1 = 0.5 * d[1];
+      vec seg2[4] = {half_d0 * d[0], half_d0 * d[1], half_d1 * d[0],
+                     half_d1 * d[1]};
+      for (int a = 0; a < 2; ++a) {
+        vec coef = l1[a] + d[a] * (1.0 / 3.0);
+        for (int b = 0; b < 2; ++b)
+          for (int c = 0; c < 2; ++c)
+            l3[4 * a + 2 * b + c] +=
+                l2[2 * a + b] * d[c] + coef * seg2[2 * b + c];
+      }
+      for (int a = 0; a < 2; ++a)
+        for (int b = 0; b < 2; ++b)
+          l2[2 * a + b] += l1[a] * d[b] + seg2[2 * a + b];
+      l1[0] += d[0];
+      l1[1] += d[1];
+    }
+    S = s_new;
+    t_prev = t;
+
+    if (paths)
+      for (size_t w = 0; w < valid; ++w) {
+        paths[w * stride + 2 * (n + 1)] = t;
+        paths[w * stride + 2 * (n + 1) + 1] = S[w];
+      }
+  }
+
+  if (sigs)
+    for (size_t w = 0; w < valid; ++w) {
+      double *o = sigs + 15 * w;
+      o[0] = 1.0;
+      o[1] = l1[0][w];
+      o[2] = l1[1][w];
+      for (int k = 0; k < 4; ++k)
+        o[3 + k] = l2[k][w];
+      for (int k = 0; k < 8; ++k)
+        o[7 + k] = l3[k][w];
+    }
+}
+
+// Paths [begin, end) of this call (global index first_path + i)
+template <int W>
+__attribute__((always_inline)) inline void
+sabr_mc_range(const McSetup &m, uint64_t first_path, size_t begin, size_t end,
+              double *out_paths, double *out_sigs) {
+  const size_t stride = 2 * (m.num_steps + 1);
+  QuantKernel::for_each_path_block<W>(
+      m.normals, first_path, begin, end,
+      [&](auto &normals, size_t p) __attribute__((always_inline)) {
+        sabr_mc_lanes<W>(m, normals, std::min<size_t>(W, end - p),
+                         out_paths ? out_paths + p * stride : nullptr,
+                         out_sigs ? out_sigs + 15 * p : nullptr);
+      });
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SABR_MC_X86_DISPATCH 1
+
+__attribute__((target("avx2,fma"))) void
+sabr_mc_range_avx2(const McSetup &m, uint64_t first_path, size_t begin,
+                   size_t end, double *out_paths, double *out_sigs) {
+  sabr_mc_range<4>(m, first_path, begin, end, out_paths, out_sigs);
+}
+
+__attribute__((target("avx512f"))) void
+sabr_mc_range_avx512(const McSetup &m, uint64_t first_path, size_t begin,
+                     size_t end, double *out_paths, double *out_sigs) {
+  sabr_mc_range<8>(m, first_path, begin, end, out_paths, out_sigs);
+}
+#endif
+
+// Chunks of MC_CHUNK paths over the pool, at the runtime ISA
+void sabr_mc_run(const McSetup &m, size_t num_paths, uint64_t first_path,
+                 double *out_paths, double *out_signatures) {
+  const int isa = signature_kernel_isa();
+  const size_t chunks = (num_paths + MC_CHUNK - 1) / MC_CHUNK;
+  QuantKernel::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+    const size_t begin = c * MC_CHUNK;
+    const size_t end = std::min(num_paths, begin + MC_CHUNK);
+#ifdef SABR_MC_X86_DISPATCH
+    switch (isa) {
+    case 2:
+      sabr_mc_range_avx512(m, first_path, begin, end, out_paths,
+                           out_signatures);
+      return;
+    case 1:
+      sabr_mc_range_avx2(m, first_path, begin, end, out_paths,
+                         out_signatures);
+      return;
+    default:
+      break;
+    }
+#else
+    (void)isa;
+#endif
+    sabr_mc_range<4>(m, first_path, begin, end, out_paths, out_signatures);
+  });
+}
+
+// =============================================================================
+// Greeks (pathwise tangents, last step integrated out)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Price and sensitivities from one simulation. Next to
+   S and σ, every path carries how S would move if S_0, α, β, ρ or ν
+   moved (its tangents), updated by the chain rule at every step. Where
+   the payoff is smooth, a sensitivity is the payoff's slope times the
+   tangent. Kinks and jumps (the call kink for gamma, a digital's jump)
+   have no useful slope along a path, so the last step is not simulated:
+   one step before maturity S_T is Gaussian, its expected payoff has a
+   closed form, and that is what gets differentiated. This is the
+   likelihood-ratio estimator on the last step with its expectation
+   taken exactly, so it adds no noise. The paths are sabr_mc_simulate's,
+   so an exercise rule fitted on them can be replayed for American
+   Greeks: there every step is simulated (the rule may look at the whole
+   path), and gamma weights each path's delta by how likely its first
+   step becomes as S_0 moves.
+
+   [HS MATH]:
+   θ ∈ {S_0, α, β, ρ, ν}, ℓ_θ = ∂ log σ / ∂θ:
+     ℓ_α = 1/α,  ℓ_ρ = Σ ν√Δ (z1 - ρ/ρ̄ z2),  ℓ_ν = Σ (√Δ(ρ z1 + ρ̄ z2) - νΔ)
+   Step g = σ S^β √Δ z1, S' = S + g (tangents 0 once absorbed):
+     ∂S'  = ∂S + g (ℓ_θ + β ∂S/S + [θ = β] log S)
+     ∂²S' = ∂²S + g (β ∂²S/S + β(β-1) (∂S/S)²)            (θ = S_0)
+   Exercise at τ <= N, h = (c(S - K))^+, c = ±1 (call / put), h > 0:
+     V = D^τ h(S_τ),  ∂V = D^τ c ∂S_τ,  ∂²V/∂S_0² = ∂V/∂S_0 · w_1
+     w_1 = ∂/∂S_0 [log p(S_1, σ_1 | S_0) + log ∂S_1/∂S_0] at fixed S_1
+         = (ρ/ρ̄ z2 - z1) ∂z1 - β/S_0 - β S_1 / (S_0² ∂S_1/∂S_0),
+     ∂z1 = -1/v - β z1/S_0,  v = α S_0^β √Δ
+   European: μ = S_{N-1}, s = σ μ^β √Δ, S_N = max(μ + s Z, 0),
+   B(μ, s) = E h(S_N), d = (μ - K)/s:
+     vanilla: B = c(μ - K)Φ(cd) + sφ(d),  B_μ = cΦ(cd),  B_s = φ(d),
+              B_μμ = φ/s,  B_μs = -dφ/s,  B_ss = d²φ/s
+              (a put also subtracts the same terms at K = 0)
+     digital: B = Φ(cd),  B_μ = cφ/s,  B_s = -cdφ/s,  B_μμ = -cdφ/s²,
+              B_μs = c(d² - 1)φ/s²,  B_ss = cd(2 - d²)φ/s²
+     ∂V  = D^N (B_μ ∂μ + B_s ∂s),  ∂s = s (ℓ_θ + β ∂μ/μ + [θ = β] log μ)
+     ∂²V = D^N (B_μμ ∂μ² + 2 B_μs ∂μ ∂s + B_ss ∂s² + B_μ ∂²μ + B_s ∂²s)
+
+   [SAFETY]:
+   - Exercise dates are the rule held fixed. Near the optimal rule
+     moving it changes the price only at second order, so the pathwise
+     first derivatives stand; gamma's likelihood ratio also sees paths
+     cross the boundary.
+   - ∂/∂ρ (and, with exercise dates, gamma) is NaN at |ρ| = 1, where ρ̄
+     has no derivative.
+   - Per-chunk sums are added in chunk order: the results do not depend
+     on the thread count.
+*/
+
+constexpr int GREEK_PARAMS = 5; // S_0, α, β, ρ, ν
+constexpr size_t GREEK_SUMS = 2 * SABR_NUM_GREEKS; // Σ x, then Σ x²
+
+struct GreeksSetup {
+  double strike, sign, rate, inv_alpha, rho_ratio, nu_dt;
+  bool digital;
+  const uint32_t *exercise; // per path, or nullptr
+};
+
+// S^β of the live lanes (1 elsewhere), as the path step takes it
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::vec
+s_beta_of(const McSetup &m, typename Lanes<W>::vec s_safe,
+          typename Lanes<W>::vec log_s) {
+  typedef typename Lanes<W>::vec vec;
+  switch (m.beta_mode) {
+  case BETA_ZERO:
+    return vec{} + 1.0;
+  case BETA_HALF:
+    return QuantKernel::vsqrt<W>(s_safe);
+  case BETA_ONE:
+    return s_safe;
+  default:
+    return QuantKernel::vexp<W>(m.beta * log_s);
+  }
+}
+
+// b = {B, B_μ, B_s, B_μμ, B_μs, B_ss} of the last step, μ and s > 0
+template <int W>
+__attribute__((always_inline)) inline void
+last_step(const GreeksSetup &g, typename Lanes<W>::vec mu,
+          typename Lanes<W>::vec s, typename Lanes<W>::vec b[6]) {
+  typedef typename Lanes<W>::vec vec;
+  const double c = g.sign;
+  const vec inv_s = 1.0 / s;
+  const vec d = (mu - g.strike) * inv_s;
+  const vec pdf = 0.3989422804014327 * QuantKernel::vexp<W>(-0.5 * d * d);
+  const vec cdf = 0.5 * QuantKernel::verfc<W>(-c * 0.7071067811865476 * d);
+  if (g.digital) {
+    const vec cp = c * pdf * inv_s;
+    b[0] = cdf;
+    b[1] = cp;
+    b[2] = -cp * d;
+    b[3] = -cp * d * inv_s;
+    b[4] = cp * (d * d - 1.0) * inv_s;
+    b[5] = cp * d * (2.0 - d * d) * inv_s;
+    return;
+  }
+  b[0] = c * (mu - g.strike) * cdf + s * pdf;
+  b[1] = c * cdf;
+  b[2] = pdf;
+  b[3] = pdf * inv_s;
+  b[4] = -d * pdf * inv_s;
+  b[5] = d * d * pdf * inv_s;
+  if (c < 0.0) {
+    // Absorption: S_N = 0 for μ + sZ < 0, where the put is worth K, not
+    // K - μ - sZ; take off the put on K = 0
+    const vec d0 = mu * inv_s;
+    const vec pdf0 =
+        0.3989422804014327 * QuantKernel::vexp<W>(-0.5 * d0 * d0);
+    const vec cdf0 = 0.5 * QuantKernel::verfc<W>(0.7071067811865476 * d0);
+    b[0] -= s * pdf0 - mu * cdf0;
+    b[1] += cdf0;
+    b[2] -= pdf0;
+    b[3] -= pdf0 * inv_s;
+    b[4] += d0 * pdf0 * inv_s;
+    b[5] -= d0 * d0 * pdf0 * inv_s;
+  }
+}
+
+// W paths of sabr_mc_lanes with tangents; adds each valid lane's results
+// and their squares to acc[GREEK_SUMS]. stop: lane 0's exercise date, or
+// null (all at maturity).
+template <int W, class Normals>
+__attribute__((always_inline)) inline void
+greeks_lanes(const McSetup &m, const GreeksSetup &g, Normals &normals,
+             size_t valid, const uint32_t *stop,
+             typename Lanes<W>::vec *acc) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+
+  const size_t N = m.num_steps;
+  vec S = vec{} + m.s0;
+  vec sigma = vec{} + m.alpha;
+  vec dS[GREEK_PARAMS] = {vec{} + 1.0}, d2S = vec{};
+  vec l_rho = vec{}, l_nu = vec{};
+  vec res[SABR_NUM_GREEKS] = {};
+  vec lr = vec{}; // gamma weight of the first step (exercise mode)
+  vec stop_at = vec{} + (double)N;
+  ivec lane = {};
+  for (size_t w = 0; w < valid; ++w) {
+    lane[w] = -1;
+    if (stop)
+      stop_at[w] = (double)stop[w];
+  }
+
+  // With exercise dates every step is simulated; otherwise the last one
+  // is integrated out below
+  const size_t steps = stop ? N : N - 1;
+  const vec *z = nullptr;
+  for (size_t n = 0; n < steps; ++n) {
+    if (n % MC_TILE == 0)
+      z = normals.tile(n, std::min(MC_TILE, N - n));
+    const vec z1 = z[2 * (n % MC_TILE)], z2 = z[2 * (n % MC_TILE) + 1];
+
+    // The sabr_mc_lanes step, term for term
+    const ivec alive = S > 0.0;
+    const vec s_safe = alive ? S : vec{} + 1.0;
+    const vec log_s = QuantKernel::vlog<W>(s_safe);
+    const vec s_beta = s_beta_of<W>(m, s_safe, log_s);
+    const vec inc = sigma * s_beta * (m.sqdt * z1);
+    vec s_new = S + inc;
+    s_new = s_new > 0.0 ? s_new : vec{};
+    s_new = alive ? s_new : vec{};
+    const ivec live = s_new > 0.0;
+    if (stop && n == 0) {
+      // ∂/∂S_0 log p(S_1, σ_1 | S_0) + ∂_{S_0} log J, J = ∂S_1/∂S_0
+      const vec v = sigma * s_beta * m.sqdt;
+      const vec dz1 = -1.0 / v - z1 * (m.beta / m.s0);
+      const vec J = 1.0 + inc * (m.beta / m.s0);
+      const vec score = dz1 * (g.rho_ratio * z2 - z1) - m.beta / m.s0;
+      lr = live ? score - m.beta * s_new / (m.s0 * m.s0 * J) : vec{};
+    }
+
+    const vec inv_s = 1.0 / s_safe;
+    const vec r0 = dS[0] * inv_s;
+    const vec ell[GREEK_PARAMS] = {vec{}, vec{} + g.inv_alpha, log_s, l_rho,
+                                   l_nu};
+    d2S = live ? d2S + inc * (m.beta * d2S * inv_s +
+                              m.beta * (m.beta - 1.0) * r0 * r0)
+               : vec{};
+    for (int q = 0; q < GREEK_PARAMS; ++q)
+      dS[q] = live ? dS[q] + inc * (ell[q] + m.beta * dS[q] * inv_s)
+                   : vec{};
+    sigma = sigma * QuantKernel::vexp<W>(
+                        m.nu_sqdt * (m.rho * z1 + m.rho_bar * z2) +
+                        m.vol_drift);
+    l_rho += m.nu_sqdt * (z1 - g.rho_ratio * z2);
+    l_nu += m.sqdt * (m.rho * z1 + m.rho_bar * z2) - g.nu_dt;
+    S = s_new;
+
+    if (!stop)
+      continue;
+    // Exercise (or maturity) at date n + 1: pathwise, gamma by the
+    // first step's likelihood ratio
+    const vec h = g.sign * (S - g.strike);
+    const ivec hit = lane & (stop_at == (double)(n + 1)) & (h > 0.0);
+    const double disc = std::exp(-g.rate * m.dt * (double)(n + 1));
+    const double dc = disc * g.sign;
+    res[SABR_GREEK_PRICE] += hit ? disc * h : vec{};
+    res[SABR_GREEK_DELTA] += hit ? dc * dS[0] : vec{};
+    res[SABR_GREEK_GAMMA] += hit ? dc * dS[0] * lr : vec{};
+    for (int q = 1; q < GREEK_PARAMS; ++q)
+      res[SABR_GREEK_VEGA + q - 1] += hit ? dc * dS[q] : vec{};
+  }
+  if (stop) {
+    for (int j = 0; j < SABR_NUM_GREEKS; ++j) {
+      acc[j] += res[j];
+      acc[SABR_NUM_GREEKS + j] += res[j] * res[j];
+    }
+    return;
+  }
+
+  // European: the last step in closed form
+  const ivec at_t = lane & (stop_at == (double)N);
+  const ivec alive = at_t & (S > 0.0);
+  const vec mu = alive ? S : vec{} + 1.0;
+  const vec log_mu = QuantKernel::vlog<W>(mu);
+  const vec s = sigma * s_beta_of<W>(m, mu, log_mu) * m.sqdt;
+  vec b[6];
+  last_step<W>(g, mu, s, b);
+
+  const double disc = std::exp(-g.rate * m.dt * (double)N);
+  // Absorbed before maturity: h(0)
+  const double dead = g.sign < 0.0 ? (g.digital ? 1.0 : g.strike) : 0.0;
+  const vec inv_mu = 1.0 / mu;
+  const vec r0 = dS[0] * inv_mu;
+  const vec ell[GREEK_PARAMS] = {vec{}, vec{} + g.inv_alpha, log_mu, l_rho,
+                                 l_nu};
+  vec ds[GREEK_PARAMS];
+  for (int q = 0; q < GREEK_PARAMS; ++q)
+    ds[q] = s * (ell[q] + m.beta * dS[q] * inv_mu);
+  const vec d2s =
+      s * (m.beta * d2S * inv_mu + m.beta * (m.beta - 1.0) * r0 * r0);
+  const vec gamma = b[3] * dS[0] * dS[0] + 2.0 * b[4] * dS[0] * ds[0] +
+                    b[5] * ds[0] * ds[0] + b[1] * d2S + b[2] * d2s;
+
+  res[SABR_GREEK_PRICE] +=
+      alive ? disc * b[0] : at_t ? vec{} + disc * dead : vec{};
+  res[SABR_GREEK_DELTA] += alive ? disc * (b[1] * dS[0] + b[2] * ds[0])
+                                 : vec{};
+  res[SABR_GREEK_GAMMA] += alive ? disc * gamma : vec{};
+  for (int q = 1; q < GREEK_PARAMS; ++q)
+    res[SABR_GREEK_VEGA + q - 1] +=
+        alive ? disc * (b[1] * dS[q] + b[2] * ds[q]) : vec{};
+
+  for (int j = 0; j < SABR_NUM_GREEKS; ++j) {
+    acc[j] += res[j];
+    acc[SABR_NUM_GREEKS + j] += res[j] * res[j];
+  }
+}
+
+// Paths [begin, end) -> partial[GREEK_SUMS]
+template <int W>
+__attribute__((always_inline)) inline void
+greeks_range(const McSetup &m, const GreeksSetup &g, size_t begin,
+             size_t end, double *partial) {
+  typedef typename Lanes<W>::vec vec;
+  vec acc[GREEK_SUMS] = {};
+  QuantKernel::for_each_path_block<W>(
+      m.normals, 0, begin, end,
+      [&](auto &normals, size_t p) __attribute__((always_inline)) {
+        greeks_lanes<W>(m, g, normals, std::min<size_t>(W, end - p),
+                        g.exercise ? g.exercise + p : nullptr, acc);
+      });
+  for (size_t j = 0; j < GREEK_SUMS; ++j) {
+    double sum = 0.0;
+    for (int w = 0; w < W; ++w)
+      sum += acc[j][w];
+    partial[j] = sum;
+  }
+}
+
+#ifdef SABR_MC_X86_DISPATCH
+__attribute__((target("avx2,fma"))) void
+greeks_range_avx2(const McSetup &m, const GreeksSetup &g, size_t begin,
+                  size_t end, double *partial) {
+  greeks_range<4>(m, g, begin, end, partial);
+}
+
+__attribute__((target("avx512f"))) void
+greeks_range_avx512(const McSetup &m, const GreeksSetup &g, size_t begin,
+                    size_t end, double *partial) {
+  greeks_range<8>(m, g, begin, end, partial);
+}
+#endif
+
+} // namespace
+
+extern "C" {
+
+void sabr_mc_simulate(const ModelParams *params, double s0, double dt,
+                      size_t num_steps, size_t num_paths, uint64_t seed,
+                      uint64_t first_path, double *out_paths,
+                      double *out_signatures) {
+  if (num_paths == 0 || (!out_paths && !out_signatures))
+    return;
+  QK_METRIC_SCOPE("sabr_mc_simulate",
+                  num_paths * ((out_paths ? 2 * (num_steps + 1) : 0) +
+                               (out_signatures ? 15 : 0)) *
+                      sizeof(double));
+
+  const McSetup m = mc_setup(*params, s0, dt, num_steps, seed, false);
+  sabr_mc_run(m, num_paths, first_path, out_paths, out_signatures);
+}
+
+int sabr_qmc_simulate(const ModelParams *params, double s0, double dt,
+                      size_t num_steps, size_t num_paths, uint64_t seed,
+                      uint64_t first_path, double *out_paths,
+                      double *out_signatures) {
+  if (2 * num_steps > QuantKernel::SOBOL_MAX_DIMS)
+    return -1;
+  if (first_path + num_paths > (1ULL << QuantKernel::SOBOL_BITS))
+    return -2;
+  if (num_paths == 0 || num_steps == 0 || (!out_paths && !out_signatures))
+    return 0;
+  QK_METRIC_SCOPE("sabr_qmc_simulate",
+                  num_paths * ((out_paths ? 2 * (num_steps + 1) : 0) +
+                               (out_signatures ? 15 : 0)) *
+                      sizeof(double));
+
+  const McSetup m = mc_setup(*params, s0, dt, num_steps, seed, true);
+  sabr_mc_run(m, num_paths, first_path, out_paths, out_signatures);
+  return 0;
+}
+
+int sabr_mc_greeks(const ModelParams *params, double s0, double dt,
+                   size_t num_steps, size_t num_paths, uint64_t seed, int qmc,
+                   double strike, double rate, int is_put, int digital,
+                   const uint32_t *exercise, double *out,
+                   double *out_stderr) {
+  if (num_paths == 0 || num_steps == 0 || !(s0 > 0.0) ||
+      !(params->alpha > 0.0) || !(strike > 0.0) || !std::isfinite(strike) ||
+      (digital && exercise))
+    return -1;
+  if (qmc && (2 * num_steps > QuantKernel::SOBOL_MAX_DIMS ||
+              num_paths > (1ULL << QuantKernel::SOBOL_BITS)))
+    return -1;
+  if (exercise)
+    for (size_t p = 0; p < num_paths; ++p)
+      if (exercise[p] == 0 || exercise[p] > num_steps)
+        return -1;
+  QK_METRIC_SCOPE("sabr_mc_greeks",
+                  num_paths * (exercise ? sizeof(uint32_t) : 0));
+
+  const McSetup m = mc_setup(*params, s0, dt, num_steps, seed, qmc != 0);
+  const GreeksSetup g{.strike = strike,
+                      .sign = is_put ? -1.0 : 1.0,
+                      .rate = rate,
+                      .inv_alpha = 1.0 / params->alpha,
+                      .rho_ratio = params->rho / m.rho_bar,
+                      .nu_dt = params->nu * dt,
+                      .digital = digital != 0,
+                      .exercise = exercise};
+
+  const int isa = signature_kernel_isa();
+  const size_t chunks = (num_paths + MC_CHUNK - 1) / MC_CHUNK;
+  std::vector<double> partial(chunks * GREEK_SUMS);
+  QuantKernel::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+    const size_t begin = c * MC_CHUNK;
+    const size_t end = std::min(num_paths, begin + MC_CHUNK);
+    double *part = partial.data() + c * GREEK_SUMS;
+#ifdef SABR_MC_X86_DISPATCH
+    switch (isa) {
+    case 2:
+      greeks_range_avx512(m, g, begin, end, part);
+      return;
+    case 1:
+      greeks_range_avx2(m, g, begin, end, part);
+      return;
+    default:
+      break;
+    }
+#else
+    (void)isa;
+#endif
+    greeks_range<4>(m, g, begin, end, part);
+  });
+
+  // Chunk order, not completion order: same sums for any thread count
+  double sums[GREEK_SUMS] = {};
+  for (size_t c = 0; c < chunks; ++c)
+    for (size_t j = 0; j < GREEK_SUMS; ++j)
+      sums[j] += partial[c * GREEK_SUMS + j];
+  const double n = (double)num_paths;
+  for (int j = 0; j < SABR_NUM_GREEKS; ++j) {
+    const double mean = sums[j] / n;
+    out[j] = mean;
+    if (out_stderr) {
+      const double var = num_paths > 1
+                             ? (sums[SABR_NUM_GREEKS + j] - n * mean * mean) /
+                                   (n - 1.0)
+                             : 0.0;
+      out_stderr[j] = std::sqrt(std::max(0.0, var) / n);
+    }
+  }
+  return 0;
+}
+
+void sabr_mc_normals(uint64_t seed, uint64_t path, size_t num_steps,
+                     double *out) {
+  const QuantKernel::NormalSource src(seed, num_steps, false);
+  QuantKernel::PhiloxNormals<4> normals(src, path);
+  for (size_t n = 0; n < num_steps; n += MC_TILE) {
+    const size_t len = std::min(MC_TILE, num_steps - n);
+    const Lanes<4>::vec *z = normals.tile(n, len);
+    for (size_t k = 0; k < 2 * len; ++k)
+      out[2 * n + k] = z[k][0];
+  }
+}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "kernel.h"
+#include <cstdint>
+
+extern "C" {
+/**
+ * @brief Simulate SABR paths natively, several paths per SIMD register.
+ *
+ *   dS = σ S^β dW,   dσ = ν σ dZ,   dW dZ = ρ dt,   σ_0 = α
+ *
+ * Euler step in S (absorbed at 0), exact lognormal step in σ. Gaussians
+ * come from a Philox4x32-10 counter-based generator keyed by seed and
+ * indexed by (global path index, step), so every path is the same for
+ * any thread count or chunking of the run (and across ISAs up to FMA
+ * rounding).
+ *
+ * @param params Single ModelParams (alpha = initial vol, beta, rho, nu).
+ * @param s0 Initial spot.
+ * @param dt Time step in years.
+ * @param num_steps Steps per path; each path has num_steps + 1 points.
+ * @param num_paths Paths to simulate in this call.
+ * @param seed Generator key.
+ * @param first_path Global index of the first path (lets a large run be
+ *                   generated in chunks with identical results).
+ * @param out_paths num_paths x (num_steps + 1) (t, S) pairs, the
+ *                  compute_signature_level3 path layout, or nullptr.
+ * @param out_signatures num_paths x 15 level-3 signatures of the same
+ *                       paths, accumulated step by step (paths need not
+ *                       be stored), or nullptr.
+ */
+void sabr_mc_simulate(const ModelParams *params, double s0, double dt,
+                      size_t num_steps, size_t num_paths, uint64_t seed,
+                      uint64_t first_path, double *out_paths,
+                      double *out_signatures);
+
+/**
+ * @brief sabr_mc_simulate driven by scrambled Sobol points (QMC).
+ *
+ * Path i is point i of a 2 * num_steps dimensional Sobol sequence with
+ * Owen scrambling keyed by seed; a Brownian bridge maps each point to the
+ * two Brownian paths, so the best-spread dimensions set the terminal
+ * values. Same layout, determinism and chunking as sabr_mc_simulate.
+ * Error bars come from randomized QMC: repeat with independent seeds and
+ * take the spread of the per-seed estimates. Balance is best when
+ * num_paths is a power of two.
+ *
+ * @param seed Scramble seed (one per RQMC replication).
+ * @return 0 on success, -1 if 2 * num_steps exceeds the 4096 Sobol
+ *         dimensions, -2 if first_path + num_paths exceeds 2^32.
+ */
+int sabr_qmc_simulate(const ModelParams *params, double s0, double dt,
+                      size_t num_steps, size_t num_paths, uint64_t seed,
+                      uint64_t first_path, double *out_paths,
+                      double *out_signatures);
+
+/// Entries of sabr_mc_greeks' results
+enum SabrGreek {
+  SABR_GREEK_PRICE, ///< discounted price
+  SABR_GREEK_DELTA, ///< ∂/∂S_0
+  SABR_GREEK_GAMMA, ///< ∂²/∂S_0² (NaN at |ρ| = 1 with exercise dates)
+  SABR_GREEK_VEGA,  ///< ∂/∂α (initial volatility)
+  SABR_GREEK_BETA,  ///< ∂/∂β
+  SABR_GREEK_RHO,   ///< ∂/∂ρ (NaN at |ρ| = 1)
+  SABR_GREEK_NU,    ///< ∂/∂ν
+  SABR_NUM_GREEKS
+};
+
+/**
+ * @brief Price and Greeks of a put or call from one SABR simulation.
+ *
+ * Simulates the sabr_mc_simulate (or, with qmc, sabr_qmc_simulate) paths
+ * of seed from path 0, each carrying its tangents in S_0, α, β, ρ and ν,
+ * and returns the price with all of its first derivatives and gamma. The
+ * payoff is differentiated along each path where it is smooth; the last
+ * step to maturity is integrated in closed form (the expectation of the
+ * likelihood-ratio weight on that step), which covers the call kink for
+ * gamma and the jump of a digital. Costs about one simulation: no bumps,
+ * no second set of random numbers.
+ *
+ * With exercise, the option is American under that stopping rule held
+ * fixed, e.g. the one lsmc_american_exercise fitted on the same paths
+ * (the price is then the LSMC price). Every step is simulated, and gamma
+ * is the pathwise delta times the likelihood-ratio score of the first
+ * step, so paths crossing the exercise boundary count.
+ *
+ * @param params Single ModelParams (alpha = initial vol > 0).
+ * @param s0 Initial spot, > 0.
+ * @param dt Time step in years.
+ * @param num_steps Steps to maturity, at least 1.
+ * @param num_paths Paths, at least 1.
+ * @param seed Generator key (scramble seed with qmc).
+ * @param qmc Non-zero for scrambled Sobol normals.
+ * @param strike Strike, > 0.
+ * @param rate Continuously compounded discount rate.
+ * @param is_put Non-zero for a put, zero for a call.
+ * @param digital Non-zero to pay 1 in the money instead of |S - K|.
+ * @param exercise num_paths exercise dates in 1..num_steps (num_steps:
+ *                 held to maturity), or nullptr for a European option.
+ * @param out SABR_NUM_GREEKS results, indexed by SabrGreek.
+ * @param out_stderr SABR_NUM_GREEKS Monte Carlo standard errors (pseudo-
+ *                   random mode; use replications for QMC), or nullptr.
+ * @return 0 on success, -1 on invalid input (including a digital with
+ *         exercise dates, or the sabr_qmc_simulate limits).
+ */
+int sabr_mc_greeks(const ModelParams *params, double s0, double dt,
+                   size_t num_steps, size_t num_paths, uint64_t seed, int qmc,
+                   double strike, double rate, int is_put, int digital,
+                   const uint32_t *exercise, double *out,
+                   double *out_stderr);
+
+/**
+ * @brief The standard normals sabr_mc_simulate draws for one path.
+ *
+ * @param out 2 * num_steps doubles: (z1, z2) per step, before the ρ
+ *            correlation is applied.
+ */
+void sabr_mc_normals(uint64_t seed, uint64_t path, size_t num_steps,
+                     double *out);
+}
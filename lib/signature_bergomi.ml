@@ -10,6 +10,12 @@ module Signature = struct
     int -> 
     (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t -> 
     unit = "caml_compute_signature_level3"
+  (* Many paths per FFI crossing: contiguous path block -> N x 15 row-major *)
+  external compute_signature_level3_batch_stub :
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    int -> int ->
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_compute_signature_level3_batch"
   (* Phase 25: Manifold Calibration *)
   external compute_frechet_mean : float array -> float * float = "caml_compute_frechet_mean"
 
@@ -29,6 +35,26 @@ module Signature = struct
     int ->
     float = "caml_compute_signature_curvature"
 
+  (* Arbitrary (dim, depth) engine: path is num_points rows of dim floats *)
+  external compute_signature_depth_stub :
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    int -> int -> int ->
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_compute_signature_depth"
+
+  external compute_log_signature_depth_stub :
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    int -> int ->
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_compute_log_signature_depth"
+
+  external compute_expected_signature_depth_stub :
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    int -> int -> int -> int ->
+    (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_compute_expected_signature_depth_bytecode"
+           "caml_compute_expected_signature_depth"
+
   type point = { t : float; value : float }
 
   let array_of_path points =
@@ -51,6 +77,20 @@ module Signature = struct
     let n = Bigarray.Array1.dim path_arr / 2 in
     compute_signature_level3_stub path_arr n out_sig
 
+  (* [paths_block] holds [num_paths] paths of [num_points] (t, value) pairs
+     back to back. Signature of path p is at [p * sig_size .. p * sig_size + 14]. *)
+  let compute_signature_batch_bigarray paths_block ~num_paths ~num_points out_sigs =
+    if Bigarray.Array1.dim paths_block < num_paths * num_points * 2 then
+      invalid_arg "compute_signature_batch: path block too small";
+    if Bigarray.Array1.dim out_sigs < num_paths * sig_size then
+      invalid_arg "compute_signature_batch: output too small";
+    compute_signature_level3_batch_stub paths_block num_paths num_points out_sigs
+
+  let compute_signature_batch paths_block ~num_paths ~num_points =
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (num_paths * sig_size) in
+    compute_signature_batch_bigarray paths_block ~num_paths ~num_points out;
+    out
+
   let compute_log_signature sig_arr =
     let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout logsig_size in
     compute_log_signature_stub sig_arr out;
@@ -62,7 +102,95 @@ module Signature = struct
     compute_expected_signature_stub path_arr n window_size out;
     out
 
+  (* 1 + d + d^2 + ... + d^depth; sig_size = signature_size ~dim:2 ~depth:3 *)
+  let signature_size ~dim ~depth =
+    let rec go n len acc = if n > depth then acc else go (n + 1) (len * dim) (acc + len) in
+    go 0 1 0
+
+  let compute_signature_depth path_arr ~dim ~depth =
+    let n = Bigarray.Array1.dim path_arr / dim in
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (signature_size ~dim ~depth) in
+    compute_signature_depth_stub path_arr n dim depth out;
+    out
+
+  let compute_log_signature_depth sig_arr ~dim ~depth =
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (signature_size ~dim ~depth - 1) in
+    compute_log_signature_depth_stub sig_arr dim depth out;
+    out
+
+  let compute_expected_sig_depth path_arr ~dim ~depth ~window_size =
+    let n = Bigarray.Array1.dim path_arr / dim in
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (signature_size ~dim ~depth) in
+    compute_expected_signature_depth_stub path_arr n dim depth window_size out;
+    out
+
   let compute_curvature sig_history_arr num_snapshots =
     compute_signature_curvature_stub sig_history_arr num_snapshots
 
 end
+
+(* Phase 26: Tick-driven signature state (C++ object, freed by the GC) *)
+module Streaming = struct
+  type t
+
+  external create_stub : int -> int -> t = "caml_streaming_signature_create"
+  external push : t -> float -> float -> unit = "caml_streaming_signature_push"
+  external num_points : t -> int = "caml_streaming_signature_num_points"
+  external curvature : t -> float = "caml_streaming_signature_curvature"
+
+  external full_stub :
+    t -> (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_streaming_signature_full"
+
+  external window_stub :
+    t -> (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_streaming_signature_window"
+
+  external expected_stub :
+    t -> (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_streaming_signature_expected"
+
+  external log_stub :
+    t -> (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    unit = "caml_streaming_signature_log"
+
+  external num_snapshots : t -> int = "caml_streaming_signature_num_snapshots"
+
+  external snapshots_stub :
+    t -> (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    int = "caml_streaming_signature_snapshots"
+
+  (* [window_size] points per window, [history] window snapshots for curvature *)
+  let create ~window_size ~history = create_stub window_size history
+
+  let full st =
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout Signature.sig_size in
+    full_stub st out;
+    out
+
+  let window st =
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout Signature.sig_size in
+    window_stub st out;
+    out
+
+  (* Expected signature of the last window_size + history - 1 points, as
+     Signature.compute_expected_sig returns it for that path *)
+  let expected st =
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout Signature.sig_size in
+    expected_stub st out;
+    out
+
+  let log_signature st =
+    let out = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout Signature.logsig_size in
+    log_stub st out;
+    out
+
+  (* Window snapshots held for the curvature, oldest first (n x sig_size) *)
+  let snapshots st =
+    let out =
+      Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout
+        (num_snapshots st * Signature.sig_size)
+    in
+    let n = snapshots_stub st out in
+    (out, n)
+end
@@ -0,0 +1,304 @@
+#include "signature_engine.h"
+#include "signature_kernel.h"
+#include <algorithm>
+
+// =============================================================================
+// Arbitrary (Dim, Depth) Signature Engine
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: The level-3, 2D kernel fingerprints a (time, price) path.
+   This engine fingerprints richer paths, e.g. (time, price, vol, volume), and
+   keeps more detail (deeper levels) of the shape.
+
+   [HS MATH]:
+   Truncated tensor algebra T^Depth(R^Dim), sig size = (d^(N+1) - 1)/(d - 1).
+   Chen: S(X * seg) = S(X) ⊗ exp(dx). Log via the truncated series of
+   log(1 + x). Expected signature via the same O(1) window slide as the
+   level-3 kernel.
+
+   [SAFETY]:
+   - (2, 3) dispatches to the hand-written level-3 kernels (no regression).
+   - Dim 2..4 x Depth 2..6 use compile-time specialisations; anything else
+     takes the runtime-sized fallback, one per thread, rebuilt only when the
+     shape changes. The tensor log uses per-thread grow-only scratch, so
+     steady-state calls allocate nothing.
+   - Fewer than 2 points give the trivial signature (1, 0, ..., 0).
+*/
+
+namespace {
+
+using QuantKernel::SIG_REANCHOR_INTERVAL;
+using QuantKernel::Signature;
+using QuantKernel::SignatureRuntime;
+
+struct ShapeOps {
+  size_t dim;
+  size_t depth;
+  void (*signature)(const double *, size_t, double *);
+  void (*log)(const double *, double *);
+  void (*expected)(const double *, size_t, size_t, size_t, double *);
+};
+
+template <size_t Dim, size_t Depth> constexpr ShapeOps shape_ops() {
+  return {Dim,
+          Depth,
+          &Signature<Dim, Depth>::compute,
+          &Signature<Dim, Depth>::log,
+          &Signature<Dim, Depth>::expected};
+}
+
+constexpr ShapeOps kShapes[] = {
+    shape_ops<2, 2>(), shape_ops<2, 4>(), shape_ops<2, 5>(),
+    shape_ops<2, 6>(), shape_ops<3, 2>(), shape_ops<3, 3>(),
+    shape_ops<3, 4>(), shape_ops<3, 5>(), shape_ops<3, 6>(),
+    shape_ops<4, 2>(), shape_ops<4, 3>(), shape_ops<4, 4>(),
+    shape_ops<4, 5>(), shape_ops<4, 6>(),
+};
+
+const ShapeOps *find_shape(size_t dim, size_t depth) {
+  for (const ShapeOps &ops : kShapes)
+    if (ops.dim == dim && ops.depth == depth)
+      return &ops;
+  return nullptr;
+}
+
+// Per-thread runtime engine, rebuilt only when the shape changes
+SignatureRuntime &runtime(size_t dim, size_t depth) {
+  static thread_local SignatureRuntime engine(1, 1);
+  if (engine.dim() != dim || engine.depth() != depth)
+    engine = SignatureRuntime(dim, depth);
+  return engine;
+}
+
+// Signature of a path with fewer than 2 points
+void trivial_signature(size_t dim, size_t depth, double *out) {
+  const size_t n = signature_size(dim, depth);
+  out[0] = 1.0;
+  std::fill(out + 1, out + n, 0.0);
+}
+
+} // namespace
+
+namespace QuantKernel {
+
+SignatureRuntime::SignatureRuntime(size_t dim, size_t depth)
+    : dim_(dim), depth_(depth), offsets_(depth + 2, 0) {
+  size_t len = 1;
+  for (size_t n = 0; n <= depth; ++n) {
+    offsets_[n + 1] = offsets_[n] + len;
+    len *= dim;
+  }
+  size_t top = level_len(depth);
+  t_.resize(top);
+  u_.resize(top);
+  dx_.resize(dim);
+  dx2_.resize(dim);
+}
+
+void SignatureRuntime::append_segment(double *S, const double *dx) {
+  for (size_t n = depth_; n >= 1; --n) {
+    const double inv_n = 1.0 / static_cast<double>(n);
+    for (size_t k = 0; k < dim_; ++k)
+      t_[k] = S[0] * dx[k] * inv_n;
+    for (size_t m = 1; m < n; ++m) {
+      const size_t len = level_len(m);
+      const double *Sm = S + offsets_[m];
+      const double scale = 1.0 / static_cast<double>(n - m);
+      for (size_t r = 0; r < len; ++r) {
+        const double base = (t_[r] + Sm[r]) * scale;
+        for (size_t k = 0; k < dim_; ++k)
+          u_[r * dim_ + k] = base * dx[k];
+      }
+      std::copy(u_.begin(), u_.begin() + len * dim_, t_.begin());
+    }
+    double *Sn = S + offsets_[n];
+    const size_t len_n = level_len(n);
+    for (size_t r = 0; r < len_n; ++r)
+      Sn[r] += t_[r];
+  }
+}
+
+void SignatureRuntime::prepend_segment(double *S, const double *a) {
+  for (size_t n = depth_; n >= 1; --n) {
+    const double inv_n = 1.0 / static_cast<double>(n);
+    for (size_t k = 0; k < dim_; ++k)
+      t_[k] = a[k] * S[0] * inv_n;
+    for (size_t m = 1; m < n; ++m) {
+      const size_t len = level_len(m);
+      const double *Sm = S + offsets_[m];
+      const double scale = 1.0 / static_cast<double>(n - m);
+      for (size_t k = 0; k < dim_; ++k) {
+        const double ak = a[k] * scale;
+        for (size_t r = 0; r < len; ++r)
+          u_[k * len + r] = ak * (t_[r] + Sm[r]);
+      }
+      std::copy(u_.begin(), u_.begin() + len * dim_, t_.begin());
+    }
+    double *Sn = S + offsets_[n];
+    const size_t len_n = level_len(n);
+    for (size_t r = 0; r < len_n; ++r)
+      Sn[r] += t_[r];
+  }
+}
+
+void SignatureRuntime::compute(const double *path, size_t num_points,
+                               double *out) {
+  const size_t n_coef = size();
+  out[0] = 1.0;
+  for (size_t k = 1; k < n_coef; ++k)
+    out[k] = 0.0;
+  for (size_t i = 1; i < num_points; ++i) {
+    for (size_t k = 0; k < dim_; ++k)
+      dx_[k] = path[i * dim_ + k] - path[(i - 1) * dim_ + k];
+    append_segment(out, dx_.data());
+  }
+}
+
+void SignatureRuntime::mul_no_constant(const double *a, const double *b,
+                                       double *c) const {
+  std::fill(c, c + size(), 0.0);
+  for (size_t n = 2; n <= depth_; ++n) {
+    double *cn = c + offsets_[n];
+    for (size_t p = 1; p < n; ++p) {
+      const double *ap = a + offsets_[p];
+      const double *bq = b + offsets_[n - p];
+      const size_t len_q = level_len(n - p);
+      const size_t len_p = level_len(p);
+      for (size_t i = 0; i < len_p; ++i)
+        for (size_t j = 0; j < len_q; ++j)
+          cn[i * len_q + j] += ap[i] * bq[j];
+    }
+  }
+}
+
+void SignatureRuntime::log(const double *sig, double *out) {
+  const size_t n_coef = size();
+  double *x = signature_scratch(4 * n_coef);
+  double *power = x + n_coef, *next = power + n_coef, *acc = next + n_coef;
+  std::copy(sig, sig + n_coef, x);
+  x[0] = 0.0;
+  std::copy(x, x + n_coef, power);
+  std::fill(acc, acc + n_coef, 0.0);
+  for (size_t k = 1; k <= depth_; ++k) {
+    const double coef = ((k % 2 == 1) ? 1.0 : -1.0) / static_cast<double>(k);
+    for (size_t r = 0; r < n_coef; ++r)
+      acc[r] += coef * power[r];
+    if (k < depth_) {
+      mul_no_constant(power, x, next);
+      std::swap(power, next);
+    }
+  }
+  for (size_t r = 1; r < n_coef; ++r)
+    out[r - 1] = acc[r];
+}
+
+void SignatureRuntime::expected(const double *path, size_t num_points,
+                                size_t window_size, size_t reanchor,
+                                double *out) {
+  if (num_points < window_size || window_size < 2) {
+    compute(path, num_points, out);
+    return;
+  }
+  const size_t n_coef = size();
+  const size_t num_windows = num_points - window_size + 1;
+  window_.resize(n_coef);
+
+  compute(path, window_size, window_.data());
+  std::copy(window_.begin(), window_.end(), out);
+
+  for (size_t start = 1; start < num_windows; ++start) {
+    if (start % reanchor == 0) {
+      compute(path + start * dim_, window_size, window_.data());
+    } else {
+      const double *out0 = path + (start - 1) * dim_;
+      const double *in0 = path + (start + window_size - 2) * dim_;
+      for (size_t k = 0; k < dim_; ++k) {
+        dx_[k] = out0[k] - out0[dim_ + k];
+        dx2_[k] = in0[dim_ + k] - in0[k];
+      }
+      prepend_segment(window_.data(), dx_.data());
+      append_segment(window_.data(), dx2_.data());
+    }
+    for (size_t k = 0; k < n_coef; ++k)
+      out[k] += window_[k];
+  }
+
+  const double inv_n = 1.0 / static_cast<double>(num_windows);
+  for (size_t k = 0; k < n_coef; ++k)
+    out[k] *= inv_n;
+}
+
+} // namespace QuantKernel
+
+extern "C" {
+
+size_t signature_size(size_t dim, size_t depth) {
+  size_t total = 0, len = 1;
+  for (size_t n = 0; n <= depth; ++n) {
+    total += len;
+    len *= dim;
+  }
+  return total;
+}
+
+void compute_signature_depth(const double *path, size_t num_points,
+                             size_t dim, size_t depth, double *output) {
+  if (dim == 0 || depth == 0)
+    return;
+  if (num_points < 2) {
+    trivial_signature(dim, depth, output);
+    return;
+  }
+
+  if (dim == 2 && depth == 3) {
+    compute_signature_level3(path, num_points, output);
+    return;
+  }
+  if (const ShapeOps *ops = find_shape(dim, depth)) {
+    ops->signature(path, num_points, output);
+    return;
+  }
+  runtime(dim, depth).compute(path, num_points, output);
+}
+
+void compute_log_signature_depth(const double *sig, size_t dim, size_t depth,
+                                 double *logsig) {
+  if (sig == nullptr || logsig == nullptr || dim == 0 || depth == 0)
+    return;
+
+  if (dim == 2 && depth == 3) {
+    compute_log_signature(sig, logsig);
+    return;
+  }
+  if (const ShapeOps *ops = find_shape(dim, depth)) {
+    ops->log(sig, logsig);
+    return;
+  }
+  runtime(dim, depth).log(sig, logsig);
+}
+
+void compute_expected_signature_depth(const double *path, size_t num_points,
+                                      size_t dim, size_t depth,
+                                      size_t window_size,
+                                      double *expected_sig) {
+  if (dim == 0 || depth == 0)
+    return;
+  if (num_points < 2) {
+    trivial_signature(dim, depth, expected_sig);
+    return;
+  }
+
+  if (dim == 2 && depth == 3) {
+    compute_expected_signature(path, num_points, window_size, expected_sig);
+    return;
+  }
+  const size_t reanchor = std::max(window_size, SIG_REANCHOR_INTERVAL);
+  if (const ShapeOps *ops = find_shape(dim, depth)) {
+    ops->expected(path, num_points, window_size, reanchor, expected_sig);
+    return;
+  }
+  runtime(dim, depth).expected(path, num_points, window_size, reanchor,
+                               expected_sig);
+}
+
+} // extern "C"
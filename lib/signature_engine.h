@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+extern "C" {
+/**
+ * @brief Number of signature coefficients for a Dim-dimensional path
+ *        truncated at Depth, including the constant term.
+ *
+ * 1 + d + d² + ... + d^Depth. For (2, 3) this is the familiar 15.
+ */
+size_t signature_size(size_t dim, size_t depth);
+
+/**
+ * @brief Compute the Signature of a Dim-dimensional path up to Depth.
+ *
+ * Layout: level 0 (the constant 1), then level 1 (d terms), level 2 (d²
+ * terms, index i*d + j), ... Level-n multi-index (i1..in) is stored
+ * row-major. For (dim, depth) = (2, 3) this is identical to
+ * compute_signature_level3 and dispatches to it.
+ *
+ * @param path Row-major num_points x dim array, e.g. (time, price, vol,
+ *             volume) per row.
+ * @param num_points Number of points in the path; fewer than 2 give the
+ *                   trivial signature (1, 0, ..., 0).
+ * @param dim Path dimension (>= 1).
+ * @param depth Truncation level (>= 1).
+ * @param output_signature Buffer of signature_size(dim, depth) doubles.
+ */
+void compute_signature_depth(const double *path, size_t num_points,
+                             size_t dim, size_t depth,
+                             double *output_signature);
+
+/**
+ * @brief Tensor logarithm of a truncated signature.
+ *
+ * log(S) = Σ_{n=1}^{depth} (-1)^{n+1} (S - 1)^{⊗n} / n, truncated.
+ * Output drops the (zero) constant term: signature_size(dim, depth) - 1
+ * doubles, same level layout. Matches compute_log_signature at (2, 3).
+ */
+void compute_log_signature_depth(const double *signature, size_t dim,
+                                 size_t depth, double *log_signature);
+
+/**
+ * @brief Expected Signature over sliding windows, any (dim, depth).
+ *
+ * Same semantics as compute_expected_signature (O(1) Chen slide with
+ * periodic re-anchoring; falls back to the whole-path signature when
+ * num_points < window_size or window_size < 2). Fewer than 2 points give
+ * the trivial signature.
+ *
+ * @param expected_sig Output: signature_size(dim, depth) doubles.
+ */
+void compute_expected_signature_depth(const double *path, size_t num_points,
+                                      size_t dim, size_t depth,
+                                      size_t window_size,
+                                      double *expected_sig);
+}
+
+// C++ internal API: tensor algebra truncated at Depth over R^Dim
+namespace QuantKernel {
+
+// Sliding-window signatures are recomputed from scratch every
+// max(window, SIG_REANCHOR_INTERVAL) slides to bound rounding drift.
+constexpr size_t SIG_REANCHOR_INTERVAL = 256;
+
+// Per-thread grow-only scratch for the tensor log: repeated calls allocate
+// nothing.
+inline double *signature_scratch(size_t n) {
+  static thread_local std::vector<double> scratch;
+  if (scratch.size() < n)
+    scratch.resize(n);
+  return scratch.data();
+}
+
+constexpr size_t ipow(size_t base, size_t exp) {
+  size_t r = 1;
+  for (size_t i = 0; i < exp; ++i)
+    r *= base;
+  return r;
+}
+
+/**
+ * Compile-time specialised truncated signature. Level offsets come from a
+ * constexpr table and the Chen updates recurse over levels at compile time,
+ * so every loop bound is a constant and small shapes unroll fully.
+ *
+ * The segment signature of a linear piece is exp(dx); both
+ *   S ⊗ exp(dx)  (append a segment)  and  exp(dx) ⊗ S  (prepend)
+ * are evaluated level by level, top-down and in place, with Horner's rule:
+ *   (S ⊗ exp(dx))_n = S_n + (((S_0 dx/n + S_1) ⊗ dx/(n-1) + ...) + S_{n-1}) ⊗ dx
+ */
+template <size_t Dim, size_t Depth> struct Signature {
+  static_assert(Dim >= 1 && Depth >= 1, "empty tensor algebra");
+
+  static constexpr std::array<size_t, Depth + 2> make_offsets() {
+    std::array<size_t, Depth + 2> off{};
+    off[0] = 0;
+    for (size_t n = 0; n <= Depth; ++n)
+      off[n + 1] = off[n] + ipow(Dim, n);
+    return off;
+  }
+
+  static constexpr std::array<size_t, Depth + 2> offsets = make_offsets();
+  static constexpr size_t size = offsets[Depth + 1];
+
+  // S <- S ⊗ exp(dx)
+  static void append_segment(double *S, const double *dx) {
+    append_levels<Depth>(S, dx);
+  }
+
+  // S <- exp(a) ⊗ S
+  static void prepend_segment(double *S, const double *a) {
+    prepend_levels<Depth>(S, a);
+  }
+
+  static void compute(const double *path, size_t num_points, double *out) {
+    out[0] = 1.0;
+    for (size_t k = 1; k < size; ++k)
+      out[k] = 0.0;
+    double dx[Dim];
+    for (size_t i = 1; i < num_points; ++i) {
+      for (size_t k = 0; k < Dim; ++k)
+        dx[k] = path[i * Dim + k] - path[(i - 1) * Dim + k];
+      append_segment(out, dx);
+    }
+  }
+
+  // c (levels >= 1) = a ⊗ b, both with zero constant term
+  static void mul_no_constant(const double *a, const double *b, double *c) {
+    for (size_t k = 0; k < size; ++k)
+      c[k] = 0.0;
+    for (size_t n = 2; n <= Depth; ++n) {
+      double *cn = c + offsets[n];
+      for (size_t p = 1; p < n; ++p) {
+        const double *ap = a + offsets[p];
+        const double *bq = b + offsets[n - p];
+        const size_t len_q = ipow_rt(n - p);
+        const size_t len_p = ipow_rt(p);
+        for (size_t i = 0; i < len_p; ++i)
+          for (size_t j = 0; j < len_q; ++j)
+            cn[i * len_q + j] += ap[i] * bq[j];
+      }
+    }
+  }
+
+  // Output drops the constant term: size - 1 doubles
+  static void log(const double *sig, double *out) {
+    double *x = signature_scratch(4 * size);
+    double *power = x + size, *next = power + size, *acc = next + size;
+    std::copy(sig, sig + size, x);
+    x[0] = 0.0;
+    std::copy(x, x + size, power);
+    std::fill(acc, acc + size, 0.0);
+    for (size_t k = 1; k <= Depth; ++k) {
+      const double coef = ((k % 2 == 1) ? 1.0 : -1.0) / static_cast<double>(k);
+      for (size_t r = 0; r < size; ++r)
+        acc[r] += coef * power[r];
+      if (k < Depth) {
+        mul_no_constant(power, x, next);
+        std::swap(power, next);
+      }
+    }
+    for (size_t r = 1; r < size; ++r)
+      out[r - 1] = acc[r];
+  }
+
+  static void expected(const double *path, size_t num_points,
+                       size_t window_size, size_t reanchor, double *out) {
+    if (num_points < window_size || window_size < 2) {
+      compute(path, num_points, out);
+      return;
+    }
+    const size_t num_windows = num_points - window_size + 1;
+    double window_sig[size];
+    double a[Dim], b[Dim];
+
+    compute(path, window_size, window_sig);
+    for (size_t k = 0; k < size; ++k)
+      out[k] = window_sig[k];
+
+    for (size_t start = 1; start < num_windows; ++start) {
+      if (start % reanchor == 0) {
+        compute(path + start * Dim, window_size, window_sig);
+      } else {
+        const double *out0 = path + (start - 1) * Dim;
+        const double *in0 = path + (start + window_size - 2) * Dim;
+        for (size_t k = 0; k < Dim; ++k) {
+          a[k] = out0[k] - out0[Dim + k];
+          b[k] = in0[Dim + k] - in0[k];
+        }
+        prepend_segment(window_sig, a);
+        append_segment(window_sig, b);
+      }
+      for (size_t k = 0; k < size; ++k)
+        out[k] += window_sig[k];
+    }
+
+    const double inv_n = 1.0 / static_cast<double>(num_windows);
+    for (size_t k = 0; k < size; ++k)
+      out[k] *= inv_n;
+  }
+
+private:
+  static constexpr size_t ipow_rt(size_t n) { return offsets[n + 1] - offsets[n]; }
+
+  // Levels are updated top-down so each one still sees the old lower levels.
+  // N and M are template parameters, so every loop below has a constant trip
+  // count and the whole update unrolls for small shapes.
+  template <size_t N> static void append_levels(double *S, const double *dx) {
+    if constexpr (N >= 1) {
+      double t[Dim];
+      constexpr double inv_n = 1.0 / static_cast<double>(N);
+      for (size_t k = 0; k < Dim; ++k)
+        t[k] = S[0] * dx[k] * inv_n;
+      append_horner<N, 1>(S, dx, t);
+      append_levels<N - 1>(S, dx);
+    }
+  }
+
+  // t holds level M; t' = (t + S_M) ⊗ dx / (N - M) until M == N
+  template <size_t N, size_t M>
+  static void append_horner(double *S, const double *dx, const double *t) {
+    constexpr size_t len = ipow(Dim, M);
+    if constexpr (M == N) {
+      double *Sn = S + offsets[N];
+      for (size_t r = 0; r < len; ++r)
+        Sn[r] += t[r];
+    } else {
+      constexpr double scale = 1.0 / static_cast<double>(N - M);
+      const double *Sm = S + offsets[M];
+      double u[len * Dim];
+      for (size_t r = 0; r < len; ++r) {
+        const double base = (t[r] + Sm[r]) * scale;
+        for (size_t k = 0; k < Dim; ++k)
+          u[r * Dim + k] = base * dx[k];
+      }
+      append_horner<N, M + 1>(S, dx, u);
+    }
+  }
+
+  template <size_t N> static void prepend_levels(double *S, const double *a) {
+    if constexpr (N >= 1) {
+      double t[Dim];
+      constexpr double inv_n = 1.0 / static_cast<double>(N);
+      for (size_t k = 0; k < Dim; ++k)
+        t[k] = a[k] * S[0] * inv_n;
+      prepend_horner<N, 1>(S, a, t);
+      prepend_levels<N - 1>(S, a);
+    }
+  }
+
+  // t holds level M; t' = a / (N - M) ⊗ (t + S_M) until M == N
+  template <size_t N, size_t M>
+  static void prepend_horner(double *S, const double *a, const double *t) {
+    constexpr size_t len = ipow(Dim, M);
+    if constexpr (M == N) {
+      double *Sn = S + offsets[N];
+      for (size_t r = 0; r < len; ++r)
+        Sn[r] += t[r];
+    } else {
+      constexpr double scale = 1.0 / static_cast<double>(N - M);
+      const double *Sm = S + offsets[M];
+      double u[len * Dim];
+      for (size_t k = 0; k < Dim; ++k) {
+        const double ak = a[k] * scale;
+        for (size_t r = 0; r < len; ++r)
+          u[k * len + r] = ak * (t[r] + Sm[r]);
+      }
+      prepend_horner<N, M + 1>(S, a, u);
+    }
+  }
+};
+
+/**
+ * Runtime-sized fallback for shapes without a compile-time specialisation.
+ * Same algorithms and layout as Signature<Dim, Depth>; scratch is held by
+ * the object so repeated calls do not allocate.
+ */
+class SignatureRuntime {
+public:
+  SignatureRuntime(size_t dim, size_t depth);
+
+  size_t size() const { return offsets_.back(); }
+  size_t dim() const { return dim_; }
+  size_t depth() const { return depth_; }
+
+  void append_segment(double *S, const double *dx);
+  void prepend_segment(double *S, const double *a);
+  void compute(const double *path, size_t num_points, double *out);
+  void log(const double *sig, double *out);
+  void expected(const double *path, size_t num_points, size_t window_size,
+                size_t reanchor, double *out);
+
+private:
+  size_t level_len(size_t n) const { return offsets_[n + 1] - offsets_[n]; }
+  void mul_no_constant(const double *a, const double *b, double *c) const;
+
+  size_t dim_;
+  size_t depth_;
+  std::vector<size_t> offsets_;
+  std::vector<double> t_, u_, dx_, dx2_, window_;
+};
+
+} // namespace QuantKernel
@@ -17,6 +17,45 @@ extern "C" {
 void compute_signature_level3(const double *path, size_t num_points,
                               double *output_signature);
 
+/**
+ * @brief Compute level-3 signatures for many paths in one call.
+ *
+ * Paths are interleaved across SIMD lanes (one path per lane), so the
+ * kernel vectorizes across paths rather than across the 2 dimensions of a
+ * single path. Uses the same runtime ISA selection as
+ * compute_signature_level3.
+ *
+ * @param paths Contiguous block of num_paths paths, each laid out as
+ *              num_points (time, value) pairs. Length should be
+ *              num_paths * 2 * num_points.
+ * @param num_paths Number of paths in the block.
+ * @param num_points Number of points per path (all paths share it).
+ * @param out Row-major num_paths x 15 output matrix; row p holds the
+ *            signature of path p in the compute_signature_level3 layout.
+ */
+void compute_signature_level3_batch(const double *paths, size_t num_paths,
+                                    size_t num_points, double *out);
+
+/**
+ * @brief Instruction set used by compute_signature_level3 on this host.
+ *
+ * Resolved once via CPUID on first use. On non-x86 builds this is always 0
+ * (NEON or scalar, fixed at compile time).
+ *
+ * @return 0 = scalar/NEON, 1 = AVX2+FMA, 2 = AVX-512F.
+ */
+int signature_kernel_isa(void);
+
+/**
+ * @brief Override the runtime ISA selection (benchmarks / cross-checks).
+ *
+ * @param level Requested level (see signature_kernel_isa). Values above
+ *              what the CPU supports, or negative values, select the best
+ *              supported level.
+ * @return The level actually selected.
+ */
+int signature_kernel_force_isa(int level);
+
 /**
  * @brief Compute the Log-Signature via BCH (Baker-Campbell-Hausdorff)
  * inversion.
@@ -37,6 +76,8 @@ void compute_log_signature(const double *signature, double *log_signature);
  *
  * Φ(X)_{s,t} = E[Sig(X)] averaged over N overlapping sub-paths.
  * Filters high-frequency noise while preserving topological structure.
+ * Windows are slid incrementally (Chen's identity), so cost is O(N)
+ * rather than O(N·W).
  *
  * @param path Full path as flat array of (time, value) pairs.
  * @param num_points Total number of points.
@@ -46,6 +87,18 @@ void compute_log_signature(const double *signature, double *log_signature);
 void compute_expected_signature(const double *path, size_t num_points,
                                 size_t window_size, double *expected_sig);
 
+/**
+ * @brief Reference Expected Signature: recomputes every window, O(N·W).
+ *
+ * compute_expected_signature slides the window in O(1) per step via Chen's
+ * identity (with periodic re-anchoring). This is the from-scratch version
+ * it is validated and benchmarked against. Same parameters and output.
+ */
+void compute_expected_signature_reference(const double *path,
+                                          size_t num_points,
+                                          size_t window_size,
+                                          double *expected_sig);
+
 /**
  * @brief Compute curvature of the path signature manifold.
  *
@@ -0,0 +1,390 @@
+#include "slv.h"
+#include "heston_qe.h"
+#include "kernel_util.h"
+#include "mc_random.h"
+#include "metrics.h"
+#include "signature_kernel.h"
+#include "simd_math.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// =============================================================================
+// SLV Leverage Calibration (particle method, SIMD across particles)
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Stochastic local vol scales the Heston volatility by a
+   leverage L(S, t), chosen so that at every date the model's spot
+   distribution is the local-vol model's (and so it reprices the same
+   vanillas). L depends on the average variance of the paths sitting at
+   each spot, which depends on L at earlier dates, so all particles move
+   together one date at a time: estimate E[V | S] from where they are,
+   set L, step every particle, repeat. One simulation yields the whole
+   surface.
+
+   [HS MATH]:
+   Step n -> n + 1, x = log S, piece constants of heston_mc.cpp:
+     V' by QE from (V, z_V)
+     x' = x + μΔ + L (K0 + (K1 + ¼Δ) V + (K2 + ¼Δ) V')
+            - ¼Δ L² (V + V') + L √(K3 (V + V')) z_S,   L = L(S_n, t_n)
+   i.e. the central-weight step with the diffusion scaled by L; at L ≡ 1
+   it is the Heston engine's step with the plain K0 (K0* assumes L ≡ 1).
+   Conditional variance (Nadaraya-Watson, quartic kernel):
+     E[V | x] = (Σ_i k((x_i - x)/h) V_i + V̄) / (Σ_i k((x_i - x)/h) + 1),
+     k(u) = (1 - u²)² on |u| < 1,   h = 1.5 σ_x N^{-1/5}
+   with V̄ the mean variance and σ_x the spread of log-spot across the N
+   particles. Particles are
+   linearly binned (counts and V sums) on SLV_NODES nodes spanning
+   [min x, max x], so an estimate sums the ~2h / spacing nodes near x
+   rather than every particle. L lives on the same nodes and is read back
+   by linear interpolation when stepping:
+     L(x, t_n) = σ_LV(e^x, t_n) / √E[V | x],   E[V | x] = v0 at t_0
+
+   [SAFETY]:
+   - Every estimate also carries one particle's worth of the date's mean
+     V. Where particles are dense this is noise; in a sparse tail (a few
+     particles, possibly all at QE's exact V = 0) it pulls E[V | x] toward
+     the mean instead of letting L explode and throw those particles
+     further out on the next step.
+   - E[V | x] is floored at 1e-8, so L stays finite where variance dies.
+   - h is at least two node spacings. Outside the particle range the
+     estimate is taken at its edge (flat extrapolation).
+   - Particles all at one point (t_0, or no spot diffusion) use the plain
+     mean of V.
+*/
+namespace {
+
+using QuantKernel::Lanes;
+using QuantKernel::QePiece;
+
+// Particles per thread-pool task (a multiple of 8)
+constexpr size_t SLV_CHUNK = 2048;
+constexpr size_t SLV_SPAN = 256;   // particles per batch of normals
+constexpr size_t SLV_NODES = 512;  // regression / leverage nodes per date
+constexpr size_t SLV_MOMENTS = 4;  // per chunk: Σ d, Σ d², min x, max x
+constexpr double SLV_BANDWIDTH = 1.5;
+constexpr double SLV_VAR_FLOOR = 1e-8;
+constexpr double SLV_PRIOR = 1.0; // particles' worth of mean V per estimate
+
+// One parallel pass over the particles (step or bin)
+struct SlvSweep {
+  const QuantKernel::NormalSource *normals;
+  const QePiece *q;
+  size_t step;
+  double quarter_dt, x0; // x0 = log s0, origin of the moments
+  double *x, *v;         // particles, padded to whole SIMD blocks
+  const double *lev;     // L of the current date on its nodes
+  double x_lo, inv_dx;   // node k at x_lo + k / inv_dx (0: all at x_lo)
+};
+
+// Node coordinate of each lane, clamped to [0, SLV_NODES - 1]
+template <int W>
+__attribute__((always_inline)) inline typename Lanes<W>::vec
+node_coord(const SlvSweep &s, typename Lanes<W>::vec x) {
+  typedef typename Lanes<W>::vec vec;
+  vec u = (x - s.x_lo) * s.inv_dx;
+  u = u > 0.0 ? u : vec{};
+  return u < (double)(SLV_NODES - 1) ? u : vec{} + (double)(SLV_NODES - 1);
+}
+
+// Step particles [begin, end) over date s.step; mom gets this chunk's
+// moments of the new log-spots.
+template <int W>
+__attribute__((always_inline)) inline void
+slv_step_range(const SlvSweep &s, size_t begin, size_t end, double *mom) {
+  typedef typename Lanes<W>::vec vec;
+  typedef typename Lanes<W>::ivec ivec;
+  typedef typename Lanes<W>::uvec uvec;
+  const QePiece &q = *s.q;
+  const double c1 = q.k1 + s.quarter_dt, c2 = q.k2 + s.quarter_dt;
+
+  vec lane{};
+  uvec lane_u{};
+  for (int w = 0; w < W; ++w) {
+    lane[w] = (double)w;
+    lane_u[w] = (uint64_t)w;
+  }
+  vec z[2 * SLV_SPAN / W];
+  // Sums by particle index mod 8, added up in that order: the same
+  // rounding at every vector width
+  constexpr size_t SLOTS = 8 / W;
+  vec sum[SLOTS] = {}, sum2[SLOTS] = {};
+  vec lo = vec{} + HUGE_VAL, hi = vec{} - HUGE_VAL;
+  for (size_t p0 = begin; p0 < end; p0 += SLV_SPAN) {
+    // The span's normals in one batch: the inverse normal gathers its
+    // tail lanes across the whole span
+    const size_t p1 = std::min(end, p0 + SLV_SPAN);
+    size_t nb = 0;
+    for (size_t p = p0; p < p1; p += W, ++nb) {
+      const uvec path = lane_u + (uint64_t)p;
+      QuantKernel::philox_step_uniforms<W>(
+          *s.normals, path & QuantKernel::RNG_LOW32, path >> 32, s.step,
+          z + 2 * nb);
+    }
+    QuantKernel::inverse_normal_inplace<W>(z, 2 * nb);
+
+    nb = 0;
+    for (size_t p = p0; p < p1; p += W, ++nb) {
+      vec x, V;
+      std::memcpy(&x, s.x + p, sizeof x);
+      std::memcpy(&V, s.v + p, sizeof V);
+
+      vec v_new, k0;
+      QuantKernel::qe_step<W>(q, V, z[2 * nb], v_new, k0);
+      const vec u = node_coord<W>(s, x);
+      vec L;
+      for (int w = 0; w < W; ++w) {
+        const size_t k = std::min((size_t)u[w], SLV_NODES - 2);
+        L[w] = s.lev[k] + (u[w] - (double)k) * (s.lev[k + 1] - s.lev[k]);
+      }
+      const vec vs = V + v_new;
+      x += q.drift + L * (q.k0 + c1 * V + c2 * v_new) -
+           s.quarter_dt * L * L * vs +
+           L * QuantKernel::vsqrt<W>(q.k3 * vs) * z[2 * nb + 1];
+      std::memcpy(s.x + p, &x, sizeof x);
+      std::memcpy(s.v + p, &v_new, sizeof v_new);
+
+      const ivec live = lane < (double)(end - p);
+      const vec d = live ? x - s.x0 : vec{};
+      sum[(p / W) % SLOTS] += d;
+      sum2[(p / W) % SLOTS] += d * d;
+      lo = live & (x < lo) ? x : lo;
+      hi = live & (x > hi) ? x : hi;
+    }
+  }
+  mom[0] = mom[1] = 0.0;
+  mom[2] = HUGE_VAL;
+  mom[3] = -HUGE_VAL;
+  for (size_t k = 0; k < SLOTS; ++k)
+    for (int w = 0; w < W; ++w) {
+      mom[0] += sum[k][w];
+      mom[1] += sum2[k][w];
+    }
+  for (int w = 0; w < W; ++w) {
+    mom[2] = std::min(mom[2], lo[w]);
+    mom[3] = std::max(mom[3], hi[w]);
+  }
+}
+
+// Linear binning of particles [begin, end): bins gets SLV_NODES weights,
+// then SLV_NODES weighted V sums.
+template <int W>
+__attribute__((always_inline)) inline void
+slv_bin_range(const SlvSweep &s, size_t begin, size_t end, double *bins) {
+  typedef typename Lanes<W>::vec vec;
+  double *cnt = bins, *sv = bins + SLV_NODES;
+  std::fill(bins, bins + 2 * SLV_NODES, 0.0);
+  for (size_t p = begin; p < end; p += W) {
+    vec x, V;
+    std::memcpy(&x, s.x + p, sizeof x);
+    std::memcpy(&V, s.v + p, sizeof V);
+    const vec u = node_coord<W>(s, x);
+    const size_t valid = std::min<size_t>(W, end - p);
+    for (size_t w = 0; w < valid; ++w) {
+      const size_t k = std::min((size_t)u[w], SLV_NODES - 2);
+      const double f = u[w] - (double)k;
+      cnt[k] += 1.0 - f;
+      cnt[k + 1] += f;
+      sv[k] += (1.0 - f) * V[w];
+      sv[k + 1] += f * V[w];
+    }
+  }
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SLV_X86_DISPATCH 1
+
+__attribute__((target("avx2,fma"))) void
+slv_step_avx2(const SlvSweep &s, size_t begin, size_t end, double *mom) {
+  slv_step_range<4>(s, begin, end, mom);
+}
+
+__attribute__((target("avx512f"))) void
+slv_step_avx512(const SlvSweep &s, size_t begin, size_t end, double *mom) {
+  slv_step_range<8>(s, begin, end, mom);
+}
+
+__attribute__((target("avx2,fma"))) void
+slv_bin_avx2(const SlvSweep &s, size_t begin, size_t end, double *bins) {
+  slv_bin_range<4>(s, begin, end, bins);
+}
+
+__attribute__((target("avx512f"))) void
+slv_bin_avx512(const SlvSweep &s, size_t begin, size_t end, double *bins) {
+  slv_bin_range<8>(s, begin, end, bins);
+}
+#endif
+
+// E[V | x] from the reduced bins, shrunk toward the date's mean; r = h in
+// node spacings, c = node coordinate of x (inside the particle range)
+double cond_variance(const double *bins, double c, double r, double mean) {
+  const double *cnt = bins, *sv = bins + SLV_NODES;
+  const size_t k0 = (size_t)std::max(0.0, std::ceil(c - r));
+  const size_t k1 =
+      (size_t)std::min((double)(SLV_NODES - 1), std::floor(c + r));
+  double num = 0.0, den = 0.0;
+  for (size_t k = k0; k <= k1; ++k) {
+    const double u = ((double)k - c) / r;
+    double w = 1.0 - u * u;
+    w *= w;
+    num += w * sv[k];
+    den += w * cnt[k];
+  }
+  return (num + SLV_PRIOR * mean) / (den + SLV_PRIOR);
+}
+
+} // namespace
+
+extern "C" {
+
+int slv_calibrate_leverage(const HestonParams *pieces, size_t num_pieces,
+                           double s0, double v0,
+                           const QuantKernel::LocalVolSurface *local_vol,
+                           const double *spots, size_t num_spots, double dt,
+                           size_t num_steps, size_t num_paths, uint64_t seed,
+                           double *out_leverage, double *out_terminal) {
+  if (!QuantKernel::qe_pieces_valid(pieces, num_pieces) || !(s0 > 0.0) ||
+      !(v0 >= 0.0) || local_vol == nullptr || num_spots == 0 ||
+      !(dt > 0.0) || num_steps == 0 || num_paths < 2 ||
+      !QuantKernel::increasing_positive(spots, num_spots))
+    return -1;
+  QK_METRIC_SCOPE("slv_calibrate_leverage",
+                  6 * num_steps * num_paths * sizeof(double));
+
+  std::vector<double> log_spot(num_spots);
+  for (size_t j = 0; j < num_spots; ++j)
+    log_spot[j] = std::log(spots[j]);
+
+  const std::vector<QePiece> qe =
+      QuantKernel::qe_pieces(pieces, num_pieces, dt, num_steps);
+  const QuantKernel::NormalSource normals(seed, num_steps, false);
+  const size_t padded = (num_paths + 7) / 8 * 8;
+  const double x0 = std::log(s0);
+  QuantKernel::AlignedVec<double> x(padded, x0), v(padded, v0);
+  const size_t chunks = (num_paths + SLV_CHUNK - 1) / SLV_CHUNK;
+  std::vector<double> moments(chunks * SLV_MOMENTS);
+  QuantKernel::AlignedVec<double> bins(chunks * 2 * SLV_NODES);
+  std::vector<double> total(2 * SLV_NODES), lev(SLV_NODES);
+
+  // Date 0: every particle at (s0, v0)
+  const double inv_sqrt_v0 = 1.0 / std::sqrt(std::max(v0, SLV_VAR_FLOOR));
+  std::fill(lev.begin(), lev.end(), local_vol->at(x0, 0.0) * inv_sqrt_v0);
+  for (size_t j = 0; j < num_spots; ++j)
+    out_leverage[j] = local_vol->at(log_spot[j], 0.0) * inv_sqrt_v0;
+
+  SlvSweep s{.normals = &normals,
+             .q = nullptr,
+             .step = 0,
+             .quarter_dt = 0.25 * dt,
+             .x0 = x0,
+             .x = x.data(),
+             .v = v.data(),
+             .lev = lev.data(),
+             .x_lo = x0,
+             .inv_dx = 0.0};
+  const int isa = signature_kernel_isa();
+  const double n_inv = 1.0 / (double)num_paths;
+  const double bandwidth =
+      SLV_BANDWIDTH * std::pow((double)num_paths, -0.2);
+
+  for (const QePiece &q : qe) {
+    s.q = &q;
+    for (size_t n = q.step_begin; n < q.step_end; ++n) {
+      s.step = n;
+      QuantKernel::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+        const size_t begin = c * SLV_CHUNK;
+        const size_t end = std::min(num_paths, begin + SLV_CHUNK);
+        double *mom = moments.data() + c * SLV_MOMENTS;
+#ifdef SLV_X86_DISPATCH
+        switch (isa) {
+        case 2:
+          slv_step_avx512(s, begin, end, mom);
+          return;
+        case 1:
+          slv_step_avx2(s, begin, end, mom);
+          return;
+        default:
+          break;
+        }
+#else
+        (void)isa;
+#endif
+        slv_step_range<4>(s, begin, end, mom);
+      });
+
+      // Nodes of date n + 1 span the particles
+      double sum = 0.0, sum2 = 0.0, lo = HUGE_VAL, hi = -HUGE_VAL;
+      for (size_t c = 0; c < chunks; ++c) {
+        const double *mom = moments.data() + c * SLV_MOMENTS;
+        sum += mom[0];
+        sum2 += mom[1];
+        lo = std::min(lo, mom[2]);
+        hi = std::max(hi, mom[3]);
+      }
+      const double mean = sum * n_inv;
+      const double spread =
+          std::sqrt(std::max(sum2 * n_inv - mean * mean, 0.0));
+      const double dx = (hi - lo) / (double)(SLV_NODES - 1);
+      s.x_lo = lo;
+      s.inv_dx = hi - lo > 1e-12 ? 1.0 / dx : 0.0;
+
+      QuantKernel::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+        const size_t begin = c * SLV_CHUNK;
+        const size_t end = std::min(num_paths, begin + SLV_CHUNK);
+        double *b = bins.data() + c * 2 * SLV_NODES;
+#ifdef SLV_X86_DISPATCH
+        switch (isa) {
+        case 2:
+          slv_bin_avx512(s, begin, end, b);
+          return;
+        case 1:
+          slv_bin_avx2(s, begin, end, b);
+          return;
+        default:
+          break;
+        }
+#endif
+        slv_bin_range<4>(s, begin, end, b);
+      });
+      std::fill(total.begin(), total.end(), 0.0);
+      for (size_t c = 0; c < chunks; ++c) {
+        const double *b = bins.data() + c * 2 * SLV_NODES;
+        for (size_t k = 0; k < 2 * SLV_NODES; ++k)
+          total[k] += b[k];
+      }
+      double mean_v = 0.0;
+      for (size_t k = 0; k < SLV_NODES; ++k)
+        mean_v += total[SLV_NODES + k];
+      mean_v *= n_inv;
+
+      // L of date n + 1 on the nodes and at the requested spots
+      const double t_next = (double)(n + 1) * dt;
+      const double r = std::max(bandwidth * spread * s.inv_dx, 2.0);
+      auto leverage = [&](double xe, double c) {
+        const double ev = s.inv_dx > 0.0
+                              ? cond_variance(total.data(), c, r, mean_v)
+                              : mean_v;
+        return local_vol->at(xe, t_next) /
+               std::sqrt(std::max(ev, SLV_VAR_FLOOR));
+      };
+      for (size_t k = 0; k < SLV_NODES; ++k)
+        lev[k] = leverage(lo + (double)k * dx, (double)k);
+      double *row = out_leverage + (n + 1) * num_spots;
+      for (size_t j = 0; j < num_spots; ++j) {
+        const double c = std::clamp((log_spot[j] - lo) * s.inv_dx, 0.0,
+                                    (double)(SLV_NODES - 1));
+        row[j] = leverage(log_spot[j], c);
+      }
+    }
+  }
+
+  if (out_terminal)
+    for (size_t i = 0; i < num_paths; ++i) {
+      out_terminal[2 * i] = std::exp(x[i]);
+      out_terminal[2 * i + 1] = v[i];
+    }
+  return 0;
+}
+}
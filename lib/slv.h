@@ -0,0 +1,45 @@
+#pragma once
+
+#include "heston_mc.h"
+#include "local_vol.h"
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+
+/**
+ * @brief Calibrate the SLV leverage surface by the particle method.
+ *
+ *   dS = μ S dt + L(S, t) √V S dW_S,   dV = κ (θ - V) dt + ξ √V dW_V,
+ *   L(S, t)² E[V | S_t = S] = σ_LV(S, t)²
+ *
+ * One simulation of num_paths particles: at every date the conditional
+ * variance is estimated by kernel regression of V on log-spot, which fixes
+ * L for the next step. V follows heston_mc_simulate's QE scheme; particles
+ * are stepped across the native thread pool with per-chunk partial sums
+ * added in chunk order, so results do not depend on the thread count.
+ *
+ * @param pieces Heston term structure, as for heston_mc_simulate (μ is
+ *               the risk-neutral drift the local vols were built with).
+ * @param num_pieces At least 1.
+ * @param s0 Initial spot.
+ * @param v0 Initial variance.
+ * @param local_vol Local-vol surface (local_vol_surface_create).
+ * @param spots num_spots increasing positive spots to report L at.
+ * @param num_spots At least 1.
+ * @param dt Time step in years.
+ * @param num_steps Steps, at least 1.
+ * @param num_paths Particles, at least 2.
+ * @param seed Philox key (particle i draws the normals of path i).
+ * @param out_leverage (num_steps + 1) x num_spots, row n = L(spots, n dt);
+ *                     row n is the leverage applied over step n.
+ * @param out_terminal num_paths (S_T, V_T) pairs, or nullptr.
+ * @return 0 on success, -1 on invalid input.
+ */
+int slv_calibrate_leverage(const HestonParams *pieces, size_t num_pieces,
+                           double s0, double v0,
+                           const QuantKernel::LocalVolSurface *local_vol,
+                           const double *spots, size_t num_spots, double dt,
+                           size_t num_steps, size_t num_paths, uint64_t seed,
+                           double *out_leverage, double *out_terminal);
+}
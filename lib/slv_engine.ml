@@ -29,26 +29,99 @@ let compute_local_vol ~s0 ~strike ~tenor ~get_vol ~r =
   if denominator <= 0.0 then vol (* Fallback to implied vol if Dupire fails *)
   else sqrt (max 0.0 (numerator /. denominator))
 
-(* Calibrate Leverage Surface L(S,t) *)
-(* L(S,t) = sigma_dup(S,t) / sqrt(E[sigma_stoch^2 | S_t=S]) *)
-let calibrate_leverage paths ~strike ~tenor ~sigma_dup =
-  let sum_sigma2 = ref 0.0 in
-  let count = ref 0 in
-  
-  (* Find paths close to strike at time t *)
-  let t_idx = int_of_float (tenor /. 0.01) in (* Assuming dt=0.01 *)
-  
-  Array.iter (fun (path, _sig) ->
-    let spot = Bigarray.Array1.get path (2 * t_idx + 1) in
-    if abs_float (spot -. strike) < 5.0 then begin
-      (* In a real SLV, we would store the stochastic vol path too. 
-         For this demo, we'll approximate the conditional expectation. *)
-      sum_sigma2 := !sum_sigma2 +. 0.04; (* Placeholder for E[sigma^2] *)
-      count := !count + 1
+(* Native surfaces (local_vol.cpp, slv.cpp) *)
+
+type buf = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+(* Vols on a strike x tenor grid: vols.(j).(i) at tenors.(j), strikes.(i) *)
+type vol_grid = {
+  strikes : float array;
+  tenors : float array;
+  vols : float array array;
+}
+
+(* Dupire local vols tabulated on a (log-spot, time) grid, freed by the GC *)
+type local_vol
+
+external local_vol_stub :
+  buf -> buf -> buf -> float -> float -> int -> int -> local_vol
+  = "caml_local_vol_surface_create_bytecode" "caml_local_vol_surface_create"
+
+external local_vol_at : local_vol -> spot:float -> t:float -> float
+  = "caml_local_vol_surface_at"
+
+(* Grid nodes whose local vol fell back to the implied vol (arbitrage in
+   the fitted surface) *)
+external arbitrage_points : local_vol -> int
+  = "caml_local_vol_surface_arbitrage_points"
+
+external calibrate_stub :
+  buf -> float -> float -> local_vol -> buf -> float -> int -> int -> int ->
+  buf -> buf -> int = "caml_slv_calibrate_leverage_bytecode" "caml_slv_calibrate_leverage"
+
+let to_buf a = Bigarray.Array1.of_array Bigarray.float64 Bigarray.c_layout a
+
+let well_formed (g : vol_grid) =
+  Array.length g.vols = Array.length g.tenors
+  && Array.for_all (fun row -> Array.length row = Array.length g.strikes) g.vols
+
+(* Local-vol surface of an implied-vol grid, built once: a cubic spline of
+   total variance per tenor, Dupire from its exact derivatives on
+   num_spots x num_times nodes spanning the strikes and [0, last tenor].
+   local_vol_at is bilinear between nodes and flat outside. Needs 3+
+   increasing strikes; arbitrage points keep their implied vol. Raises
+   Invalid_argument on an invalid grid. *)
+let local_vol_surface ?(num_spots = 256) ?(num_times = 64) ~s0 ~r (implied : vol_grid) =
+  if not (well_formed implied) || num_spots < 2 || num_times < 2 then
+    invalid_arg "Slv_engine.local_vol_surface: invalid grid";
+  local_vol_stub (to_buf (Array.concat (Array.to_list implied.vols)))
+    (to_buf implied.strikes) (to_buf implied.tenors) s0 r num_spots num_times
+
+(* Leverage L(S,t) = sigma_dup(S,t) / sqrt(E[V | S_t = S]) at spots x dates
+   n dt: surface row n holds L(spots, n dt), the leverage over step n.
+   terminal: num_paths (S_T, V_T) pairs of the calibrating particles. *)
+type leverage = {
+  spots : float array;
+  dt : float;
+  surface : buf;
+  terminal : buf;
+}
+
+(* Calibrates the whole leverage surface in one particle simulation: Heston
+   variance (QE, term structure with its drift replaced by r) times the
+   leverage, with E[V | S] re-estimated by kernel regression at every step
+   across the native thread pool. local_vol is built with the same s0 and r
+   (local_vol_surface). Raises Invalid_argument on invalid input. *)
+let calibrate_leverage ?(seed = Random.bits ()) (term : Heston.term_structure) ~s0 ~v0 ~r
+    (local_vol : local_vol) ~spots ~dt ~num_steps ~num_paths =
+  let pieces =
+    Heston.pieces_buffer (List.map (fun (t_end, p) -> (t_end, { p with Heston.mu = r })) term)
+  in
+  let create n = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout n in
+  let surface = create ((num_steps + 1) * Array.length spots) in
+  let terminal = create (2 * num_paths) in
+  if num_steps < 1 || num_paths < 2
+  || calibrate_stub pieces s0 v0 local_vol (to_buf spots) dt num_steps num_paths seed
+       surface terminal <> 0
+  then invalid_arg "Slv_engine.calibrate_leverage: invalid input";
+  { spots; dt; surface; terminal }
+
+(* L at (spot, t): linear between spots and dates, flat outside *)
+let leverage_at (l : leverage) ~spot ~t =
+  let n = Array.length l.spots in
+  let rows = Bigarray.Array1.dim l.surface / n in
+  let at row =
+    let o = row * n in
+    if spot <= l.spots.(0) then l.surface.{o}
+    else if spot >= l.spots.(n - 1) then l.surface.{o + n - 1}
+    else begin
+      let i = ref 1 in
+      while l.spots.(!i) < spot do incr i done;
+      let w = (spot -. l.spots.(!i - 1)) /. (l.spots.(!i) -. l.spots.(!i - 1)) in
+      l.surface.{o + !i - 1} +. w *. (l.surface.{o + !i} -. l.surface.{o + !i - 1})
     end
-  ) paths;
-  
-  if !count = 0 then 1.0
-  else 
-    let e_sigma2 = !sum_sigma2 /. float_of_int !count in
-    sigma_dup /. (sqrt e_sigma2)
+  in
+  let u = Float.min (float_of_int (rows - 1)) (Float.max 0.0 (t /. l.dt)) in
+  let row = min (int_of_float u) (rows - 2) in
+  let w = u -. float_of_int row in
+  (1.0 -. w) *. at row +. w *. at (row + 1)
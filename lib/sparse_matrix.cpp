@@ -0,0 +1,381 @@
+#include "sparse_matrix.h"
+#include "metrics.h"
+#include "signature_kernel.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SPARSE_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// =============================================================================
+// SELL-C-σ / Blocked CSR SpMV
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Plain CSR walks one row at a time, so short rows leave
+   the SIMD units idle and every x[col] is a dependent scalar load. SELL
+   packs 8 rows side by side (rows of similar length, thanks to the σ sort)
+   so each step loads 8 values, gathers 8 x entries and does one FMA. BCSR
+   instead keeps small dense blocks, loading one contiguous run of x per
+   block, which wins when the non-zeros cluster (banded transition graphs).
+
+   [HS MATH]:
+   SELL-C-σ (Kreutzer et al.): chunk c holds rows π(cC .. cC + C - 1) where
+   π sorts rows by descending length within each window of σ rows. Chunk
+   length L_c = max row length in the chunk; stored entries Σ_c C · L_c.
+   Larger σ means less padding but less locality in y (the scatter through
+   π stays inside a σ window).
+
+   [SAFETY]:
+   - Padding slots hold value 0 and a valid column index, so gathers never
+     read outside x. (With an inf/NaN in x a padded row can turn an inf
+     result into NaN, as 0 * inf does.)
+   - Parts partition output rows, so threads never write the same y entry.
+*/
+
+namespace QuantKernel {
+
+// -----------------------------------------------------------------------------
+// Build
+// -----------------------------------------------------------------------------
+
+SparseMatrix::SparseMatrix(const double *values, const int *col_indices,
+                           const int *row_ptr, int num_rows, int num_cols,
+                           Format format, int param)
+    : format_(format), num_rows_(num_rows), num_cols_(num_cols),
+      nnz_((size_t)row_ptr[num_rows]) {
+  if (format_ == BCSR) {
+    int block = (param == 2 || param == 4) ? param : DEFAULT_BLOCK;
+    if (num_cols_ < block)
+      format_ = CSR; // no room for a single block
+    else
+      build_bcsr(values, col_indices, row_ptr, block);
+  } else if (format_ == SELL) {
+    build_sell(values, col_indices, row_ptr, param);
+  }
+  if (format_ == CSR)
+    build_csr(values, col_indices, row_ptr);
+}
+
+void SparseMatrix::build_csr(const double *values, const int *col_indices,
+                             const int *row_ptr) {
+  row_ptr_.assign(row_ptr, row_ptr + num_rows_ + 1);
+  cols_.assign(col_indices, col_indices + nnz_);
+  vals_.assign(values, values + nnz_);
+  stored_ = nnz_;
+
+  // One unit of overhead per row, so runs of empty rows still balance
+  std::vector<size_t> prefix(num_rows_ + 1);
+  for (int i = 0; i <= num_rows_; ++i)
+    prefix[i] = (size_t)row_ptr_[i] + (size_t)i;
+  partition(prefix);
+}
+
+void SparseMatrix::build_sell(const double *values, const int *col_indices,
+                              const int *row_ptr, int sigma) {
+  const int C = SELL_C;
+  if (sigma <= 0)
+    sigma = DEFAULT_SIGMA;
+  sigma = (sigma + C - 1) / C * C;
+
+  std::vector<int> order(num_rows_);
+  std::iota(order.begin(), order.end(), 0);
+  auto row_len = [&](int r) { return row_ptr[r + 1] - row_ptr[r]; };
+  for (int w = 0; w < num_rows_; w += sigma) {
+    auto first = order.begin() + w;
+    auto last = order.begin() + std::min(num_rows_, w + sigma);
+    std::stable_sort(first, last,
+                     [&](int a, int b) { return row_len(a) > row_len(b); });
+  }
+
+  const size_t num_chunks = ((size_t)num_rows_ + C - 1) / C;
+  perm_.assign(num_chunks * C, -1);
+  chunk_ptr_.assign(num_chunks + 1, 0);
+  for (size_t c = 0; c < num_chunks; ++c) {
+    int len = 0;
+    for (int r = 0; r < C; ++r) {
+      size_t slot = c * C + r;
+      if (slot < (size_t)num_rows_) {
+        perm_[slot] = order[slot];
+        len = std::max(len, row_len(order[slot]));
+      }
+    }
+    chunk_ptr_[c + 1] = chunk_ptr_[c] + (int64_t)len * C;
+  }
+
+  stored_ = (size_t)chunk_ptr_[num_chunks];
+  cols_.assign(stored_, 0);
+  vals_.assign(stored_, 0.0);
+  for (size_t c = 0; c < num_chunks; ++c) {
+    const int64_t base = chunk_ptr_[c];
+    const int64_t len = (chunk_ptr_[c + 1] - base) / C;
+    for (int r = 0; r < C; ++r) {
+      int row = perm_[c * C + r];
+      int begin = row >= 0 ? row_ptr[row] : 0;
+      int n = row >= 0 ? row_len(row) : 0;
+      int pad_col = n > 0 ? col_indices[begin + n - 1] : 0;
+      for (int64_t j = 0; j < len; ++j) {
+        size_t k = (size_t)(base + j * C + r);
+        if (j < n) {
+          cols_[k] = col_indices[begin + j];
+          vals_[k] = values[begin + j];
+        } else {
+          cols_[k] = pad_col;
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> prefix(num_chunks + 1);
+  for (size_t c = 0; c <= num_chunks; ++c)
+    prefix[c] = (size_t)chunk_ptr_[c] + c * C;
+  partition(prefix);
+}
+
+void SparseMatrix::build_bcsr(const double *values, const int *col_indices,
+                              const int *row_ptr, int block) {
+  const int B = block;
+  block_ = B;
+  const size_t num_block_rows = ((size_t)num_rows_ + B - 1) / B;
+  row_ptr_.assign(num_block_rows + 1, 0);
+  cols_.clear();
+  vals_.clear();
+
+  std::vector<std::tuple<int, int, double>> entries; // (col, local row, value)
+  for (size_t br = 0; br < num_block_rows; ++br) {
+    entries.clear();
+    const int r0 = (int)br * B;
+    const int r1 = std::min(num_rows_, r0 + B);
+    for (int r = r0; r < r1; ++r)
+      for (int k = row_ptr[r]; k < row_ptr[r + 1]; ++k)
+        entries.emplace_back(col_indices[k], r - r0, values[k]);
+    std::sort(entries.begin(), entries.end(),
+              [](const auto &a, const auto &b) {
+                return std::get<0>(a) < std::get<0>(b);
+              });
+
+    // Greedy cover: each block starts at the first uncovered column
+    for (size_t e = 0; e < entries.size();) {
+      const int c0 = std::min(std::get<0>(entries[e]), num_cols_ - B);
+      const size_t off = vals_.size();
+      cols_.push_back(c0);
+      vals_.resize(off + (size_t)B * B, 0.0);
+      for (; e < entries.size() && std::get<0>(entries[e]) < c0 + B; ++e) {
+        auto [col, r, v] = entries[e];
+        vals_[off + (size_t)r * B + (col - c0)] += v;
+      }
+    }
+    row_ptr_[br + 1] = (int64_t)cols_.size();
+  }
+  stored_ = vals_.size();
+
+  std::vector<size_t> prefix(num_block_rows + 1);
+  for (size_t br = 0; br <= num_block_rows; ++br)
+    prefix[br] = (size_t)row_ptr_[br] * B * B + br * B;
+  partition(prefix);
+}
+
+void SparseMatrix::partition(const std::vector<size_t> &prefix) {
+  const size_t units = prefix.size() - 1;
+  const size_t total = prefix.back();
+  const size_t parts = std::min(
+      std::max<size_t>(units, 1),
+      sparse_num_parts(total, ThreadPool::global().size()));
+  parts_.assign(parts + 1, units);
+  parts_[0] = 0;
+  for (size_t p = 1; p < parts; ++p) {
+    size_t target = (size_t)((double)total * (double)p / (double)parts);
+    parts_[p] = std::max(
+        parts_[p - 1],
+        (size_t)(std::lower_bound(prefix.begin(), prefix.end() - 1, target) -
+                 prefix.begin()));
+  }
+}
+
+double SparseMatrix::fill_ratio() const {
+  return nnz_ == 0 ? 1.0 : (double)stored_ / (double)nnz_;
+}
+
+// -----------------------------------------------------------------------------
+// Kernels
+// -----------------------------------------------------------------------------
+namespace {
+
+void csr_rows(const int64_t *row_ptr, const int *cols, const double *vals,
+              size_t begin, size_t end, const double *x, double *y) {
+  for (size_t i = begin; i < end; ++i) {
+    double sum = 0.0;
+    for (int64_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k)
+      sum += vals[k] * x[cols[k]];
+    y[i] = sum;
+  }
+}
+
+template <int B>
+void bcsr_rows(const int64_t *row_ptr, const int *cols, const double *vals,
+               int num_rows, size_t begin, size_t end, const double *x,
+               double *y) {
+  for (size_t br = begin; br < end; ++br) {
+    double acc[B] = {};
+    for (int64_t b = row_ptr[br]; b < row_ptr[br + 1]; ++b) {
+      const double *v = vals + (size_t)b * B * B;
+      const double *xs = x + cols[b];
+      for (int r = 0; r < B; ++r)
+        for (int k = 0; k < B; ++k)
+          acc[r] += v[r * B + k] * xs[k];
+    }
+    const int r0 = (int)br * B;
+    for (int r = 0; r < B && r0 + r < num_rows; ++r)
+      y[r0 + r] = acc[r];
+  }
+}
+
+constexpr int C = SparseMatrix::SELL_C;
+
+void sell_chunks_scalar(const int64_t *chunk_ptr, const int *cols,
+                        const double *vals, const int *perm, size_t begin,
+                        size_t end, const double *x, double *y) {
+  for (size_t c = begin; c < end; ++c) {
+    double acc[C] = {};
+    for (int64_t k = chunk_ptr[c]; k < chunk_ptr[c + 1]; k += C)
+      for (int r = 0; r < C; ++r)
+        acc[r] += vals[k + r] * x[cols[k + r]];
+    for (int r = 0; r < C; ++r)
+      if (perm[c * C + r] >= 0)
+        y[perm[c * C + r]] = acc[r];
+  }
+}
+
+#ifdef SPARSE_X86_DISPATCH
+__attribute__((target("avx2,fma"))) void
+sell_chunks_avx2(const int64_t *chunk_ptr, const int *cols, const double *vals,
+                 const int *perm, size_t begin, size_t end, const double *x,
+                 double *y) {
+  for (size_t c = begin; c < end; ++c) {
+    __m256d v_acc_lo = _mm256_setzero_pd();
+    __m256d v_acc_hi = _mm256_setzero_pd();
+    for (int64_t k = chunk_ptr[c]; k < chunk_ptr[c + 1]; k += C) {
+      __m128i v_col_lo = _mm_loadu_si128((const __m128i *)&cols[k]);
+      __m128i v_col_hi = _mm_loadu_si128((const __m128i *)&cols[k + 4]);
+      v_acc_lo = _mm256_fmadd_pd(_mm256_loadu_pd(&vals[k]),
+                                 _mm256_i32gather_pd(x, v_col_lo, 8), v_acc_lo);
+      v_acc_hi =
+          _mm256_fmadd_pd(_mm256_loadu_pd(&vals[k + 4]),
+                          _mm256_i32gather_pd(x, v_col_hi, 8), v_acc_hi);
+    }
+    alignas(32) double acc[C];
+    _mm256_store_pd(&acc[0], v_acc_lo);
+    _mm256_store_pd(&acc[4], v_acc_hi);
+    for (int r = 0; r < C; ++r)
+      if (perm[c * C + r] >= 0)
+        y[perm[c * C + r]] = acc[r];
+  }
+}
+
+__attribute__((target("avx512f"))) void
+sell_chunks_avx512(const int64_t *chunk_ptr, const int *cols,
+                   const double *vals, const int *perm, size_t begin,
+                   size_t end, const double *x, double *y) {
+  for (size_t c = begin; c < end; ++c) {
+    __m512d v_acc = _mm512_setzero_pd();
+    for (int64_t k = chunk_ptr[c]; k < chunk_ptr[c + 1]; k += C) {
+      __m256i v_col = _mm256_loadu_si256((const __m256i *)&cols[k]);
+      v_acc = _mm512_fmadd_pd(_mm512_loadu_pd(&vals[k]),
+                              _mm512_i32gather_pd(v_col, x, 8), v_acc);
+    }
+    alignas(64) double acc[C];
+    _mm512_store_pd(acc, v_acc);
+    for (int r = 0; r < C; ++r)
+      if (perm[c * C + r] >= 0)
+        y[perm[c * C + r]] = acc[r];
+  }
+}
+#endif
+
+} // namespace
+
+void SparseMatrix::multiply_range(size_t begin, size_t end, const double *x,
+                                  double *y) const {
+  switch (format_) {
+  case CSR:
+    csr_rows(row_ptr_.data(), cols_.data(), vals_.data(), begin, end, x, y);
+    return;
+  case BCSR:
+    if (block_ == 2)
+      bcsr_rows<2>(row_ptr_.data(), cols_.data(), vals_.data(), num_rows_,
+                   begin, end, x, y);
+    else
+      bcsr_rows<4>(row_ptr_.data(), cols_.data(), vals_.data(), num_rows_,
+                   begin, end, x, y);
+    return;
+  case SELL:
+#ifdef SPARSE_X86_DISPATCH
+    // Same process-wide ISA selection as the signature kernels
+    switch (signature_kernel_isa()) {
+    case 2:
+      sell_chunks_avx512(chunk_ptr_.data(), cols_.data(), vals_.data(),
+                         perm_.data(), begin, end, x, y);
+      return;
+    case 1:
+      sell_chunks_avx2(chunk_ptr_.data(), cols_.data(), vals_.data(),
+                       perm_.data(), begin, end, x, y);
+      return;
+    default:
+      break;
+    }
+#endif
+    sell_chunks_scalar(chunk_ptr_.data(), cols_.data(), vals_.data(),
+                       perm_.data(), begin, end, x, y);
+    return;
+  }
+}
+
+void SparseMatrix::multiply(const double *x, double *y) const {
+  const size_t parts = parts_.size() - 1;
+  ThreadPool::global().parallel_for(parts, [&](size_t p) {
+    multiply_range(parts_[p], parts_[p + 1], x, y);
+  });
+}
+
+} // namespace QuantKernel
+
+extern "C" {
+
+QuantKernel::SparseMatrix *sparse_matrix_create(const double *values,
+                                                const int *col_indices,
+                                                const int *row_ptr,
+                                                int num_rows, int num_cols,
+                                                int format, int param) {
+  if (format < QuantKernel::SparseMatrix::CSR ||
+      format > QuantKernel::SparseMatrix::BCSR || num_rows < 0 ||
+      num_cols < 0 || row_ptr[0] != 0)
+    return nullptr;
+  for (int i = 0; i < num_rows; ++i)
+    if (row_ptr[i + 1] < row_ptr[i])
+      return nullptr;
+  for (int k = 0; k < row_ptr[num_rows]; ++k)
+    if (col_indices[k] < 0 || col_indices[k] >= num_cols)
+      return nullptr;
+  return new QuantKernel::SparseMatrix(
+      values, col_indices, row_ptr, num_rows, num_cols,
+      (QuantKernel::SparseMatrix::Format)format, param);
+}
+
+void sparse_matrix_destroy(QuantKernel::SparseMatrix *m) { delete m; }
+
+void sparse_matrix_spmv(const QuantKernel::SparseMatrix *m, const double *x,
+                        double *y) {
+  QK_METRIC_SCOPE("sparse_matrix_spmv",
+                  m->nnz() * (sizeof(double) + sizeof(int)) +
+                      ((size_t)m->num_rows() + m->num_cols()) *
+                          sizeof(double));
+  m->multiply(x, y);
+}
+
+double sparse_matrix_fill_ratio(const QuantKernel::SparseMatrix *m) {
+  return m->fill_ratio();
+}
+}
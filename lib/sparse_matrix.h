@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+/// Entries below which a sparse kernel is not worth splitting across threads.
+constexpr size_t SPARSE_MIN_PART_ENTRIES = 32768;
+
+/// Number of parts to split `entries` units of work into on `threads`
+/// threads (4 parts per thread for balance, never below the minimum size).
+inline size_t sparse_num_parts(size_t entries, size_t threads) {
+  size_t by_size = entries / SPARSE_MIN_PART_ENTRIES;
+  return std::max<size_t>(1, std::min(threads * 4, by_size));
+}
+
+/// First row of part p when the rows of a CSR matrix are split into `parts`
+/// runs with equal nnz. Monotone in p; p == parts gives num_rows.
+inline int csr_part_begin(const int *row_ptr, int num_rows, size_t p,
+                          size_t parts) {
+  if (p == 0)
+    return 0;
+  if (p >= parts)
+    return num_rows;
+  const int64_t target =
+      (int64_t)((double)row_ptr[num_rows] * (double)p / (double)parts);
+  return (int)(std::lower_bound(row_ptr, row_ptr + num_rows, target) -
+               row_ptr);
+}
+
+/**
+ * Sparse matrix built once from CSR and kept in an SpMV-friendly layout.
+ *
+ * Formats:
+ *  - CSR:  plain copy of the input.
+ *  - SELL: SELL-C-σ with C = 8 (one AVX-512 register of doubles). Rows are
+ *          sorted by length inside windows of σ rows, cut into chunks of 8
+ *          and each chunk is padded to its longest row and stored column
+ *          major, so one step of a chunk is one 8-lane gather + FMA.
+ *  - BCSR: register-blocked CSR with B x B dense blocks (B = 2 or 4). A
+ *          block covers B consecutive columns starting anywhere (clamped to
+ *          num_cols - B), which keeps the fill low on banded structure.
+ *
+ * multiply() splits the rows (chunks / block rows) into parts with equal
+ * stored entries, computed once at build time, and runs them on the
+ * process-wide ThreadPool. Every output row is written by exactly one part.
+ */
+class SparseMatrix {
+public:
+  enum Format { CSR = 0, SELL = 1, BCSR = 2 };
+
+  static constexpr int SELL_C = 8;
+  static constexpr int DEFAULT_SIGMA = 256;
+  static constexpr int DEFAULT_BLOCK = 4;
+
+  /// param: σ for SELL (rounded up to a multiple of C, <= 0 -> default),
+  ///        block size for BCSR (2 or 4, anything else -> default).
+  SparseMatrix(const double *values, const int *col_indices,
+               const int *row_ptr, int num_rows, int num_cols, Format format,
+               int param);
+
+  /// y = A x (x: num_cols, y: num_rows).
+  void multiply(const double *x, double *y) const;
+
+  Format format() const { return format_; }
+  int num_rows() const { return num_rows_; }
+  int num_cols() const { return num_cols_; }
+  size_t nnz() const { return nnz_; }
+  /// Stored entries (padding included) over nnz; 1.0 for CSR.
+  double fill_ratio() const;
+
+private:
+  void build_csr(const double *values, const int *col_indices,
+                 const int *row_ptr);
+  void build_sell(const double *values, const int *col_indices,
+                  const int *row_ptr, int sigma);
+  void build_bcsr(const double *values, const int *col_indices,
+                  const int *row_ptr, int block);
+  // Cuts [0, units) into parts of roughly equal stored entries;
+  // prefix[u] = stored entries before unit u.
+  void partition(const std::vector<size_t> &prefix);
+
+  void multiply_range(size_t begin, size_t end, const double *x,
+                      double *y) const;
+
+  Format format_;
+  int num_rows_, num_cols_;
+  size_t nnz_;
+  size_t stored_ = 0;
+
+  // CSR
+  std::vector<int64_t> row_ptr_;
+  std::vector<int> cols_;
+  std::vector<double> vals_;
+
+  // SELL-C-σ: chunk c owns slots [chunk_ptr_[c], chunk_ptr_[c + 1]),
+  // lane r of step j at chunk_ptr_[c] + j * C + r; cols_ / vals_ reused.
+  std::vector<int64_t> chunk_ptr_;
+  std::vector<int> perm_; // slot row -> original row (-1 for padding rows)
+
+  // BCSR: block row br owns blocks [row_ptr_[br], row_ptr_[br + 1]),
+  // block b starts at column cols_[b], values vals_[b * B * B ...] row major.
+  int block_ = 0;
+
+  std::vector<size_t> parts_; // unit boundaries, parts_.size() - 1 parts
+};
+
+} // namespace QuantKernel
+
+extern "C" {
+/**
+ * @brief Build a sparse matrix handle from CSR.
+ *
+ * The input arrays are copied; they can be released after the call.
+ *
+ * @param format 0 = CSR, 1 = SELL-C-σ, 2 = blocked CSR.
+ * @param param σ for SELL (<= 0 -> 256), block size for BCSR (2 or 4,
+ *              anything else -> 4). Ignored for CSR.
+ * @return Owned handle; release with sparse_matrix_destroy. nullptr if the
+ *         format is unknown or the CSR arrays are inconsistent.
+ */
+QuantKernel::SparseMatrix *sparse_matrix_create(const double *values,
+                                                const int *col_indices,
+                                                const int *row_ptr,
+                                                int num_rows, int num_cols,
+                                                int format, int param);
+
+void sparse_matrix_destroy(QuantKernel::SparseMatrix *m);
+
+/**
+ * @brief y = A x, multithreaded over nnz-balanced row partitions.
+ */
+void sparse_matrix_spmv(const QuantKernel::SparseMatrix *m, const double *x,
+                        double *y);
+
+/**
+ * @brief Stored entries (padding included) per structural non-zero.
+ */
+double sparse_matrix_fill_ratio(const QuantKernel::SparseMatrix *m);
+}
@@ -8,89 +8,99 @@ let handle_client (conn : Connected_client.t) =
   let current_symbol = ref "NVDA" in
   Lwt_log.info_f ~section "Client %d connected" id >>= fun () ->
 
-  (* Listen for incoming messages (symbol switches) *)
+  (* Listen for incoming messages (symbol switches, metrics requests) *)
   let rec listen_loop () =
     Lwt.catch (fun () ->
       Connected_client.recv conn >>= fun frame ->
       let content = frame.Websocket.Frame.content in
-      (try
-        let json = Yojson.Safe.from_string content in
-        let open Yojson.Safe.Util in
-        let msg_type = json |> member "type" |> to_string in
-        if msg_type = "switch_symbol" then begin
-          let sym = json |> member "symbol" |> to_string in
-          current_symbol := sym;
-          Lwt_log.info_f ~section "Client %d switched to %s" id sym |> Lwt.ignore_result
-        end
-      with _ -> ());
+      let reply =
+        try
+          let json = Yojson.Safe.from_string content in
+          let open Yojson.Safe.Util in
+          let msg_type = json |> member "type" |> to_string in
+          if msg_type = "switch_symbol" then begin
+            let sym = json |> member "symbol" |> to_string in
+            current_symbol := sym;
+            Lwt_log.info_f ~section "Client %d switched to %s" id sym |> Lwt.ignore_result;
+            None
+          end else if msg_type = "metrics" then
+            (* p50/p99/p999 per native kernel, merged across threads *)
+            Some (Yojson.Basic.to_string (Kernel_metrics.to_json ()))
+          else None
+        with _ -> None
+      in
+      (match reply with
+       | Some msg -> Connected_client.send conn (Websocket.Frame.create ~content:msg ())
+       | None -> Lwt.return_unit) >>= fun () ->
       listen_loop ()
     ) (fun _ -> Lwt.return_unit)
   in
 
+    (* Live feed: one SABR path (same model as the display paths) read one
+       point per tick into a persistent streaming signature, so each tick
+       only slides the window. The path is simulated natively in segments
+       of [segment_len] steps; a new segment restarts sigma at sigma0 from
+       the last spot. The state spans the last [path_len] feed points. *)
+    let window_size = 20 and path_len = 100 and segment_len = 1000 in
+    let config : Monte_carlo.Engine.config = {
+      num_paths = 5;
+      num_steps = 100;
+      dt = 0.01;
+      num_domains = 1;
+    } in
+    let live_sig =
+      Signature_bergomi.Streaming.create ~window_size ~history:(path_len - window_size + 1)
+    in
+    let segment = ref (Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout 0) in
+    let segment_pos = ref segment_len in
+    let spot = ref 100.0 in
+    let recent = Queue.create () in
     let tick_count = ref 0 in
 
+    let serialize_path (path, _sig) =
+      let n = Bigarray.Array1.dim path / 2 in
+      let spots = ref [] in
+      for i = n - 1 downto 0 do
+        let spot = Bigarray.Array1.get path (2 * i + 1) in
+        spots := `Float spot :: !spots
+      done;
+      `List !spots
+    in
+
     let rec stream_data () =
       incr tick_count;
-      let config : Monte_carlo.Engine.config = {
-        num_paths = 5;
-        num_steps = 100;
-        dt = 0.01;
-        num_domains = 1;
-      } in
+      let flattened = Monte_carlo.Engine.run_parallel config (100.0, 0.2) 0.5 (-0.5) 0.4 in
 
-      let results = Monte_carlo.Engine.run_parallel config (100.0, 0.2) 0.5 (-0.5) 0.4 in
-      let flattened = Array.concat results in
+      if !segment_pos >= segment_len then begin
+        let paths, _ =
+          Monte_carlo.Engine.simulate_native
+            { config with num_paths = 1; num_steps = segment_len } (!spot, 0.2) 0.5 (-0.5) 0.4
+        in
+        segment := paths;
+        segment_pos := 0
+      end;
+      incr segment_pos;
+      spot := !segment.{2 * !segment_pos + 1};
+      Signature_bergomi.Streaming.push live_sig (float_of_int !tick_count *. config.dt) !spot;
+      Queue.push !spot recent;
+      if Queue.length recent > path_len then ignore (Queue.pop recent);
+      let live_path = List.of_seq (Queue.to_seq recent) in
 
-      let serialize_path (path, _sig) =
-        let n = Bigarray.Array1.dim path / 2 in
-        let spots = ref [] in
-        for i = n - 1 downto 0 do
-          let spot = Bigarray.Array1.get path (2 * i + 1) in
-          spots := `Float spot :: !spots
-        done;
-        `List !spots
-      in
-
-      (* Compute Manifold State from the first simulated path *)
       let manifold_json =
-        if Array.length flattened > 0 then begin
-          let (first_path, _) = flattened.(0) in
-          (* Build signature history from all paths for curvature *)
-          let num_sigs = min 10 (Array.length flattened) in
-          let sig_history = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (num_sigs * 15) in
-          for s = 0 to num_sigs - 1 do
-            let (_, path_sig) = flattened.(s) in
-            for k = 0 to 14 do
-              Bigarray.Array1.set sig_history (s * 15 + k) (Bigarray.Array1.get path_sig k)
-            done
-          done;
-          let state = Manifold_geometry.compute_state first_path sig_history num_sigs in
-          
-          (* TRIGGER RESEARCH BRIDGE EVERY 5 SECONDS (approx 10 ticks) *)
-          if !tick_count mod 10 = 0 then (
-            (* Convert Bigarray path to float list for serialization *)
-            let n = Bigarray.Array1.dim first_path / 2 in
-            let raw_path_list = List.init n (fun i -> Bigarray.Array1.get first_path (2 * i + 1)) in
-            Research_bridge.run_async state raw_path_list
-          );
+        let state = Manifold_geometry.compute_state_streaming live_sig in
+
+        (* TRIGGER RESEARCH BRIDGE EVERY 5 SECONDS (approx 10 ticks) *)
+        if !tick_count mod 10 = 0 then
+          Research_bridge.run_async state live_path;
 
-          `Assoc [
-            ("fisher_distance", `Float state.fisher_distance);
-            ("curvature", `Float state.curvature);
-            ("exhaustion", `Float (Manifold_geometry.density_value state.exhaustion));
-            ("mu", `Float state.mu);
-            ("sigma2", `Float state.sigma2);
-            ("log_signature", `List (Array.to_list (Array.map (fun v -> `Float v) state.log_signature)))
-          ]
-        end else
-          `Assoc [
-            ("fisher_distance", `Float 0.0);
-            ("curvature", `Float 0.0);
-            ("exhaustion", `Float 0.5);
-            ("mu", `Float 0.0);
-            ("sigma2", `Float 0.0);
-            ("log_signature", `List [])
-          ]
+        `Assoc [
+          ("fisher_distance", `Float state.fisher_distance);
+          ("curvature", `Float state.curvature);
+          ("exhaustion", `Float (Manifold_geometry.density_value state.exhaustion));
+          ("mu", `Float state.mu);
+          ("sigma2", `Float state.sigma2);
+          ("log_signature", `List (Array.to_list (Array.map (fun v -> `Float v) state.log_signature)))
+        ]
       in
 
       let symbol = !current_symbol in
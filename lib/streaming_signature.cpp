@@ -0,0 +1,229 @@
+#include "streaming_signature.h"
+#include "signature_engine.h"
+#include "signature_kernel.h"
+#include <algorithm>
+
+// =============================================================================
+// Streaming Signature: O(1) per-tick manifold inputs
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Live data arrives one tick at a time, so the fingerprint is
+   kept alive between ticks instead of being rebuilt from a fresh batch of
+   paths. Each tick glues one segment on (and, for the window, peels one off).
+
+   [HS MATH]:
+   - Full:     S_{0,t+1} = S_{0,t} ⊗ exp(x_{t+1} - x_t)
+   - Windowed: S_{s+1,t+1} = exp(x_s - x_{s+1}) ⊗ S_{s,t} ⊗ exp(x_{t+1} - x_t)
+   - Curvature: κ averaged over consecutive snapshot triples; each new
+     snapshot adds one triple and (once the ring is full) retires one.
+   - Expected: E[S] over the full-window snapshots held; each new snapshot
+     adds one window and (once the ring is full) retires one, which is
+     compute_expected_signature over the last W + H - 1 points.
+
+   [SAFETY]:
+   - Window drift is bounded by re-anchoring from the point ring.
+   - The curvature and expected-signature running sums are re-summed from
+     their rings whenever the rings wrap, so they cannot drift either.
+*/
+
+namespace QuantKernel {
+
+using Sig23 = Signature<2, 3>;
+
+StreamingSignature::StreamingSignature(size_t window_size, size_t history_size)
+    : window_size_(std::max<size_t>(window_size, 2)),
+      reanchor_(std::max(window_size_, SIG_REANCHOR_INTERVAL)),
+      history_size_(std::max<size_t>(history_size, 3)),
+      ring_(2 * window_size_, 0.0), snapshots_(history_size_ * SIG_SIZE, 0.0),
+      kappa_(history_size_ - 2, 0.0) {
+  full_[0] = 1.0;
+  window_[0] = 1.0;
+}
+
+void StreamingSignature::push(double t, double x) {
+  if (num_points_ == 0) {
+    ring_[0] = t;
+    ring_[1] = x;
+    last_[0] = t;
+    last_[1] = x;
+    num_points_ = 1;
+    record_snapshot();
+    return;
+  }
+
+  const double dx_in[2] = {t - last_[0], x - last_[1]};
+  Sig23::append_segment(full_.data(), dx_in);
+
+  if (num_points_ < window_size_) {
+    // Window still filling: it is the full signature so far
+    Sig23::append_segment(window_.data(), dx_in);
+    size_t slot = (ring_head_ + num_points_) % window_size_;
+    ring_[2 * slot] = t;
+    ring_[2 * slot + 1] = x;
+  } else {
+    // Leaving segment runs oldest -> second oldest; its inverse is
+    // exp(p_oldest - p_second). The oldest slot then takes the new point.
+    const size_t oldest = ring_head_;
+    const size_t second = (ring_head_ + 1) % window_size_;
+    const double dx_out_neg[2] = {ring_[2 * oldest] - ring_[2 * second],
+                                  ring_[2 * oldest + 1] - ring_[2 * second + 1]};
+    ring_[2 * oldest] = t;
+    ring_[2 * oldest + 1] = x;
+    ring_head_ = second;
+
+    if (++slides_ % reanchor_ == 0) {
+      reanchor_window();
+    } else {
+      Sig23::prepend_segment(window_.data(), dx_out_neg);
+      Sig23::append_segment(window_.data(), dx_in);
+    }
+  }
+
+  last_[0] = t;
+  last_[1] = x;
+  ++num_points_;
+  record_snapshot();
+}
+
+void StreamingSignature::reanchor_window() {
+  window_.fill(0.0);
+  window_[0] = 1.0;
+  for (size_t i = 1; i < window_size_; ++i) {
+    const size_t prev = (ring_head_ + i - 1) % window_size_;
+    const size_t curr = (ring_head_ + i) % window_size_;
+    const double dx[2] = {ring_[2 * curr] - ring_[2 * prev],
+                          ring_[2 * curr + 1] - ring_[2 * prev + 1]};
+    Sig23::append_segment(window_.data(), dx);
+  }
+}
+
+void StreamingSignature::record_snapshot() {
+  double *slot_sig = snapshots_.data() + snap_head_ * SIG_SIZE;
+  // Full windows are the newest snapshots, so the retired (oldest) one is
+  // a full window only once every slot holds one
+  if (num_full_ == history_size_)
+    for (size_t k = 0; k < SIG_SIZE; ++k)
+      expected_sum_[k] -= slot_sig[k];
+  std::copy(window_.begin(), window_.end(), slot_sig);
+  if (num_points_ >= window_size_) {
+    for (size_t k = 0; k < SIG_SIZE; ++k)
+      expected_sum_[k] += window_[k];
+    num_full_ = std::min(num_full_ + 1, history_size_);
+  }
+  snap_head_ = (snap_head_ + 1) % history_size_;
+  if (snap_head_ == 0 && num_full_ > 0) {
+    expected_sum_.fill(0.0);
+    for (size_t i = history_size_ - num_full_; i < history_size_; ++i)
+      for (size_t k = 0; k < SIG_SIZE; ++k)
+        expected_sum_[k] += snapshots_[i * SIG_SIZE + k];
+  }
+  if (num_snapshots_ < history_size_)
+    ++num_snapshots_;
+  if (num_snapshots_ < 3)
+    return;
+
+  // Newest triple, oldest first, contiguous for compute_signature_curvature
+  double triple[3 * SIG_SIZE];
+  for (size_t i = 0; i < 3; ++i) {
+    size_t slot = (snap_head_ + history_size_ - 3 + i) % history_size_;
+    std::copy(snapshots_.begin() + slot * SIG_SIZE,
+              snapshots_.begin() + (slot + 1) * SIG_SIZE,
+              triple + i * SIG_SIZE);
+  }
+  const double kappa = compute_signature_curvature(triple, 3);
+
+  if (num_kappa_ == kappa_.size())
+    kappa_sum_ -= kappa_[kappa_head_];
+  else
+    ++num_kappa_;
+  kappa_[kappa_head_] = kappa;
+  kappa_sum_ += kappa;
+  kappa_head_ = (kappa_head_ + 1) % kappa_.size();
+
+  if (kappa_head_ == 0) {
+    kappa_sum_ = 0.0;
+    for (size_t i = 0; i < num_kappa_; ++i)
+      kappa_sum_ += kappa_[i];
+  }
+}
+
+void StreamingSignature::log_signature(double *out) const {
+  compute_log_signature(window_.data(), out);
+}
+
+void StreamingSignature::expected_signature(double *out) const {
+  if (num_full_ == 0) {
+    std::copy(window_.begin(), window_.end(), out);
+    return;
+  }
+  const double inv_n = 1.0 / static_cast<double>(num_full_);
+  for (size_t k = 0; k < SIG_SIZE; ++k)
+    out[k] = expected_sum_[k] * inv_n;
+}
+
+double StreamingSignature::curvature() const {
+  if (num_kappa_ == 0)
+    return 0.0;
+  return kappa_sum_ / static_cast<double>(num_kappa_);
+}
+
+size_t StreamingSignature::snapshots(double *out) const {
+  const size_t start =
+      (num_snapshots_ < history_size_) ? 0 : snap_head_;
+  for (size_t i = 0; i < num_snapshots_; ++i) {
+    size_t slot = (start + i) % history_size_;
+    std::copy(snapshots_.begin() + slot * SIG_SIZE,
+              snapshots_.begin() + (slot + 1) * SIG_SIZE, out + i * SIG_SIZE);
+  }
+  return num_snapshots_;
+}
+
+} // namespace QuantKernel
+
+extern "C" {
+
+QuantKernel::StreamingSignature *streaming_signature_create(size_t window_size,
+                                                            size_t history_size) {
+  return new QuantKernel::StreamingSignature(window_size, history_size);
+}
+
+void streaming_signature_destroy(QuantKernel::StreamingSignature *state) {
+  delete state;
+}
+
+void streaming_signature_push(QuantKernel::StreamingSignature *state, double t,
+                              double x) {
+  state->push(t, x);
+}
+
+void streaming_signature_full(const QuantKernel::StreamingSignature *state,
+                              double *out) {
+  std::copy(state->full(), state->full() + 15, out);
+}
+
+void streaming_signature_window(const QuantKernel::StreamingSignature *state,
+                                double *out) {
+  std::copy(state->window(), state->window() + 15, out);
+}
+
+void streaming_signature_expected(const QuantKernel::StreamingSignature *state,
+                                  double *out) {
+  state->expected_signature(out);
+}
+
+size_t streaming_signature_snapshots(const QuantKernel::StreamingSignature *state,
+                                     double *out) {
+  return state->snapshots(out);
+}
+
+void streaming_signature_log(const QuantKernel::StreamingSignature *state,
+                             double *out) {
+  state->log_signature(out);
+}
+
+double
+streaming_signature_curvature(const QuantKernel::StreamingSignature *state) {
+  return state->curvature();
+}
+
+} // extern "C"
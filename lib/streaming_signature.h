@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+/**
+ * Tick-driven level-3 signature state for a live (time, value) stream.
+ *
+ * Every push is O(1) amortized:
+ *  - full signature:     S <- S ⊗ exp(dx)
+ *  - windowed signature: S <- exp(-dx_out) ⊗ S ⊗ exp(dx_in) over the last
+ *                        window_size points, re-anchored from the point ring
+ *                        every max(window_size, SIG_REANCHOR_INTERVAL) slides
+ *  - snapshot history:   ring of the last history_size windowed signatures,
+ *                        with per-triple curvature terms kept so the
+ *                        compute_signature_curvature average is updated
+ *                        incrementally.
+ *  - expected signature: running sum of the full-window snapshots held, so
+ *                        it equals compute_expected_signature over the last
+ *                        window_size + history_size - 1 points.
+ */
+class StreamingSignature {
+public:
+  static constexpr size_t SIG_SIZE = 15;
+  static constexpr size_t LOGSIG_SIZE = 14;
+
+  StreamingSignature(size_t window_size, size_t history_size);
+
+  void push(double t, double x);
+
+  size_t num_points() const { return num_points_; }
+  const double *full() const { return full_.data(); }
+  const double *window() const { return window_.data(); }
+  void log_signature(double *out) const;
+
+  /// Mean of the full windows in the snapshot history (the window itself
+  /// while fewer than window_size points have arrived).
+  void expected_signature(double *out) const;
+
+  /// Equals compute_signature_curvature over the snapshots currently held
+  /// (oldest first).
+  double curvature() const;
+
+  size_t num_snapshots() const { return num_snapshots_; }
+
+  /// Copies the snapshot history, oldest first, into out (num_snapshots x 15).
+  size_t snapshots(double *out) const;
+
+private:
+  void reanchor_window();
+  void record_snapshot();
+
+  size_t window_size_;
+  size_t reanchor_;
+  size_t history_size_;
+
+  // Ring of the last window_size points, (t, x) interleaved
+  std::vector<double> ring_;
+  size_t ring_head_ = 0; // index of the oldest point
+  size_t num_points_ = 0;
+  size_t slides_ = 0;
+  double last_[2] = {0.0, 0.0};
+
+  std::array<double, SIG_SIZE> full_{};
+  std::array<double, SIG_SIZE> window_{};
+
+  // Ring of windowed-signature snapshots and their triple curvatures
+  std::vector<double> snapshots_;
+  std::vector<double> kappa_;
+  size_t snap_head_ = 0;
+  size_t num_snapshots_ = 0;
+  size_t kappa_head_ = 0;
+  size_t num_kappa_ = 0;
+  double kappa_sum_ = 0.0;
+
+  // Sum of the snapshots taken with a full window (always the newest ones)
+  std::array<double, SIG_SIZE> expected_sum_{};
+  size_t num_full_ = 0;
+};
+
+} // namespace QuantKernel
+
+extern "C" {
+/**
+ * @brief Create a streaming signature state.
+ *
+ * @param window_size Points per sliding window (>= 2).
+ * @param history_size Windowed-signature snapshots kept for curvature (>= 3).
+ * @return Owned handle; release with streaming_signature_destroy.
+ */
+QuantKernel::StreamingSignature *streaming_signature_create(size_t window_size,
+                                                            size_t history_size);
+
+void streaming_signature_destroy(QuantKernel::StreamingSignature *state);
+
+/**
+ * @brief Append one live point. O(1) amortized.
+ */
+void streaming_signature_push(QuantKernel::StreamingSignature *state, double t,
+                              double x);
+
+/**
+ * @brief Signature of everything pushed so far (15 doubles).
+ */
+void streaming_signature_full(const QuantKernel::StreamingSignature *state,
+                              double *out);
+
+/**
+ * @brief Signature of the last window_size points (15 doubles).
+ */
+void streaming_signature_window(const QuantKernel::StreamingSignature *state,
+                                double *out);
+
+/**
+ * @brief Expected signature of the last window_size + history_size - 1
+ * points (15 doubles), as compute_expected_signature would return it.
+ */
+void streaming_signature_expected(const QuantKernel::StreamingSignature *state,
+                                  double *out);
+
+/**
+ * @brief Snapshot history, oldest first (num_snapshots x 15 doubles).
+ * @return Snapshots written (at most history_size).
+ */
+size_t streaming_signature_snapshots(const QuantKernel::StreamingSignature *state,
+                                     double *out);
+
+/**
+ * @brief Log-signature of the current window (14 doubles).
+ */
+void streaming_signature_log(const QuantKernel::StreamingSignature *state,
+                             double *out);
+
+/**
+ * @brief Curvature of the windowed-signature snapshot history.
+ */
+double
+streaming_signature_curvature(const QuantKernel::StreamingSignature *state);
+}
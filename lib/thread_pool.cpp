@@ -0,0 +1,135 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace QuantKernel {
+
+namespace {
+
+uint64_t pack_span(uint64_t begin, uint64_t end) { return begin | end << 32; }
+uint64_t span_begin(uint64_t s) { return s & 0xffffffffu; }
+uint64_t span_end(uint64_t s) { return s >> 32; }
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  slots_.reset(new Slot[num_threads]);
+  workers_.reserve(num_threads - 1);
+  for (size_t i = 1; i < num_threads; ++i)
+    workers_.emplace_back([this, i]() { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  wake_cv_.notify_all();
+  for (std::thread &t : workers_)
+    t.join();
+}
+
+ThreadPool &ThreadPool::global() {
+  static ThreadPool pool([]() -> size_t {
+    const char *env = std::getenv("QK_NUM_THREADS");
+    const long n = env ? std::strtol(env, nullptr, 10) : 0;
+    return n > 0 ? (size_t)n : 0;
+  }());
+  return pool;
+}
+
+bool &ThreadPool::in_pool_task() {
+  thread_local bool flag = false;
+  return flag;
+}
+
+bool ThreadPool::next_index(size_t slot, size_t &index) {
+  std::atomic<uint64_t> &own = slots_[slot].span;
+  for (;;) {
+    uint64_t s = own.load(std::memory_order_acquire);
+    while (span_begin(s) < span_end(s)) {
+      if (own.compare_exchange_weak(s, pack_span(span_begin(s) + 1, span_end(s)),
+                                    std::memory_order_acq_rel)) {
+        index = span_begin(s);
+        return true;
+      }
+    }
+
+    // Own range empty: steal the back half of the largest one left
+    size_t victim = slot;
+    uint64_t best = 0;
+    for (size_t v = 0; v < size(); ++v) {
+      const uint64_t vs = slots_[v].span.load(std::memory_order_acquire);
+      if (v != slot && span_end(vs) > span_begin(vs) &&
+          span_end(vs) - span_begin(vs) > best) {
+        best = span_end(vs) - span_begin(vs);
+        victim = v;
+      }
+    }
+    if (victim == slot)
+      return false; // in-flight items belong to whoever took them
+
+    uint64_t vs = slots_[victim].span.load(std::memory_order_acquire);
+    const uint64_t b = span_begin(vs), e = span_end(vs);
+    if (b >= e)
+      continue;
+    const uint64_t mid = e - (e - b + 1) / 2;
+    if (!slots_[victim].span.compare_exchange_strong(
+            vs, pack_span(b, mid), std::memory_order_acq_rel))
+      continue;
+    // [mid, e) is now ours alone; run its first index, publish the rest
+    own.store(pack_span(mid + 1, e), std::memory_order_release);
+    index = mid;
+    return true;
+  }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)> &job) {
+  std::lock_guard<std::mutex> submit(submit_mu_);
+  const size_t threads = size();
+  for (size_t t = 0; t < threads; ++t)
+    slots_[t].span.store(pack_span(count * t / threads,
+                                   count * (t + 1) / threads),
+                         std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    job_ = &job;
+    pending_ = workers_.size();
+    ++generation_;
+  }
+  wake_cv_.notify_all();
+
+  in_pool_task() = true;
+  job(0);
+  in_pool_task() = false;
+
+  std::unique_lock<std::mutex> lock(mu_);
+  done_cv_.wait(lock, [this]() { return pending_ == 0; });
+  job_ = nullptr;
+}
+
+void ThreadPool::worker_loop(size_t slot) {
+  in_pool_task() = true;
+  size_t seen = 0;
+  for (;;) {
+    const std::function<void(size_t)> *job;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      wake_cv_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+      if (stop_)
+        return;
+      seen = generation_;
+      job = job_;
+    }
+    (*job)(slot);
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (--pending_ == 0)
+        done_cv_.notify_one();
+    }
+  }
+}
+
+} // namespace QuantKernel
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// C++ internal API
+namespace QuantKernel {
+
+/**
+ * Fixed-size pool of persistent worker threads for data-parallel kernels.
+ *
+ * parallel_for splits [0, n) into one contiguous range per thread. Each
+ * thread takes indices from the front of its own range and, once that is
+ * empty, steals the back half of the largest range left, so uneven work
+ * items (e.g. smiles with different strike counts) balance themselves
+ * while every thread mostly writes one contiguous slice of the output.
+ * The calling thread participates and the call blocks until every index is
+ * done. A parallel_for issued from inside a pool task runs inline, so
+ * nesting cannot deadlock.
+ */
+class ThreadPool {
+public:
+  /// num_threads == 0 -> std::thread::hardware_concurrency()
+  explicit ThreadPool(size_t num_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Total threads working on a parallel_for, caller included.
+  size_t size() const { return workers_.size() + 1; }
+
+  /// Process-wide pool, created on first use. QK_NUM_THREADS, if set to a
+  /// positive integer, overrides the thread count.
+  static ThreadPool &global();
+
+  template <class Fn> void parallel_for(size_t n, Fn &&fn) {
+    if (n == 0)
+      return;
+    if (n == 1 || workers_.empty() || in_pool_task()) {
+      for (size_t i = 0; i < n; ++i)
+        fn(i);
+      return;
+    }
+    // Ranges are packed as two 32-bit halves; larger n runs in passes
+    for (size_t base = 0; base < n; base += MAX_PASS) {
+      const size_t count = std::min(MAX_PASS, n - base);
+      run(count, [&](size_t slot) {
+        size_t i;
+        while (next_index(slot, i))
+          fn(base + i);
+      });
+    }
+  }
+
+private:
+  static constexpr size_t MAX_PASS = (size_t)1 << 31;
+
+  // One thread's remaining range [begin, end), packed begin | end << 32.
+  // The owner advances begin, thieves lower end, both by CAS on the pair.
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> span{0};
+  };
+
+  // Splits [0, count) over the slots, publishes job to every worker (slot
+  // 1..), runs it on the caller (slot 0), waits for all.
+  void run(size_t count, const std::function<void(size_t)> &job);
+  // Next index for slot: its own front, else a stolen half. false = done.
+  bool next_index(size_t slot, size_t &index);
+  void worker_loop(size_t slot);
+  static bool &in_pool_task();
+
+  std::vector<std::thread> workers_;
+  std::unique_ptr<Slot[]> slots_;
+  std::mutex submit_mu_; // one parallel_for at a time
+  std::mutex mu_;
+  std::condition_variable wake_cv_;
+  std::condition_variable done_cv_;
+  const std::function<void(size_t)> *job_ = nullptr;
+  size_t generation_ = 0;
+  size_t pending_ = 0;
+  bool stop_ = false;
+};
+
+} // namespace QuantKernel
@@ -0,0 +1,429 @@
+#include "tracer.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#else
+#include <functional>
+#endif
+
+// =============================================================================
+// Tracer: binary spill and Chrome JSON conversion
+// =============================================================================
+/*
+   [PLAIN ENGLISH]: Threads only append fixed-size records to their own
+   ring. Everything slow (file I/O, name strings, JSON) happens on the
+   flusher thread or offline, so turning tracing on barely moves the
+   timings being measured.
+
+   Spill file layout (host byte order):
+     header  "QKTRACE1", u32 pid
+     records u32 type, then
+       NAME   (1): u32 id, u32 len, len bytes
+       EVENTS (2): u32 tid, u32 count, count x TraceEvent (16 bytes)
+       CLOCK  (3): u64 ticks, u64 steady_ns    (one per flush)
+       DROP   (4): u32 tid, u64 dropped events (on disable)
+
+   [HS MATH]:
+   ns_per_tick = (ns_last - ns_first) / (ticks_last - ticks_first) over the
+   CLOCK pairs; ts_us = (ticks - ticks_first) · ns_per_tick / 1000.
+
+   [SAFETY]:
+   - Rings are single producer (owning thread) / single consumer (flusher):
+     the producer publishes head with release, the flusher frees slots by
+     publishing tail with release. The producer keeps its own copy of tail
+     and re-reads the shared one only when that copy says the ring is full.
+   - head and tail sit on separate cache lines, so the flusher's tail
+     stores do not invalidate the line the producer writes every event.
+   - A thread's ring outlives the thread until drained: retire_thread (at
+     thread exit) only flags it, and drain() moves it to the free list
+     after writing its last events. Rings change hands under threads_mu_,
+     which also orders the old owner's writes before the new owner's.
+   - Whether a drain is still due is tracked under threads_mu_ (draining_),
+     not by enabled(): a thread exiting while disable() is between
+     clearing enabled_ and its last drain still gets its events written.
+*/
+
+namespace {
+
+enum TraceRecord : uint32_t {
+  REC_NAME = 1,
+  REC_EVENTS = 2,
+  REC_CLOCK = 3,
+  REC_DROP = 4
+};
+
+constexpr char TRACE_MAGIC[8] = {'Q', 'K', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr auto TRACE_FLUSH_INTERVAL = std::chrono::milliseconds(10);
+
+uint32_t current_tid() {
+#if defined(__linux__)
+  return (uint32_t)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+  uint64_t tid = 0;
+  pthread_threadid_np(nullptr, &tid);
+  return (uint32_t)tid;
+#else
+  return (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+}
+
+uint32_t current_pid() {
+#if defined(__linux__) || defined(__APPLE__)
+  return (uint32_t)getpid();
+#else
+  return 1;
+#endif
+}
+
+uint64_t steady_ns() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <class T> void put(std::FILE *f, const T &v) {
+  std::fwrite(&v, sizeof(T), 1, f);
+}
+
+template <class T> bool get(std::FILE *f, T &v) {
+  return std::fread(&v, sizeof(T), 1, f) == 1;
+}
+
+// Closes the spill file at exit; the Tracer itself is never destroyed
+struct TraceAtExit {
+  ~TraceAtExit() { QuantKernel::Tracer::instance().disable(); }
+} trace_at_exit;
+
+} // namespace
+
+namespace QuantKernel {
+
+struct Tracer::ThreadExit {
+  ThreadBuffer *tb = nullptr;
+  ~ThreadExit() {
+    if (tb)
+      Tracer::instance().retire_thread(tb);
+  }
+};
+
+bool Tracer::enable(const char *path) {
+  std::lock_guard<std::mutex> io(io_mu_);
+  if (file_)
+    return true; // already tracing
+  file_ = std::fopen(path, "wb");
+  if (!file_)
+    return false;
+  std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), file_);
+  put(file_, current_pid());
+  {
+    std::lock_guard<std::mutex> lock(names_mu_);
+    names_written_ = 0;
+  }
+  {
+    // Events recorded before this file existed belong to no trace
+    std::lock_guard<std::mutex> lock(threads_mu_);
+    for (auto &tb : threads_)
+      tb->tail.store(tb->head.load(std::memory_order_acquire),
+                     std::memory_order_release);
+    draining_ = true;
+  }
+  drain(); // first clock pair
+  stop_ = false;
+  enabled_.store(true, std::memory_order_release);
+  flusher_ = std::thread([this]() { flusher_loop(); });
+  return true;
+}
+
+void Tracer::disable() {
+  if (!enabled_.exchange(false))
+    return;
+  {
+    std::lock_guard<std::mutex> lock(wake_mu_);
+    stop_ = true;
+  }
+  wake_cv_.notify_all();
+  if (flusher_.joinable())
+    flusher_.join();
+
+  std::lock_guard<std::mutex> io(io_mu_);
+  drain(true);
+  {
+    std::lock_guard<std::mutex> lock(threads_mu_);
+    for (auto &tb : threads_) {
+      uint64_t dropped = tb->dropped.exchange(0);
+      if (dropped) {
+        put(file_, (uint32_t)REC_DROP);
+        put(file_, tb->tid);
+        put(file_, dropped);
+      }
+    }
+  }
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+void Tracer::flush() {
+  std::lock_guard<std::mutex> io(io_mu_);
+  if (file_) {
+    drain();
+    std::fflush(file_);
+  }
+}
+
+uint32_t Tracer::intern(const char *name) {
+  std::lock_guard<std::mutex> lock(names_mu_);
+  auto it = name_ids_.find(name);
+  if (it != name_ids_.end())
+    return it->second;
+  uint32_t id = (uint32_t)names_.size();
+  names_.emplace_back(name);
+  name_ids_.emplace(names_.back(), id);
+  return id;
+}
+
+Tracer::ThreadBuffer *Tracer::register_thread() {
+  thread_local ThreadExit thread_exit;
+  {
+    std::lock_guard<std::mutex> lock(threads_mu_);
+    if (free_.empty()) {
+      threads_.push_back(std::make_unique<ThreadBuffer>());
+    } else {
+      threads_.push_back(std::move(free_.back()));
+      free_.pop_back();
+    }
+    tls_buffer_ = threads_.back().get();
+  }
+  tls_buffer_->tid = current_tid();
+  thread_exit.tb = tls_buffer_;
+  return tls_buffer_;
+}
+
+void Tracer::retire_thread(ThreadBuffer *tb) {
+  if (tls_buffer_ == tb)
+    tls_buffer_ = nullptr;
+  std::lock_guard<std::mutex> lock(threads_mu_);
+  tb->retired = true;
+  if (draining_)
+    return; // drain() frees it after writing its last events
+  for (size_t i = 0; i < threads_.size(); ++i)
+    if (threads_[i].get() == tb) {
+      release_ring(i);
+      return;
+    }
+}
+
+void Tracer::release_ring(size_t index) {
+  ThreadBuffer &tb = *threads_[index];
+  tb.head.store(0, std::memory_order_relaxed);
+  tb.tail.store(0, std::memory_order_relaxed);
+  tb.tail_cache = 0;
+  tb.dropped.store(0, std::memory_order_relaxed);
+  tb.retired = false;
+  free_.push_back(std::move(threads_[index]));
+  threads_[index] = std::move(threads_.back());
+  threads_.pop_back();
+}
+
+void Tracer::flusher_loop() {
+  std::unique_lock<std::mutex> lock(wake_mu_);
+  while (!stop_) {
+    wake_cv_.wait_for(lock, TRACE_FLUSH_INTERVAL);
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> io(io_mu_);
+      drain();
+    }
+    lock.lock();
+  }
+}
+
+void Tracer::drain(bool last) {
+  {
+    std::lock_guard<std::mutex> lock(names_mu_);
+    for (; names_written_ < names_.size(); ++names_written_) {
+      const std::string &n = names_[names_written_];
+      put(file_, (uint32_t)REC_NAME);
+      put(file_, (uint32_t)names_written_);
+      put(file_, (uint32_t)n.size());
+      std::fwrite(n.data(), 1, n.size(), file_);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(threads_mu_);
+  for (size_t i = 0; i < threads_.size();) {
+    ThreadBuffer *tb = threads_[i].get();
+    // Set under threads_mu_ after the owner's last event: head is final
+    const bool retired = tb->retired;
+    const uint64_t head = tb->head.load(std::memory_order_acquire);
+    uint64_t tail = tb->tail.load(std::memory_order_relaxed);
+    while (tail < head) {
+      // Contiguous run up to the ring's wrap point
+      const size_t start = tail & (RING_CAPACITY - 1);
+      const uint32_t count =
+          (uint32_t)std::min<uint64_t>(head - tail, RING_CAPACITY - start);
+      put(file_, (uint32_t)REC_EVENTS);
+      put(file_, tb->tid);
+      put(file_, count);
+      std::fwrite(&tb->ring[start], sizeof(TraceEvent), count, file_);
+      tail += count;
+    }
+    tb->tail.store(tail, std::memory_order_release);
+
+    if (!retired) {
+      ++i;
+      continue;
+    }
+    const uint64_t dropped = tb->dropped.load(std::memory_order_relaxed);
+    if (dropped) {
+      put(file_, (uint32_t)REC_DROP);
+      put(file_, tb->tid);
+      put(file_, dropped);
+    }
+    release_ring(i); // moves the last ring into slot i
+  }
+  // Threads retiring from here on release their own rings
+  if (last)
+    draining_ = false;
+
+  put(file_, (uint32_t)REC_CLOCK);
+  put(file_, now());
+  put(file_, steady_ns());
+}
+
+} // namespace QuantKernel
+
+extern "C" {
+
+int enable_tracing(const char *filename) {
+  return QuantKernel::Tracer::instance().enable(filename) ? 0 : -1;
+}
+
+void disable_tracing(void) { QuantKernel::Tracer::instance().disable(); }
+
+void trace_begin(const char *name) {
+  QuantKernel::Tracer &tracer = QuantKernel::Tracer::instance();
+  if (tracer.enabled())
+    tracer.record(tracer.intern(name), 'B');
+}
+
+void trace_end(const char *name) {
+  QuantKernel::Tracer &tracer = QuantKernel::Tracer::instance();
+  if (tracer.enabled())
+    tracer.record(tracer.intern(name), 'E');
+}
+
+long trace_convert_to_json(const char *bin_path, const char *json_path) {
+  using QuantKernel::TraceEvent;
+  std::FILE *in = std::fopen(bin_path, "rb");
+  if (!in)
+    return -1;
+
+  char magic[sizeof(TRACE_MAGIC)];
+  uint32_t pid = 0;
+  if (std::fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+      std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0 || !get(in, pid)) {
+    std::fclose(in);
+    return -1;
+  }
+
+  std::map<uint32_t, std::string> names;
+  std::vector<std::pair<uint32_t, TraceEvent>> events; // (tid, event)
+  std::vector<std::pair<uint32_t, uint64_t>> drops;
+  uint64_t t0 = 0, t1 = 0, ns0 = 0, ns1 = 0;
+  bool have_clock = false, ok = true;
+
+  uint32_t type;
+  while (ok && get(in, type)) {
+    switch (type) {
+    case REC_NAME: {
+      uint32_t id, len;
+      ok = get(in, id) && get(in, len) && len < (1u << 20);
+      if (ok) {
+        std::string s(len, '\0');
+        ok = std::fread(&s[0], 1, len, in) == len;
+        names[id] = std::move(s);
+      }
+      break;
+    }
+    case REC_EVENTS: {
+      uint32_t tid, count;
+      ok = get(in, tid) && get(in, count) &&
+           count <= QuantKernel::Tracer::RING_CAPACITY;
+      for (uint32_t i = 0; ok && i < count; ++i) {
+        TraceEvent e;
+        ok = get(in, e);
+        events.emplace_back(tid, e);
+      }
+      break;
+    }
+    case REC_CLOCK: {
+      uint64_t ticks, ns;
+      ok = get(in, ticks) && get(in, ns);
+      if (ok && !have_clock) {
+        t0 = ticks;
+        ns0 = ns;
+        have_clock = true;
+      }
+      t1 = ticks;
+      ns1 = ns;
+      break;
+    }
+    case REC_DROP: {
+      uint32_t tid;
+      uint64_t n;
+      ok = get(in, tid) && get(in, n);
+      drops.emplace_back(tid, n);
+      break;
+    }
+    default:
+      ok = false;
+    }
+  }
+  std::fclose(in);
+  if (!ok)
+    return -1;
+
+  const double ns_per_tick =
+      (t1 > t0 && ns1 > ns0) ? (double)(ns1 - ns0) / (double)(t1 - t0) : 1.0;
+
+  std::FILE *out = std::fopen(json_path, "w");
+  if (!out)
+    return -1;
+  std::fputc('[', out);
+  bool first = true;
+  for (const auto &[tid, e] : events) {
+    auto it = names.find(e.name_id);
+    std::string name = it != names.end() ? it->second : "?";
+    std::string escaped;
+    for (char c : name) {
+      if (c == '"' || c == '\\')
+        escaped += '\\';
+      if ((unsigned char)c >= 0x20)
+        escaped += c;
+    }
+    const double ts_us =
+        ((double)e.ticks - (double)t0) * ns_per_tick / 1000.0;
+    std::fprintf(out,
+                 "%s{\"name\":\"%s\",\"cat\":\"kernel\",\"ph\":\"%c\","
+                 "\"ts\":%.3f,\"pid\":%u,\"tid\":%u}",
+                 first ? "" : ",\n", escaped.c_str(), (char)e.phase, ts_us,
+                 pid, tid);
+    first = false;
+  }
+  for (const auto &[tid, n] : drops)
+    std::fprintf(out,
+                 "%s{\"name\":\"dropped_events\",\"ph\":\"i\",\"s\":\"t\","
+                 "\"ts\":0,\"pid\":%u,\"tid\":%u,\"args\":{\"count\":%llu}}",
+                 first ? "" : ",\n", pid, tid, (unsigned long long)n);
+  std::fputs("]\n", out);
+  std::fclose(out);
+  return (long)events.size();
+}
+}
@@ -1,94 +1,249 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
-#include <fstream>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#define QK_TRACE_TSC 1
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define QK_TRACE_CNTVCT 1
+#endif
+
+// The ring pointer is read on every event: initial-exec TLS keeps that a
+// single thread-pointer-relative load inside the shared library too,
+// instead of a __tls_get_addr call.
+#if defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+#define QK_TRACE_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define QK_TRACE_TLS
+#endif
+
+// Build with -DQK_DISABLE_TRACING to compile every TraceScope /
+// QK_TRACE_SCOPE down to nothing.
 
 namespace QuantKernel {
 
+/// One begin/end record as stored in the rings and the spill file.
+struct TraceEvent {
+  uint64_t ticks;   // Tracer::now()
+  uint32_t name_id; // Tracer::intern()
+  uint32_t phase;   // 'B' or 'E'
+};
+
+/**
+ * Low-overhead tracer: per-thread lock-free rings + background spill.
+ *
+ * The hot path (record) is a relaxed load of the enabled flag, a raw
+ * counter read (TSC on x86, CNTVCT on ARM, steady_clock elsewhere) and a
+ * 16-byte store plus the release publish of head into the calling
+ * thread's single-producer ring; the flusher's tail is only re-read when
+ * the producer's cached copy says the ring is full. No lock, no
+ * allocation, no formatting. A flusher thread drains every ring into a
+ * compact binary file every few ms; if a ring is full the event is
+ * dropped and counted, the producer never waits. trace_convert_to_json
+ * turns the file into Chrome trace JSON offline, with the real pid / tid.
+ *
+ * A thread's ring is retired when the thread exits and reused by the next
+ * thread that records, once the flusher has drained it, so memory follows
+ * the number of live tracing threads rather than of threads ever created.
+ *
+ * Names are interned once (QK_TRACE_SCOPE caches the id per call site).
+ * Timestamps are raw counter ticks; the file carries (ticks, steady ns)
+ * clock pairs from which the converter derives the tick rate, so an
+ * invariant counter is assumed.
+ */
 class Tracer {
 public:
+  static constexpr size_t RING_CAPACITY = size_t(1) << 18; // events / thread
+
+  struct ThreadBuffer {
+    // Producer line: written by the owning thread only
+    alignas(64) std::atomic<uint64_t> head{0}; // next write
+    uint64_t tail_cache = 0; // producer's last view of tail
+    std::atomic<uint64_t> dropped{0};
+    // Zeroed up front so page faults land in register_thread, not record
+    std::unique_ptr<TraceEvent[]> ring{new TraceEvent[RING_CAPACITY]()};
+    // Consumer line: written by the flusher
+    alignas(64) std::atomic<uint64_t> tail{0}; // next read
+    uint32_t tid = 0;
+    bool retired = false; // owner exited; guarded by threads_mu_
+  };
+
   static Tracer &instance() {
-    static Tracer instance;
-    return instance;
+    // Never destroyed: threads joined during static teardown (pool
+    // workers) still retire their rings into it. The spill file is closed
+    // at exit by a static in tracer.cpp.
+    static Tracer *tracer = new Tracer;
+    return *tracer;
   }
 
-  void begin_event(const std::string &name,
-                   const std::string &category = "kernel") {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto ts = std::chrono::duration_cast<std::chrono::microseconds>(
-                  now.time_since_epoch())
-                  .count();
-    log_event(name, category, "B", ts);
+  /// Starts spilling to path (binary). false if the file cannot be opened.
+  bool enable(const char *path);
+  /// Drains every ring, stops the flusher and closes the file.
+  void disable();
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /// Stable id for a name; takes a lock, call once per call site.
+  uint32_t intern(const char *name);
+
+  static uint64_t now() {
+#if defined(QK_TRACE_TSC)
+    return __rdtsc();
+#elif defined(QK_TRACE_CNTVCT)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
   }
 
-  void end_event(const std::string &name,
-                 const std::string &category = "kernel") {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto ts = std::chrono::duration_cast<std::chrono::microseconds>(
-                  now.time_since_epoch())
-                  .count();
-    log_event(name, category, "E", ts);
+  void record(uint32_t name_id, uint32_t phase) {
+    if (!enabled())
+      return;
+    ThreadBuffer *tb = tls_buffer_;
+    if (__builtin_expect(tb == nullptr, 0))
+      tb = register_thread();
+    const uint64_t h = tb->head.load(std::memory_order_relaxed);
+    if (__builtin_expect(h - tb->tail_cache >= RING_CAPACITY, 0)) {
+      tb->tail_cache = tb->tail.load(std::memory_order_acquire);
+      if (h - tb->tail_cache >= RING_CAPACITY) {
+        // Single writer: no read-modify-write needed
+        tb->dropped.store(tb->dropped.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+        return;
+      }
+    }
+    tb->ring[h & (RING_CAPACITY - 1)] = TraceEvent{now(), name_id, phase};
+    tb->head.store(h + 1, std::memory_order_release);
   }
 
-  void enable(const std::string &filename) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    file_.open(filename);
-    file_ << "[";
-    first_event_ = true;
-  }
-
-  void flush() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (file_.is_open())
-      file_.flush();
-  }
+  // Kept for existing callers: flushes what the rings hold right now.
+  void flush();
 
 private:
   Tracer() = default;
-  ~Tracer() {
-    if (file_.is_open()) {
-      file_ << "]";
-      file_.close();
-    }
-  }
-
-  void log_event(const std::string &name, const std::string &category,
-                 const std::string &ph, long long ts) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!file_.is_open())
-      return;
-
-    if (!first_event_)
-      file_ << ",";
-    first_event_ = false;
 
-    file_ << "{\"name\":\"" << name << "\",\"cat\":\"" << category
-          << "\",\"ph\":\"" << ph << "\",\"ts\":" << ts
-          << ",\"pid\":1,\"tid\":1}";
-  }
-
-  std::ofstream file_;
-  std::mutex mutex_;
-  bool first_event_ = true;
+  // Hands the calling thread a ring (a drained free one if any) and
+  // arranges for retire_thread at thread exit.
+  ThreadBuffer *register_thread();
+  // Marks the ring retired; with no spill file left to drain it goes
+  // straight to the free list, otherwise drain() frees it once its events
+  // are written.
+  void retire_thread(ThreadBuffer *tb);
+  // Resets a ring and moves it from threads_ to free_. Caller holds
+  // threads_mu_.
+  void release_ring(size_t index);
+  void flusher_loop();
+  // Writes pending names, every ring's new events and a clock pair, then
+  // frees drained retired rings. The last drain before the file closes
+  // also clears draining_. Caller holds io_mu_.
+  void drain(bool last = false);
+
+  struct ThreadExit; // thread_local whose destructor calls retire_thread
+
+  std::atomic<bool> enabled_{false};
+  QK_TRACE_TLS inline static thread_local ThreadBuffer *tls_buffer_ = nullptr;
+
+  std::mutex names_mu_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, uint32_t> name_ids_;
+  size_t names_written_ = 0;
+
+  std::mutex threads_mu_;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads_; // rings being drained
+  std::vector<std::unique_ptr<ThreadBuffer>> free_;    // drained, unowned
+  // A drain() is still due, so retired rings wait for it (threads_mu_)
+  bool draining_ = false;
+
+  std::mutex io_mu_;
+  std::FILE *file_ = nullptr;
+  std::thread flusher_;
+  std::mutex wake_mu_;
+  std::condition_variable wake_cv_;
+  bool stop_ = false;
 };
 
+#ifndef QK_DISABLE_TRACING
+
 // RAII Helper
 class TraceScope {
-  std::string name_;
+  uint32_t id_;
 
 public:
-  TraceScope(const std::string &name) : name_(name) {
-    Tracer::instance().begin_event(name_);
+  explicit TraceScope(uint32_t name_id) : id_(name_id) {
+    Tracer::instance().record(id_, 'B');
   }
-  ~TraceScope() { Tracer::instance().end_event(name_); }
+  /// Interns on every construction; prefer QK_TRACE_SCOPE in hot code.
+  explicit TraceScope(const char *name)
+      : TraceScope(Tracer::instance().intern(name)) {}
+  explicit TraceScope(const std::string &name) : TraceScope(name.c_str()) {}
+  ~TraceScope() { Tracer::instance().record(id_, 'E'); }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+};
+
+#define QK_TRACE_CONCAT_(a, b) a##b
+#define QK_TRACE_CONCAT(a, b) QK_TRACE_CONCAT_(a, b)
+/// Scope traced under a literal name, interned once per call site.
+#define QK_TRACE_SCOPE(name)                                                   \
+  static const uint32_t QK_TRACE_CONCAT(qk_trace_id_, __LINE__) =              \
+      ::QuantKernel::Tracer::instance().intern(name);                          \
+  ::QuantKernel::TraceScope QK_TRACE_CONCAT(qk_trace_scope_, __LINE__)(        \
+      QK_TRACE_CONCAT(qk_trace_id_, __LINE__))
+
+#else
+
+class TraceScope {
+public:
+  template <class T> explicit TraceScope(const T &) {}
 };
 
+#define QK_TRACE_SCOPE(name) ((void)0)
+
+#endif
+
 } // namespace QuantKernel
 
 extern "C" {
-void enable_tracing(const char *filename) {
-  QuantKernel::Tracer::instance().enable(filename);
-}
+/**
+ * @brief Start tracing into a binary spill file (convert it with
+ *        trace_convert_to_json or the trace2json tool).
+ * @return 0 on success, -1 if the file cannot be opened.
+ */
+int enable_tracing(const char *filename);
+
+/**
+ * @brief Drain all pending events and close the spill file.
+ */
+void disable_tracing(void);
+
+/**
+ * @brief Record a begin / end event named name on the calling thread; a
+ *        no-op while tracing is off. The name is interned per call, so use
+ *        these for coarse spans from bindings, not in hot kernels.
+ */
+void trace_begin(const char *name);
+void trace_end(const char *name);
+
+/**
+ * @brief Convert a binary spill file into Chrome trace JSON
+ *        (chrome://tracing, Perfetto).
+ * @return Number of events written, or -1 on an unreadable or corrupt
+ *         input / unwritable output.
+ */
+long trace_convert_to_json(const char *bin_path, const char *json_path);
 }
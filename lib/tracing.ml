@@ -0,0 +1,29 @@
+(* Low-overhead tracer of the native kernels: per-thread rings spilled to a
+   binary file, turned into Chrome trace JSON offline. *)
+
+external enable_stub : string -> bool = "caml_tracing_enable"
+external disable_stub : unit -> unit = "caml_tracing_disable"
+external span_begin : string -> unit = "caml_tracing_begin"
+external span_end : string -> unit = "caml_tracing_end"
+external to_json_stub : string -> string -> int = "caml_tracing_to_json"
+
+(* Starts spilling to [path]. Raises [Failure] if it cannot be opened. *)
+let enable path =
+  if not (enable_stub path) then failwith ("cannot open trace file: " ^ path)
+
+(* Drains every pending event and closes the spill file *)
+let disable () = disable_stub ()
+
+(* Runs [f] inside a span named [name] on the calling thread; a plain call
+   while tracing is off *)
+let with_span name f =
+  span_begin name;
+  Fun.protect ~finally:(fun () -> span_end name) f
+
+(* Converts the spill [bin] into Chrome trace JSON at [json] and returns the
+   number of events. Raises [Failure] on a corrupt spill or unwritable
+   output. *)
+let to_json ~bin ~json =
+  let n = to_json_stub bin json in
+  if n < 0 then failwith ("cannot convert trace file: " ^ bin);
+  n
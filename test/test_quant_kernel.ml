@@ -41,8 +41,1096 @@ let test_heston_non_negative_variance =
        next_v >= 0.0
     )
 
+(* Property: Batched signatures match the single-path kernel row by row *)
+let test_signature_batch_matches_single =
+  let gen =
+    QCheck.Gen.(pair (int_range 1 13) (int_range 2 80))
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:200
+    ~name:"signature_batch_matches_single"
+    arb
+    (fun (num_paths, num_points) ->
+       let open Signature_bergomi.Signature in
+       let block = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout
+           (num_paths * num_points * 2) in
+       for p = 0 to num_paths - 1 do
+         let w = ref 0.0 in
+         for i = 0 to num_points - 1 do
+           w := !w +. (Random.float 2.0 -. 1.0) *. 0.1;
+           block.{(p * num_points + i) * 2} <- float_of_int i *. 0.01;
+           block.{(p * num_points + i) * 2 + 1} <- !w
+         done
+       done;
+       let batch = compute_signature_batch block ~num_paths ~num_points in
+       let ok = ref true in
+       for p = 0 to num_paths - 1 do
+         let path = Bigarray.Array1.sub block (p * num_points * 2) (num_points * 2) in
+         let single = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout sig_size in
+         compute_signature_bigarray path single;
+         for k = 0 to sig_size - 1 do
+           let a = single.{k} and b = batch.{p * sig_size + k} in
+           if abs_float (a -. b) > 1e-12 *. Float.max 1.0 (abs_float a) then ok := false
+         done
+       done;
+       !ok
+    )
+
+(* Property: The streaming manifold state equals the batch one on the
+   stream's last window_size + history - 1 points and its snapshots *)
+let test_streaming_state_matches_batch =
+  let gen = QCheck.Gen.(pair (int_range 3 30) (int_range 1 200)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:100
+    ~name:"streaming_state_matches_batch"
+    arb
+    (fun (history, num_points) ->
+       let module S = Signature_bergomi.Streaming in
+       let window_size = 20 in
+       let stream = S.create ~window_size ~history in
+       let points = Array.make (2 * num_points) 0.0 in
+       let w = ref 100.0 in
+       for i = 0 to num_points - 1 do
+         w := !w +. (Random.float 2.0 -. 1.0);
+         points.(2 * i) <- float_of_int i *. 0.01;
+         points.(2 * i + 1) <- !w;
+         S.push stream points.(2 * i) !w
+       done;
+       let len = min num_points (window_size + history - 1) in
+       let path = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (2 * len) in
+       for k = 0 to 2 * len - 1 do
+         path.{k} <- points.(2 * (num_points - len) + k)
+       done;
+       let snaps, num_snaps = S.snapshots stream in
+       let batch = Manifold_geometry.compute_state path snaps num_snaps in
+       let live = Manifold_geometry.compute_state_streaming stream in
+       let close a b = abs_float (a -. b) <= 1e-9 *. Float.max 1.0 (abs_float a) in
+       let open Manifold_geometry in
+       close batch.curvature live.curvature
+       && close batch.mu live.mu
+       && close batch.sigma2 live.sigma2
+       && Array.for_all2 close batch.log_signature live.log_signature
+    )
+
+(* Property: LM calibration recovers the parameters that generated a smile *)
+let test_sabr_calibration_recovers_params =
+  let gen =
+    QCheck.Gen.(triple (float_range 0.1 0.5) (float_range (-0.7) 0.7) (float_range 0.1 1.2))
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:100
+    ~name:"sabr_calibration_recovers_params"
+    arb
+    (fun (vol_level, rho, nu) ->
+       let module B = Memory_bridge.Bridge in
+       let alpha = vol_level *. 10.0 in (* beta = 0.5, F = 100 *)
+       let truth = B.create_buffer 1 in
+       B.set_param truth 0 (alpha, 0.5, rho, nu);
+       let vec l = Bigarray.Array1.of_array Bigarray.float64 Bigarray.c_layout l in
+       let strikes = vec (Array.init 21 (fun k -> 60.0 +. 4.0 *. float_of_int k)) in
+       let forwards = vec [| 100.0 |] and tenors = vec [| 1.0 |] in
+       let vols = Sabr.Surface.implied_vol_surface ~params:truth ~forwards ~tenors ~strikes in
+       let offsets = Bigarray.Array1.of_array Bigarray.int32 Bigarray.c_layout [| 0l; 21l |] in
+       let params = B.create_buffer 1 in
+       B.set_param params 0 (0.0, 0.5, 0.0, 0.0);
+       let rmse =
+         Sabr.Calibrator.calibrate_chain ~strikes ~vols ~offsets ~forwards ~tenors ~params ()
+       in
+       rmse.{0} < 1e-8
+       && abs_float (params.{0} -. alpha) < 1e-5 *. alpha
+       && abs_float (params.{2} -. rho) < 1e-5
+       && abs_float (params.{3} -. nu) < 1e-5
+    )
+
+(* Property: native SABR paths do not depend on how the run is chunked, and
+   their on-the-fly signatures match the batch kernel on the stored paths *)
+let test_sabr_mc_chunking_and_signatures =
+  let gen =
+    QCheck.Gen.(triple (int_range 1 40) (int_range 1 60) (int_range 0 1000))
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:100
+    ~name:"sabr_mc_chunking_and_signatures"
+    arb
+    (fun (num_paths, num_steps, seed) ->
+       let open Monte_carlo.Engine in
+       let config = { num_paths; num_steps; dt = 1.0 /. 252.0; num_domains = 1 } in
+       let spot = (100.0, 0.3) in
+       let paths, sigs = simulate_native ~seed config spot 0.7 (-0.4) 0.6 in
+       let split = num_paths / 2 in
+       let _, head =
+         simulate_native ~seed ~store_paths:false { config with num_paths = split }
+           spot 0.7 (-0.4) 0.6 in
+       let _, tail =
+         simulate_native ~seed ~first_path:split ~store_paths:false
+           { config with num_paths = num_paths - split } spot 0.7 (-0.4) 0.6 in
+       let batch =
+         Signature_bergomi.Signature.compute_signature_batch paths ~num_paths
+           ~num_points:(num_steps + 1) in
+       let ok = ref true in
+       for i = 0 to num_paths * 15 - 1 do
+         let chunked = if i < split * 15 then head.{i} else tail.{i - split * 15} in
+         if chunked <> sigs.{i} then ok := false;
+         if abs_float (batch.{i} -. sigs.{i}) > 1e-12 *. Float.max 1.0 (abs_float sigs.{i})
+         then ok := false
+       done;
+       !ok
+    )
+
+(* Property: QMC runs split at any path give the same paths, and every
+   terminal value stays finite and non-negative *)
+let test_sabr_qmc_chunking =
+  let gen = QCheck.Gen.(triple (int_range 1 70) (int_range 1 40) (int_range 0 1000)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:100
+    ~name:"sabr_qmc_chunking"
+    arb
+    (fun (num_paths, num_steps, seed) ->
+       let open Monte_carlo.Engine in
+       let config = { num_paths; num_steps; dt = 1.0 /. 252.0; num_domains = 1 } in
+       let spot = (100.0, 0.3) in
+       let paths, _ = simulate_qmc ~seed config spot 0.5 (-0.3) 0.8 in
+       let split = num_paths / 3 in
+       let head, _ = simulate_qmc ~seed { config with num_paths = split } spot 0.5 (-0.3) 0.8 in
+       let tail, _ =
+         simulate_qmc ~seed ~first_path:split { config with num_paths = num_paths - split }
+           spot 0.5 (-0.3) 0.8 in
+       let path_len = 2 * (num_steps + 1) in
+       let ok = ref true in
+       for i = 0 to num_paths * path_len - 1 do
+         let chunked =
+           if i < split * path_len then head.{i} else tail.{i - split * path_len} in
+         if chunked <> paths.{i} then ok := false
+       done;
+       for p = 0 to num_paths - 1 do
+         let s_t = paths.{p * path_len + path_len - 1} in
+         if not (Float.is_finite s_t && s_t >= 0.0) then ok := false
+       done;
+       !ok
+    )
+
+(* Property: native Heston runs split at any path agree with one run, and
+   the QE variance never goes negative *)
+let test_heston_native_chunking =
+  let gen =
+    QCheck.Gen.(quad (int_range 1 50) (int_range 1 30) (float_range 0.05 1.5) bool)
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:100
+    ~name:"heston_native_chunking"
+    arb
+    (fun (num_paths, num_steps, xi, qmc) ->
+       let term =
+         [ (0.05, { Heston.default_params with xi });
+           (infinity, { Heston.default_params with xi = xi *. 0.5; theta = 0.04 }) ] in
+       let run ~first_path n =
+         Heston.simulate ~seed:7 ~first_path ~qmc ~store_variance:true term ~s0:100.0
+           ~v0:0.09 ~dt:0.01 ~num_steps ~num_paths:n in
+       let whole = run ~first_path:0 num_paths in
+       let split = num_paths / 2 in
+       let head = run ~first_path:0 split in
+       let tail = run ~first_path:split (num_paths - split) in
+       let ok = ref true in
+       for i = 0 to 2 * num_paths - 1 do
+         let chunked =
+           if i < 2 * split then head.Heston.terminal.{i} else tail.Heston.terminal.{i - 2 * split} in
+         if chunked <> whole.Heston.terminal.{i} then ok := false
+       done;
+       for i = 0 to Bigarray.Array1.dim whole.Heston.variance - 1 do
+         if not (whole.Heston.variance.{i} >= 0.0) then ok := false
+       done;
+       !ok
+    )
+
+(* Property: the native LSMC engine prices the same blocks as the OCaml
+   reference, puts and calls, around the money *)
+let test_lsmc_native_matches_reference =
+  let gen = QCheck.Gen.(triple (int_range 0 1000) (int_range 2 20) (float_range 90.0 110.0)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:20
+    ~name:"lsmc_native_matches_reference"
+    arb
+    (fun (seed, num_steps, strike) ->
+       let open Monte_carlo.Engine in
+       let config = { num_paths = 1500; num_steps; dt = 1.0 /. 52.0; num_domains = 1 } in
+       let paths, sigs = simulate_native ~seed config (100.0, 0.3) 0.5 (-0.3) 0.8 in
+       let views = views config paths sigs in
+       List.for_all (fun opt_type ->
+           let reference =
+             American_pricing.LSMC.price_american views strike 0.03 config.dt opt_type in
+           let native =
+             American_pricing.LSMC.price_block ~paths ~sigs ~num_paths:config.num_paths
+               ~num_steps strike 0.03 config.dt opt_type in
+           Float.abs (native -. reference) <= 1e-6 *. (1.0 +. Float.abs reference))
+         [ American_pricing.LSMC.Put; American_pricing.LSMC.Call ]
+    )
+
+(* Property: pricing a chain in one pass gives every option the same price
+   as its own price_block call *)
+let test_lsmc_chain_matches_single =
+  let gen = QCheck.Gen.(pair (int_range 0 1000) (int_range 2 20)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:10
+    ~name:"lsmc_chain_matches_single"
+    arb
+    (fun (seed, num_steps) ->
+       let open Monte_carlo.Engine in
+       let config = { num_paths = 1500; num_steps; dt = 1.0 /. 52.0; num_domains = 1 } in
+       let paths, sigs = simulate_native ~seed config (100.0, 0.3) 0.5 (-0.3) 0.8 in
+       let options = American_pricing.LSMC.[|
+           (90.0, Put); (95.0, Call); (100.0, Put); (100.0, Call);
+           (105.0, Put); (100.0, Put); (110.0, Call) |] in
+       let chain =
+         American_pricing.LSMC.price_chain ~paths ~sigs ~num_paths:config.num_paths
+           ~num_steps options 0.03 config.dt in
+       Array.for_all2 (fun (strike, opt_type) price ->
+           let single =
+             American_pricing.LSMC.price_block ~paths ~sigs ~num_paths:config.num_paths
+               ~num_steps strike 0.03 config.dt opt_type in
+           Float.abs (price -. single) <= 1e-9 *. (1.0 +. Float.abs single))
+         options chain.American_pricing.LSMC.prices
+    )
+
+(* Property: native Greeks are the derivatives of the native price (same
+   seed, so bumping S0 and sigma0 moves the same paths), and replaying the
+   LSMC exercise dates reprices the American option exactly *)
+let test_sabr_greeks_match_bumps =
+  let gen = QCheck.Gen.(triple (int_range 0 1000) (int_range 2 20) (float_range 90.0 110.0)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:10
+    ~name:"sabr_greeks_match_bumps"
+    arb
+    (fun (seed, num_steps, strike) ->
+       let open Monte_carlo.Engine in
+       let config = { num_paths = 2000; num_steps; dt = 1.0 /. 52.0; num_domains = 1 } in
+       let close a b tol = Float.abs (a -. b) <= tol *. (1.0 +. Float.abs b) in
+       let european = List.for_all (fun (put, digital) ->
+           let price ?(s0 = 100.0) ?(sigma0 = 0.3) () =
+             (greeks ~seed ~digital config (s0, sigma0) 0.5 (-0.3) 0.8 ~strike ~rate:0.03 ~put).price
+           in
+           let g = greeks ~seed ~digital config (100.0, 0.3) 0.5 (-0.3) 0.8 ~strike ~rate:0.03 ~put in
+           let h = 1e-4 in
+           close g.delta ((price ~s0:(100.0 +. h) () -. price ~s0:(100.0 -. h) ()) /. (2.0 *. h)) 1e-5
+           && close g.vega ((price ~sigma0:(0.3 +. h) () -. price ~sigma0:(0.3 -. h) ()) /. (2.0 *. h)) 1e-5)
+           [ (false, false); (true, false); (false, true); (true, true) ]
+       in
+       let paths, sigs = simulate_native ~seed config (100.0, 0.3) 0.5 (-0.3) 0.8 in
+       let american, exercise =
+         American_pricing.LSMC.exercise_block ~paths ~sigs ~num_paths:config.num_paths
+           ~num_steps strike 0.03 config.dt American_pricing.LSMC.Put in
+       let g = greeks ~seed ~exercise config (100.0, 0.3) 0.5 (-0.3) 0.8 ~strike ~rate:0.03 ~put:true in
+       european && close g.price american 1e-9 && g.delta <= 0.0
+    )
+
+(* Property: for a smile in forward moneyness y with total variance
+   w = T (a + b y + c y^2), the native surface matches Dupire's closed form
+   sigma^2 = a(y) / g(y, T) (the spline is exact for w quadratic in y, so
+   only the bilinear lookup differs) and flags no arbitrage *)
+let test_local_vol_surface_matches_dupire =
+  let gen =
+    QCheck.Gen.(quad (float_range 0.02 0.09) (float_range (-0.02) 0.0)
+                  (float_range 0.0 0.1) (float_range 0.0 0.05))
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:20
+    ~name:"local_vol_surface_matches_dupire"
+    arb
+    (fun (a0, b, c, r) ->
+       let s0 = 100.0 in
+       let a y = a0 +. b *. y +. c *. y *. y in
+       let strikes = Array.init 41 (fun i -> 40.0 +. 4.0 *. float_of_int i) in
+       let tenors = [| 0.25; 0.5; 1.0; 1.5; 2.0 |] in
+       let vols =
+         Array.map (fun t -> Array.map (fun k -> sqrt (a (log (k /. s0) -. r *. t))) strikes)
+           tenors in
+       let lv = Slv_engine.local_vol_surface ~s0 ~r { Slv_engine.strikes; tenors; vols } in
+       let close (k, t) =
+         let y = log (k /. s0) -. r *. t in
+         let a1 = b +. 2.0 *. c *. y in
+         let lin = 1.0 -. y *. a1 /. (2.0 *. a y) in
+         let g =
+           lin *. lin -. 0.25 *. a1 /. a y *. t *. a1 -. t *. t *. a1 *. a1 /. 16.0 +. c *. t in
+         Float.abs (Slv_engine.local_vol_at lv ~spot:k ~t -. sqrt (a y /. g)) <= 1e-3
+       in
+       Slv_engine.arbitrage_points lv = 0
+       && List.for_all close
+            [ (60.0, 0.1); (85.0, 0.3); (100.0, 0.0); (100.0, 0.7); (117.0, 1.2); (180.0, 1.9) ]
+    )
+
+(* Property: a flat smile has a flat local-vol surface, and the calibrated SLV
+   particles are lognormal at that vol (log-variance sigma^2 T around the
+   forward) whatever the Heston correlation under the leverage *)
+let test_slv_flat_smile_is_lognormal =
+  let gen =
+    QCheck.Gen.(triple (int_range 0 1000) (float_range 0.15 0.3) (float_range (-0.7) 0.0))
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:5
+    ~name:"slv_flat_smile_is_lognormal"
+    arb
+    (fun (seed, sigma, rho) ->
+       let s0 = 100.0 and r = 0.03 and t = 1.0 in
+       let strikes = [| 50.0; 80.0; 100.0; 125.0; 200.0 |] in
+       let tenors = [| 0.25; 0.5; 1.0 |] in
+       let implied =
+         { Slv_engine.strikes; tenors; vols = Array.map (fun _ -> Array.make 5 sigma) tenors } in
+       let local_vol = Slv_engine.local_vol_surface ~s0 ~r implied in
+       let flat =
+         List.for_all
+           (fun (spot, t) ->
+              Float.abs (Slv_engine.local_vol_at local_vol ~spot ~t -. sigma) <= 1e-12)
+           [ (30.0, 0.0); (50.0, 0.1); (100.0, 0.4); (140.0, 0.75); (200.0, 1.0); (400.0, 3.0) ] in
+       let term = Heston.flat { Heston.default_params with theta = 0.04; xi = 0.3; rho } in
+       let num_paths = 20_000 in
+       let lev =
+         Slv_engine.calibrate_leverage ~seed term ~s0 ~v0:0.04 ~r local_vol
+           ~spots:[| 80.0; 100.0; 125.0 |] ~dt:0.02 ~num_steps:50 ~num_paths in
+       let sum = ref 0.0 and sum2 = ref 0.0 in
+       for i = 0 to num_paths - 1 do
+         let x = log lev.Slv_engine.terminal.{2 * i} in
+         sum := !sum +. x;
+         sum2 := !sum2 +. x *. x
+       done;
+       let n = float_of_int num_paths in
+       let mean = !sum /. n in
+       let var = !sum2 /. n -. mean *. mean in
+       flat
+       && Float.abs (lev.Slv_engine.surface.{1} -. sigma /. 0.2) <= 1e-12
+       && Float.abs (var /. (sigma *. sigma *. t) -. 1.0) <= 0.05
+       && Float.abs (mean -. (log s0 +. (r -. 0.5 *. sigma *. sigma) *. t)) <= 0.01
+    )
+
+(* Reference tensor algebra truncated at [depth] over R^dim: level n is
+   stored row-major from offset 1 + dim + ... + dim^(n-1) *)
+let ref_offsets ~dim ~depth =
+  let off = Array.make (depth + 2) 0 in
+  let len = ref 1 in
+  for n = 0 to depth do
+    off.(n + 1) <- off.(n) + !len;
+    len := !len * dim
+  done;
+  off
+
+(* a ⊗ b, level by level *)
+let ref_tensor_mul ~dim ~depth a b =
+  let off = ref_offsets ~dim ~depth in
+  let c = Array.make off.(depth + 1) 0.0 in
+  for n = 0 to depth do
+    for p = 0 to n do
+      let len_q = off.(n - p + 1) - off.(n - p) in
+      for i = 0 to off.(p + 1) - off.(p) - 1 do
+        for j = 0 to len_q - 1 do
+          let k = off.(n) + i * len_q + j in
+          c.(k) <- c.(k) +. a.(off.(p) + i) *. b.(off.(n - p) + j)
+        done
+      done
+    done
+  done;
+  c
+
+(* exp(dx): level n is dx^{⊗n} / n! *)
+let ref_tensor_exp ~dim ~depth dx =
+  let off = ref_offsets ~dim ~depth in
+  let e = Array.make off.(depth + 1) 0.0 in
+  e.(0) <- 1.0;
+  for n = 1 to depth do
+    for i = 0 to off.(n) - off.(n - 1) - 1 do
+      for k = 0 to dim - 1 do
+        e.(off.(n) + i * dim + k) <- e.(off.(n - 1) + i) *. dx.(k) /. float_of_int n
+      done
+    done
+  done;
+  e
+
+(* Chen's identity: S = exp(dx_1) ⊗ ... ⊗ exp(dx_{n-1}) over the path's
+   num_points rows of dim floats *)
+let ref_signature ~dim ~depth (path : float array) =
+  let size = (ref_offsets ~dim ~depth).(depth + 1) in
+  let s = ref (Array.init size (fun k -> if k = 0 then 1.0 else 0.0)) in
+  for i = 1 to Array.length path / dim - 1 do
+    let dx = Array.init dim (fun k -> path.(i * dim + k) -. path.((i - 1) * dim + k)) in
+    s := ref_tensor_mul ~dim ~depth !s (ref_tensor_exp ~dim ~depth dx)
+  done;
+  !s
+
+(* Random walk of num_points rows of dim floats *)
+let random_path ~dim num_points =
+  let w = Array.make dim 0.0 in
+  Array.init (num_points * dim) (fun k ->
+      let c = k mod dim in
+      w.(c) <- w.(c) +. (Random.float 2.0 -. 1.0) *. 0.1;
+      w.(c))
+
+let bigarray_of_array a = Bigarray.Array1.of_array Bigarray.float64 Bigarray.c_layout a
+
+let close_rel tol a b = abs_float (a -. b) <= tol *. Float.max 1.0 (abs_float a)
+
+(* Property: the level-3 kernel (whichever ISA branch this machine takes)
+   matches the reference signature built from Chen's identity *)
+let test_signature_level3_matches_reference =
+  let gen = QCheck.Gen.int_range 2 200 in
+  let arb = QCheck.make gen in
+  Test.make ~count:200
+    ~name:"signature_level3_matches_reference"
+    arb
+    (fun num_points ->
+       let open Signature_bergomi.Signature in
+       let path = random_path ~dim:2 num_points in
+       let native = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout sig_size in
+       compute_signature_bigarray (bigarray_of_array path) native;
+       let reference = ref_signature ~dim:2 ~depth:3 path in
+       Array.for_all Fun.id (Array.mapi (fun k r -> close_rel 1e-10 r native.{k}) reference)
+    )
+
+(* Property: the sliding expected signature (Chen slide, re-anchored every
+   256 windows) equals the mean of the per-window reference signatures, and
+   falls back to the whole-path signature when the path is too short *)
+let test_expected_signature_matches_windows =
+  let gen = QCheck.Gen.(pair (int_range 2 600) (int_range 2 40)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:30
+    ~name:"expected_signature_matches_windows"
+    arb
+    (fun (num_points, window_size) ->
+       let open Signature_bergomi.Signature in
+       let path = random_path ~dim:2 num_points in
+       let native = compute_expected_sig (bigarray_of_array path) ~window_size in
+       let reference =
+         if num_points < window_size then ref_signature ~dim:2 ~depth:3 path
+         else begin
+           let num_windows = num_points - window_size + 1 in
+           let acc = Array.make sig_size 0.0 in
+           for start = 0 to num_windows - 1 do
+             let w = ref_signature ~dim:2 ~depth:3 (Array.sub path (2 * start) (2 * window_size)) in
+             Array.iteri (fun k x -> acc.(k) <- acc.(k) +. x) w
+           done;
+           Array.map (fun x -> x /. float_of_int num_windows) acc
+         end
+       in
+       Array.for_all Fun.id (Array.mapi (fun k r -> close_rel 1e-9 r native.{k}) reference)
+    )
+
+(* Truncated log(1 + x) = Σ (-1)^{k+1} x^{⊗k} / k with x = s - 1; the
+   (zero) constant term is dropped, as in the native layout *)
+let ref_tensor_log ~dim ~depth s =
+  let x = Array.copy s in
+  x.(0) <- 0.0;
+  let acc = Array.make (Array.length s) 0.0 in
+  let power = ref x in
+  for k = 1 to depth do
+    let coef = (if k mod 2 = 1 then 1.0 else -1.0) /. float_of_int k in
+    Array.iteri (fun r p -> acc.(r) <- acc.(r) +. coef *. p) !power;
+    power := ref_tensor_mul ~dim ~depth !power x
+  done;
+  Array.sub acc 1 (Array.length s - 1)
+
+(* Property: the (dim, depth) engine matches the reference signature and
+   tensor log on compile-time shapes, the level-3 dispatch and the runtime
+   fallback (dim 1 and 5, depth 1), and gives the trivial signature for
+   paths of fewer than 2 points *)
+let test_signature_depth_matches_reference =
+  let gen = QCheck.Gen.(triple (int_range 1 5) (int_range 1 5) (int_range 0 30)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:200
+    ~name:"signature_depth_matches_reference"
+    arb
+    (fun (dim, depth, num_points) ->
+       let open Signature_bergomi.Signature in
+       let path = random_path ~dim num_points in
+       let native = compute_signature_depth (bigarray_of_array path) ~dim ~depth in
+       let native_log = compute_log_signature_depth native ~dim ~depth in
+       let reference = ref_signature ~dim ~depth path in
+       let reference_log = ref_tensor_log ~dim ~depth reference in
+       Bigarray.Array1.dim native = signature_size ~dim ~depth
+       && Array.for_all Fun.id (Array.mapi (fun k r -> close_rel 1e-10 r native.{k}) reference)
+       && Array.for_all Fun.id
+            (Array.mapi (fun k r -> close_rel 1e-10 r native_log.{k}) reference_log)
+    )
+
+(* Hagan et al. (2002) lognormal vol; z/x(z) switches to its series near
+   the money, where the log form cancels *)
+let ref_hagan_vol ~forward:f ~strike:k ~tenor:t (alpha, beta, rho, nu) =
+  if f <= 0.0 || k <= 0.0 then 0.0
+  else begin
+    let fk = (f *. k) ** ((1.0 -. beta) /. 2.0) in
+    let lfk = log (f /. k) in
+    let z = nu /. alpha *. fk *. lfk in
+    let z_over_x =
+      if abs_float z < 1e-4 then 1.0 -. rho *. z /. 2.0 +. (2.0 -. 3.0 *. rho *. rho) *. z *. z /. 12.0
+      else z /. log ((sqrt (1.0 -. 2.0 *. rho *. z +. z *. z) +. z -. rho) /. (1.0 -. rho))
+    in
+    let omb = 1.0 -. beta in
+    let omb2 = omb *. omb in
+    let denom = fk *. (1.0 +. omb2 /. 24.0 *. lfk *. lfk +. omb2 *. omb2 /. 1920.0 *. lfk ** 4.0) in
+    let correction =
+      1.0 +. (omb2 /. 24.0 *. alpha *. alpha /. (fk *. fk)
+              +. 0.25 *. rho *. beta *. nu *. alpha /. fk
+              +. (2.0 -. 3.0 *. rho *. rho) /. 24.0 *. nu *. nu) *. t
+    in
+    alpha /. denom *. z_over_x *. correction
+  end
+
+(* Property: every point of the batch surface (param set x tenor x strike,
+   ATM and non-positive strikes included) matches the scalar Hagan formula *)
+let test_sabr_surface_matches_hagan =
+  let gen =
+    QCheck.Gen.(quad (float_range 0.0 1.0) (float_range 0.1 0.5) (float_range (-0.9) 0.9)
+                  (float_range 0.05 1.5))
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:200
+    ~name:"sabr_surface_matches_hagan"
+    arb
+    (fun (beta, vol_level, rho, nu) ->
+       let module B = Memory_bridge.Bridge in
+       let f0 = 50.0 +. Random.float 100.0 in
+       let sets = [| (vol_level *. f0 ** (1.0 -. beta), beta, rho, nu);
+                     (0.3, 1.0, -. rho, nu *. 0.5) |] in
+       let params = B.create_buffer 2 in
+       Array.iteri (B.set_param params) sets;
+       let forwards = Array.init 3 (fun j -> f0 *. exp (0.01 *. float_of_int j)) in
+       let tenors = Array.init 3 (fun _ -> 0.1 +. Random.float 4.9) in
+       let strikes =
+         Array.append [| 0.0; -1.0 |] (Array.init 31 (fun i -> f0 *. (0.5 +. 0.05 *. float_of_int i)))
+       in
+       let surface =
+         Sabr.Surface.implied_vol_surface ~params ~forwards:(bigarray_of_array forwards)
+           ~tenors:(bigarray_of_array tenors) ~strikes:(bigarray_of_array strikes)
+       in
+       let ok = ref true in
+       Array.iteri (fun p set ->
+           for j = 0 to 2 do
+             Array.iteri (fun i strike ->
+                 let reference =
+                   ref_hagan_vol ~forward:forwards.(j) ~strike ~tenor:tenors.(j) set in
+                 let native = surface.{(p * 3 + j) * Array.length strikes + i} in
+                 if abs_float (native -. reference) > 1e-10 *. abs_float reference
+                 then ok := false)
+               strikes
+           done)
+         sets;
+       !ok
+    )
+
+let ref_gelu x = 0.5 *. x *. (1.0 +. tanh (0.79788456 *. (x +. 0.044715 *. x *. x *. x)))
+
+(* Dense layer y = W x + b, W row-major [out][in] as in the qkmlp format *)
+let ref_dense w b x =
+  Array.mapi (fun i bi ->
+      let sum = ref bi in
+      Array.iteri (fun j xj -> sum := !sum +. w.(i).(j) *. xj) x;
+      !sum)
+    b
+
+(* Writes a qkmlp v1 file for the given (weights, biases, activation) layers *)
+let write_qkmlp layers =
+  let path = Filename.temp_file "quant_kernel" ".qkmlp" in
+  let oc = open_out path in
+  Printf.fprintf oc "qkmlp 1\nlayers %d\n" (List.length layers);
+  List.iter (fun (w, b, act) ->
+      Printf.fprintf oc "dense %d %d %s\n" (Array.length w.(0)) (Array.length b) act;
+      Array.iter (Array.iter (Printf.fprintf oc "%.17g ")) w;
+      Array.iter (Printf.fprintf oc "%.17g ") b;
+      output_char oc '\n')
+    layers;
+  close_out oc;
+  path
+
+let random_matrix rows cols = Array.init rows (fun _ -> Array.init cols (fun _ -> Random.float 2.0 -. 1.0))
+
+(* Property: with a loaded 7 -> hidden -> 4 network, every row of the
+   batched GEMM engine equals the per-sample forward pass plus the SABR
+   output constraints, and the float32 path stays within float rounding *)
+let test_neural_calibrate_matches_forward =
+  let gen = QCheck.Gen.(pair (int_range 1 40) (int_range 1 150)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:50
+    ~name:"neural_calibrate_matches_forward"
+    arb
+    (fun (hidden, batch) ->
+       let w1 = random_matrix hidden 7 and b1 = Array.init hidden (fun _ -> Random.float 2.0 -. 1.0) in
+       let w2 = random_matrix 4 hidden and b2 = Array.init 4 (fun _ -> Random.float 2.0 -. 1.0) in
+       let path = write_qkmlp [ (w1, b1, "gelu"); (w2, b2, "linear") ] in
+       Neural_calibrate.load_weights path;
+       Sys.remove path;
+       let inputs = Array.init (7 * batch) (fun _ -> Random.float 4.0 -. 2.0) in
+       let out = Neural_calibrate.calibrate_batch (bigarray_of_array inputs) in
+       let inputs32 = Bigarray.Array1.of_array Bigarray.float32 Bigarray.c_layout inputs in
+       let out32 = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (4 * batch) in
+       Neural_calibrate.calibrate_sabr_f32 inputs32 out32;
+       let ok = ref true in
+       for r = 0 to batch - 1 do
+         let x = Array.sub inputs (7 * r) 7 in
+         let y = ref_dense w2 b2 (Array.map ref_gelu (ref_dense w1 b1 x)) in
+         let expected =
+           [| Float.max 0.01 y.(0); 0.5; Float.min 0.99 (Float.max (-0.99) y.(2)); Float.max 0.01 y.(3) |] in
+         Array.iteri (fun k e ->
+             if abs_float (out.{4 * r + k} -. e) > 1e-9 *. (1.0 +. abs_float e)
+                || abs_float (out32.{4 * r + k} -. e) > 1e-4 *. (1.0 +. abs_float e)
+             then ok := false)
+           expected
+       done;
+       !ok
+    )
+
+(* Property: the native SABR surface network prices the fixed grid
+   (F = 100, T = 1, K_i = 80 + 0.4 i) with Hagan while no weights are
+   loaded, and with the loaded 6 -> hidden -> 1 network's forward pass on
+   [alpha; beta; rho; nu; ln(K/F); T] once they are *)
+let test_neural_sabr_inference_matches_reference =
+  let gen =
+    QCheck.Gen.(quad (int_range 1 24) (float_range 0.0 1.0) (float_range (-0.9) 0.9)
+                  (float_range 0.05 1.5))
+  in
+  let arb = QCheck.make gen in
+  Test.make ~count:50
+    ~name:"neural_sabr_inference_matches_reference"
+    arb
+    (fun (hidden, beta, rho, nu) ->
+       let open Ctypes in
+       let alpha = 0.25 *. 100.0 ** (1.0 -. beta) in
+       let c_params = make Memory_bridge.Types.model_params in
+       setf c_params Memory_bridge.Types.alpha alpha;
+       setf c_params Memory_bridge.Types.beta beta;
+       setf c_params Memory_bridge.Types.rho rho;
+       setf c_params Memory_bridge.Types.nu nu;
+       let surf_size = 100 in
+       let infer () =
+         let out = allocate_n double ~count:surf_size in
+         Sabr.Solver.neural_sabr_inference (addr c_params) out (Unsigned.Size_t.of_int surf_size);
+         CArray.to_list (CArray.from_ptr out surf_size)
+       in
+       let strike i = 80.0 +. 0.4 *. float_of_int i in
+       Sabr.Solver.clear_weights ();
+       let hagan_ok =
+         List.for_all Fun.id
+           (List.mapi (fun i v ->
+                let reference =
+                  ref_hagan_vol ~forward:100.0 ~strike:(strike i) ~tenor:1.0 (alpha, beta, rho, nu) in
+                abs_float (v -. reference) <= 1e-10 *. reference)
+               (infer ()))
+       in
+       let w1 = random_matrix hidden 6 and b1 = Array.init hidden (fun _ -> Random.float 2.0 -. 1.0) in
+       let w2 = random_matrix 1 hidden and b2 = [| Random.float 2.0 -. 1.0 |] in
+       let path = write_qkmlp [ (w1, b1, "gelu"); (w2, b2, "linear") ] in
+       let loaded = Sabr.Solver.load_weights path = Ok () && Sabr.Solver.model_loaded () in
+       Sys.remove path;
+       let net_ok =
+         List.for_all Fun.id
+           (List.mapi (fun i v ->
+                let x = [| alpha; beta; rho; nu; log (strike i) -. log 100.0; 1.0 |] in
+                let y = (ref_dense w2 b2 (Array.map ref_gelu (ref_dense w1 b1 x))).(0) in
+                abs_float (v -. y) <= 1e-9 *. (1.0 +. abs_float y))
+               (infer ()))
+       in
+       Sabr.Solver.clear_weights ();
+       hagan_ok && loaded && net_ok && not (Sabr.Solver.model_loaded ())
+    )
+
+(* Random num_rows x num_cols CSR matrix: up to 12 distinct, unsorted
+   columns per row, empty rows included *)
+let random_csr num_rows num_cols =
+  let open Markov_chain.Markov in
+  let rows =
+    Array.init num_rows (fun _ ->
+        let k = Random.int (min num_cols 12 + 1) in
+        let perm = Array.init num_cols Fun.id in
+        for i = 0 to k - 1 do
+          let j = i + Random.int (num_cols - i) in
+          let tmp = perm.(i) in
+          perm.(i) <- perm.(j);
+          perm.(j) <- tmp
+        done;
+        Array.map (fun c -> (c, Random.float 2.0 -. 1.0)) (Array.sub perm 0 k))
+  in
+  let entries = Array.concat (Array.to_list rows) in
+  let nnz = Array.length entries in
+  let row_ptr = Bigarray.Array1.create Bigarray.int32 Bigarray.c_layout (num_rows + 1) in
+  row_ptr.{0} <- 0l;
+  Array.iteri (fun r row ->
+      row_ptr.{r + 1} <- Int32.add row_ptr.{r} (Int32.of_int (Array.length row)))
+    rows;
+  { values = bigarray_of_array (Array.map snd entries);
+    col_indices =
+      Bigarray.Array1.of_array Bigarray.int32 Bigarray.c_layout
+        (Array.map (fun (c, _) -> Int32.of_int c) entries);
+    row_ptr; num_rows; num_cols; nnz }
+
+(* y = A x straight from the CSR arrays *)
+let ref_csr_spmv (m : Markov_chain.Markov.csr_matrix) x =
+  let open Markov_chain.Markov in
+  Array.init m.num_rows (fun r ->
+      let sum = ref 0.0 in
+      for k = Int32.to_int m.row_ptr.{r} to Int32.to_int m.row_ptr.{r + 1} - 1 do
+        sum := !sum +. m.values.{k} *. x.(Int32.to_int m.col_indices.{k})
+      done;
+      !sum)
+
+(* Property: every native SpMV format (CSR, SELL-C-sigma at several sigmas,
+   2x2 and 4x4 BCSR) multiplies rectangular matrices like the plain CSR loop *)
+let test_sparse_formats_match_csr =
+  let gen = QCheck.Gen.(pair (int_range 1 300) (int_range 1 300)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:100
+    ~name:"sparse_formats_match_csr"
+    arb
+    (fun (num_rows, num_cols) ->
+       let open Markov_chain.Markov in
+       let m = random_csr num_rows num_cols in
+       let x = Array.init num_cols (fun _ -> Random.float 2.0 -. 1.0) in
+       let reference = ref_csr_spmv m x in
+       List.for_all (fun (format, param) ->
+           let a = Sparse.of_csr ~format ~param m in
+           let y = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout num_rows in
+           Sparse.spmv a (bigarray_of_array x) y;
+           (Sparse.fill_ratio a >= 1.0 || m.nnz = 0)
+           && Array.for_all Fun.id (Array.mapi (fun r e -> abs_float (y.{r} -. e) <= 1e-12) reference))
+         [ (Sparse.Csr, 0); (Sparse.Sell, 0); (Sparse.Sell, 1); (Sparse.Sell, 8);
+           (Sparse.Bcsr, 2); (Sparse.Bcsr, 4) ]
+    )
+
+(* Random irreducible, aperiodic chain on num_states states: a ring with
+   self-loops plus up to 4 random edges per state, rows renormalized *)
+let random_chain num_states =
+  let edges =
+    List.concat
+      (List.init num_states (fun i ->
+           (i, (i + 1) mod num_states, 1.0) :: (i, i, 1.0)
+           :: List.init (Random.int 5) (fun _ -> (i, Random.int num_states, Random.float 1.0))))
+  in
+  let column f = Array.of_list (List.map f edges) in
+  let int32_vec a = Bigarray.Array1.of_array Bigarray.int32 Bigarray.c_layout a in
+  Markov_chain.Markov.of_coo ~renormalize:true ~num_nodes:num_states
+    (int32_vec (column (fun (i, _, _) -> Int32.of_int i)))
+    (int32_vec (column (fun (_, j, _) -> Int32.of_int j)))
+    (bigarray_of_array (column (fun (_, _, p) -> p)))
+
+(* pi P for a row-stochastic CSR matrix, rows being "from" states *)
+let ref_markov_step (m : Markov_chain.Markov.csr_matrix) pi =
+  let open Markov_chain.Markov in
+  let out = Array.make m.num_cols 0.0 in
+  for i = 0 to m.num_rows - 1 do
+    for k = Int32.to_int m.row_ptr.{i} to Int32.to_int m.row_ptr.{i + 1} - 1 do
+      let j = Int32.to_int m.col_indices.{k} in
+      out.(j) <- out.(j) +. pi.(i) *. m.values.{k}
+    done
+  done;
+  out
+
+(* Property: k-step propagation equals k reference steps, and both
+   stationary solvers agree with a long reference power iteration *)
+let test_markov_engine_matches_reference =
+  let gen = QCheck.Gen.(pair (int_range 1 40) (int_range 0 50)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:50
+    ~name:"markov_engine_matches_reference"
+    arb
+    (fun (num_states, steps) ->
+       let open Markov_chain.Markov in
+       let m = random_chain num_states in
+       let engine = Engine.of_csr m in
+       let pi0 = Array.init num_states (fun _ -> Random.float 1.0) in
+       let total = Array.fold_left ( +. ) 0.0 pi0 in
+       let pi0 = Array.map (fun x -> x /. total) pi0 in
+       let propagated = Engine.propagate engine (bigarray_of_array pi0) steps in
+       let reference = ref pi0 in
+       for _ = 1 to steps do reference := ref_markov_step m !reference done;
+       let stationary = ref (Array.make num_states (1.0 /. float_of_int num_states)) in
+       for _ = 1 to 20_000 do stationary := ref_markov_step m !stationary done;
+       Engine.num_states engine = num_states
+       && Array.for_all Fun.id
+            (Array.mapi (fun i r -> abs_float (propagated.{i} -. r) <= 1e-12) !reference)
+       && List.for_all (fun method_ ->
+           let pi, _, residual = Engine.stationary ~method_ ~tol:1e-12 ~max_iters:100_000 engine in
+           residual <= 1e-12
+           && Array.for_all Fun.id
+                (Array.mapi (fun i r -> abs_float (pi.{i} -. r) <= 1e-8) !stationary))
+         [ Engine.Power; Engine.Arnoldi ]
+    )
+
+(* Property: SpMM over K row-major vectors, threaded or not, equals K
+   reference SpMVs, one per column of X *)
+let test_spmm_matches_spmv =
+  let gen = QCheck.Gen.(triple (int_range 1 200) (int_range 1 200) (int_range 1 40)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:100
+    ~name:"spmm_matches_spmv"
+    arb
+    (fun (num_rows, num_cols, num_vecs) ->
+       let open Ctypes in
+       let m = random_csr num_rows num_cols in
+       let x = Array.init (num_cols * num_vecs) (fun _ -> Random.float 2.0 -. 1.0) in
+       let x_ba = bigarray_of_array x in
+       let int_ptr v = coerce (ptr int32_t) (ptr int) (bigarray_start array1 v) in
+       List.for_all (fun parallel ->
+           let y = Bigarray.Array1.create Bigarray.float64 Bigarray.c_layout (num_rows * num_vecs) in
+           Markov_chain.Markov.spmm_csr
+             (bigarray_start array1 m.Markov_chain.Markov.values)
+             (int_ptr m.Markov_chain.Markov.col_indices) (int_ptr m.Markov_chain.Markov.row_ptr)
+             num_rows num_cols (bigarray_start array1 x_ba) num_vecs (bigarray_start array1 y)
+             parallel;
+           List.for_all (fun v ->
+               let column = Array.init num_cols (fun c -> x.(c * num_vecs + v)) in
+               Array.for_all Fun.id
+                 (Array.mapi (fun r e -> abs_float (y.{r * num_vecs + v} -. e) <= 1e-12)
+                    (ref_csr_spmv m column)))
+             (List.init num_vecs Fun.id))
+         [ 0; 1 ]
+    )
+
+(* CSR arrays from per-row (target, prob) lists, rows optionally scaled by
+   the inverse of their sum *)
+let ref_csr_of_rows ~renormalize rows =
+  let rows =
+    Array.map (fun row ->
+        let sum = List.fold_left (fun acc (_, p) -> acc +. p) 0.0 row in
+        if renormalize && sum > 0.0 then
+          let inv = 1.0 /. sum in
+          List.map (fun (j, p) -> (j, p *. inv)) row
+        else row)
+      rows
+  in
+  let row_ptr = Array.make (Array.length rows + 1) 0 in
+  Array.iteri (fun i row -> row_ptr.(i + 1) <- row_ptr.(i) + List.length row) rows;
+  let entries = Array.of_list (List.concat (Array.to_list rows)) in
+  (row_ptr, Array.map fst entries, Array.map snd entries)
+
+let csr_matches (m : Markov_chain.Markov.csr_matrix) (row_ptr, cols, values) =
+  let open Markov_chain.Markov in
+  m.nnz = Array.length cols
+  && Array.for_all Fun.id (Array.mapi (fun i r -> Int32.to_int m.row_ptr.{i} = r) row_ptr)
+  && Array.for_all Fun.id (Array.mapi (fun k c -> Int32.to_int m.col_indices.{k} = c) cols)
+  && Array.for_all Fun.id (Array.mapi (fun k v -> close_rel 1e-15 v m.values.{k}) values)
+
+(* Property: the native COO -> CSR builder prunes, renormalizes and keeps
+   input order within a row exactly like the Hashtbl pipeline
+   (prune_graph, then one CSR row per state) and a stable sort by source *)
+let test_csr_builder_matches_hashtbl =
+  let gen = QCheck.Gen.(triple (int_range 1 50) (int_range 0 300) (float_range 0.0 0.5)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:200
+    ~name:"csr_builder_matches_hashtbl"
+    arb
+    (fun (num_nodes, num_edges, epsilon) ->
+       let open Markov_chain.Markov in
+       let edges =
+         Array.init num_edges (fun _ ->
+             (Random.int num_nodes, Random.int num_nodes, Random.float 1.0)) in
+       let g : graph = Hashtbl.create num_nodes in
+       for i = num_nodes - 1 downto 0 do
+         let ts =
+           List.filter_map (fun (s, d, p) -> if s = i then Some { target = d; prob = p } else None)
+             (Array.to_list edges) in
+         if ts <> [] then Hashtbl.replace g i ts
+       done;
+       let rows_of_graph g =
+         Array.init num_nodes (fun i ->
+             match Hashtbl.find_opt g i with
+             | Some ts -> List.map (fun t -> (t.target, t.prob)) ts
+             | None -> [])
+       in
+       let pruned = prune_to_csr g num_nodes epsilon in
+       let column f = Array.map f edges in
+       let int32_vec a = Bigarray.Array1.of_array Bigarray.int32 Bigarray.c_layout a in
+       let raw =
+         of_coo ~epsilon ~num_nodes
+           (int32_vec (column (fun (s, _, _) -> Int32.of_int s)))
+           (int32_vec (column (fun (_, d, _) -> Int32.of_int d)))
+           (bigarray_of_array (column (fun (_, _, p) -> p)))
+       in
+       csr_matches pruned (ref_csr_of_rows ~renormalize:true (rows_of_graph (prune_graph g epsilon)))
+       && csr_matches raw (ref_csr_of_rows ~renormalize:false (rows_of_graph (prune_graph g epsilon)))
+       && csr_matches (to_csr g num_nodes) (ref_csr_of_rows ~renormalize:false (rows_of_graph g))
+    )
+
+(* Index of [sub] in [s] at or after [from], if any *)
+let rec find_from s sub from =
+  if from + String.length sub > String.length s then None
+  else if String.sub s from (String.length sub) = sub then Some from
+  else find_from s sub (from + 1)
+
+(* Property: nested OCaml spans recorded while tracing is on come back from
+   the binary spill as matching Chrome trace begin / end events, in order,
+   and spans outside enable / disable are not recorded *)
+let test_tracing_round_trips_spans =
+  let gen = QCheck.Gen.(list_size (int_range 0 50) (int_range 0 5)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:20
+    ~name:"tracing_round_trips_spans"
+    arb
+    (fun ids ->
+       let names = List.map (Printf.sprintf "span_%d") ids in
+       let bin = Filename.temp_file "quant_kernel" ".qkt" in
+       let json = Filename.temp_file "quant_kernel" ".json" in
+       Tracing.with_span "untraced" ignore;
+       Tracing.enable bin;
+       let rec nest = function
+         | [] -> ()
+         | name :: rest -> Tracing.with_span name (fun () -> nest rest)
+       in
+       nest names;
+       Tracing.disable ();
+       Tracing.with_span "untraced" ignore;
+       let count = Tracing.to_json ~bin ~json in
+       let ic = open_in_bin json in
+       let text = really_input_string ic (in_channel_length ic) in
+       close_in ic;
+       Sys.remove bin;
+       Sys.remove json;
+       let expected =
+         List.map (fun n -> (n, 'B')) names @ List.rev_map (fun n -> (n, 'E')) names in
+       let in_order =
+         List.fold_left (fun pos (name, phase) ->
+             match pos with
+             | None -> None
+             | Some p ->
+               find_from text
+                 (Printf.sprintf "{\"name\":\"%s\",\"cat\":\"kernel\",\"ph\":\"%c\"" name phase) p
+               |> Option.map (fun i -> i + 1))
+           (Some 0) expected
+       in
+       count = 2 * List.length names && in_order <> None
+    )
+
+(* Calls recorded so far for a kernel; 0 before its first call *)
+let metric_calls name =
+  match List.find_opt (fun k -> k.Kernel_metrics.name = name) (Kernel_metrics.snapshot ()) with
+  | Some k -> k.Kernel_metrics.calls
+  | None -> 0
+
+(* Property: each outermost kernel call adds exactly one sample to its own
+   histogram and none to the kernels it runs internally (level-3 inside
+   the batch and the expected signature, the surface inside the analytic
+   neural SABR fallback) *)
+let test_metrics_count_outermost_calls =
+  let gen = QCheck.Gen.(triple (int_range 1 5) (int_range 1 5) (int_range 1 5)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:20
+    ~name:"metrics_count_outermost_calls"
+    arb
+    (fun (batches, expected, inferences) ->
+       let open Signature_bergomi.Signature in
+       let names =
+         [ "compute_signature_level3"; "compute_signature_level3_batch";
+           "compute_expected_signature"; "sabr_implied_vol_surface"; "neural_sabr_inference" ] in
+       let before = List.map metric_calls names in
+       let num_paths = 1 + Random.int 9 and num_points = 2 + Random.int 60 in
+       let block = bigarray_of_array (random_path ~dim:2 (num_paths * num_points)) in
+       for _ = 1 to batches do
+         ignore (compute_signature_batch block ~num_paths ~num_points)
+       done;
+       for _ = 1 to expected do
+         ignore (compute_expected_sig block ~window_size:20)
+       done;
+       Sabr.Solver.clear_weights ();
+       for _ = 1 to inferences do
+         ignore (Sabr.Solver.solve { Sabr.alpha = 2.5; beta = 0.5; rho = -0.3; nu = 0.6 })
+       done;
+       let after = List.map metric_calls names in
+       List.map2 ( - ) after before = [ 0; batches; expected; 0; inferences ]
+    )
+
+(* (name, size, median_ns, mad_ns, calls_per_sample) per bench_kernels
+   baseline case *)
+let baseline_cases =
+  lazy
+    (let field name = function `Assoc f -> List.assoc_opt name f | _ -> None in
+     let num = function
+       | Some (`Float x) -> x
+       | Some (`Int i) -> float_of_int i
+       | _ -> nan
+     in
+     let str = function Some (`String s) -> s | _ -> "" in
+     match field "results" (Yojson.Safe.from_file "../bench/baseline.json") with
+     | Some (`List results) ->
+       List.map (fun r ->
+           (str (field "name" r), str (field "size" r), num (field "median_ns" r),
+            num (field "mad_ns" r), num (field "calls_per_sample" r)))
+         results
+     | _ -> [])
+
+(* Property: every regression baseline case is usable (unique name and
+   size, positive finite median, non-negative MAD), and every kernel that
+   has recorded a metrics sample in this run, i.e. every instrumented
+   entry point the properties above reach, has a baseline case *)
+let test_bench_baseline_covers_kernels =
+  let gen = QCheck.Gen.int_range 0 10_000 in
+  let arb = QCheck.make gen in
+  Test.make ~count:50
+    ~name:"bench_baseline_covers_kernels"
+    arb
+    (fun i ->
+       let cases = Lazy.force baseline_cases in
+       cases <> []
+       &&
+       let name, size, median, mad, calls = List.nth cases (i mod List.length cases) in
+       Float.is_finite median && median > 0.0 && mad >= 0.0 && calls >= 1.0
+       && List.length (List.filter (fun (n, s, _, _, _) -> n = name && s = size) cases) = 1
+       && List.for_all (fun k ->
+           k.Kernel_metrics.calls = 0
+           || List.exists (fun (n, _, _, _, _) -> n = k.Kernel_metrics.name) cases)
+         (Kernel_metrics.snapshot ())
+    )
+
+(* Property: run_parallel returns one (path, sig) view per path, whatever
+   num_paths is relative to the pool size; view i is the path the engine
+   gives for (seed, first_path = i) alone, starts at (0, s0), and carries
+   the reference signature of its points *)
+let test_run_parallel_matches_single_paths =
+  let gen = QCheck.Gen.(triple (int_range 1 97) (int_range 1 40) (int_range 0 1000)) in
+  let arb = QCheck.make gen in
+  Test.make ~count:50
+    ~name:"run_parallel_matches_single_paths"
+    arb
+    (fun (num_paths, num_steps, seed) ->
+       let open Monte_carlo.Engine in
+       let config = { num_paths; num_steps; dt = 1.0 /. 252.0; num_domains = 1 } in
+       let spot = (100.0, 0.3) in
+       let views = run_parallel ~seed config spot 0.6 (-0.4) 0.7 in
+       let path_len = 2 * (num_steps + 1) in
+       Array.length views = num_paths
+       && Array.for_all Fun.id
+            (Array.mapi (fun i (path, sig_) ->
+                 let single, single_sig =
+                   simulate_native ~seed ~first_path:i { config with num_paths = 1 } spot 0.6
+                     (-0.4) 0.7 in
+                 let points = Array.init path_len (fun k -> path.{k}) in
+                 let reference = ref_signature ~dim:2 ~depth:3 points in
+                 path.{0} = 0.0 && path.{1} = 100.0
+                 && Array.for_all Fun.id (Array.init path_len (fun k -> path.{k} = single.{k}))
+                 && Array.for_all Fun.id (Array.init 15 (fun k -> sig_.{k} = single_sig.{k}))
+                 && Array.for_all Fun.id
+                      (Array.mapi (fun k r -> close_rel 1e-10 r sig_.{k}) reference))
+                views)
+    )
+
 let () =
   QCheck_runner.run_tests_main [
     test_sabr_validation;
     test_heston_non_negative_variance;
+    test_signature_batch_matches_single;
+    test_streaming_state_matches_batch;
+    test_sabr_calibration_recovers_params;
+    test_sabr_mc_chunking_and_signatures;
+    test_sabr_qmc_chunking;
+    test_heston_native_chunking;
+    test_lsmc_native_matches_reference;
+    test_lsmc_chain_matches_single;
+    test_sabr_greeks_match_bumps;
+    test_local_vol_surface_matches_dupire;
+    test_slv_flat_smile_is_lognormal;
+    test_signature_level3_matches_reference;
+    test_expected_signature_matches_windows;
+    test_signature_depth_matches_reference;
+    test_sabr_surface_matches_hagan;
+    test_neural_calibrate_matches_forward;
+    test_neural_sabr_inference_matches_reference;
+    test_sparse_formats_match_csr;
+    test_markov_engine_matches_reference;
+    test_spmm_matches_spmv;
+    test_csr_builder_matches_hashtbl;
+    test_tracing_round_trips_spans;
+    test_metrics_count_outermost_calls;
+    test_bench_baseline_covers_kernels;
+    test_run_parallel_matches_single_paths;
   ]